@@ -69,19 +69,28 @@ OCStackResult ConcurrentIotivityUtils::queueCreateResource(const std::string &ur
 OCStackResult ConcurrentIotivityUtils::respondToRequest(OCEntityHandlerRequest *request,
         OCRepPayload *payload, OCEntityHandlerResult responseCode)
 {
-    std::unique_ptr<OCEntityHandlerResponse> response = make_unique<OCEntityHandlerResponse>();
-
-    response->requestHandle = request->requestHandle;
-    response->ehResult = responseCode;
-
     // Clone a copy since this allocation is going across thread boundaries.
-    response->payload = (OCPayload *) OCRepPayloadClone(payload);
+    std::unique_ptr<OCRepPayload, decltype(OCRepPayloadDestroy) *> clone {
+        OCRepPayloadClone(payload), OCRepPayloadDestroy};
 
-    if (payload != NULL && response->payload == NULL)
+    if (payload != NULL && clone == NULL)
     {
         return OC_STACK_NO_MEMORY;
     }
 
+    return respondToRequest(request, std::move(clone), responseCode);
+}
+
+OCStackResult ConcurrentIotivityUtils::respondToRequest(OCEntityHandlerRequest *request,
+        std::unique_ptr<OCRepPayload, decltype(OCRepPayloadDestroy) *> payload,
+        OCEntityHandlerResult responseCode)
+{
+    std::unique_ptr<OCEntityHandlerResponse> response = make_unique<OCEntityHandlerResponse>();
+
+    response->requestHandle = request->requestHandle;
+    response->ehResult = responseCode;
+    response->payload = (OCPayload *) payload.release();
+
     std::unique_ptr<IotivityWorkItem> item = make_unique<SendResponseItem>(std::move(response));
     m_queue->put(std::move(item));
 
@@ -92,28 +101,23 @@ OCStackResult ConcurrentIotivityUtils::respondToRequestWithError(OCEntityHandler
         const std::string &errorMessage,
         OCEntityHandlerResult errorCode)
 {
-    OCRepPayload *errorPayload = NULL;
+    std::unique_ptr<OCRepPayload, decltype(OCRepPayloadDestroy) *> errorPayload {
+        NULL, OCRepPayloadDestroy};
 
     if (!errorMessage.empty())
     {
-        errorPayload = OCRepPayloadCreate();
+        errorPayload.reset(OCRepPayloadCreate());
 
         if (!errorPayload)
         {
             return OC_STACK_NO_MEMORY;
         }
 
-        OCRepPayloadSetPropString(errorPayload, "x.org.iotivity.error", errorMessage.c_str());
-    }
-
-    OCStackResult res = respondToRequest(request, errorPayload, errorCode);
-
-    if (errorPayload)
-    {
-        OCRepPayloadDestroy(errorPayload);
+        OCRepPayloadSetPropString(errorPayload.get(), "x.org.iotivity.error",
+                                  errorMessage.c_str());
     }
 
-    return res;
+    return respondToRequest(request, std::move(errorPayload), errorCode);
 }
 
 OCStackResult ConcurrentIotivityUtils::queueNotifyObservers(const std::string &resourceUri)
@@ -21,6 +21,12 @@
 
 #include "curlClient.h"
 #include <iostream>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
 #include "logger.h"
 
 using namespace std;
@@ -30,6 +36,501 @@ using namespace OC::Bridging;
 
 #define DEFAULT_CURL_TIMEOUT_SECONDS     60L
 
+// Connections kept alive by the shared client, in total and per host.
+#define CURL_MAX_CONNECTIONS             16L
+#define CURL_MAX_HOST_CONNECTIONS        4L
+
+// Upper bound of one curl_multi_wait() call; new requests wake the client earlier.
+#define CURL_MULTI_WAIT_MS               1000
+
+namespace OC
+{
+    namespace Bridging
+    {
+        /**
+         * Runs the requests of all CurlClient instances of the process on one curl multi
+         * handle and one thread, so connections to a host are kept alive and reused
+         * between requests. The easy handles are only touched by that thread.
+         */
+        class CurlMultiClient
+        {
+            public:
+                static CurlMultiClient *instance();
+
+                ~CurlMultiClient();
+
+                int submit(const CurlClient &request, CurlCallback callback);
+
+                bool isClientThread() const
+                {
+                    return std::this_thread::get_id() == m_thread.get_id();
+                }
+
+            private:
+                struct Transfer
+                {
+                    CURL *curl;
+                    struct curl_slist *headers;
+
+                    // Key of a coalesced GET, empty for requests that are never shared.
+                    std::string key;
+
+                    // Strings curl keeps pointers to while the transfer runs.
+                    std::string url;
+                    std::string method;
+                    std::string body;
+                    std::string username;
+                    curl_usessl useSsl;
+
+                    CurlClient::MemoryChunk rspBody;
+                    CurlClient::MemoryChunk rspHeader;
+
+                    // Guarded by m_mutex, GETs may join until the transfer completes.
+                    std::vector<CurlCallback> callbacks;
+                };
+
+                CurlMultiClient();
+
+                bool start();
+                void run();
+                void wakeup();
+                void startTransfer(Transfer *transfer);
+                void completeTransfer(CURL *curl, CURLcode code);
+                void destroyTransfer(Transfer *transfer);
+
+                CURLM *m_multi;
+                CURLSH *m_share;
+                int m_wakeupFds[2];
+                std::thread m_thread;
+
+                std::mutex m_mutex;
+                bool m_stop;
+                std::deque<Transfer *> m_pending;
+                std::map<std::string, Transfer *> m_coalescedGets;
+
+                // Only used by the client thread.
+                std::map<CURL *, Transfer *> m_running;
+        };
+    }
+}
+
+static int buildHeaderList(const std::vector<std::string> &inHeaders, struct curl_slist **headers)
+{
+    for (unsigned int i = 0; i < inHeaders.size(); i++)
+    {
+        struct curl_slist *appended = curl_slist_append(*headers, inHeaders[i].c_str());
+        if (NULL == appended)
+        {
+            OIC_LOG(ERROR, TAG, "curl_slist_append failed");
+            return MPM_RESULT_OUT_OF_MEMORY;
+        }
+        *headers = appended;
+    }
+    return MPM_RESULT_OK;
+}
+
+static void configureHandle(CURL *curl,
+                            const std::string &url,
+                            const std::string &method,
+                            struct curl_slist *headers,
+                            const std::string &request,
+                            const std::string &username,
+                            curl_usessl useSsl,
+                            size_t (*writeCallback)(void *, size_t, size_t, void *),
+                            void *body,
+                            void *header)
+{
+    // Expect the transfer to complete within DEFAULT_CURL_TIMEOUT seconds
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, DEFAULT_CURL_TIMEOUT_SECONDS);
+
+    // Set CURLOPT_VERBOSE to 1L below to see detailed debugging
+    // information on curl operations.
+    curl_easy_setopt(curl, CURLOPT_VERBOSE, 0);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, false);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, writeCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, body);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, header);
+    if (CURLUSESSL_NONE != useSsl)
+    {
+        curl_easy_setopt(curl, CURLOPT_USE_SSL, useSsl);
+    }
+
+    if (!username.empty())
+    {
+        curl_easy_setopt(curl, CURLOPT_USERNAME, username.c_str());
+    }
+
+    if (!method.empty())
+    {
+        // NOTE: The documentation for CURLOPT_CUSTOMREQUEST only lists HTTP, FTP, IMAP, POP3, and SMTP
+        //       as valid options, although it says all this option does is change the string used in
+        //       the request. (Basically, don't know whether this option has any effect as currently
+        //       used?
+
+        /// only required for GET, PUT, DELETE
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method.c_str());
+    }
+}
+
+CurlMultiClient *CurlMultiClient::instance()
+{
+    // Plugins run in forked processes, the client is created by the first request of
+    // each process so its thread lives in that process.
+    static CurlMultiClient client;
+    static bool started = client.start();
+
+    return started ? &client : NULL;
+}
+
+CurlMultiClient::CurlMultiClient() :
+    m_multi(NULL), m_share(NULL), m_stop(false)
+{
+    m_wakeupFds[0] = -1;
+    m_wakeupFds[1] = -1;
+}
+
+bool CurlMultiClient::start()
+{
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    m_multi = curl_multi_init();
+    if (m_multi == NULL)
+    {
+        OIC_LOG(ERROR, TAG, "curl_multi_init failed");
+        return false;
+    }
+
+    curl_multi_setopt(m_multi, CURLMOPT_MAXCONNECTS, CURL_MAX_CONNECTIONS);
+    curl_multi_setopt(m_multi, CURLMOPT_MAX_HOST_CONNECTIONS, CURL_MAX_HOST_CONNECTIONS);
+
+    // All handles run on the client thread, so the share needs no lock callbacks.
+    m_share = curl_share_init();
+    if (m_share != NULL)
+    {
+        curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+
+    if (pipe(m_wakeupFds) != 0)
+    {
+        OIC_LOG(ERROR, TAG, "Failed to create the wakeup pipe");
+        m_wakeupFds[0] = -1;
+        m_wakeupFds[1] = -1;
+        return false;
+    }
+    fcntl(m_wakeupFds[0], F_SETFL, O_NONBLOCK);
+    fcntl(m_wakeupFds[1], F_SETFL, O_NONBLOCK);
+
+    m_thread = std::thread(&CurlMultiClient::run, this);
+    return true;
+}
+
+CurlMultiClient::~CurlMultiClient()
+{
+    if (m_thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        wakeup();
+        m_thread.join();
+    }
+
+    for (auto &running : m_running)
+    {
+        curl_multi_remove_handle(m_multi, running.first);
+        destroyTransfer(running.second);
+    }
+    for (Transfer *transfer : m_pending)
+    {
+        destroyTransfer(transfer);
+    }
+
+    if (m_wakeupFds[0] >= 0)
+    {
+        close(m_wakeupFds[0]);
+        close(m_wakeupFds[1]);
+    }
+    if (m_share != NULL)
+    {
+        curl_share_cleanup(m_share);
+    }
+    if (m_multi != NULL)
+    {
+        curl_multi_cleanup(m_multi);
+    }
+}
+
+int CurlMultiClient::submit(const CurlClient &request, CurlCallback callback)
+{
+    std::string key;
+
+    if (request.m_method == OC::PlatformCommands::GET && request.m_requestBody.empty())
+    {
+        key = request.m_url + '\n' + request.m_username + '\n' + std::to_string(request.m_useSsl);
+        for (const std::string &header : request.m_requestHeaders)
+        {
+            key += '\n' + header;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_stop)
+    {
+        return MPM_RESULT_INTERNAL_ERROR;
+    }
+
+    if (!key.empty())
+    {
+        auto inFlight = m_coalescedGets.find(key);
+        if (inFlight != m_coalescedGets.end())
+        {
+            inFlight->second->callbacks.push_back(std::move(callback));
+            return MPM_RESULT_OK;
+        }
+    }
+
+    Transfer *transfer = new Transfer();
+    transfer->curl = NULL;
+    transfer->headers = NULL;
+    transfer->key = key;
+    transfer->url = request.m_url;
+    transfer->method = request.m_method;
+    transfer->body = request.m_requestBody;
+    transfer->username = request.m_username;
+    transfer->useSsl = request.m_useSsl;
+    transfer->callbacks.push_back(std::move(callback));
+
+    if (buildHeaderList(request.m_requestHeaders, &transfer->headers) != MPM_RESULT_OK)
+    {
+        destroyTransfer(transfer);
+        return MPM_RESULT_OUT_OF_MEMORY;
+    }
+
+    if (!key.empty())
+    {
+        m_coalescedGets[key] = transfer;
+    }
+    m_pending.push_back(transfer);
+    wakeup();
+
+    return MPM_RESULT_OK;
+}
+
+void CurlMultiClient::wakeup()
+{
+    const char byte = 0;
+    // A full pipe already holds a wakeup, so a failed write is not an error.
+    if (write(m_wakeupFds[1], &byte, sizeof(byte)) < 0)
+    {
+        OIC_LOG(DEBUG, TAG, "wakeup already pending");
+    }
+}
+
+void CurlMultiClient::run()
+{
+    while (true)
+    {
+        std::deque<Transfer *> pending;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stop)
+            {
+                break;
+            }
+            pending.swap(m_pending);
+        }
+
+        for (Transfer *transfer : pending)
+        {
+            startTransfer(transfer);
+        }
+
+        int running = 0;
+        curl_multi_perform(m_multi, &running);
+
+        int queued = 0;
+        CURLMsg *msg = NULL;
+        while ((msg = curl_multi_info_read(m_multi, &queued)) != NULL)
+        {
+            if (msg->msg == CURLMSG_DONE)
+            {
+                completeTransfer(msg->easy_handle, msg->data.result);
+            }
+        }
+
+        struct curl_waitfd wakeupFd;
+        wakeupFd.fd = m_wakeupFds[0];
+        wakeupFd.events = CURL_WAIT_POLLIN;
+        wakeupFd.revents = 0;
+
+        curl_multi_wait(m_multi, &wakeupFd, 1, CURL_MULTI_WAIT_MS, NULL);
+
+        if (wakeupFd.revents)
+        {
+            char buffer[64];
+            while (read(m_wakeupFds[0], buffer, sizeof(buffer)) > 0)
+            {
+            }
+        }
+    }
+}
+
+void CurlMultiClient::startTransfer(Transfer *transfer)
+{
+    CURLcode code = CURLE_OUT_OF_MEMORY;
+
+    transfer->curl = curl_easy_init();
+    if (transfer->curl != NULL)
+    {
+        configureHandle(transfer->curl, transfer->url, transfer->method, transfer->headers,
+                        transfer->body, transfer->username, transfer->useSsl,
+                        CurlClient::WriteCallback, &transfer->rspBody, &transfer->rspHeader);
+        curl_easy_setopt(transfer->curl, CURLOPT_PRIVATE, transfer);
+        if (m_share != NULL)
+        {
+            curl_easy_setopt(transfer->curl, CURLOPT_SHARE, m_share);
+        }
+
+        if (curl_multi_add_handle(m_multi, transfer->curl) == CURLM_OK)
+        {
+            m_running[transfer->curl] = transfer;
+            return;
+        }
+        code = CURLE_FAILED_INIT;
+    }
+
+    OIC_LOG(ERROR, TAG, "Failed to start the transfer");
+    m_running[transfer->curl] = transfer;
+    completeTransfer(transfer->curl, code);
+}
+
+void CurlMultiClient::completeTransfer(CURL *curl, CURLcode code)
+{
+    auto running = m_running.find(curl);
+    if (running == m_running.end())
+    {
+        return;
+    }
+    Transfer *transfer = running->second;
+    m_running.erase(running);
+
+    CurlResponse response;
+    response.result = MPM_RESULT_OK;
+    response.responseCode = INVALID_RESPONSE_CODE;
+
+    if (code != CURLE_OK)
+    {
+        OIC_LOG_V(ERROR, TAG, "curl transfer failed with %lu", (unsigned long) code);
+        response.result = MPM_RESULT_NETWORK_ERROR;
+    }
+    else
+    {
+        if (CURLE_OK != curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.responseCode))
+        {
+            OIC_LOG(WARNING, TAG, "curl_easy_getinfo(CURLINFO_RESPONSE_CODE) failed.");
+            response.responseCode = INVALID_RESPONSE_CODE;
+        }
+        response.body = transfer->rspBody.memory;
+        CurlClient::decomposeHeader(transfer->rspHeader.memory, response.headers);
+    }
+
+    if (curl != NULL)
+    {
+        curl_multi_remove_handle(m_multi, curl);
+    }
+
+    std::vector<CurlCallback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!transfer->key.empty())
+        {
+            m_coalescedGets.erase(transfer->key);
+        }
+        callbacks.swap(transfer->callbacks);
+    }
+
+    destroyTransfer(transfer);
+
+    for (CurlCallback &callback : callbacks)
+    {
+        callback(response);
+    }
+}
+
+void CurlMultiClient::destroyTransfer(Transfer *transfer)
+{
+    if (transfer->headers != NULL)
+    {
+        curl_slist_free_all(transfer->headers);
+    }
+    if (transfer->curl != NULL)
+    {
+        curl_easy_cleanup(transfer->curl);
+    }
+    free(transfer->rspBody.memory);
+    free(transfer->rspHeader.memory);
+    delete transfer;
+}
+
+int CurlClient::send()
+{
+    CurlMultiClient *client = CurlMultiClient::instance();
+
+    // A callback on the client thread can not wait for that thread, it keeps the
+    // blocking request of its own.
+    if (client != NULL && !client->isClientThread())
+    {
+        std::mutex mutex;
+        std::condition_variable completed;
+        bool done = false;
+        CurlResponse response;
+
+        int result = client->submit(*this, [&](const CurlResponse & completedResponse)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            response = completedResponse;
+            done = true;
+            completed.notify_one();
+        });
+
+        if (result == MPM_RESULT_OK)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            completed.wait(lock, [&done] { return done; });
+
+            m_lastResponseCode = response.responseCode;
+            if (response.result == MPM_RESULT_OK)
+            {
+                m_response = response.body;
+                m_outHeaders.insert(m_outHeaders.end(), response.headers.begin(),
+                                    response.headers.end());
+            }
+            return response.result;
+        }
+    }
+
+    return doInternalRequest(m_url, m_method, m_requestHeaders, m_requestBody, m_username, m_outHeaders,
+                             m_response);
+}
+
+int CurlClient::sendAsync(CurlCallback callback)
+{
+    CurlMultiClient *client = CurlMultiClient::instance();
+    if (client == NULL)
+    {
+        return MPM_RESULT_INTERNAL_ERROR;
+    }
+    return client->submit(*this, std::move(callback));
+}
+
 
 size_t CurlClient::WriteCallback(void *contents, size_t size, size_t nmemb, void *userp)
 {
@@ -94,52 +595,14 @@ int CurlClient::doInternalRequest(const std::string &url,
     {
         curl_easy_reset(curl);
 
-        for (unsigned int i = 0; i < inHeaders.size(); i++)
+        result = buildHeaderList(inHeaders, &headers);
+        if (result != MPM_RESULT_OK)
         {
-            headers = curl_slist_append(headers, inHeaders[i].c_str());
-            if (NULL == headers)
-            {
-                OIC_LOG(ERROR, TAG, "curl_slist_append failed");
-                result = MPM_RESULT_OUT_OF_MEMORY;
-                goto CLEANUP;
-            }
-        }
-
-        // Expect the transfer to complete within DEFAULT_CURL_TIMEOUT seconds
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, DEFAULT_CURL_TIMEOUT_SECONDS);
-
-        // Set CURLOPT_VERBOSE to 1L below to see detailed debugging
-        // information on curl operations.
-        curl_easy_setopt(curl, CURLOPT_VERBOSE, 0);
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, false);
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &rsp_body);
-        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &rsp_header);
-        if (CURLUSESSL_NONE != m_useSsl)
-        {
-            curl_easy_setopt(curl, CURLOPT_USE_SSL, m_useSsl);
-        }
-
-        if (!username.empty())
-        {
-            curl_easy_setopt(curl, CURLOPT_USERNAME, username.c_str());
+            goto CLEANUP;
         }
 
-        if (!method.empty())
-        {
-            // NOTE: The documentation for CURLOPT_CUSTOMREQUEST only lists HTTP, FTP, IMAP, POP3, and SMTP
-            //       as valid options, although it says all this option does is change the string used in
-            //       the request. (Basically, don't know whether this option has any effect as currently
-            //       used?
-
-            /// only required for GET, PUT, DELETE
-            curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method.c_str());
-        }
+        configureHandle(curl, url, method, headers, request, username, m_useSsl,
+                        WriteCallback, &rsp_body, &rsp_header);
 
         res = curl_easy_perform(curl);
         if (res != CURLE_OK)
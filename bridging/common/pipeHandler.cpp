@@ -28,6 +28,8 @@
 #include <string.h>
 #include <errno.h>
 #include "messageHandler.h"
+#include "pluginIf.h"
+#include "shmHandler.h"
 #include "iotivity_config.h"
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
@@ -113,13 +115,22 @@ ssize_t MPMReadPipeMessage(int fd, MPMPipeMessage *pipe_message)
         }
         else
         {
-            ret = read(fd, (void*)pipe_message->payload, pipe_message->payloadSize);
-            if (ret < 0)
+            /* payloads larger than the pipe buffer arrive in several reads */
+            size_t payloadRead = 0;
+            do
             {
-                OIC_LOG_V(ERROR, TAG, "Error Reading message from the pipe - [%s]", strerror(errno));
-                return ret;
+                ret = read(fd, (uint8_t *)pipe_message->payload + payloadRead,
+                           pipe_message->payloadSize - payloadRead);
+                if (ret < 0)
+                {
+                    OIC_LOG_V(ERROR, TAG, "Error Reading message from the pipe - [%s]",
+                              strerror(errno));
+                    return ret;
+                }
+                payloadRead += ret;
             }
-            bytesRead += ret;
+            while (ret > 0 && payloadRead < pipe_message->payloadSize);
+            bytesRead += payloadRead;
         }
     }
     else
@@ -129,3 +140,21 @@ ssize_t MPMReadPipeMessage(int fd, MPMPipeMessage *pipe_message)
     }
     return bytesRead;
 }
+
+MPMResult MPMWriteMessage(const MPMPipe *pipe, const MPMPipeMessage *pipe_message)
+{
+    if (pipe->ring)
+    {
+        return MPMShmWriteMessage(pipe->ring, pipe->write_fd, pipe_message);
+    }
+    return MPMWritePipeMessage(pipe->write_fd, pipe_message);
+}
+
+ssize_t MPMReadMessage(const MPMPipe *pipe, MPMPipeMessage *pipe_message)
+{
+    if (pipe->ring)
+    {
+        return MPMShmReadMessage(pipe->ring, pipe->read_fd, pipe_message);
+    }
+    return MPMReadPipeMessage(pipe->read_fd, pipe_message);
+}
@@ -50,13 +50,25 @@ static void waitForChildProcessToComplete(pid_t child_pid, int32_t timeout);
 
 /* This is a timed wait for pipe write; the written value is returned in the passed
  * in message buffer.
- * @param[in]  fd_to_parent       File descriptor
+ * @param[in]  pipe_to_parent     Pipe from the child
  * @param[out] message            Message from the child
  * @param[in]  timeout            Time to wait for pipe write in seconds
  */
-static void timedWaitForPipeWrite(int fd_to_parent, MPMPipeMessage *message,
+static void timedWaitForPipeWrite(const MPMPipe *pipe_to_parent, MPMPipeMessage *message,
                                   int32_t timeout);
 
+/* This function maps the shared memory rings of both pipes when the shared
+ * memory transport is enabled. The pipes keep carrying the messages if it is
+ * not enabled or if mapping fails.
+ * @param[in] ctx        the plugin context created with the "create" function
+ */
+static void createSharedMemoryRings(MPMCommonPluginCtx *ctx);
+
+/* This function unmaps the shared memory rings of both pipes, if any.
+ * @param[in] ctx        the plugin context created with the "create" function
+ */
+static void destroySharedMemoryRings(MPMCommonPluginCtx *ctx);
+
 
 /**
  * The purpose of this function is to create a context or instance of the
@@ -122,6 +134,8 @@ static int start(MPMCommonPluginCtx *ctx)
             return result;
         }
 
+        createSharedMemoryRings(ctx);
+
         switch (pid = fork())
         {
             case 0:
@@ -165,7 +179,7 @@ static int start(MPMCommonPluginCtx *ctx)
                  * The parent must wait here for some time to
                  * learn what happened.
                  */
-                timedWaitForPipeWrite(ctx->parent_reads_fds.read_fd,
+                timedWaitForPipeWrite(&ctx->parent_reads_fds,
                                       &pipe_message,
                                       MPM_TIMEOUT_VAL_IN_SEC);
                 if (pipe_message.msgType == MPM_DONE)
@@ -195,6 +209,7 @@ static int start(MPMCommonPluginCtx *ctx)
                      */
                     close(ctx->child_reads_fds.write_fd);
                     close(ctx->parent_reads_fds.read_fd);
+                    destroySharedMemoryRings(ctx);
                 }
 
                 OICFree((void*)pipe_message.payload);
@@ -204,6 +219,11 @@ static int start(MPMCommonPluginCtx *ctx)
             case -1:
                 perror("fork");
                 OIC_LOG(ERROR, TAG, "Fork returned error.");
+                close(ctx->child_reads_fds.read_fd);
+                close(ctx->child_reads_fds.write_fd);
+                close(ctx->parent_reads_fds.read_fd);
+                close(ctx->parent_reads_fds.write_fd);
+                destroySharedMemoryRings(ctx);
                 break;
         }
     }
@@ -233,7 +253,7 @@ static void stop(MPMCommonPluginCtx *ctx)
         pipe_message.msgType = MPM_STOP;
         pipe_message.payload = NULL;
 
-        result = MPMWritePipeMessage(ctx->child_reads_fds.write_fd, &pipe_message);
+        result = MPMWriteMessage(&ctx->child_reads_fds, &pipe_message);
         if (result != MPM_RESULT_OK)
         {
             OIC_LOG(ERROR, TAG, "Failed to write to pipe for stop");
@@ -265,6 +285,10 @@ static void destroy(MPMCommonPluginCtx *ctx)
     {
         stop(ctx);
     }
+    if (ctx)
+    {
+        destroySharedMemoryRings(ctx);
+    }
     OICFree(ctx);
 }
 
@@ -308,10 +332,38 @@ static void waitForChildProcessToComplete(pid_t child_pid, int32_t timeout)
     }
 }
 
-static void timedWaitForPipeWrite(int fd, MPMPipeMessage *msg, int32_t timeout)
+static void createSharedMemoryRings(MPMCommonPluginCtx *ctx)
+{
+    if (getenv(MPM_SHM_TRANSPORT_ENV) == NULL)
+    {
+        return;
+    }
+
+    ctx->parent_reads_fds.ring = MPMShmRingCreate(MPM_SHM_RING_SIZE);
+    ctx->child_reads_fds.ring = MPMShmRingCreate(MPM_SHM_RING_SIZE);
+
+    if (ctx->parent_reads_fds.ring == NULL || ctx->child_reads_fds.ring == NULL)
+    {
+        OIC_LOG(ERROR, TAG, "Failed to map shared memory, using the pipes for messages");
+        destroySharedMemoryRings(ctx);
+        return;
+    }
+    OIC_LOG(INFO, TAG, "Using shared memory for messages");
+}
+
+static void destroySharedMemoryRings(MPMCommonPluginCtx *ctx)
+{
+    MPMShmRingDestroy(ctx->parent_reads_fds.ring);
+    ctx->parent_reads_fds.ring = NULL;
+    MPMShmRingDestroy(ctx->child_reads_fds.ring);
+    ctx->child_reads_fds.ring = NULL;
+}
+
+static void timedWaitForPipeWrite(const MPMPipe *pipe, MPMPipeMessage *msg, int32_t timeout)
 {
     if (NULL != msg)
     {
+        int fd = pipe->read_fd;
         struct timeval tv;
         fd_set fdset;
         int nfd = -1;
@@ -337,7 +389,7 @@ static void timedWaitForPipeWrite(int fd, MPMPipeMessage *msg, int32_t timeout)
             {
                 if (FD_ISSET(fd, &(fdset)))
                 {
-                    nbytes = MPMReadPipeMessage(fd, msg);
+                    nbytes = MPMReadMessage(pipe, msg);
                 }
             }
             else
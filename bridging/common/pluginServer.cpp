@@ -122,15 +122,17 @@ std::unique_ptr<ConcurrentIotivityUtils> iotivityUtils = NULL;
 /**
  * This is a non blocking pipe read function
  *
- * @param[in] fd            file descriptor from where messages are to be read
+ * @param[in] pipe          pipe from where messages are to be read
  * @param[in] com_ctx       common context
  * @param[in] ctx           plugin specific context
  *
  * @return false if STOP request has come from the MPM, true if STOP request
  *         has not come from the MPM
  */
-bool processMessagesFromMPM(int fd, MPMCommonPluginCtx *com_ctx, MPMPluginCtx *ctx)
+bool processMessagesFromMPM(const MPMPipe *pipe, MPMCommonPluginCtx *com_ctx,
+                            MPMPluginCtx *ctx)
 {
+    int fd = pipe->read_fd;
     struct timeval tv;
     fd_set fdset;
     int nfd = -1;
@@ -157,7 +159,7 @@ bool processMessagesFromMPM(int fd, MPMCommonPluginCtx *com_ctx, MPMPluginCtx *c
     {
         if (FD_ISSET(fd, &(fdset)))
         {
-            nbytes = MPMReadPipeMessage(fd, &pipe_message);
+            nbytes = MPMReadMessage(pipe, &pipe_message);
             if (nbytes == 0)
             {
                 OIC_LOG(DEBUG, TAG, "EOF was read and file descriptor was found to be closed");
@@ -354,7 +356,7 @@ void *processMessageFromPipeThreadProc(void *arg)
     MPMCommonPluginCtx *ctx = (MPMCommonPluginCtx *)arg;
     while (true)
     {
-        bool result = processMessagesFromMPM(ctx->child_reads_fds.read_fd, ctx, g_plugin_context);
+        bool result = processMessagesFromMPM(&ctx->child_reads_fds, ctx, g_plugin_context);
         if (result != MPM_RESULT_OK)
         {
             OIC_LOG(INFO, TAG, "Leaving processMessageFromPipeThreadProc ");
@@ -380,14 +382,14 @@ MPMResult maintainInfrastructure(MPMResult result, MPMCommonPluginCtx *ctx)
             pipe_message.msgType = MPM_DONE;
             pipe_message.payloadSize = 0;
             pipe_message.payload = NULL;
-            result = MPMWritePipeMessage(ctx->parent_reads_fds.write_fd, &pipe_message);
+            result = MPMWriteMessage(&ctx->parent_reads_fds, &pipe_message);
         }
         else
         {
             pipe_message.msgType = MPM_ERROR;
             pipe_message.payloadSize = 0;
             pipe_message.payload = NULL;
-            result = MPMWritePipeMessage(ctx->parent_reads_fds.write_fd, &pipe_message);
+            result = MPMWriteMessage(&ctx->parent_reads_fds, &pipe_message);
         }
 
         if (result == MPM_RESULT_OK)
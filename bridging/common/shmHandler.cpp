@@ -0,0 +1,334 @@
+//******************************************************************
+//
+// Copyright 2017 Intel Mobile Communications GmbH All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+
+/**
+ * This file implements the shared memory ring carrying the messages between the
+ * MPM and the plugin processes. Each ring has a single reading process; the
+ * writers are serialized by a process shared mutex that also guards the read
+ * and write positions. Messages larger than the ring are written to the pipe
+ * after their doorbell, with the framing of the pipe transport.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+#include "shmHandler.h"
+#include "pluginIf.h"
+#include "iotivity_config.h"
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include "platform_features.h"
+#include "oic_malloc.h"
+#include "logger.h"
+
+#define TAG "SHM_HANDLER"
+
+/** Doorbell telling the message is in the ring. */
+#define MPM_SHM_DOORBELL_RING   0
+
+/** Doorbell telling the message follows in the pipe. */
+#define MPM_SHM_DOORBELL_INLINE 1
+
+/**
+ * Header of the ring, the data area follows it in the same mapping.
+ * head and tail count the bytes written and read since the ring was created,
+ * so head - tail is the number of bytes waiting to be read.
+ */
+struct MPMShmRing
+{
+    pthread_mutex_t lock;
+    pthread_cond_t space;
+    /* serializes the writes to the doorbell pipe, so an inline message is not
+     * split by another doorbell. Never held while waiting for the ring lock.
+     */
+    pthread_mutex_t pipeLock;
+    size_t mapSize;
+    size_t size;
+    size_t head;
+    size_t tail;
+};
+
+/** Header written in front of each payload in the ring. */
+typedef struct
+{
+    size_t payloadSize;
+    MPMMessageType msgType;
+} MPMShmRecord;
+
+static uint8_t *ringData(MPMShmRing *ring)
+{
+    return (uint8_t *)(ring + 1);
+}
+
+static void copyToRing(MPMShmRing *ring, size_t pos, const void *src, size_t len)
+{
+    size_t offset = pos % ring->size;
+    size_t first = (len < ring->size - offset) ? len : ring->size - offset;
+
+    memcpy(ringData(ring) + offset, src, first);
+    memcpy(ringData(ring), (const uint8_t *)src + first, len - first);
+}
+
+static void copyFromRing(MPMShmRing *ring, size_t pos, void *dst, size_t len)
+{
+    size_t offset = pos % ring->size;
+    size_t first = (len < ring->size - offset) ? len : ring->size - offset;
+
+    memcpy(dst, ringData(ring) + offset, first);
+    memcpy((uint8_t *)dst + first, ringData(ring), len - first);
+}
+
+/* Completes taking a robust mutex, ret is what locking it returned. If the other
+ * process died holding it, the positions are still consistent as each one is
+ * only updated once its data is copied, so the mutex is made usable again and
+ * the pipe reports the end of the peer. Returns 0 if the mutex is held.
+ */
+static int recoverLock(pthread_mutex_t *mutex, int ret)
+{
+    if (ret == EOWNERDEAD)
+    {
+        OIC_LOG(ERROR, TAG, "Peer process died while holding the ring lock");
+        ret = pthread_mutex_consistent(mutex);
+        if (ret != 0)
+        {
+            pthread_mutex_unlock(mutex);
+        }
+    }
+
+    if (ret != 0)
+    {
+        OIC_LOG_V(ERROR, TAG, "Error locking the shared memory ring - [%s]", strerror(ret));
+    }
+    return ret;
+}
+
+static int lockShared(pthread_mutex_t *mutex)
+{
+    return recoverLock(mutex, pthread_mutex_lock(mutex));
+}
+
+static MPMResult ringDoorbell(MPMShmRing *ring, int fd, const MPMPipeMessage *inlineMessage)
+{
+    const char doorbell = inlineMessage ? MPM_SHM_DOORBELL_INLINE : MPM_SHM_DOORBELL_RING;
+    MPMResult result = MPM_RESULT_OK;
+
+    if (lockShared(&ring->pipeLock) != 0)
+    {
+        return MPM_RESULT_INTERNAL_ERROR;
+    }
+
+    if (write(fd, &doorbell, sizeof(doorbell)) < 0)
+    {
+        OIC_LOG_V(ERROR, TAG, "Error writing doorbell over the pipe - [%s]", strerror(errno));
+        result = MPM_RESULT_INTERNAL_ERROR;
+    }
+    else if (inlineMessage)
+    {
+        result = MPMWritePipeMessage(fd, inlineMessage);
+    }
+
+    pthread_mutex_unlock(&ring->pipeLock);
+    return result;
+}
+
+MPMShmRing *MPMShmRingCreate(size_t size)
+{
+    pthread_mutexattr_t mutexAttr;
+    pthread_condattr_t condAttr;
+    size_t mapSize = sizeof(MPMShmRing) + size;
+
+    void *map = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED)
+    {
+        OIC_LOG_V(ERROR, TAG, "Error mapping the shared memory ring - [%s]", strerror(errno));
+        return NULL;
+    }
+
+    MPMShmRing *ring = (MPMShmRing *)map;
+    ring->mapSize = mapSize;
+    ring->size = size;
+    ring->head = 0;
+    ring->tail = 0;
+
+    pthread_mutexattr_init(&mutexAttr);
+    pthread_mutexattr_setpshared(&mutexAttr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&mutexAttr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&ring->lock, &mutexAttr);
+    pthread_mutex_init(&ring->pipeLock, &mutexAttr);
+    pthread_mutexattr_destroy(&mutexAttr);
+
+    pthread_condattr_init(&condAttr);
+    pthread_condattr_setpshared(&condAttr, PTHREAD_PROCESS_SHARED);
+    pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+    pthread_cond_init(&ring->space, &condAttr);
+    pthread_condattr_destroy(&condAttr);
+
+    return ring;
+}
+
+void MPMShmRingDestroy(MPMShmRing *ring)
+{
+    if (ring)
+    {
+        /* the lock and condition are shared with the other process, which may
+         * still use them, so they are only unmapped here.
+         */
+        munmap(ring, ring->mapSize);
+    }
+}
+
+MPMResult MPMShmWriteMessage(MPMShmRing *ring, int fd, const MPMPipeMessage *pipe_message)
+{
+    MPMShmRecord record;
+    struct timespec deadline;
+
+    OIC_LOG(DEBUG, TAG, "writing message to the shared memory ring");
+
+    OIC_LOG_V(DEBUG, TAG, "Message type = %d, payload size = %" PRIuPTR, pipe_message->msgType,
+              pipe_message->payloadSize);
+
+    record.payloadSize = pipe_message->payload ? pipe_message->payloadSize : 0;
+    record.msgType = pipe_message->msgType;
+
+    size_t needed = sizeof(record) + record.payloadSize;
+    if (needed > ring->size)
+    {
+        OIC_LOG_V(DEBUG, TAG, "Message of %" PRIuPTR " bytes sent through the pipe", needed);
+        return ringDoorbell(ring, fd, pipe_message);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += MPM_TIMEOUT_VAL_IN_SEC;
+
+    if (lockShared(&ring->lock) != 0)
+    {
+        return MPM_RESULT_INTERNAL_ERROR;
+    }
+
+    while (ring->size - (ring->head - ring->tail) < needed)
+    {
+        int ret = pthread_cond_timedwait(&ring->space, &ring->lock, &deadline);
+        if (ret == ETIMEDOUT)
+        {
+            pthread_mutex_unlock(&ring->lock);
+            OIC_LOG(ERROR, TAG, "Timed out waiting for room in the ring");
+            return MPM_RESULT_INTERNAL_ERROR;
+        }
+        if (recoverLock(&ring->lock, ret) != 0)
+        {
+            return MPM_RESULT_INTERNAL_ERROR;
+        }
+    }
+
+    copyToRing(ring, ring->head, &record, sizeof(record));
+    if (record.payloadSize > 0)
+    {
+        copyToRing(ring, ring->head + sizeof(record), pipe_message->payload, record.payloadSize);
+    }
+    ring->head += needed;
+
+    pthread_mutex_unlock(&ring->lock);
+
+    return ringDoorbell(ring, fd, NULL);
+}
+
+ssize_t MPMShmReadMessage(MPMShmRing *ring, int fd, MPMPipeMessage *pipe_message)
+{
+    MPMShmRecord record;
+    char doorbell = 0;
+
+    OIC_LOG(DEBUG, TAG, "reading message from the shared memory ring");
+
+    ssize_t ret = read(fd, &doorbell, sizeof(doorbell));
+    if (ret < 0)
+    {
+        OIC_LOG_V(ERROR, TAG, "Error Reading doorbell from the pipe - [%s]", strerror(errno));
+        return ret;
+    }
+    if (ret == 0)
+    {
+        return 0;
+    }
+
+    if (doorbell == MPM_SHM_DOORBELL_INLINE)
+    {
+        return MPMReadPipeMessage(fd, pipe_message);
+    }
+
+    if (lockShared(&ring->lock) != 0)
+    {
+        return -1;
+    }
+    if (ring->head == ring->tail)
+    {
+        pthread_mutex_unlock(&ring->lock);
+        OIC_LOG(ERROR, TAG, "Doorbell rang but the ring is empty");
+        return -1;
+    }
+    copyFromRing(ring, ring->tail, &record, sizeof(record));
+    size_t start = ring->tail + sizeof(record);
+    pthread_mutex_unlock(&ring->lock);
+
+    /* this is the only reader and the writers never overwrite unread bytes,
+     * so the payload is copied out without holding the lock.
+     */
+    pipe_message->msgType = record.msgType;
+    pipe_message->payloadSize = record.payloadSize;
+    pipe_message->payload = NULL;
+
+    ssize_t bytesRead = sizeof(record.payloadSize) + sizeof(record.msgType);
+
+    if (record.payloadSize > 0)
+    {
+        uint8_t *payload = (uint8_t *) OICMalloc(record.payloadSize);
+        if (!payload)
+        {
+            OIC_LOG(ERROR, TAG, "failed to allocate memory");
+            bytesRead = 0;
+        }
+        else
+        {
+            copyFromRing(ring, start, payload, record.payloadSize);
+            pipe_message->payload = payload;
+            bytesRead += record.payloadSize;
+        }
+    }
+
+    if (pipe_message->msgType == MPM_NOMSG)
+    {
+        bytesRead = 0;
+    }
+
+    if (lockShared(&ring->lock) != 0)
+    {
+        OICFree((void *)pipe_message->payload);
+        pipe_message->payload = NULL;
+        return -1;
+    }
+    ring->tail = start + record.payloadSize;
+    pthread_cond_broadcast(&ring->space);
+    pthread_mutex_unlock(&ring->lock);
+
+    return bytesRead;
+}
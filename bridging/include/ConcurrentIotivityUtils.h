@@ -37,6 +37,7 @@
 #include "WorkQueue.h"
 #include "ocstack.h"
 #include "octypes.h"
+#include "ocpayload.h"
 
 namespace OC
 {
@@ -66,23 +67,23 @@ namespace OC
                 bool m_shutDownOCProcessThread;
                 static const int OCPROCESS_SLEEP_MICROSECONDS = 200000;
 
-                // Fetches work item from queue and processes it.
+                // Fetches all queued work items and processes them under one lock of the
+                // Iotivity API mutex.
                 void processWorkQueue()
                 {
-                    while (true)
-                    {
-                        std::unique_ptr<IotivityWorkItem> workItem;
-                        bool fetchedWorkItem = m_queue->get(&workItem);
+                    std::deque<std::unique_ptr<IotivityWorkItem>> workItems;
 
-                        if (fetchedWorkItem)
+                    while (m_queue->get_all(&workItems))
+                    {
                         {
                             std::lock_guard<std::mutex> lock(m_iotivityApiCallMutex);
-                            workItem->process();
-                        }
-                        else
-                        {
-                            break;
+
+                            for (auto &workItem : workItems)
+                            {
+                                workItem->process();
+                            }
                         }
+                        workItems.clear();
                     }
                 }
 
@@ -187,6 +188,21 @@ namespace OC
                 respondToRequest(OCEntityHandlerRequest *request, OCRepPayload *payload,
                                  OCEntityHandlerResult responseCode);
 
+                /**
+                 * Send a response to a request without copying the payload.
+                 *
+                 * @param[in] request OCEntityHandleRequest type that was handed in the entityhandler.
+                 * @param[in] payload The response payload. Ownership is passed to the worker thread,
+                 *                which frees it after sending the response.
+                 * @param[in] responseCode The response code of type OCEntityHandlerResult in ocstack.h
+                 *
+                 * @return OCStackResult OC_STACK_OK on success, some other value upon failure.
+                 */
+                OCStackResult static
+                respondToRequest(OCEntityHandlerRequest *request,
+                                 std::unique_ptr<OCRepPayload, decltype(OCRepPayloadDestroy) *> payload,
+                                 OCEntityHandlerResult responseCode);
+
                 /**
                  * Respond with an error message. Internally calls
                  * ConcurrentIotivityUtils::respondToRequest() after creating
@@ -109,10 +109,18 @@ namespace OC
                 : m_response(std::move(response))
                 {}
 
+                // The item owns the payload, which is still set if the queue was shut down
+                // before the response was sent.
+                virtual ~SendResponseItem()
+                {
+                    OCPayloadDestroy(m_response->payload);
+                }
+
                 virtual void process()
                 {
                     OCDoResponse((m_response).get());
                     OCPayloadDestroy(m_response->payload);
+                    m_response->payload = NULL;
                 }
 
             private:
@@ -22,7 +22,7 @@
 #ifndef _WORKQUEUE_H_
 #define _WORKQUEUE_H_
 
-#include <queue>
+#include <deque>
 #include <mutex>
 #include <memory>
 #include <condition_variable>
@@ -38,13 +38,16 @@ namespace OC
     {
         /**
          * Provides a generic, minimal thread safe queue.
+         *
+         * A consumer can fetch one item at a time with get() or take everything that
+         * is queued with get_all(), which costs one lock and one wakeup per batch.
          */
         template<class T>
         class WorkQueue
         {
             private:
 
-                std::queue<T> m_workQueue;
+                std::deque<T> m_workQueue;
                 std::mutex m_workQueueMutex;
                 std::condition_variable m_cv;
                 bool m_signalToShutDown;
@@ -57,17 +60,19 @@ namespace OC
                 }
 
                 /**
-                 * Puts the arg in the queue and notifies all threads waiting
+                 * Puts the arg in the queue and wakes up one thread waiting
                  * to fetch things from the queue.
                  *
                  * @para[in] m item The item to insert into the queue.
                  */
                 void put(T item)
                 {
-                    std::unique_lock<std::mutex> lock(m_workQueueMutex);
-
-                    m_workQueue.push(std::move(item));
-                    m_cv.notify_all();
+                    {
+                        std::lock_guard<std::mutex> lock(m_workQueueMutex);
+                        m_workQueue.push_back(std::move(item));
+                    }
+                    // notify after unlocking so the woken thread does not block on the mutex.
+                    m_cv.notify_one();
                 }
 
                 /**
@@ -92,7 +97,34 @@ namespace OC
                     }
 
                     *item = std::move(m_workQueue.front());
-                    m_workQueue.pop();
+                    m_workQueue.pop_front();
+                    return true;
+                }
+
+                /**
+                 * Blocking function to fetch all items in the queue at once.
+                 *
+                 * @param[out] items Receives the queued items in the order they were put.
+                 *                   Anything it held before is discarded.
+                 * @return true if items are fetched from the queue.
+                           false if the queue is shutdown.
+                 */
+                bool get_all(std::deque<T> *items)
+                {
+                    std::unique_lock<std::mutex> lock(m_workQueueMutex);
+
+                    m_cv.wait(lock, [this]()
+                    {
+                        return m_workQueue.size() > 0 || m_signalToShutDown;
+                    });
+
+                    if (m_signalToShutDown)
+                    {
+                        return false;
+                    }
+
+                    items->clear();
+                    items->swap(m_workQueue);
                     return true;
                 }
 
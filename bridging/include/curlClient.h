@@ -28,6 +28,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <functional>
 #include <curl/curl.h>
 #include <stdexcept>
 #include "mpmErrorCode.h"
@@ -43,8 +44,30 @@ namespace OC
 
         const long INVALID_RESPONSE_CODE = 0;
 
+        /**
+         * Outcome of a request sent with CurlClient::sendAsync().
+         */
+        struct CurlResponse
+        {
+            /// MPM_RESULT_OK if the transfer completed, an MPMResult error otherwise.
+            int result;
+
+            long responseCode;
+            std::string body;
+            std::vector<std::string> headers;
+        };
+
+        /**
+         * Completion callback of CurlClient::sendAsync(). It runs on the thread shared by
+         * all requests of the process, so it should hand long work off to another thread.
+         */
+        typedef std::function<void(const CurlResponse &response)> CurlCallback;
+
+        class CurlMultiClient;
+
         class CurlClient
         {
+                friend class CurlMultiClient;
 
             public:
                 enum class CurlMethod
@@ -101,11 +124,26 @@ namespace OC
                     return *this;
                 }
 
-                int send()
-                {
-                    return doInternalRequest(m_url, m_method, m_requestHeaders, m_requestBody, m_username, m_outHeaders,
-                                             m_response);
-                }
+                /**
+                 * Sends the request and waits for the response. Requests of the whole process
+                 * share one pool of keep-alive connections, so polling the same host does not
+                 * pay a new TCP and TLS handshake each time.
+                 *
+                 * @return MPM_RESULT_OK on success, error code otherwise
+                 */
+                int send();
+
+                /**
+                 * Queues the request and returns without waiting for the response. Identical
+                 * GET requests in flight at the same time are sent once and all of their
+                 * callbacks get the same response.
+                 *
+                 * @param[in] callback  Called once with the outcome of the request
+                 *
+                 * @return MPM_RESULT_OK if the request was queued, error code otherwise. The
+                 *         callback is not called if the request was not queued.
+                 */
+                int sendAsync(CurlCallback callback);
 
                 std::string getResponseBody()
                 {
@@ -159,7 +197,7 @@ namespace OC
 
                 } MemoryChunk;
 
-                int decomposeHeader(const char *header, std::vector<std::string> &headers);
+                static int decomposeHeader(const char *header, std::vector<std::string> &headers);
 
 
                 int doInternalRequest(const std::string &url,
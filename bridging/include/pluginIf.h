@@ -33,6 +33,7 @@
 #include <pthread.h>
 #include <stdbool.h>
 #include "messageHandler.h"
+#include "shmHandler.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -46,6 +47,13 @@ struct MPMPipe
 {
     int read_fd;
     int write_fd;
+
+    /**
+     * Shared memory ring carrying the messages when the shared memory transport
+     * is enabled; the pipe then only carries one doorbell byte per message.
+     * NULL when the messages are written to the pipe itself.
+     */
+    MPMShmRing *ring;
 };
 
 /**
@@ -90,6 +98,26 @@ struct MPMCommonPluginCtx
 /** time out value */
 #define MPM_TIMEOUT_VAL_IN_SEC  60
 
+/**
+ * This function writes a message over the pipe, or over its shared memory ring
+ * when it has one
+ * @param[in] pipe          pipe the message is written to
+ * @param[in] pipe_message  message to be written
+ *
+ * @return MPM_RESULT_OK on success, error code on failure
+ */
+MPMResult MPMWriteMessage(const MPMPipe *pipe, const MPMPipeMessage *pipe_message);
+
+/**
+ * This function reads a message from the pipe, or from its shared memory ring
+ * when it has one
+ * @param[in] pipe              pipe the message is read from
+ * @param[in,out] pipe_message  for storing the read message.
+ *
+ * @return number of bytes read
+ */
+ssize_t MPMReadMessage(const MPMPipe *pipe, MPMPipeMessage *pipe_message);
+
 /**
  * This function is a OCF server.  The function does not return unless there is an
  * error or this main thread was signaled by the parent process main thread.
@@ -0,0 +1,94 @@
+//******************************************************************
+//
+// Copyright 2017 Intel Mobile Communications GmbH All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+
+/* This file contains the shared memory transport used between the mini plugin
+ * manager and the plugin processes. The ring is mapped before the fork so both
+ * processes see the same memory; the pipe of the plugin context is only used as
+ * the doorbell, one byte per message, which keeps select() and EOF detection
+ * working exactly as they do for messages written to the pipe. A message larger
+ * than the ring follows its doorbell in the pipe.
+ */
+
+#ifndef _SHMHANDLER_H
+#define _SHMHANDLER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include "messageHandler.h"
+#include "mpmErrorCode.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Size in bytes of the data area of each shared memory ring. */
+#define MPM_SHM_RING_SIZE     (1024 * 1024)
+
+/**
+ * Name of the environment variable enabling the shared memory transport.
+ * The pipes are used for the messages if it is not set.
+ */
+#define MPM_SHM_TRANSPORT_ENV "MPM_SHM_TRANSPORT"
+
+typedef struct MPMShmRing MPMShmRing;
+
+/**
+ * This function maps a ring shared with the processes forked afterwards
+ * @param[in] size  size of the data area of the ring in bytes
+ *
+ * @return the ring on success, NULL on failure
+ */
+MPMShmRing *MPMShmRingCreate(size_t size);
+
+/**
+ * This function unmaps a ring created with MPMShmRingCreate
+ * @param[in] ring  ring to be unmapped, may be NULL
+ */
+void MPMShmRingDestroy(MPMShmRing *ring);
+
+/**
+ * This function copies a message into the ring and rings the doorbell. It waits
+ * up to MPM_TIMEOUT_VAL_IN_SEC seconds for the reader to make room. A message
+ * larger than the ring is written to the pipe after the doorbell instead.
+ * @param[in] ring          ring the message is copied to
+ * @param[in] fd            write end of the doorbell pipe
+ * @param[in] pipe_message  message to be written
+ *
+ * @return MPM_RESULT_OK on success, MPM_RESULT_INTERNAL_ERROR on failure
+ */
+MPMResult MPMShmWriteMessage(MPMShmRing *ring, int fd, const MPMPipeMessage *pipe_message);
+
+/**
+ * This function waits for the doorbell and copies the next message out of the ring
+ * @param[in] ring              ring the message is read from
+ * @param[in] fd                read end of the doorbell pipe
+ * @param[in,out] pipe_message  for storing the read message.
+ *
+ * @return number of bytes read, 0 if the writer closed the pipe, -1 on error
+ */
+ssize_t MPMShmReadMessage(MPMShmRing *ring, int fd, MPMPipeMessage *pipe_message);
+
+#ifdef __cplusplus
+}
+#endif // #ifdef __cplusplus
+
+#endif
@@ -171,7 +171,7 @@ static void *readResponse(void *)
                     pipe_message.payloadSize = 0;
                     pipe_message.msgType = MPM_NOMSG;
                     pipe_message.payload = NULL;
-                    readbytes = MPMReadPipeMessage(ctx->parent_reads_fds.read_fd, &pipe_message);
+                    readbytes = MPMReadMessage(&ctx->parent_reads_fds, &pipe_message);
                     if ((childStat != 0) || (readbytes <= 0))
                     {
                         OIC_LOG_V(DEBUG, TAG, "Plugin %s is exited",
@@ -419,7 +419,7 @@ MPMResult MPMSendPipeMessage(MPMPluginHandle pluginHandle, MPMMessage message, s
         pipe_message.payloadSize = size;
         pipe_message.payload = (uint8_t *)message;
         MPMCommonPluginCtx *ctx = (MPMCommonPluginCtx *) (plugin_instance->plugin_ctx);
-        result = MPMWritePipeMessage(ctx->child_reads_fds.write_fd, &pipe_message);
+        result = MPMWriteMessage(&ctx->child_reads_fds, &pipe_message);
 
         pipe_message.msgType = MPM_NOMSG;
         pipe_message.payloadSize = 0;
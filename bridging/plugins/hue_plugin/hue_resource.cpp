@@ -785,7 +785,12 @@ OCEntityHandlerResult handleEntityHandlerRequests(
                  return OC_EH_OK;
         }
         responsePayload = getCommonPayload(uri.c_str(),interfaceQuery, resourceType, payload);
-        ConcurrentIotivityUtils::respondToRequest(entityHandlerRequest, responsePayload, ehResult);
+
+        // The response owns the payload from here on.
+        std::unique_ptr<OCRepPayload, decltype(OCRepPayloadDestroy) *> response {
+            responsePayload, OCRepPayloadDestroy};
+        responsePayload = NULL;
+        ConcurrentIotivityUtils::respondToRequest(entityHandlerRequest, std::move(response), ehResult);
         OICFree(dupQuery);
     }
     catch (const char *errorMessage)
@@ -630,9 +630,9 @@ OCEntityHandlerResult resourceEntityHandler(OCEntityHandlerFlag ,
                 return OC_EH_OK;
         }
 
-        OCRepPayload *responsePayload = processGetRequest(targetLight, callBackParamResourceType);
-        ConcurrentIotivityUtils::respondToRequest(request, responsePayload, result);
-        OCRepPayloadDestroy(responsePayload);
+        std::unique_ptr<OCRepPayload, decltype(OCRepPayloadDestroy) *> responsePayload {
+            processGetRequest(targetLight, callBackParamResourceType), OCRepPayloadDestroy};
+        ConcurrentIotivityUtils::respondToRequest(request, std::move(responsePayload), result);
     }
     catch (const std::exception &exp)
     {
@@ -494,10 +494,10 @@ resourceEntityHandlerCb(OCEntityHandlerFlag, OCEntityHandlerRequest *request, vo
         }
 
         targetThermostat->get(data);
-        OCRepPayload *payload = getPayload(uri.c_str(), data);
+        std::unique_ptr<OCRepPayload, decltype(OCRepPayloadDestroy) *> payload {
+            getPayload(uri.c_str(), data), OCRepPayloadDestroy};
 
-        ConcurrentIotivityUtils::respondToRequest(request, payload, result);
-        OCRepPayloadDestroy(payload);
+        ConcurrentIotivityUtils::respondToRequest(request, std::move(payload), result);
     }
 
     catch (std::string errorMessage)
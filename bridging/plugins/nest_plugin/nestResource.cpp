@@ -802,9 +802,10 @@ OCEntityHandlerResult resourceEntityHandlerCb(OCEntityHandlerFlag,
                 return OC_EH_OK;
         }
 
-        OCRepPayload *responsePayload = processGetRequest(targetThermostat);
-        ConcurrentIotivityUtils::respondToRequest(entityHandlerRequest, responsePayload, result);
-        OCRepPayloadDestroy(responsePayload);
+        std::unique_ptr<OCRepPayload, decltype(OCRepPayloadDestroy) *> responsePayload {
+            processGetRequest(targetThermostat), OCRepPayloadDestroy};
+        ConcurrentIotivityUtils::respondToRequest(entityHandlerRequest, std::move(responsePayload),
+                result);
     }
     catch (const std::exception &exp)
     {
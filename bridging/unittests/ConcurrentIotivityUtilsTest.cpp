@@ -0,0 +1,213 @@
+//******************************************************************
+//
+// Copyright 2017 Intel Mobile Communications GmbH All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "ConcurrentIotivityUtils.h"
+
+using namespace OC::Bridging;
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+    typedef WorkQueue<std::unique_ptr<IotivityWorkItem>> IotivityWorkQueue;
+
+    class CountingItem : public IotivityWorkItem
+    {
+        public:
+            CountingItem(std::atomic<size_t> &count) : m_count(count) {}
+
+            virtual void process()
+            {
+                m_count++;
+            }
+
+        private:
+            std::atomic<size_t> &m_count;
+    };
+
+    bool waitFor(const std::atomic<size_t> &counter, size_t count)
+    {
+        auto deadline = Clock::now() + std::chrono::seconds(30);
+        while (counter < count)
+        {
+            if (Clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    double itemsPerSecond(size_t count, Clock::time_point start)
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                           Clock::now() - start).count();
+        return elapsed ? (count * 1000000.0) / elapsed : 0;
+    }
+
+    OCRepPayload *createResponsePayload()
+    {
+        OCRepPayload *payload = OCRepPayloadCreate();
+        OCRepPayloadSetUri(payload, "/hue/light/1");
+        OCRepPayloadAddResourceType(payload, "oic.r.switch.binary");
+        OCRepPayloadAddResourceType(payload, "oic.r.light.brightness");
+        OCRepPayloadAddInterface(payload, "oic.if.a");
+        OCRepPayloadSetPropBool(payload, "value", true);
+        OCRepPayloadSetPropInt(payload, "brightness", 75);
+        OCRepPayloadSetPropString(payload, "name", "Living room lamp");
+        return payload;
+    }
+}
+
+TEST(WorkQueueTest, GetReturnsItemsInOrder)
+{
+    WorkQueue<int> queue;
+    queue.put(1);
+    queue.put(2);
+
+    int item = 0;
+    EXPECT_TRUE(queue.get(&item));
+    EXPECT_EQ(1, item);
+    EXPECT_TRUE(queue.get(&item));
+    EXPECT_EQ(2, item);
+}
+
+TEST(WorkQueueTest, GetAllDrainsQueueInOrder)
+{
+    WorkQueue<int> queue;
+    for (int i = 0; i < 10; ++i)
+    {
+        queue.put(i);
+    }
+
+    std::deque<int> items = { 42 };
+    EXPECT_TRUE(queue.get_all(&items));
+    ASSERT_EQ(10u, items.size());
+    for (int i = 0; i < 10; ++i)
+    {
+        EXPECT_EQ(i, items[i]);
+    }
+
+    queue.put(10);
+    EXPECT_TRUE(queue.get_all(&items));
+    ASSERT_EQ(1u, items.size());
+    EXPECT_EQ(10, items[0]);
+}
+
+TEST(WorkQueueTest, ShutdownWakesWaitingConsumer)
+{
+    WorkQueue<int> queue;
+    std::atomic<bool> fetched(true);
+
+    std::thread consumer([&queue, &fetched]()
+    {
+        std::deque<int> items;
+        fetched = queue.get_all(&items);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    queue.shutdown();
+    consumer.join();
+
+    EXPECT_FALSE(fetched);
+}
+
+// Queue work items from several threads the way plugins do while they discover
+// devices and log how many items/sec the worker thread gets through.
+TEST(ConcurrentIotivityUtilsTest, QueueThroughputBenchmark)
+{
+    const size_t producerCount = 4;
+    const size_t itemsPerProducer = 50000;
+    std::atomic<size_t> processed(0);
+
+    IotivityWorkQueue *queue = new IotivityWorkQueue();
+    ConcurrentIotivityUtils utils{std::unique_ptr<IotivityWorkQueue>(queue)};
+    utils.startWorkerThreads();
+
+    auto start = Clock::now();
+    std::vector<std::thread> producers;
+    for (size_t i = 0; i < producerCount; ++i)
+    {
+        producers.push_back(std::thread([queue, &processed, itemsPerProducer]()
+        {
+            for (size_t j = 0; j < itemsPerProducer; ++j)
+            {
+                queue->put(OC::Bridging::make_unique<CountingItem>(processed));
+            }
+        }));
+    }
+    for (auto &producer : producers)
+    {
+        producer.join();
+    }
+
+    EXPECT_TRUE(waitFor(processed, producerCount * itemsPerProducer));
+    std::cout << "work items: " << itemsPerSecond(producerCount * itemsPerProducer, start)
+              << " items/sec" << std::endl;
+
+    utils.stopWorkerThreads();
+}
+
+// Responses that are cloned before queueing against responses that hand their
+// payload to the worker thread.
+TEST(ConcurrentIotivityUtilsTest, RespondToRequestBenchmark)
+{
+    const size_t count = 20000;
+    std::atomic<size_t> processed(0);
+    OCEntityHandlerRequest request = OCEntityHandlerRequest();
+
+    IotivityWorkQueue *queue = new IotivityWorkQueue();
+    ConcurrentIotivityUtils utils{std::unique_ptr<IotivityWorkQueue>(queue)};
+    utils.startWorkerThreads();
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        OCRepPayload *payload = createResponsePayload();
+        EXPECT_EQ(OC_STACK_OK, ConcurrentIotivityUtils::respondToRequest(&request, payload,
+                  OC_EH_OK));
+        OCRepPayloadDestroy(payload);
+    }
+    queue->put(OC::Bridging::make_unique<CountingItem>(processed));
+    EXPECT_TRUE(waitFor(processed, 1));
+    std::cout << "cloned responses: " << itemsPerSecond(count, start) << " items/sec"
+              << std::endl;
+
+    start = Clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::unique_ptr<OCRepPayload, decltype(OCRepPayloadDestroy) *> payload {
+            createResponsePayload(), OCRepPayloadDestroy};
+        EXPECT_EQ(OC_STACK_OK, ConcurrentIotivityUtils::respondToRequest(&request,
+                  std::move(payload), OC_EH_OK));
+    }
+    queue->put(OC::Bridging::make_unique<CountingItem>(processed));
+    EXPECT_TRUE(waitFor(processed, 2));
+    std::cout << "moved responses: " << itemsPerSecond(count, start) << " items/sec"
+              << std::endl;
+
+    utils.stopWorkerThreads();
+}
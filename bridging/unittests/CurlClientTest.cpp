@@ -0,0 +1,319 @@
+//******************************************************************
+//
+// Copyright 2017 Intel Mobile Communications GmbH All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <gtest/gtest.h>
+#include "curlClient.h"
+
+using namespace OC::Bridging;
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const char RESPONSE_BODY[] = "{\"on\":true}";
+
+    // HTTP/1.1 server on the loopback interface which keeps connections alive and
+    // counts the connections and requests it gets.
+    class StubHttpServer
+    {
+        public:
+            StubHttpServer(int delayMs = 0) :
+                m_listenFd(-1), m_port(0), m_delayMs(delayMs), m_stop(false),
+                m_connections(0), m_requests(0)
+            {
+                struct sockaddr_in addr;
+                socklen_t len = sizeof(addr);
+
+                memset(&addr, 0, sizeof(addr));
+                addr.sin_family = AF_INET;
+                addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                addr.sin_port = 0;
+
+                m_listenFd = socket(AF_INET, SOCK_STREAM, 0);
+                if (m_listenFd < 0 ||
+                    bind(m_listenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+                    listen(m_listenFd, 16) != 0 ||
+                    getsockname(m_listenFd, (struct sockaddr *)&addr, &len) != 0)
+                {
+                    return;
+                }
+                m_port = ntohs(addr.sin_port);
+                m_acceptThread = std::thread(&StubHttpServer::acceptConnections, this);
+            }
+
+            ~StubHttpServer()
+            {
+                m_stop = true;
+                shutdown(m_listenFd, SHUT_RDWR);
+                close(m_listenFd);
+                if (m_acceptThread.joinable())
+                {
+                    m_acceptThread.join();
+                }
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (int fd : m_connectionFds)
+                {
+                    shutdown(fd, SHUT_RDWR);
+                }
+                for (std::thread &thread : m_connectionThreads)
+                {
+                    thread.join();
+                }
+                for (int fd : m_connectionFds)
+                {
+                    close(fd);
+                }
+            }
+
+            std::string url(const std::string &path) const
+            {
+                return "http://127.0.0.1:" + std::to_string(m_port) + path;
+            }
+
+            size_t connections() const
+            {
+                return m_connections;
+            }
+
+            size_t requests() const
+            {
+                return m_requests;
+            }
+
+        private:
+            void acceptConnections()
+            {
+                while (!m_stop)
+                {
+                    int fd = accept(m_listenFd, NULL, NULL);
+                    if (fd < 0)
+                    {
+                        break;
+                    }
+                    m_connections++;
+
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_connectionFds.push_back(fd);
+                    m_connectionThreads.push_back(std::thread(&StubHttpServer::serve, this, fd));
+                }
+            }
+
+            void serve(int fd)
+            {
+                std::string buffer;
+                char chunk[1024];
+
+                while (!m_stop)
+                {
+                    size_t end = buffer.find("\r\n\r\n");
+                    if (end == std::string::npos)
+                    {
+                        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+                        if (received <= 0)
+                        {
+                            return;
+                        }
+                        buffer.append(chunk, received);
+                        continue;
+                    }
+
+                    size_t bodyLength = 0;
+                    const char *length = strcasestr(buffer.substr(0, end).c_str(), "content-length:");
+                    if (length)
+                    {
+                        bodyLength = strtoul(length + strlen("content-length:"), NULL, 10);
+                    }
+                    while (buffer.size() < end + 4 + bodyLength)
+                    {
+                        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+                        if (received <= 0)
+                        {
+                            return;
+                        }
+                        buffer.append(chunk, received);
+                    }
+                    buffer.erase(0, end + 4 + bodyLength);
+                    m_requests++;
+
+                    std::this_thread::sleep_for(std::chrono::milliseconds(m_delayMs));
+
+                    std::string response = "HTTP/1.1 200 OK\r\n"
+                                           "Content-Type: application/json\r\n"
+                                           "Content-Length: " + std::to_string(strlen(RESPONSE_BODY)) +
+                                           "\r\n\r\n" + RESPONSE_BODY;
+                    if (::send(fd, response.c_str(), response.size(), MSG_NOSIGNAL) < 0)
+                    {
+                        return;
+                    }
+                }
+            }
+
+            int m_listenFd;
+            uint16_t m_port;
+            int m_delayMs;
+            std::atomic<bool> m_stop;
+            std::atomic<size_t> m_connections;
+            std::atomic<size_t> m_requests;
+            std::thread m_acceptThread;
+            std::mutex m_mutex;
+            std::vector<int> m_connectionFds;
+            std::vector<std::thread> m_connectionThreads;
+    };
+
+    bool waitFor(const std::atomic<size_t> &counter, size_t count)
+    {
+        auto deadline = Clock::now() + std::chrono::seconds(30);
+        while (counter < count)
+        {
+            if (Clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+}
+
+TEST(CurlClientTest, SendReturnsResponse)
+{
+    StubHttpServer server;
+
+    CurlClient cc = CurlClient(CurlClient::CurlMethod::GET, server.url("/lights/1"))
+                    .addRequestHeader(CURL_HEADER_ACCEPT_JSON);
+
+    EXPECT_EQ(MPM_RESULT_OK, cc.send());
+    EXPECT_EQ(200, cc.getLastResponseCode());
+    EXPECT_EQ(RESPONSE_BODY, cc.getResponseBody());
+    ASSERT_FALSE(cc.getResponseHeaders().empty());
+    EXPECT_EQ("HTTP/1.1 200 OK", cc.getResponseHeaders()[0]);
+}
+
+TEST(CurlClientTest, SequentialRequestsReuseConnection)
+{
+    StubHttpServer server;
+
+    for (int i = 0; i < 5; ++i)
+    {
+        std::string body = "{\"on\":false}";
+        CurlClient cc = CurlClient(CurlClient::CurlMethod::PUT, server.url("/lights/1/state"))
+                        .addRequestHeader(CURL_CONTENT_TYPE_JSON)
+                        .setRequestBody(body);
+        EXPECT_EQ(MPM_RESULT_OK, cc.send());
+    }
+
+    EXPECT_EQ(5u, server.requests());
+    EXPECT_EQ(1u, server.connections());
+}
+
+TEST(CurlClientTest, SendAsyncCallsBack)
+{
+    StubHttpServer server;
+    std::atomic<size_t> completed(0);
+    CurlResponse received;
+
+    CurlClient cc = CurlClient(CurlClient::CurlMethod::GET, server.url("/lights"));
+    EXPECT_EQ(MPM_RESULT_OK, cc.sendAsync([&](const CurlResponse & response)
+    {
+        received = response;
+        completed++;
+    }));
+
+    ASSERT_TRUE(waitFor(completed, 1));
+    EXPECT_EQ(MPM_RESULT_OK, received.result);
+    EXPECT_EQ(200, received.responseCode);
+    EXPECT_EQ(RESPONSE_BODY, received.body);
+}
+
+TEST(CurlClientTest, IdenticalConcurrentGetsAreCoalesced)
+{
+    const size_t count = 10;
+    StubHttpServer server(200);
+    std::atomic<size_t> completed(0);
+    std::atomic<size_t> matching(0);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        CurlClient cc = CurlClient(CurlClient::CurlMethod::GET, server.url("/lights"));
+        EXPECT_EQ(MPM_RESULT_OK, cc.sendAsync([&](const CurlResponse & response)
+        {
+            if (response.result == MPM_RESULT_OK && response.body == RESPONSE_BODY)
+            {
+                matching++;
+            }
+            completed++;
+        }));
+    }
+
+    ASSERT_TRUE(waitFor(completed, count));
+    EXPECT_EQ(count, matching);
+    EXPECT_EQ(1u, server.requests());
+}
+
+TEST(CurlClientTest, PutsAreNotCoalesced)
+{
+    const size_t count = 3;
+    StubHttpServer server(100);
+    std::atomic<size_t> completed(0);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::string body = "{\"on\":true}";
+        CurlClient cc = CurlClient(CurlClient::CurlMethod::PUT, server.url("/lights/1/state"))
+                        .setRequestBody(body);
+        EXPECT_EQ(MPM_RESULT_OK, cc.sendAsync([&](const CurlResponse &)
+        {
+            completed++;
+        }));
+    }
+
+    ASSERT_TRUE(waitFor(completed, count));
+    EXPECT_EQ(count, server.requests());
+}
+
+TEST(CurlClientTest, SendReportsNetworkError)
+{
+    uint16_t port = 0;
+    {
+        // Take a free port and release it again so nothing listens on it.
+        StubHttpServer server;
+        port = (uint16_t)std::stoi(server.url("").substr(strlen("http://127.0.0.1:")));
+    }
+
+    CurlClient cc = CurlClient(CurlClient::CurlMethod::GET,
+                               "http://127.0.0.1:" + std::to_string(port) + "/lights");
+
+    EXPECT_EQ(MPM_RESULT_NETWORK_ERROR, cc.send());
+    EXPECT_EQ(INVALID_RESPONSE_CODE, cc.getLastResponseCode());
+}
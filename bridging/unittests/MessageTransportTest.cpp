@@ -0,0 +1,237 @@
+//******************************************************************
+//
+// Copyright 2017 Intel Mobile Communications GmbH All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <string.h>
+#include <unistd.h>
+#include <gtest/gtest.h>
+#include "oic_malloc.h"
+#include "pluginIf.h"
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    class MessageTransportTest : public ::testing::Test
+    {
+        protected:
+            virtual void SetUp()
+            {
+                int fds[2];
+                ASSERT_EQ(0, pipe(fds));
+                m_pipe.read_fd = fds[0];
+                m_pipe.write_fd = fds[1];
+                m_pipe.ring = NULL;
+            }
+
+            virtual void TearDown()
+            {
+                if (m_pipe.write_fd >= 0)
+                {
+                    close(m_pipe.write_fd);
+                }
+                close(m_pipe.read_fd);
+                MPMShmRingDestroy(m_pipe.ring);
+            }
+
+            void closeWriteEnd()
+            {
+                close(m_pipe.write_fd);
+                m_pipe.write_fd = -1;
+            }
+
+            // Sends count messages from another thread and logs how many
+            // messages/sec and MB/sec the reader gets through.
+            void benchmark(const char *name, size_t count, size_t payloadSize)
+            {
+                std::vector<uint8_t> payload(payloadSize, 0x5a);
+                MPMPipe *pipe = &m_pipe;
+
+                auto start = Clock::now();
+                std::thread writer([pipe, &payload, count]()
+                {
+                    MPMPipeMessage message;
+                    message.msgType = MPM_SCAN;
+                    message.payloadSize = payload.size();
+                    message.payload = payload.data();
+
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        EXPECT_EQ(MPM_RESULT_OK, MPMWriteMessage(pipe, &message));
+                    }
+                });
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    MPMPipeMessage message = { 0, MPM_NOMSG, NULL };
+                    ASSERT_GT(MPMReadMessage(pipe, &message), 0);
+                    ASSERT_EQ(payloadSize, message.payloadSize);
+                    OICFree((void *)message.payload);
+                }
+                writer.join();
+
+                auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                                   Clock::now() - start).count();
+                if (elapsed)
+                {
+                    std::cout << name << " (" << payloadSize << " byte payloads): "
+                              << (count * 1000000.0) / elapsed << " messages/sec, "
+                              << (count * payloadSize) / (double)elapsed << " MB/sec"
+                              << std::endl;
+                }
+            }
+
+            MPMPipe m_pipe;
+    };
+
+    void expectRoundTrip(MPMPipe *pipe, MPMMessageType type, const char *payload)
+    {
+        MPMPipeMessage sent;
+        sent.msgType = type;
+        sent.payloadSize = payload ? strlen(payload) + 1 : 0;
+        sent.payload = (const uint8_t *)payload;
+        ASSERT_EQ(MPM_RESULT_OK, MPMWriteMessage(pipe, &sent));
+
+        MPMPipeMessage received = { 0, MPM_NOMSG, NULL };
+        EXPECT_GT(MPMReadMessage(pipe, &received), 0);
+        EXPECT_EQ(type, received.msgType);
+        ASSERT_EQ(sent.payloadSize, received.payloadSize);
+        if (payload)
+        {
+            EXPECT_STREQ(payload, (const char *)received.payload);
+        }
+        OICFree((void *)received.payload);
+    }
+}
+
+TEST_F(MessageTransportTest, RoundTripOverPipe)
+{
+    expectRoundTrip(&m_pipe, MPM_ADD, "{\"uri\":\"/hue/light/1\"}");
+    expectRoundTrip(&m_pipe, MPM_STOP, NULL);
+}
+
+TEST_F(MessageTransportTest, RoundTripOverSharedMemory)
+{
+    m_pipe.ring = MPMShmRingCreate(MPM_SHM_RING_SIZE);
+    ASSERT_NE((MPMShmRing *)NULL, m_pipe.ring);
+
+    expectRoundTrip(&m_pipe, MPM_ADD, "{\"uri\":\"/hue/light/1\"}");
+    expectRoundTrip(&m_pipe, MPM_STOP, NULL);
+}
+
+TEST_F(MessageTransportTest, SharedMemoryWrapsAround)
+{
+    m_pipe.ring = MPMShmRingCreate(256);
+    ASSERT_NE((MPMShmRing *)NULL, m_pipe.ring);
+
+    std::string payload;
+    for (size_t i = 0; i < 500; ++i)
+    {
+        payload.assign(i % 200, (char)('a' + i % 26));
+        expectRoundTrip(&m_pipe, MPM_SCAN, payload.c_str());
+    }
+}
+
+TEST_F(MessageTransportTest, SharedMemoryWaitsForRoom)
+{
+    m_pipe.ring = MPMShmRingCreate(256);
+    ASSERT_NE((MPMShmRing *)NULL, m_pipe.ring);
+
+    benchmark("shared memory, small ring", 10000, 100);
+}
+
+TEST_F(MessageTransportTest, SharedMemorySendsOversizedMessageInline)
+{
+    m_pipe.ring = MPMShmRingCreate(64);
+    ASSERT_NE((MPMShmRing *)NULL, m_pipe.ring);
+
+    std::string payload(100, 'x');
+    expectRoundTrip(&m_pipe, MPM_SCAN, payload.c_str());
+    expectRoundTrip(&m_pipe, MPM_ADD, "{}");
+}
+
+TEST_F(MessageTransportTest, SharedMemoryKeepsOrderWithInlineMessages)
+{
+    m_pipe.ring = MPMShmRingCreate(256);
+    ASSERT_NE((MPMShmRing *)NULL, m_pipe.ring);
+
+    // larger than the pipe buffer, so the reader has to run meanwhile.
+    const size_t sizes[] = { 16, 512 * 1024, 16, 200, 16 };
+    const size_t count = sizeof(sizes) / sizeof(sizes[0]);
+    MPMPipe *pipe = &m_pipe;
+
+    std::thread writer([pipe, &sizes, count]()
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            std::vector<uint8_t> payload(sizes[i], (uint8_t)i);
+            MPMPipeMessage message;
+            message.msgType = MPM_SCAN;
+            message.payloadSize = payload.size();
+            message.payload = payload.data();
+            EXPECT_EQ(MPM_RESULT_OK, MPMWriteMessage(pipe, &message));
+        }
+    });
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        MPMPipeMessage message = { 0, MPM_NOMSG, NULL };
+        EXPECT_GT(MPMReadMessage(pipe, &message), 0);
+        EXPECT_EQ(MPM_SCAN, message.msgType);
+        EXPECT_EQ(sizes[i], message.payloadSize);
+        if (message.payload)
+        {
+            EXPECT_EQ((uint8_t)i, message.payload[0]);
+            EXPECT_EQ((uint8_t)i, message.payload[message.payloadSize - 1]);
+        }
+        OICFree((void *)message.payload);
+    }
+    writer.join();
+}
+
+TEST_F(MessageTransportTest, SharedMemoryReportsClosedPipe)
+{
+    m_pipe.ring = MPMShmRingCreate(MPM_SHM_RING_SIZE);
+    ASSERT_NE((MPMShmRing *)NULL, m_pipe.ring);
+
+    closeWriteEnd();
+
+    MPMPipeMessage message = { 0, MPM_NOMSG, NULL };
+    EXPECT_EQ(0, MPMReadMessage(&m_pipe, &message));
+}
+
+TEST_F(MessageTransportTest, PipeThroughputBenchmark)
+{
+    benchmark("pipe", 20000, 64);
+    benchmark("pipe", 20000, 4000);
+}
+
+TEST_F(MessageTransportTest, SharedMemoryThroughputBenchmark)
+{
+    m_pipe.ring = MPMShmRingCreate(MPM_SHM_RING_SIZE);
+    ASSERT_NE((MPMShmRing *)NULL, m_pipe.ring);
+
+    benchmark("shared memory", 20000, 64);
+    benchmark("shared memory", 20000, 4000);
+}
@@ -48,6 +48,13 @@ extern "C"
 // Typedefs
 //-----------------------------------------------------------------------------
 
+/**
+ * Called after each successful allocation by OICMalloc, OICCalloc and OICRealloc.
+ *
+ * @param size - Size of the allocated memory block in bytes
+ */
+typedef void (*OICAllocationHook)(size_t size);
+
 //-----------------------------------------------------------------------------
 // Function prototypes
 //-----------------------------------------------------------------------------
@@ -120,6 +127,17 @@ void OICFreeAndSetToNull(void **ptr);
  */
 void OICFree(void *ptr);
 
+/**
+ * Sets a function to be called after each successful allocation, e.g. to count
+ * allocations in tests and benchmarks.
+ *
+ * NOTE: The hook is not synchronized with allocations on other threads; set it
+ *       while no other thread allocates.
+ *
+ * @param hook - Function to call, or NULL to remove the hook.
+ */
+void OICSetAllocationHook(OICAllocationHook hook);
+
 /**
  * Securely zero the contents of a memory buffer in a way that won't be
  * optimized out by the compiler. Do not use memset for this purpose, because
@@ -43,6 +43,7 @@
 //-----------------------------------------------------------------------------
 // Private variables
 //-----------------------------------------------------------------------------
+static OICAllocationHook g_allocationHook = NULL;
 
 //-----------------------------------------------------------------------------
 // Macros
@@ -63,6 +64,11 @@
 static uint32_t count;
 #endif
 
+void OICSetAllocationHook(OICAllocationHook hook)
+{
+    g_allocationHook = hook;
+}
+
 void *OICMalloc(size_t size)
 {
     if (0 == size)
@@ -70,17 +76,20 @@ void *OICMalloc(size_t size)
         return NULL;
     }
 
-#ifdef ENABLE_MALLOC_DEBUG
     void *ptr = malloc(size);
+    if (ptr && g_allocationHook)
+    {
+        g_allocationHook(size);
+    }
+
+#ifdef ENABLE_MALLOC_DEBUG
     if (ptr)
     {
         count++;
     }
     OIC_LOG_V(INFO, TAG, "malloc: ptr=%p, size=%u, count=%u", ptr, size, count);
-    return ptr;
-#else
-    return malloc(size);
 #endif
+    return ptr;
 }
 
 void *OICCalloc(size_t num, size_t size)
@@ -90,17 +99,20 @@ void *OICCalloc(size_t num, size_t size)
         return NULL;
     }
 
-#ifdef ENABLE_MALLOC_DEBUG
     void *ptr = calloc(num, size);
+    if (ptr && g_allocationHook)
+    {
+        g_allocationHook(num * size);
+    }
+
+#ifdef ENABLE_MALLOC_DEBUG
     if (ptr)
     {
         count++;
     }
     OIC_LOG_V(INFO, TAG, "calloc: ptr=%p, num=%u, size=%u, count=%u", ptr, num, size, count);
-    return ptr;
-#else
-    return calloc(num, size);
 #endif
+    return ptr;
 }
 
 void *OICRealloc(void* ptr, size_t size)
@@ -115,15 +127,18 @@ void *OICRealloc(void* ptr, size_t size)
 
     // Otherwise leave the behavior up to realloc() itself:
 
-#ifdef ENABLE_MALLOC_DEBUG
     void* newptr = realloc(ptr, size);
+    if (newptr && g_allocationHook)
+    {
+        g_allocationHook(size);
+    }
+
+#ifdef ENABLE_MALLOC_DEBUG
     OIC_LOG_V(INFO, TAG, "realloc: ptr=%p, newptr=%p, size=%u", ptr, newptr, size);
+#endif
     // Very important to return the correct pointer here, as it only *somtimes*
     // differs and thus can be hard to notice/test:
     return newptr;
-#else
-    return realloc(ptr, size);
-#endif
 }
 
 void OICFreeAndSetToNull(void **ptr)
@@ -33,6 +33,9 @@
 #include "cacommon.h"
 #include "casecurityinterface.h"
 
+/** see ocevent.h */
+struct oc_event_t;
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -231,6 +234,61 @@ CATransportAdapter_t CAGetSelectedNetwork();
  */
 CAResult_t CAHandleRequestResponse();
 
+#ifndef SINGLE_THREAD
+/**
+ * Set the number of worker threads that handle received requests and responses.
+ * With workers, received data is delivered from these threads instead of
+ * ::CAHandleRequestResponse. Data from the same endpoint with the same token
+ * is always delivered in order by the same worker.
+ * It must be called before ::CAInitialize.
+ *
+ * @param[in]   count     number of workers, 0 to deliver from ::CAHandleRequestResponse.
+ *
+ * @return  ::CA_STATUS_OK or ::CA_STATUS_INVALID_PARAM or ::CA_STATUS_FAILED
+ */
+CAResult_t CASetReceiveWorkerCount(uint8_t count);
+
+/**
+ * Register an event that is signaled whenever received data is waiting for
+ * ::CAHandleRequestResponse, so the caller can block on the event instead of
+ * polling. Several events may be registered, all of them are signaled.
+ * The event must stay valid until it is unregistered.
+ *
+ * @param[in]   event     event created with oc_event_new().
+ *
+ * @return  ::CA_STATUS_OK or ::CA_STATUS_INVALID_PARAM or ::CA_MEMORY_ALLOC_FAILED
+ */
+CAResult_t CARegisterProcessEvent(struct oc_event_t *event);
+
+/**
+ * Unregister an event registered with ::CARegisterProcessEvent.
+ *
+ * @param[in]   event     event to unregister.
+ */
+void CAUnregisterProcessEvent(struct oc_event_t *event);
+#endif
+
+/**
+ * Set how long received requests are remembered to filter out duplicates.
+ * The default is EXCHANGE_LIFETIME of RFC 7252 (247 seconds).
+ *
+ * @param[in]   lifetime  lifetime in milliseconds.
+ *
+ * @return  ::CA_STATUS_OK or ::CA_STATUS_INVALID_PARAM
+ */
+CAResult_t CASetExchangeLifetime(uint32_t lifetime);
+
+/**
+ * Get the number of received requests found to be duplicates (hits) and
+ * not found to be duplicates (misses) since ::CAInitialize.
+ *
+ * @param[out]  hits      number of duplicates dropped.
+ * @param[out]  misses    number of requests passed on.
+ *
+ * @return  ::CA_STATUS_OK or ::CA_STATUS_INVALID_PARAM
+ */
+CAResult_t CAGetDuplicateFilterStats(uint32_t *hits, uint32_t *misses);
+
 #ifdef RA_ADAPTER
 /**
  * Set Remote Access information for XMPP Client.
@@ -161,6 +161,14 @@ typedef void (*CAgetPkixInfoHandler)(PkiInfo_t * inf);
  */
 CAResult_t CAregisterPkixInfoHandler(CAgetPkixInfoHandler getPkixInfoHandler);
 
+/**
+ * Notify that the info returned by the PKIX info callback changed.
+ * The certificates, private key and CRL are parsed once and reused for all handshakes
+ * until this is called.
+ * @return  ::CA_STATUS_OK or appropriate error code.
+ */
+CAResult_t CAinvalidatePkixInfo();
+
 /**
  * Select the cipher suite for dtls handshake.
  *
@@ -195,6 +203,47 @@ CAResult_t CASelectCipherSuite(const uint16_t cipher, CATransportAdapter_t adapt
  */
 CAResult_t CAEnableAnonECDHCipherSuite(const bool enable);
 
+/**
+ * Session resumption modes, see CASetSessionResumption().
+ */
+typedef enum
+{
+    CA_SESSION_RESUMPTION_NONE = 0,             /**< Always do a full handshake. */
+    CA_SESSION_RESUMPTION_CACHE = (1 << 0),     /**< Resume by session ID, server keeps state. */
+    CA_SESSION_RESUMPTION_TICKETS = (1 << 1)    /**< Resume by RFC 5077 session ticket. */
+} CASessionResumption_t;
+
+/**
+ * Enable or disable resumption of (D)TLS sessions for a transport adapter.
+ * Sessions established with a certificate based cipher suite are kept by the client,
+ * keyed by the device ID (or the address) of the server, and by the server in a
+ * session cache or a session ticket. Sessions of PSK and anonymous cipher suites are
+ * never resumed. All kept sessions are dropped when the credentials change.
+ *
+ * @param[in] adapter  transport adapter (TCP/IP/BLE)
+ * @param[in] modes    bitwise OR of ::CASessionResumption_t values.
+ *
+ * @retval  ::CA_STATUS_OK    Successful.
+ * @retval  ::CA_STATUS_INVALID_PARAM  Invalid input arguments.
+ * @retval  ::CA_STATUS_FAILED Operation failed.
+ *
+ * @note IP and BLE share the DTLS server configuration, the server side resumes sessions
+ *       on both of them if it is enabled for one.
+ */
+CAResult_t CASetSessionResumption(CATransportAdapter_t adapter, uint32_t modes);
+
+/**
+ * Get the number of full and of resumed (D)TLS handshakes completed so far.
+ *
+ * @param[out] full     number of full handshakes.
+ * @param[out] resumed  number of abbreviated handshakes which resumed a session.
+ *
+ * @retval  ::CA_STATUS_OK    Successful.
+ * @retval  ::CA_STATUS_INVALID_PARAM  Invalid input arguments.
+ * @retval  ::CA_STATUS_FAILED Operation failed.
+ */
+CAResult_t CAGetHandshakeStats(uint32_t *full, uint32_t *resumed);
+
 
 /**
  * Generate ownerPSK using PRF.
@@ -85,7 +85,7 @@ LOCAL_C_INCLUDES += $(OIC_C_COMMON_PATH)/oic_malloc/include
 LOCAL_C_INCLUDES += $(OIC_C_COMMON_PATH)/oic_string/include
 
 LOCAL_SRC_FILES =       oic_logger.c oic_console_logger.c logger.c \
-                        uarraylist.c uqueue.c \
+                        uarraylist.c uhashmap.c uqueue.c \
                         cathreadpool_pthreads.c camutex_pthreads.c \
                         caremotehandler.c
 
@@ -113,6 +113,15 @@ bool u_arraylist_add(u_arraylist_t *list, void *data);
  */
 void *u_arraylist_remove(u_arraylist_t *list, size_t index);
 
+/**
+ * Remove the data of the index from the array list in constant time. The last
+ * element is moved to the index, so the order of the elements is not kept.
+ * @param[in] list       pointer of array list.
+ * @param[in] index      index of array list.
+ * @return void pointer of the data if success or NULL pointer otherwise.
+ */
+void *u_arraylist_swap_remove(u_arraylist_t *list, size_t index);
+
 /**
  * Returns the length of the array list.
  * @param[in] list       pointer of array list.
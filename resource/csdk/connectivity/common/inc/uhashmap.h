@@ -0,0 +1,155 @@
+/* ****************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+/**
+ * @file
+ *
+ * This file contains the APIs for a byte-keyed hash map.
+ *
+ * Keys are arbitrary byte sequences and are copied into the map, so the
+ * caller does not need to keep them alive. Values are stored as plain
+ * pointers and are never freed by the map.
+ */
+
+#ifndef U_HASHMAP_H_
+#define U_HASHMAP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct u_hashmap_entry_t u_hashmap_entry_t;
+
+/**
+ * hash map structure.
+ *
+ * @note
+ * Members should be treated as private and not accessed directly. Instead
+ * all access should be through the defined u_hashmap_*() functions.
+ */
+typedef struct u_hashmap_t
+{
+    u_hashmap_entry_t **buckets;
+    size_t capacity;
+    size_t length;
+} u_hashmap_t;
+
+/**
+ * Callback invoked by ::u_hashmap_foreach for every entry.
+ * @param[in] key        pointer of key bytes.
+ * @param[in] keyLen     length of key.
+ * @param[in] value      value stored for the key.
+ * @param[in] ctx        user context passed to ::u_hashmap_foreach.
+ * @return true to remove the entry from the map, false to keep it.
+ */
+typedef bool (*u_hashmap_visit_t)(const void *key, size_t keyLen, void *value, void *ctx);
+
+/**
+ * API to create hash map and initialize the buckets.
+ * @param[in] capacity   initial number of buckets (rounded up to a power of two).
+ * @return  u_hashmap_t if Success, NULL otherwise.
+ */
+u_hashmap_t *u_hashmap_create(size_t capacity);
+
+/**
+ * Resets and deletes the hash map.
+ * Stored values are not freed. Calling function must take care of freeing
+ * dynamic memory referenced by the values before freeing the map.
+ * @param[in] map        u_hashmap pointer
+ */
+void u_hashmap_free(u_hashmap_t **map);
+
+/**
+ * Add or replace the value for a key.
+ * @param[in] map        pointer of hash map.
+ * @param[in] key        pointer of key bytes.
+ * @param[in] keyLen     length of key.
+ * @param[in] value      value to store.
+ * @return true if success, false otherwise.
+ */
+bool u_hashmap_put(u_hashmap_t *map, const void *key, size_t keyLen, void *value);
+
+/**
+ * Returns the value for a key.
+ * @param[in] map        pointer of hash map.
+ * @param[in] key        pointer of key bytes.
+ * @param[in] keyLen     length of key.
+ * @return value if found, NULL otherwise.
+ */
+void *u_hashmap_get(const u_hashmap_t *map, const void *key, size_t keyLen);
+
+/**
+ * Returns whether the key exists or not.
+ * @param[in] map        pointer of hash map.
+ * @param[in] key        pointer of key bytes.
+ * @param[in] keyLen     length of key.
+ * @return true if exists, false otherwise.
+ */
+bool u_hashmap_contains(const u_hashmap_t *map, const void *key, size_t keyLen);
+
+/**
+ * Remove the entry for a key.
+ * @param[in] map        pointer of hash map.
+ * @param[in] key        pointer of key bytes.
+ * @param[in] keyLen     length of key.
+ * @return the removed value if found, NULL otherwise.
+ */
+void *u_hashmap_remove(u_hashmap_t *map, const void *key, size_t keyLen);
+
+/**
+ * Visit every entry of the hash map. Entries for which the callback returns
+ * true are removed. The map must not be modified by the callback otherwise.
+ * @param[in] map        pointer of hash map.
+ * @param[in] visit      callback invoked for every entry.
+ * @param[in] ctx        user context handed to the callback.
+ */
+void u_hashmap_foreach(u_hashmap_t *map, u_hashmap_visit_t visit, void *ctx);
+
+/**
+ * Remove all entries. Stored values are not freed.
+ * @param[in] map        pointer of hash map.
+ */
+void u_hashmap_clear(u_hashmap_t *map);
+
+/**
+ * Returns the number of entries in the hash map.
+ * @param[in] map        pointer of hash map.
+ * @return number of entries.
+ */
+size_t u_hashmap_length(const u_hashmap_t *map);
+
+/**
+ * Computes the hash used by the map for the given bytes (32-bit FNV-1a).
+ * @param[in] key        pointer of key bytes.
+ * @param[in] keyLen     length of key.
+ * @return hash value.
+ */
+uint32_t u_hashmap_hash(const void *key, size_t keyLen);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U_HASHMAP_H_ */
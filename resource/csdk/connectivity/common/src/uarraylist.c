@@ -201,6 +201,22 @@ void *u_arraylist_remove(u_arraylist_t *list, size_t index)
     return removed;
 }
 
+void *u_arraylist_swap_remove(u_arraylist_t *list, size_t index)
+{
+    void *removed = NULL;
+
+    if (!list || (index >= list->length))
+    {
+        return NULL;
+    }
+
+    removed = list->data[index];
+    list->data[index] = list->data[list->length - 1];
+    list->length--;
+
+    return removed;
+}
+
 size_t u_arraylist_length(const u_arraylist_t *list)
 {
     if (!list)
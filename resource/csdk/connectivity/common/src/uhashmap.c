@@ -0,0 +1,300 @@
+/******************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "uhashmap.h"
+#include "logger.h"
+#include "oic_malloc.h"
+
+#define TAG "OIC_UHASHMAP"
+
+/**
+ * Use this default bucket count when no capacity is given.
+ */
+#define U_HASHMAP_DEFAULT_CAPACITY 16
+
+/**
+ * FNV-1a parameters.
+ */
+#define U_HASHMAP_FNV_OFFSET 2166136261u
+#define U_HASHMAP_FNV_PRIME  16777619u
+
+/**
+ * Entry of a bucket chain. Key bytes are stored inline after the entry.
+ */
+struct u_hashmap_entry_t
+{
+    u_hashmap_entry_t *next;
+    uint32_t hash;
+    size_t keyLen;
+    void *value;
+    unsigned char key[];
+};
+
+uint32_t u_hashmap_hash(const void *key, size_t keyLen)
+{
+    const unsigned char *bytes = (const unsigned char *) key;
+    uint32_t hash = U_HASHMAP_FNV_OFFSET;
+
+    for (size_t i = 0; i < keyLen; i++)
+    {
+        hash ^= bytes[i];
+        hash *= U_HASHMAP_FNV_PRIME;
+    }
+    return hash;
+}
+
+static size_t u_hashmap_round_capacity(size_t capacity)
+{
+    size_t rounded = U_HASHMAP_DEFAULT_CAPACITY;
+    while (rounded < capacity)
+    {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+static bool u_hashmap_grow(u_hashmap_t *map)
+{
+    size_t newCapacity = map->capacity << 1;
+    u_hashmap_entry_t **buckets =
+        (u_hashmap_entry_t **) OICCalloc(newCapacity, sizeof(map->buckets[0]));
+    if (!buckets)
+    {
+        OIC_LOG(DEBUG, TAG, "Memory allocation failed.");
+        return false;
+    }
+
+    for (size_t i = 0; i < map->capacity; i++)
+    {
+        u_hashmap_entry_t *entry = map->buckets[i];
+        while (entry)
+        {
+            u_hashmap_entry_t *next = entry->next;
+            size_t index = entry->hash & (newCapacity - 1);
+            entry->next = buckets[index];
+            buckets[index] = entry;
+            entry = next;
+        }
+    }
+
+    OICFree(map->buckets);
+    map->buckets = buckets;
+    map->capacity = newCapacity;
+    return true;
+}
+
+static u_hashmap_entry_t **u_hashmap_find(const u_hashmap_t *map, uint32_t hash,
+                                          const void *key, size_t keyLen)
+{
+    u_hashmap_entry_t **link = &map->buckets[hash & (map->capacity - 1)];
+    while (*link)
+    {
+        u_hashmap_entry_t *entry = *link;
+        if (entry->hash == hash && entry->keyLen == keyLen
+            && (0 == keyLen || 0 == memcmp(entry->key, key, keyLen)))
+        {
+            return link;
+        }
+        link = &entry->next;
+    }
+    return link;
+}
+
+u_hashmap_t *u_hashmap_create(size_t capacity)
+{
+    u_hashmap_t *map = (u_hashmap_t *) OICCalloc(1, sizeof(u_hashmap_t));
+    if (!map)
+    {
+        OIC_LOG(DEBUG, TAG, "Out of memory");
+        return NULL;
+    }
+
+    map->capacity = u_hashmap_round_capacity(capacity);
+    map->length = 0;
+
+    map->buckets = (u_hashmap_entry_t **) OICCalloc(map->capacity, sizeof(map->buckets[0]));
+    if (!map->buckets)
+    {
+        OIC_LOG(DEBUG, TAG, "Out of memory");
+        OICFree(map);
+        return NULL;
+    }
+    return map;
+}
+
+void u_hashmap_free(u_hashmap_t **map)
+{
+    if (!map || !(*map))
+    {
+        return;
+    }
+
+    u_hashmap_clear(*map);
+    OICFree((*map)->buckets);
+    OICFree(*map);
+
+    *map = NULL;
+}
+
+bool u_hashmap_put(u_hashmap_t *map, const void *key, size_t keyLen, void *value)
+{
+    if (!map || (!key && keyLen))
+    {
+        return false;
+    }
+
+    uint32_t hash = u_hashmap_hash(key, keyLen);
+    u_hashmap_entry_t **link = u_hashmap_find(map, hash, key, keyLen);
+    if (*link)
+    {
+        (*link)->value = value;
+        return true;
+    }
+
+    u_hashmap_entry_t *entry =
+        (u_hashmap_entry_t *) OICMalloc(sizeof(u_hashmap_entry_t) + keyLen);
+    if (!entry)
+    {
+        OIC_LOG(DEBUG, TAG, "Out of memory");
+        return false;
+    }
+    entry->hash = hash;
+    entry->keyLen = keyLen;
+    entry->value = value;
+    if (keyLen)
+    {
+        memcpy(entry->key, key, keyLen);
+    }
+
+    size_t index = hash & (map->capacity - 1);
+    entry->next = map->buckets[index];
+    map->buckets[index] = entry;
+    map->length++;
+
+    // Keep the load factor below 3/4. A failed grow is non-fatal, the map
+    // only gets slower.
+    if ((map->length * 4) > (map->capacity * 3))
+    {
+        (void) u_hashmap_grow(map);
+    }
+    return true;
+}
+
+void *u_hashmap_get(const u_hashmap_t *map, const void *key, size_t keyLen)
+{
+    if (!map || (!key && keyLen))
+    {
+        return NULL;
+    }
+
+    u_hashmap_entry_t **link = u_hashmap_find(map, u_hashmap_hash(key, keyLen), key, keyLen);
+    return *link ? (*link)->value : NULL;
+}
+
+bool u_hashmap_contains(const u_hashmap_t *map, const void *key, size_t keyLen)
+{
+    if (!map || (!key && keyLen))
+    {
+        return false;
+    }
+
+    return NULL != *u_hashmap_find(map, u_hashmap_hash(key, keyLen), key, keyLen);
+}
+
+void *u_hashmap_remove(u_hashmap_t *map, const void *key, size_t keyLen)
+{
+    if (!map || (!key && keyLen))
+    {
+        return NULL;
+    }
+
+    u_hashmap_entry_t **link = u_hashmap_find(map, u_hashmap_hash(key, keyLen), key, keyLen);
+    u_hashmap_entry_t *entry = *link;
+    if (!entry)
+    {
+        return NULL;
+    }
+
+    void *value = entry->value;
+    *link = entry->next;
+    OICFree(entry);
+    map->length--;
+    return value;
+}
+
+void u_hashmap_foreach(u_hashmap_t *map, u_hashmap_visit_t visit, void *ctx)
+{
+    if (!map || !visit)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < map->capacity; i++)
+    {
+        u_hashmap_entry_t **link = &map->buckets[i];
+        while (*link)
+        {
+            u_hashmap_entry_t *entry = *link;
+            if (visit(entry->key, entry->keyLen, entry->value, ctx))
+            {
+                *link = entry->next;
+                OICFree(entry);
+                map->length--;
+            }
+            else
+            {
+                link = &entry->next;
+            }
+        }
+    }
+}
+
+void u_hashmap_clear(u_hashmap_t *map)
+{
+    if (!map)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < map->capacity; i++)
+    {
+        u_hashmap_entry_t *entry = map->buckets[i];
+        while (entry)
+        {
+            u_hashmap_entry_t *next = entry->next;
+            OICFree(entry);
+            entry = next;
+        }
+        map->buckets[i] = NULL;
+    }
+    map->length = 0;
+}
+
+size_t u_hashmap_length(const u_hashmap_t *map)
+{
+    if (!map)
+    {
+        OIC_LOG(DEBUG, TAG, "Invalid Parameter");
+        return 0;
+    }
+    return map->length;
+}
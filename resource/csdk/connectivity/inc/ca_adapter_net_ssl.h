@@ -57,6 +57,24 @@ typedef ssize_t (*CAPacketSendCallback)(CAEndpoint_t *endpoint,
  */
 CAResult_t CAsetTlsCipherSuite(const uint32_t cipher);
 
+/**
+ * Select how (D)TLS sessions of a transport adapter are resumed.
+ *
+ * @param[in] adapter   transport adapter
+ * @param[in] modes     bitwise OR of ::CASessionResumption_t values
+ *
+ * @retval  ::CA_STATUS_OK for success, otherwise some error value
+ */
+CAResult_t CAsetTlsSessionResumption(CATransportAdapter_t adapter, uint32_t modes);
+
+/**
+ * Get the number of full and of resumed handshakes.
+ *
+ * @param[out] full     number of full handshakes
+ * @param[out] resumed  number of resumed handshakes
+ */
+void CAsslGetHandshakeStats(uint32_t *full, uint32_t *resumed);
+
 /**
  * Used set send and recv callbacks for different adapters(WIFI,EtherNet).
  *
@@ -80,6 +98,12 @@ void CAsetCredentialTypesCallback(CAgetCredentialTypesHandler credTypesCallback)
  */
 void CAsetSslCredentialsCallback(CAgetPskCredentialsHandler credCallback);
 
+/**
+ * Drop the certificates, private key and CRL parsed for earlier handshakes, so the next
+ * handshake loads them again from the PKIX info callback.
+ */
+void CAsslInvalidatePkixInfo();
+
 /**
  * Close the TLS session
  *
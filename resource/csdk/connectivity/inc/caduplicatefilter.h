@@ -0,0 +1,95 @@
+/******************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+/**
+ * @file
+ * This file contains the duplicate filter for received messages.
+ *
+ * Every received message is remembered for EXCHANGE_LIFETIME (RFC 7252,
+ * section 4.8.2) keyed by message ID, token, interface index and source
+ * address, so retransmitted duplicates are recognized in O(1). A second key
+ * without the source address catches the copy of a multicast message that
+ * arrives over the other IP address family.
+ */
+
+#ifndef CA_DUPLICATE_FILTER_H_
+#define CA_DUPLICATE_FILTER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cacommon.h"
+
+/** EXCHANGE_LIFETIME of RFC 7252 with default transmission parameters. **/
+#define CA_DEFAULT_EXCHANGE_LIFETIME_MSEC   247000
+
+/** maximum number of remembered messages, the oldest is evicted first. **/
+#ifdef ARDUINO
+#define CA_DUPLICATE_FILTER_MAX_ENTRIES     8
+#else
+#define CA_DUPLICATE_FILTER_MAX_ENTRIES     4096
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Initializes the duplicate filter.
+ * @return  ::CA_STATUS_OK or ERROR CODES (::CAResult_t error codes in cacommon.h).
+ */
+CAResult_t CADuplicateFilterInitialize();
+
+/**
+ * Removes all remembered messages and frees the duplicate filter.
+ */
+void CADuplicateFilterTerminate();
+
+/**
+ * Checks whether a received message is a duplicate and remembers it otherwise.
+ * @param[in]   ep             source endpoint.
+ * @param[in]   messageId      CoAP message ID.
+ * @param[in]   token          token of the message.
+ * @param[in]   tokenLength    length of the token.
+ * @return  true if the message was already received within the lifetime.
+ */
+bool CADuplicateFilterCheck(const CAEndpoint_t *ep, uint16_t messageId,
+                            const CAToken_t token, uint8_t tokenLength);
+
+/**
+ * Sets how long received messages are remembered, messages already
+ * remembered included.
+ * @param[in]   lifetime       lifetime in milliseconds.
+ */
+void CADuplicateFilterSetLifetime(uint32_t lifetime);
+
+/**
+ * Returns the filter counters.
+ * @param[out]  hits           number of messages found to be duplicates.
+ * @param[out]  misses         number of messages that were not duplicates.
+ */
+void CADuplicateFilterGetStats(uint32_t *hits, uint32_t *misses);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif  /* CA_DUPLICATE_FILTER_H_ */
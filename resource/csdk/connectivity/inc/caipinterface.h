@@ -150,6 +150,16 @@ void CAIPSendData(CAEndpoint_t *endpoint,
                   size_t dataLength,
                   bool isMulticast);
 
+/**
+ * Enable or disable batched datagram I/O.
+ * Where recvmmsg()/sendmmsg() are available, a readable socket is drained
+ * with one receive call and multicast data is sent to all interfaces with
+ * one send call. Batching is enabled by default.
+ *
+ * @param[in]  enable      true to batch datagrams, false for one call per datagram.
+ */
+void CAIPSetBatchedIO(bool enable);
+
 /**
  * Get IP adapter connection state.
  *
@@ -61,6 +61,26 @@ typedef struct
     char addr[MAX_ADDR_STR_SIZE_CA];
 } CAInterface_t;
 
+#if defined(__linux__) && !defined(__ANDROID__) && !defined(__TIZEN__)
+/*
+ * The network monitor of this platform keeps the interface snapshot current from
+ * netlink events, so senders do not have to enumerate the interfaces themselves.
+ */
+#define CA_IP_INTERFACE_SNAPSHOT
+#endif
+
+/*
+ * Immutable list of CAInterface_t items. A snapshot returned by
+ * CAIPAcquireInterfaceSnapshot() stays valid until it is released, even if the
+ * interfaces change in the meantime.
+ */
+typedef struct
+{
+    uint32_t version;       /**< Incremented every time the interfaces change. */
+    u_arraylist_t *iflist;  /**< CAInterface_t items. Must not be modified. */
+    int32_t slot;           /**< Internal, -1 if the snapshot is not shared. */
+} CAIPInterfaceSnapshot_t;
+
 typedef struct CAIPCBData_t
 {
     struct CAIPCBData_t *next;
@@ -126,6 +146,32 @@ CAResult_t CAIPStopNetworkMonitor(CATransportAdapter_t adapter);
  */
 void CAProcessNewInterface(CAInterface_t *ifchanged);
 
+/**
+ * Get the current network interfaces without enumerating them. Does not block,
+ * the snapshot is only built on demand if the network monitor does not maintain it.
+ *
+ * @return  Snapshot of the interfaces or NULL on failure. Release it with
+ *          CAIPReleaseInterfaceSnapshot().
+ */
+const CAIPInterfaceSnapshot_t *CAIPAcquireInterfaceSnapshot();
+
+/**
+ * Release a snapshot returned by CAIPAcquireInterfaceSnapshot().
+ *
+ * @param[in]  snapshot     Snapshot to release.
+ */
+void CAIPReleaseInterfaceSnapshot(const CAIPInterfaceSnapshot_t *snapshot);
+
+/**
+ * Apply network interface changes to the snapshot.
+ *
+ * @param[in]  ifindex      Network interface index whose items are replaced, or 0 to
+ *                          replace all items.
+ * @param[in]  iflist       Current CAInterface_t items of that interface. NULL or
+ *                          an empty list removes the interface.
+ */
+void CAIPUpdateInterfaceSnapshot(uint32_t ifindex, const u_arraylist_t *iflist);
+
 /**
  * This function return link local zone id related from ifindex.
  *
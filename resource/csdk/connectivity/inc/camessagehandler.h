@@ -29,9 +29,18 @@
 #include "cacommon.h"
 #include <coap/coap.h>
 
+/** see ocevent.h */
+struct oc_event_t;
+
 #define CA_MEMORY_ALLOC_CHECK(arg) { if (NULL == arg) {OIC_LOG(ERROR, TAG, "Out of memory"); \
 goto memory_error_exit;} }
 
+/** Maximum number of received messages handled per CAHandleRequestResponseCallbacks call. */
+#define CA_HANDLE_BATCH_SIZE 32
+
+/** Maximum number of receive worker threads. */
+#define CA_MAX_RECEIVE_WORKERS 8
+
 typedef enum
 {
     SEND_TYPE_MULTICAST = 0,
@@ -88,9 +97,33 @@ void CATerminateMessageHandler();
 
 /**
  * Handler for receiving request and response callback in single thread model.
+ * Handles up to ::CA_HANDLE_BATCH_SIZE queued messages per call.
  */
 void CAHandleRequestResponseCallbacks();
 
+#ifndef SINGLE_THREAD
+/**
+ * Set the number of receive worker threads, see ::CASetReceiveWorkerCount.
+ * @param[in] count    number of workers, up to ::CA_MAX_RECEIVE_WORKERS.
+ * @return  ::CA_STATUS_OK or ERROR CODES (::CAResult_t error codes in cacommon.h).
+ */
+CAResult_t CASetReceiveWorkers(uint8_t count);
+
+/**
+ * Add an event signaled when data is queued for ::CAHandleRequestResponseCallbacks,
+ * see ::CARegisterProcessEvent.
+ * @param[in] event    event to signal.
+ * @return  ::CA_STATUS_OK or ERROR CODES (::CAResult_t error codes in cacommon.h).
+ */
+CAResult_t CAAddProcessEvent(struct oc_event_t *event);
+
+/**
+ * Stop signaling an event added with ::CAAddProcessEvent.
+ * @param[in] event    event to remove.
+ */
+void CARemoveProcessEvent(struct oc_event_t *event);
+#endif
+
 /**
  * Setting the Callback funtion for network state change callback.
  * @param[in] nwMonitorHandler    callback for network state change.
@@ -44,6 +44,27 @@ typedef void (*CAThreadTask)(void *threadData);
 /** Data destroy function. **/
 typedef void (*CADataDestroyFunction)(void *data, uint32_t size);
 
+/** Data match function, returns true if the data should be removed. **/
+typedef bool (*CAQueueingThreadCompareFunc)(void *data, uint32_t size, void *ctx);
+
+/** Number of slots of the lock-free ring, must be a power of two. **/
+#ifdef ARDUINO
+#define CA_QUEUEING_THREAD_RING_SIZE 8
+#else
+#define CA_QUEUEING_THREAD_RING_SIZE 256
+#endif
+
+/** Slot of the lock-free ring. **/
+typedef struct
+{
+    /** Position the slot is ready for, see caqueueingthread.c. **/
+    volatile int32_t sequence;
+    /** Queued data. **/
+    void *msg;
+    /** Length of the queued data. **/
+    uint32_t size;
+} CAQueueingThreadSlot_t;
+
 typedef struct
 {
     /** Thread pool of the thread started. **/
@@ -58,8 +79,18 @@ typedef struct
     CADataDestroyFunction destroy;
     /** Variable to inform the thread to stop. **/
     bool isStop;
-    /** Que on which the thread is operating. **/
+    /** Overflow que used while the ring is full. **/
     u_queue_t *dataQueue;
+    /** Bounded multi-producer/single-consumer ring. **/
+    CAQueueingThreadSlot_t *ring;
+    /** Next ring position claimed by a producer. **/
+    volatile int32_t enqueuePos;
+    /** Next ring position read by the consumer (guarded by threadMutex). **/
+    int32_t dequeuePos;
+    /** Number of messages in the overflow que. **/
+    volatile int32_t overflowCount;
+    /** Set while the consumer is about to sleep on threadCond. **/
+    volatile int32_t isWaiting;
 } CAQueueingThread_t;
 
 /**
@@ -89,6 +120,27 @@ CAResult_t CAQueueingThreadStart(CAQueueingThread_t *thread);
  */
 CAResult_t CAQueueingThreadAddData(CAQueueingThread_t *thread, void *data, uint32_t size);
 
+/**
+ * Take the oldest queued data without running the thread task.
+ * Ownership of the data moves to the caller.
+ * @param[in]   thread       thread data.
+ * @param[out]  data         dequeued data.
+ * @param[out]  size         length of the dequeued data.
+ * @return  CA_STATUS_OK if data was dequeued, CA_STATUS_FAILED if the que is empty.
+ */
+CAResult_t CAQueueingThreadGetData(CAQueueingThread_t *thread, void **data, uint32_t *size);
+
+/**
+ * Remove and destroy every queued data for which compareFunc returns true.
+ * @param[in]   thread       thread data.
+ * @param[in]   compareFunc  match function.
+ * @param[in]   ctx          user context passed to compareFunc.
+ * @return  CA_STATUS_OK or ERROR CODES (CAResult_t error codes in cacommon.h).
+ */
+CAResult_t CAQueueingThreadClearContextData(CAQueueingThread_t *thread,
+                                            CAQueueingThreadCompareFunc compareFunc,
+                                            void *ctx);
+
 /**
  * Stop the queuing thread.
  * @param[in]   thread       thread data that needs to be started.
@@ -30,7 +30,7 @@
 
 #include "cathreadpool.h"
 #include "octhread.h"
-#include "uarraylist.h"
+#include "uhashmap.h"
 #include "cacommon.h"
 
 /** IP, EDR, LE. **/
@@ -47,6 +47,19 @@
 /** check period is 1 sec. **/
 #define RETRANSMISSION_CHECK_PERIOD_SEC     1
 
+/** number of timer wheel slots. **/
+#ifdef ARDUINO
+#define RETRANSMISSION_WHEEL_SLOTS          16
+#else
+#define RETRANSMISSION_WHEEL_SLOTS          256
+#endif
+
+/** timer wheel granularity is 100 msec. **/
+#define RETRANSMISSION_WHEEL_TICK_MSEC      100
+
+/** retransmission data, private to the retransmission module. **/
+typedef struct CARetransmissionData CARetransmissionData_t;
+
 /** retransmission data send method type. **/
 typedef CAResult_t (*CADataSendMethod_t)(const CAEndpoint_t *endpoint,
                                          const void *pdu,
@@ -91,8 +104,14 @@ typedef struct
     /** Variable to inform the thread to stop. **/
     bool isStop;
 
-    /** array list on which the thread is operating. **/
-    u_arraylist_t *dataList;
+    /** retransmission data keyed by message id and transport adapter. **/
+    u_hashmap_t *dataMap;
+
+    /** timer wheel holding the retransmission data by deadline. **/
+    CARetransmissionData_t **timerWheel;
+
+    /** wheel tick from which the next check starts. **/
+    uint64_t wheelTick;
 
 } CARetransmission_t;
 
@@ -26,6 +26,7 @@
 #endif
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include <assert.h>
 #include "ca_adapter_net_ssl.h"
@@ -46,6 +47,13 @@
 #include "mbedtls/ssl_internal.h"
 #include "mbedtls/net_sockets.h"
 #include "mbedtls/oid.h"
+#if defined(MBEDTLS_SSL_CACHE_C)
+#include "mbedtls/ssl_cache.h"
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_TICKET_C)
+#include "mbedtls/ssl_ticket.h"
+#define SSL_SESSION_TICKETS
+#endif
 #ifdef __WITH_DTLS__
 #include "mbedtls/timing.h"
 #include "mbedtls/ssl_cookie.h"
@@ -169,6 +177,30 @@
  */
 #define CBC_IV_LENGTH (0)
 
+/**
+ * @def SSL_SESSION_LIFETIME
+ * @brief Seconds a session can be resumed after it was established.
+ */
+#define SSL_SESSION_LIFETIME (86400)
+/**
+ * @def SSL_MAX_SESSIONS
+ * @brief Maximum number of sessions kept for resumption, as server and as client.
+ */
+#define SSL_MAX_SESSIONS (32)
+/**
+ * @def SSL_PEER_TABLE_SIZE
+ * @brief Number of buckets of the peer table, must be a power of 2.
+ */
+#define SSL_PEER_TABLE_SIZE (1024)
+/**
+ * @def SSL_PEER_UNLISTED
+ * @brief listIndex of a peer which is not in the peer list.
+ */
+#define SSL_PEER_UNLISTED SIZE_MAX
+
+#define FNV_OFFSET_BASIS (2166136261U)
+#define FNV_PRIME        (16777619U)
+
 /**
  * @var RETRANSMISSION_TIME
  * @brief Maximum timeout value (in seconds) to start DTLS retransmission.
@@ -359,6 +391,15 @@ static void DebugSsl(void *ctx, int level, const char *file, int line, const cha
  */
 typedef ByteArray_t SslCacheMessage_t;
 
+/**
+ * Data structure for holding a session established as client, to resume it later.
+ */
+typedef struct SslSession
+{
+    CAEndpoint_t endpoint;          /**< Server the session was established with. */
+    mbedtls_ssl_session session;
+} SslSession_t;
+
 
 /**
  * Data structure for holding the send and recv callbacks.
@@ -375,7 +416,10 @@ typedef struct TlsCallBacks
 typedef struct SslContext
 {
     u_arraylist_t *peerList;         /**< peer list which holds the mapping between
-                                              peer id, it's n/w address and mbedTLS context. */
+                                              peer id, it's n/w address and mbedTLS context,
+                                              in no particular order. */
+    struct SslEndPoint *peerTable[SSL_PEER_TABLE_SIZE]; /**< peers of peerList by address. */
+    uint32_t peerRefs;               /**< References to peers, including those of peerList. */
     mbedtls_entropy_context entropy;
     mbedtls_ctr_drbg_context rnd;
     mbedtls_x509_crt ca;
@@ -393,6 +437,28 @@ typedef struct SslContext
     bool cipherFlag[2];
     int selectedCipher;
 
+    /*
+     * ca, crt, pkey and crl are parsed once and kept until the credentials change,
+     * see CAsslInvalidatePkixInfo().
+     */
+    bool pkixLoaded;                    /**< ca holds the trust chain of pkixSource. */
+    bool pkixOwnCert;                   /**< crt and pkey hold a usable own certificate. */
+    bool pkixCrl;                       /**< crl holds a usable CRL. */
+    CAgetPkixInfoHandler pkixSource;    /**< Callback the credentials were loaded with. */
+    bool ownCertConfigured[2];          /**< crt and pkey were added to the DTLS/TLS configs. */
+
+    uint32_t sessionResumption[MAX_SUPPORTED_ADAPTERS];  /**< CASessionResumption_t flags. */
+    u_arraylist_t *sessionList;         /**< SslSession_t items, oldest first. */
+#if defined(MBEDTLS_SSL_CACHE_C)
+    mbedtls_ssl_cache_context sessionCache;
+#endif
+#ifdef SSL_SESSION_TICKETS
+    mbedtls_ssl_ticket_context ticketCtx;
+    bool ticketsReady;
+#endif
+    uint32_t fullHandshakes;
+    uint32_t resumedHandshakes;
+
 #ifdef __WITH_DTLS__
     mbedtls_ssl_cookie_ctx cookieCtx;
     int timerId;
@@ -426,9 +492,30 @@ static CAgetPkixInfoHandler g_getPkixInfoCallback = NULL;
 /**
  * @var g_dtlsContextMutex
  * @brief Mutex to synchronize access to g_caSslContext and g_sslCallback.
+ *        The mutex of a peer may be locked while holding it, never the other way round.
  */
 static oc_mutex g_sslContextMutex = NULL;
 
+/**
+ * @var g_sslRndMutex
+ * @brief Mutex to synchronize access to the random generator, which is also used while
+ *        only the mutex of a peer is held.
+ */
+static oc_mutex g_sslRndMutex = NULL;
+
+/**
+ * @var g_sslCookieMutex
+ * @brief Mutex to synchronize access to the DTLS cookie context, which is also used while
+ *        only the mutex of a peer is held.
+ */
+static oc_mutex g_sslCookieMutex = NULL;
+
+/**
+ * @var g_sslPeerReleasedCond
+ * @brief Signaled with g_sslContextMutex held when the last peer reference is dropped.
+ */
+static oc_cond g_sslPeerReleasedCond = NULL;
+
 /**
  * @var g_sslCallback
  * @brief callback to deliver the TLS handshake result
@@ -456,9 +543,14 @@ typedef struct SslEndPoint
     SslRecBuf_t recBuf;
     uint8_t master[MASTER_SECRET_LEN];
     uint8_t random[2*RANDOM_LEN];
+    bool resumed;
 #ifdef __WITH_DTLS__
     mbedtls_timing_delay_context timer;
 #endif // __WITH_DTLS__
+    oc_mutex mutex;                 /**< Protects ssl once the handshake is over. */
+    uint32_t refCount;              /**< References to the peer, peerList holds one. */
+    size_t listIndex;               /**< Position in peerList or SSL_PEER_UNLISTED. */
+    struct SslEndPoint *hashNext;   /**< Next peer in the same bucket of peerTable. */
 } SslEndPoint_t;
 
 void CAsetPskCredentialsCallback(CAgetPskCredentialsHandler credCallback)
@@ -497,6 +589,65 @@ static int GetAdapterIndex(CATransportAdapter_t adapter)
             return -1;
     }
 }
+/**
+ * Random generator callback of mbedTLS, serializes access to the ctr_drbg context.
+ *
+ * @param[in]  ctx    ctr_drbg context
+ * @param[out]  buf    buffer to fill
+ * @param[in]  len    buffer length
+ *
+ * @return  0 on success
+ */
+static int SslRandom(void * ctx, unsigned char * buf, size_t len)
+{
+    oc_mutex_lock(g_sslRndMutex);
+    int ret = mbedtls_ctr_drbg_random(ctx, buf, len);
+    oc_mutex_unlock(g_sslRndMutex);
+    return ret;
+}
+
+#ifdef __WITH_DTLS__
+/**
+ * Cookie write callback of mbedTLS, serializes access to the cookie context.
+ *
+ * @param[in]  ctx    cookie context
+ * @param[in,out]  p    position to write the cookie to, moved past it
+ * @param[in]  end    end of the buffer
+ * @param[in]  cliId    transport level ID of the client
+ * @param[in]  cliIdLen    length of cliId
+ *
+ * @return  0 on success
+ */
+static int SslCookieWrite(void * ctx, unsigned char ** p, unsigned char * end,
+                          const unsigned char * cliId, size_t cliIdLen)
+{
+    oc_mutex_lock(g_sslCookieMutex);
+    int ret = mbedtls_ssl_cookie_write(ctx, p, end, cliId, cliIdLen);
+    oc_mutex_unlock(g_sslCookieMutex);
+    return ret;
+}
+
+/**
+ * Cookie check callback of mbedTLS, serializes access to the cookie context.
+ *
+ * @param[in]  ctx    cookie context
+ * @param[in]  cookie    cookie sent by the client
+ * @param[in]  cookieLen    length of cookie
+ * @param[in]  cliId    transport level ID of the client
+ * @param[in]  cliIdLen    length of cliId
+ *
+ * @return  0 if the cookie is valid
+ */
+static int SslCookieCheck(void * ctx, const unsigned char * cookie, size_t cookieLen,
+                          const unsigned char * cliId, size_t cliIdLen)
+{
+    oc_mutex_lock(g_sslCookieMutex);
+    int ret = mbedtls_ssl_cookie_check(ctx, cookie, cookieLen, cliId, cliIdLen);
+    oc_mutex_unlock(g_sslCookieMutex);
+    return ret;
+}
+#endif // __WITH_DTLS__
+
 /**
  * Write callback.
  *
@@ -647,11 +798,10 @@ static void DeInitPkixInfo(PkiInfo_t * inf)
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
 }
 
-//Loads PKIX related information from SRM
-static int InitPKIX(CATransportAdapter_t adapter)
+//Loads PKIX related information from SRM and parses it into g_caSslContext
+static void LoadPKIX()
 {
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "In %s", __func__);
-    VERIFY_NON_NULL_RET(g_getPkixInfoCallback, NET_SSL_TAG, "PKIX info callback is NULL", -1);
     // load pk key, cert, trust chain and crl
     PkiInfo_t pkiInfo = {
         BYTE_ARRAY_INITIALIZER,
@@ -660,12 +810,12 @@ static int InitPKIX(CATransportAdapter_t adapter)
         BYTE_ARRAY_INITIALIZER
     };
 
-    if (g_getPkixInfoCallback)
-    {
-        g_getPkixInfoCallback(&pkiInfo);
-    }
+    g_getPkixInfoCallback(&pkiInfo);
 
-    VERIFY_NON_NULL_RET(g_caSslContext, NET_SSL_TAG, "SSL Context is NULL", -1);
+    g_caSslContext->pkixLoaded = false;
+    g_caSslContext->pkixOwnCert = false;
+    g_caSslContext->pkixCrl = false;
+    g_caSslContext->pkixSource = g_getPkixInfoCallback;
 
     mbedtls_x509_crt_free(&g_caSslContext->ca);
     mbedtls_x509_crt_free(&g_caSslContext->crt);
@@ -677,12 +827,6 @@ static int InitPKIX(CATransportAdapter_t adapter)
     mbedtls_pk_init(&g_caSslContext->pkey);
     mbedtls_x509_crl_init(&g_caSslContext->crl);
 
-    mbedtls_ssl_config * serverConf = (adapter == CA_ADAPTER_IP ||
-                                   adapter == CA_ADAPTER_GATT_BTLE ?
-                                   &g_caSslContext->serverDtlsConf : &g_caSslContext->serverTlsConf);
-    mbedtls_ssl_config * clientConf = (adapter == CA_ADAPTER_IP ||
-                                   adapter == CA_ADAPTER_GATT_BTLE ?
-                                   &g_caSslContext->clientDtlsConf : &g_caSslContext->clientTlsConf);
     // optional
     int ret;
     int errNum;
@@ -704,20 +848,112 @@ static int InitPKIX(CATransportAdapter_t adapter)
         OIC_LOG(WARNING, NET_SSL_TAG, "Key parsing error");
         goto required;
     }
+    g_caSslContext->pkixOwnCert = true;
 
-    ret = mbedtls_ssl_conf_own_cert(serverConf, &g_caSslContext->crt, &g_caSslContext->pkey);
-    if (0 != ret)
+    required:
+    count = ParseChain(&g_caSslContext->ca, pkiInfo.ca.data, pkiInfo.ca.len, &errNum);
+    if(0 >= count)
     {
-        OIC_LOG(WARNING, NET_SSL_TAG, "Own certificate parsing error");
-        goto required;
+        OIC_LOG(ERROR, NET_SSL_TAG, "CA chain parsing error");
+        DeInitPkixInfo(&pkiInfo);
+        OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
+        return;
     }
-    ret = mbedtls_ssl_conf_own_cert(clientConf, &g_caSslContext->crt, &g_caSslContext->pkey);
+    if(0 != errNum)
+    {
+        OIC_LOG_V(WARNING, NET_SSL_TAG, "CA chain parsing warning: %d certs failed to parse", errNum);
+    }
+    g_caSslContext->pkixLoaded = true;
+
+    ret = mbedtls_x509_crl_parse_der(&g_caSslContext->crl, pkiInfo.crl.data, pkiInfo.crl.len);
     if(0 != ret)
     {
-        OIC_LOG(WARNING, NET_SSL_TAG, "Own certificate configuration error");
+        OIC_LOG(WARNING, NET_SSL_TAG, "CRL parsing error");
+    }
+    else
+    {
+        g_caSslContext->pkixCrl = true;
+    }
+
+    DeInitPkixInfo(&pkiInfo);
+
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
+}
+
+/**
+ * Removes the own certificates added to a configuration with mbedtls_ssl_conf_own_cert().
+ * The certificates and keys themselves are owned by the SSL context.
+ *
+ * @param[in]  conf    the (D)TLS configuration object
+ */
+static void ResetOwnCert(mbedtls_ssl_config * conf)
+{
+    mbedtls_ssl_key_cert *cur = conf->key_cert;
+    while (NULL != cur)
+    {
+        mbedtls_ssl_key_cert *next = cur->next;
+        mbedtls_free(cur);
+        cur = next;
+    }
+    conf->key_cert = NULL;
+}
+
+//Configures the PKIX related information from SRM, loading it if it changed
+static int InitPKIX(CATransportAdapter_t adapter)
+{
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "In %s", __func__);
+    VERIFY_NON_NULL_RET(g_getPkixInfoCallback, NET_SSL_TAG, "PKIX info callback is NULL", -1);
+    VERIFY_NON_NULL_RET(g_caSslContext, NET_SSL_TAG, "SSL Context is NULL", -1);
+
+    if (!g_caSslContext->pkixLoaded || g_caSslContext->pkixSource != g_getPkixInfoCallback)
+    {
+        LoadPKIX();
+    }
+    else
+    {
+        OIC_LOG(DEBUG, NET_SSL_TAG, "Using cached PKIX info");
+    }
+
+    bool isDtls = (adapter == CA_ADAPTER_IP || adapter == CA_ADAPTER_GATT_BTLE);
+    mbedtls_ssl_config * serverConf = (isDtls ?
+                                   &g_caSslContext->serverDtlsConf : &g_caSslContext->serverTlsConf);
+    mbedtls_ssl_config * clientConf = (isDtls ?
+                                   &g_caSslContext->clientDtlsConf : &g_caSslContext->clientTlsConf);
+    int ret;
+
+    if (!g_caSslContext->pkixOwnCert)
+    {
+        /* crt and pkey are empty after a reload without an own certificate. */
+        if (g_caSslContext->ownCertConfigured[isDtls ? 0 : 1])
+        {
+            ResetOwnCert(serverConf);
+            ResetOwnCert(clientConf);
+            g_caSslContext->ownCertConfigured[isDtls ? 0 : 1] = false;
+        }
         goto required;
     }
 
+    /*
+     * The configs keep pointers to crt and pkey, which are reloaded in place. Add them
+     * only once, mbedtls_ssl_conf_own_cert() appends to the list of own certificates.
+     */
+    if (!g_caSslContext->ownCertConfigured[isDtls ? 0 : 1])
+    {
+        ret = mbedtls_ssl_conf_own_cert(serverConf, &g_caSslContext->crt, &g_caSslContext->pkey);
+        if (0 != ret)
+        {
+            OIC_LOG(WARNING, NET_SSL_TAG, "Own certificate parsing error");
+            goto required;
+        }
+        ret = mbedtls_ssl_conf_own_cert(clientConf, &g_caSslContext->crt, &g_caSslContext->pkey);
+        if(0 != ret)
+        {
+            OIC_LOG(WARNING, NET_SSL_TAG, "Own certificate configuration error");
+            goto required;
+        }
+        g_caSslContext->ownCertConfigured[isDtls ? 0 : 1] = true;
+    }
+
     /* If we get here, certificates could be used, so configure OCF EKUs. */
     ret = mbedtls_ssl_conf_ekus(serverConf, (const char*)EKU_IDENTITY, sizeof(EKU_IDENTITY),
         (const char*)EKU_IDENTITY, sizeof(EKU_IDENTITY));
@@ -735,23 +971,15 @@ static int InitPKIX(CATransportAdapter_t adapter)
     }
 
     required:
-    count = ParseChain(&g_caSslContext->ca, pkiInfo.ca.data, pkiInfo.ca.len, &errNum);
-    if(0 >= count)
+    if (!g_caSslContext->pkixLoaded)
     {
-        OIC_LOG(ERROR, NET_SSL_TAG, "CA chain parsing error");
+        OIC_LOG(ERROR, NET_SSL_TAG, "No CA chain");
         OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
-        DeInitPkixInfo(&pkiInfo);
         return -1;
     }
-    if(0 != errNum)
-    {
-        OIC_LOG_V(WARNING, NET_SSL_TAG, "CA chain parsing warning: %d certs failed to parse", errNum);
-    }
 
-    ret = mbedtls_x509_crl_parse_der(&g_caSslContext->crl, pkiInfo.crl.data, pkiInfo.crl.len);
-    if(0 != ret)
+    if (!g_caSslContext->pkixCrl)
     {
-        OIC_LOG(WARNING, NET_SSL_TAG, "CRL parsing error");
         CONF_SSL(clientConf, serverConf, mbedtls_ssl_conf_ca_chain, &g_caSslContext->ca, NULL);
     }
     else
@@ -760,12 +988,306 @@ static int InitPKIX(CATransportAdapter_t adapter)
                  &g_caSslContext->ca, &g_caSslContext->crl);
     }
 
-    DeInitPkixInfo(&pkiInfo);
-
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
     return 0;
 }
 
+/**
+ * Checks whether sessions of a ciphersuite may be resumed. Sessions of PSK and anonymous
+ * ciphersuites are not, the identity of the peer is not part of the session.
+ *
+ * @param[in]  ciphersuite    TLS ciphersuite code
+ *
+ * @return  true if the ciphersuite authenticates with certificates
+ */
+static bool IsCertCipherSuite(int ciphersuite)
+{
+    return (MBEDTLS_TLS_ECDHE_PSK_WITH_AES_128_CBC_SHA256 != ciphersuite &&
+            MBEDTLS_TLS_ECDH_ANON_WITH_AES_128_CBC_SHA256 != ciphersuite);
+}
+
+/**
+ * Checks whether a kept session was established with the given server.
+ *
+ * @param[in]  first    server of the kept session
+ * @param[in]  second    server to connect to
+ *
+ * @return  true if the device ID, or if there is none the address, matches
+ */
+static bool IsSameSslPeer(const CAEndpoint_t *first, const CAEndpoint_t *second)
+{
+    if (first->adapter != second->adapter)
+    {
+        return false;
+    }
+    if ('\0' != first->remoteId[0] || '\0' != second->remoteId[0])
+    {
+        return (0 == strncmp(first->remoteId, second->remoteId, CA_MAX_IDENTITY_SIZE));
+    }
+    return (0 == strncmp(first->addr, second->addr, MAX_ADDR_STR_SIZE_CA)
+            && first->port == second->port);
+}
+
+/**
+ * Deletes kept client sessions.
+ *
+ * @param[in]  adapter    transport adapter whose sessions are deleted, CA_ALL_ADAPTERS for all
+ */
+static void DeleteSessions(CATransportAdapter_t adapter)
+{
+    oc_mutex_assert_owner(g_sslContextMutex, true);
+    VERIFY_NON_NULL_VOID(g_caSslContext, NET_SSL_TAG, "SSL Context is NULL");
+
+    for (size_t i = u_arraylist_length(g_caSslContext->sessionList); i > 0; i--)
+    {
+        SslSession_t *item = (SslSession_t *)u_arraylist_get(g_caSslContext->sessionList, i - 1);
+        if (NULL != item && 0 != (item->endpoint.adapter & adapter))
+        {
+            u_arraylist_remove(g_caSslContext->sessionList, i - 1);
+            mbedtls_ssl_session_free(&item->session);
+            OICFree(item);
+        }
+    }
+}
+
+/**
+ * Keeps the session of a completed client handshake to resume it later.
+ *
+ * @param[in]  tep    endpoint with session info
+ */
+static void SaveSslSession(SslEndPoint_t *tep)
+{
+    oc_mutex_assert_owner(g_sslContextMutex, true);
+    VERIFY_NON_NULL_VOID(g_caSslContext, NET_SSL_TAG, "SSL Context is NULL");
+    VERIFY_NON_NULL_VOID(tep, NET_SSL_TAG, "tep");
+
+    int adapterIndex = GetAdapterIndex(tep->sep.endpoint.adapter);
+    if (0 > adapterIndex || CA_SESSION_RESUMPTION_NONE ==
+        g_caSslContext->sessionResumption[adapterIndex] ||
+        !IsCertCipherSuite(tep->ssl.session->ciphersuite))
+    {
+        return;
+    }
+
+    SslSession_t *item = NULL;
+    for (size_t i = 0; i < u_arraylist_length(g_caSslContext->sessionList); i++)
+    {
+        SslSession_t *cur = (SslSession_t *)u_arraylist_get(g_caSslContext->sessionList, i);
+        if (NULL != cur && IsSameSslPeer(&cur->endpoint, &tep->sep.endpoint))
+        {
+            item = (SslSession_t *)u_arraylist_remove(g_caSslContext->sessionList, i);
+            mbedtls_ssl_session_free(&item->session);
+            break;
+        }
+    }
+    if (NULL == item && SSL_MAX_SESSIONS <= u_arraylist_length(g_caSslContext->sessionList))
+    {
+        // drop the oldest session
+        item = (SslSession_t *)u_arraylist_remove(g_caSslContext->sessionList, 0);
+        if (NULL != item)
+        {
+            mbedtls_ssl_session_free(&item->session);
+        }
+    }
+    if (NULL == item)
+    {
+        item = (SslSession_t *)OICCalloc(1, sizeof(SslSession_t));
+        if (NULL == item)
+        {
+            OIC_LOG(ERROR, NET_SSL_TAG, "calloc failed!");
+            return;
+        }
+    }
+
+    item->endpoint = tep->sep.endpoint;
+    mbedtls_ssl_session_init(&item->session);
+    if (0 != mbedtls_ssl_get_session(&tep->ssl, &item->session))
+    {
+        OIC_LOG(ERROR, NET_SSL_TAG, "Failed to copy session");
+        mbedtls_ssl_session_free(&item->session);
+        OICFree(item);
+        return;
+    }
+    if (!u_arraylist_add(g_caSslContext->sessionList, (void *)item))
+    {
+        OIC_LOG(ERROR, NET_SSL_TAG, "u_arraylist_add failed!");
+        mbedtls_ssl_session_free(&item->session);
+        OICFree(item);
+        return;
+    }
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "Session with [%s:%d] kept",
+              tep->sep.endpoint.addr, tep->sep.endpoint.port);
+}
+
+/**
+ * Offers the kept session with a server, if any, in the ClientHello.
+ *
+ * @param[in]  tep    endpoint with session info, before the handshake started
+ */
+static void LoadSslSession(SslEndPoint_t *tep)
+{
+    oc_mutex_assert_owner(g_sslContextMutex, true);
+    VERIFY_NON_NULL_VOID(g_caSslContext, NET_SSL_TAG, "SSL Context is NULL");
+    VERIFY_NON_NULL_VOID(tep, NET_SSL_TAG, "tep");
+
+    int adapterIndex = GetAdapterIndex(tep->sep.endpoint.adapter);
+    if (0 > adapterIndex ||
+        CA_SESSION_RESUMPTION_NONE == g_caSslContext->sessionResumption[adapterIndex])
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < u_arraylist_length(g_caSslContext->sessionList); i++)
+    {
+        SslSession_t *item = (SslSession_t *)u_arraylist_get(g_caSslContext->sessionList, i);
+        if (NULL != item && IsSameSslPeer(&item->endpoint, &tep->sep.endpoint))
+        {
+            if (0 != mbedtls_ssl_set_session(&tep->ssl, &item->session))
+            {
+                OIC_LOG(WARNING, NET_SSL_TAG, "Failed to set session, doing a full handshake");
+            }
+            return;
+        }
+    }
+}
+
+#if defined(MBEDTLS_SSL_CACHE_C)
+/**
+ * Session cache callback which only caches sessions that may be resumed.
+ */
+static int SetCachedSession(void *data, const mbedtls_ssl_session *session)
+{
+    if (!IsCertCipherSuite(session->ciphersuite))
+    {
+        return 0;
+    }
+    return mbedtls_ssl_cache_set(data, session);
+}
+#endif
+
+#ifdef SSL_SESSION_TICKETS
+/**
+ * Session ticket callback which only issues tickets for sessions that may be resumed.
+ * An empty ticket is sent for the others.
+ */
+static int WriteSessionTicket(void *ctx, const mbedtls_ssl_session *session,
+                              unsigned char *start, const unsigned char *end,
+                              size_t *tlen, uint32_t *lifetime)
+{
+    if (!IsCertCipherSuite(session->ciphersuite))
+    {
+        return -1;
+    }
+    return mbedtls_ssl_ticket_write(ctx, session, start, end, tlen, lifetime);
+}
+#endif
+
+/**
+ * Applies the session resumption modes of the adapters to the configs.
+ * The DTLS server config serves IP and BLE, so it resumes sessions if either of them does.
+ */
+static void ConfigureSessionResumption()
+{
+    oc_mutex_assert_owner(g_sslContextMutex, true);
+    VERIFY_NON_NULL_VOID(g_caSslContext, NET_SSL_TAG, "SSL Context is NULL");
+
+    const uint32_t *modes = g_caSslContext->sessionResumption;
+    struct
+    {
+        mbedtls_ssl_config *clientConf;
+        mbedtls_ssl_config *serverConf;
+        uint32_t modes;
+    } confs[] = {
+#ifdef __WITH_DTLS__
+        { &g_caSslContext->clientDtlsConf, &g_caSslContext->serverDtlsConf,
+          modes[GetAdapterIndex(CA_ADAPTER_IP)] | modes[GetAdapterIndex(CA_ADAPTER_GATT_BTLE)] },
+#endif
+#ifdef __WITH_TLS__
+        { &g_caSslContext->clientTlsConf, &g_caSslContext->serverTlsConf,
+          modes[GetAdapterIndex(CA_ADAPTER_TCP)] },
+#endif
+        { NULL, NULL, 0 }
+    };
+
+    for (size_t i = 0; NULL != confs[i].clientConf; i++)
+    {
+#if defined(MBEDTLS_SSL_CACHE_C)
+        if (confs[i].modes & CA_SESSION_RESUMPTION_CACHE)
+        {
+            mbedtls_ssl_conf_session_cache(confs[i].serverConf, &g_caSslContext->sessionCache,
+                                           mbedtls_ssl_cache_get, SetCachedSession);
+        }
+        else
+        {
+            mbedtls_ssl_conf_session_cache(confs[i].serverConf, NULL, NULL, NULL);
+        }
+#endif
+#ifdef SSL_SESSION_TICKETS
+        if ((confs[i].modes & CA_SESSION_RESUMPTION_TICKETS) && g_caSslContext->ticketsReady)
+        {
+            mbedtls_ssl_conf_session_tickets(confs[i].clientConf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+            mbedtls_ssl_conf_session_tickets_cb(confs[i].serverConf, WriteSessionTicket,
+                                                mbedtls_ssl_ticket_parse, &g_caSslContext->ticketCtx);
+        }
+        else
+        {
+            mbedtls_ssl_conf_session_tickets(confs[i].clientConf, MBEDTLS_SSL_SESSION_TICKETS_DISABLED);
+            mbedtls_ssl_conf_session_tickets_cb(confs[i].serverConf, NULL, NULL, NULL);
+        }
+#endif
+    }
+}
+
+/**
+ * Forgets the sessions kept by the server side, cached sessions are deleted and tickets
+ * issued so far can no longer be decrypted.
+ */
+static void ResetServerSessions()
+{
+    oc_mutex_assert_owner(g_sslContextMutex, true);
+    VERIFY_NON_NULL_VOID(g_caSslContext, NET_SSL_TAG, "SSL Context is NULL");
+
+#if defined(MBEDTLS_SSL_CACHE_C)
+    mbedtls_ssl_cache_free(&g_caSslContext->sessionCache);
+    mbedtls_ssl_cache_init(&g_caSslContext->sessionCache);
+    mbedtls_ssl_cache_set_timeout(&g_caSslContext->sessionCache, SSL_SESSION_LIFETIME);
+    mbedtls_ssl_cache_set_max_entries(&g_caSslContext->sessionCache, SSL_MAX_SESSIONS);
+#endif
+#ifdef SSL_SESSION_TICKETS
+    // new ticket keys
+    mbedtls_ssl_ticket_free(&g_caSslContext->ticketCtx);
+    mbedtls_ssl_ticket_init(&g_caSslContext->ticketCtx);
+    g_caSslContext->ticketsReady =
+        (0 == mbedtls_ssl_ticket_setup(&g_caSslContext->ticketCtx, SslRandom,
+                                       &g_caSslContext->rnd, MBEDTLS_CIPHER_AES_128_GCM,
+                                       SSL_SESSION_LIFETIME));
+    if (!g_caSslContext->ticketsReady)
+    {
+        OIC_LOG(ERROR, NET_SSL_TAG, "Session ticket setup failed!");
+    }
+    ConfigureSessionResumption();
+#endif
+}
+
+void CAsslInvalidatePkixInfo()
+{
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "In %s", __func__);
+    VERIFY_NON_NULL_VOID(g_sslContextMutex, NET_SSL_TAG, "context mutex is NULL");
+
+    oc_mutex_lock(g_sslContextMutex);
+    if (NULL != g_caSslContext)
+    {
+        // parsed again by the next handshake which needs them
+        g_caSslContext->pkixLoaded = false;
+        // sessions were authenticated with the old credentials
+        DeleteSessions(CA_ALL_ADAPTERS);
+        ResetServerSessions();
+    }
+    oc_mutex_unlock(g_sslContextMutex);
+
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
+}
+
 /*
  * PSK callback.
  *
@@ -807,49 +1329,124 @@ static int GetPskCredentialsCallback(void * notUsed, mbedtls_ssl_context * ssl,
     OIC_LOG_V(WARNING, NET_SSL_TAG, "Out %s", __func__);
     return -1;
 }
+static uint32_t HashBytes(uint32_t hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * Gets the bucket of the peer table for an endpoint.
+ *
+ * @param[in]  endpoint    remote address
+ *
+ * @return  index into peerTable
+ */
+static size_t GetPeerTableIndex(const CAEndpoint_t *endpoint)
+{
+    uint32_t hash = FNV_OFFSET_BASIS;
+    hash = HashBytes(hash, &endpoint->adapter, sizeof(endpoint->adapter));
+    hash = HashBytes(hash, endpoint->addr, strnlen(endpoint->addr, sizeof(endpoint->addr)));
+    // BLE peers are identified by their address only
+    if (CA_ADAPTER_GATT_BTLE != endpoint->adapter)
+    {
+        hash = HashBytes(hash, &endpoint->port, sizeof(endpoint->port));
+    }
+    return hash & (SSL_PEER_TABLE_SIZE - 1);
+}
+
+/**
+ * Gets session corresponding for endpoint.
+ *
+ * @param[in]  peer    remote address
+ *
+ * @return  TLS session or NULL
+ */
+static SslEndPoint_t *GetSslPeer(const CAEndpoint_t *peer)
+{
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "In %s", __func__);
+
+    oc_mutex_assert_owner(g_sslContextMutex, true);
+
+    VERIFY_NON_NULL_RET(peer, NET_SSL_TAG, "TLS peer is NULL", NULL);
+    VERIFY_NON_NULL_RET(g_caSslContext, NET_SSL_TAG, "SSL Context is NULL", NULL);
+
+    SslEndPoint_t *tep = g_caSslContext->peerTable[GetPeerTableIndex(peer)];
+    for (; NULL != tep; tep = tep->hashNext)
+    {
+        if((peer->adapter == tep->sep.endpoint.adapter)
+                && (0 == strncmp(peer->addr, tep->sep.endpoint.addr, MAX_ADDR_STR_SIZE_CA))
+                && (peer->port == tep->sep.endpoint.port || CA_ADAPTER_GATT_BTLE == peer->adapter))
+        {
+            OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
+            return tep;
+        }
+    }
+    OIC_LOG(DEBUG, NET_SSL_TAG, "Return NULL");
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
+    return NULL;
+}
+
+/**
+ * Adds endpoint with session to the peer list and table.
+ *
+ * @param[in]  tep    endpoint with session info
+ *
+ * @return  true on success
+ */
+static bool AddSslPeer(SslEndPoint_t *tep)
+{
+    oc_mutex_assert_owner(g_sslContextMutex, true);
+    VERIFY_NON_NULL_RET(g_caSslContext, NET_SSL_TAG, "SSL Context is NULL", false);
+
+    tep->listIndex = u_arraylist_length(g_caSslContext->peerList);
+    if (!u_arraylist_add(g_caSslContext->peerList, (void *) tep))
+    {
+        tep->listIndex = SSL_PEER_UNLISTED;
+        return false;
+    }
+    size_t index = GetPeerTableIndex(&tep->sep.endpoint);
+    tep->hashNext = g_caSslContext->peerTable[index];
+    g_caSslContext->peerTable[index] = tep;
+    tep->refCount = 1;
+    g_caSslContext->peerRefs++;
+    return true;
+}
+
 /**
- * Gets session corresponding for endpoint.
- *
- * @param[in]  peer    remote address
+ * Takes a reference to an endpoint, so it can be used without holding g_sslContextMutex.
  *
- * @return  TLS session or NULL
+ * @param[in]  tep    endpoint with session info
  */
-static SslEndPoint_t *GetSslPeer(const CAEndpoint_t *peer)
+static void AcquireSslPeer(SslEndPoint_t *tep)
 {
-    size_t listIndex = 0;
-    size_t listLength = 0;
-    OIC_LOG_V(DEBUG, NET_SSL_TAG, "In %s", __func__);
-
     oc_mutex_assert_owner(g_sslContextMutex, true);
 
-    VERIFY_NON_NULL_RET(peer, NET_SSL_TAG, "TLS peer is NULL", NULL);
-    VERIFY_NON_NULL_RET(g_caSslContext, NET_SSL_TAG, "SSL Context is NULL", NULL);
+    tep->refCount++;
+    g_caSslContext->peerRefs++;
+}
 
-    SslEndPoint_t *tep = NULL;
-    listLength = u_arraylist_length(g_caSslContext->peerList);
-    for (listIndex = 0; listIndex < listLength; listIndex++)
+/**
+ * Removes endpoint with session from the peer table, but not from the peer list.
+ *
+ * @param[in]  tep    endpoint with session info
+ */
+static void UnlinkSslPeer(SslEndPoint_t *tep)
+{
+    SslEndPoint_t **link = &g_caSslContext->peerTable[GetPeerTableIndex(&tep->sep.endpoint)];
+    for (; NULL != *link; link = &(*link)->hashNext)
     {
-        tep = (SslEndPoint_t *) u_arraylist_get(g_caSslContext->peerList, listIndex);
-        if (NULL == tep)
-        {
-            continue;
-        }
-
-        OIC_LOG_V(DEBUG, NET_SSL_TAG, "Compare [%s:%d] and [%s:%d] for %d adapter",
-                  peer->addr, peer->port, tep->sep.endpoint.addr, tep->sep.endpoint.port,
-                  peer->adapter);
-
-        if((peer->adapter == tep->sep.endpoint.adapter)
-                && (0 == strncmp(peer->addr, tep->sep.endpoint.addr, MAX_ADDR_STR_SIZE_CA))
-                && (peer->port == tep->sep.endpoint.port || CA_ADAPTER_GATT_BTLE == peer->adapter))
+        if (tep == *link)
         {
-            OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
-            return tep;
+            *link = tep->hashNext;
+            tep->hashNext = NULL;
+            return;
         }
     }
-    OIC_LOG(DEBUG, NET_SSL_TAG, "Return NULL");
-    OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
-    return NULL;
 }
 
 /**
@@ -1030,9 +1627,54 @@ static void DeleteSslEndPoint(SslEndPoint_t * tep)
 
     mbedtls_ssl_free(&tep->ssl);
     DeleteCacheList(tep->cacheList);
+    oc_mutex_free(tep->mutex);
     OICFree(tep);
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
 }
+/**
+ * Drops a reference to an endpoint, deletes it with the last one.
+ *
+ * @param[in]  tep    endpoint with session info
+ */
+static void ReleaseSslPeer(SslEndPoint_t * tep)
+{
+    oc_mutex_assert_owner(g_sslContextMutex, true);
+
+    // CAdeinitSslAdapter() keeps the context until all references are dropped
+    if (0 == --g_caSslContext->peerRefs)
+    {
+        oc_cond_broadcast(g_sslPeerReleasedCond);
+    }
+    if (0 == --tep->refCount)
+    {
+        DeleteSslEndPoint(tep);
+    }
+}
+/**
+ * Removes endpoint from the list, if it was not removed already, and drops the
+ * reference of the list.
+ *
+ * @param[in]  tep    endpoint with session info
+ */
+static void RemoveSslPeer(SslEndPoint_t * tep)
+{
+    oc_mutex_assert_owner(g_sslContextMutex, true);
+
+    if (NULL != g_caSslContext && SSL_PEER_UNLISTED != tep->listIndex)
+    {
+        // the last peer of the list takes the place of the removed one
+        u_arraylist_swap_remove(g_caSslContext->peerList, tep->listIndex);
+        SslEndPoint_t *moved =
+            (SslEndPoint_t *)u_arraylist_get(g_caSslContext->peerList, tep->listIndex);
+        if (NULL != moved)
+        {
+            moved->listIndex = tep->listIndex;
+        }
+        tep->listIndex = SSL_PEER_UNLISTED;
+        UnlinkSslPeer(tep);
+        ReleaseSslPeer(tep);
+    }
+}
 /**
  * Removes endpoint session from list.
  *
@@ -1045,21 +1687,10 @@ static void RemovePeerFromList(CAEndpoint_t * endpoint)
     VERIFY_NON_NULL_VOID(g_caSslContext, NET_SSL_TAG, "SSL Context is NULL");
     VERIFY_NON_NULL_VOID(endpoint, NET_SSL_TAG, "endpoint");
 
-    size_t listLength = u_arraylist_length(g_caSslContext->peerList);
-    for (size_t listIndex = 0; listIndex < listLength; listIndex++)
+    SslEndPoint_t * tep = GetSslPeer(endpoint);
+    if (NULL != tep)
     {
-        SslEndPoint_t * tep = (SslEndPoint_t *)u_arraylist_get(g_caSslContext->peerList, listIndex);
-        if (NULL == tep)
-        {
-            continue;
-        }
-        if(0 == strncmp(endpoint->addr, tep->sep.endpoint.addr, MAX_ADDR_STR_SIZE_CA)
-                && (endpoint->port == tep->sep.endpoint.port))
-        {
-            u_arraylist_remove(g_caSslContext->peerList, listIndex);
-            DeleteSslEndPoint(tep);
-            return;
-        }
+        RemoveSslPeer(tep);
     }
 }
 
@@ -1143,6 +1774,7 @@ static void DeletePeerList()
         {
             continue;
         }
+        oc_mutex_lock(tep->mutex);
         if (MBEDTLS_SSL_HANDSHAKE_OVER == tep->ssl.state)
         {
             int ret = 0;
@@ -1152,7 +1784,12 @@ static void DeletePeerList()
             }
             while (MBEDTLS_ERR_SSL_WANT_WRITE == ret);
         }
-        DeleteSslEndPoint(tep);
+        oc_mutex_unlock(tep->mutex);
+
+        // peers in use by CAencryptSsl() or CAdecryptSsl() are deleted when released
+        tep->listIndex = SSL_PEER_UNLISTED;
+        UnlinkSslPeer(tep);
+        ReleaseSslPeer(tep);
     }
     u_arraylist_free(&g_caSslContext->peerList);
 }
@@ -1178,13 +1815,15 @@ CAResult_t CAcloseSslConnection(const CAEndpoint_t *endpoint)
     }
     /* No error checking, the connection might be closed already */
     int ret = 0;
+    oc_mutex_lock(tep->mutex);
     do
     {
         ret = mbedtls_ssl_close_notify(&tep->ssl);
     }
     while (MBEDTLS_ERR_SSL_WANT_WRITE == ret);
+    oc_mutex_unlock(tep->mutex);
 
-    RemovePeerFromList(&tep->sep.endpoint);
+    RemoveSslPeer(tep);
     oc_mutex_unlock(g_sslContextMutex);
 
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
@@ -1230,9 +1869,8 @@ void CAcloseSslConnectionAll(CATransportAdapter_t transportType)
         }
         while (MBEDTLS_ERR_SSL_WANT_WRITE == ret);*/
 
-        // delete from list
-        u_arraylist_remove(g_caSslContext->peerList, i - 1);
-        DeleteSslEndPoint(tep);
+        // delete from list, only peers already visited are moved
+        RemoveSslPeer(tep);
     }
     oc_mutex_unlock(g_sslContextMutex);
 
@@ -1264,6 +1902,7 @@ static SslEndPoint_t * NewSslEndPoint(const CAEndpoint_t * endpoint, mbedtls_ssl
 
     tep->sep.endpoint = *endpoint;
     tep->sep.endpoint.flags = (CATransportFlags_t)(tep->sep.endpoint.flags | CA_SECURE);
+    tep->listIndex = SSL_PEER_UNLISTED;
 
     if(0 != mbedtls_ssl_setup(&tep->ssl, config))
     {
@@ -1300,6 +1939,17 @@ static SslEndPoint_t * NewSslEndPoint(const CAEndpoint_t * endpoint, mbedtls_ssl
         OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
         return NULL;
     }
+    // recursive, the upper layer may send to the peer while its data is received
+    tep->mutex = oc_mutex_new_recursive();
+    if (NULL == tep->mutex)
+    {
+        OIC_LOG(ERROR, NET_SSL_TAG, "mutex initialization failed!");
+        u_arraylist_free(&tep->cacheList);
+        mbedtls_ssl_free(&tep->ssl);
+        OICFree(tep);
+        OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
+        return NULL;
+    }
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "New [%s role] endpoint added [%s:%d]",
             (MBEDTLS_SSL_IS_SERVER==config->endpoint ? "server" : "client"),
             endpoint->addr, endpoint->port);
@@ -1472,8 +2122,8 @@ static SslEndPoint_t * InitiateTlsHandshake(const CAEndpoint_t *endpoint)
     }
 
     oc_mutex_lock(g_sslContextMutex);
-    ret = u_arraylist_add(g_caSslContext->peerList, (void *) tep);
-    if (!ret)
+    LoadSslSession(tep);
+    if (!AddSslPeer(tep))
     {
         oc_mutex_unlock(g_sslContextMutex);
         OIC_LOG(ERROR, NET_SSL_TAG, "u_arraylist_add failed!");
@@ -1500,9 +2150,9 @@ static SslEndPoint_t * InitiateTlsHandshake(const CAEndpoint_t *endpoint)
                                "Handshake error",
                                MBEDTLS_SSL_ALERT_MSG_HANDSHAKE_FAILURE))
         {
+            // checkSslOperation() removed and deleted tep already
             oc_mutex_unlock(g_sslContextMutex);
             OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
-            DeleteSslEndPoint(tep);
             return NULL;
         }
     }
@@ -1537,9 +2187,25 @@ void CAdeinitSslAdapter()
     // Clear all lists
     DeletePeerList();
 
+    // peers still in use refer to the configs, wait until they are released
+    while (0 < g_caSslContext->peerRefs)
+    {
+        oc_cond_wait(g_sslPeerReleasedCond, g_sslContextMutex);
+    }
+    DeleteSessions(CA_ALL_ADAPTERS);
+    u_arraylist_free(&g_caSslContext->sessionList);
+
     // De-initialize mbedTLS
+    mbedtls_x509_crt_free(&g_caSslContext->ca);
     mbedtls_x509_crt_free(&g_caSslContext->crt);
     mbedtls_pk_free(&g_caSslContext->pkey);
+    mbedtls_x509_crl_free(&g_caSslContext->crl);
+#if defined(MBEDTLS_SSL_CACHE_C)
+    mbedtls_ssl_cache_free(&g_caSslContext->sessionCache);
+#endif
+#ifdef SSL_SESSION_TICKETS
+    mbedtls_ssl_ticket_free(&g_caSslContext->ticketCtx);
+#endif
 #ifdef __WITH_TLS__
     mbedtls_ssl_config_free(&g_caSslContext->clientTlsConf);
     mbedtls_ssl_config_free(&g_caSslContext->serverTlsConf);
@@ -1551,6 +2217,15 @@ void CAdeinitSslAdapter()
 #endif // __WITH_DTLS__
     mbedtls_ctr_drbg_free(&g_caSslContext->rnd);
     mbedtls_entropy_free(&g_caSslContext->entropy);
+    oc_mutex_free(g_sslRndMutex);
+    g_sslRndMutex = NULL;
+    oc_mutex_free(g_sslCookieMutex);
+    g_sslCookieMutex = NULL;
+    if (NULL != g_sslPeerReleasedCond)
+    {
+        oc_cond_free(g_sslPeerReleasedCond);
+        g_sslPeerReleasedCond = NULL;
+    }
 #ifdef __WITH_DTLS__
     StopRetransmit();
 #endif
@@ -1583,7 +2258,7 @@ static int InitConfig(mbedtls_ssl_config * conf, int transport, int mode)
      * time, see extlibs/mbedtls/config-iotivity.h
      */
     mbedtls_ssl_conf_psk_cb(conf, GetPskCredentialsCallback, NULL);
-    mbedtls_ssl_conf_rng(conf, mbedtls_ctr_drbg_random, &g_caSslContext->rnd);
+    mbedtls_ssl_conf_rng(conf, SslRandom, &g_caSslContext->rnd);
     mbedtls_ssl_conf_curves(conf, curve[ADAPTER_CURVE_SECP256R1]);
     mbedtls_ssl_conf_authmode(conf, MBEDTLS_SSL_VERIFY_REQUIRED);
 
@@ -1591,11 +2266,16 @@ static int InitConfig(mbedtls_ssl_config * conf, int transport, int mode)
     if (MBEDTLS_SSL_TRANSPORT_DATAGRAM == transport &&
             MBEDTLS_SSL_IS_SERVER == mode)
     {
-        mbedtls_ssl_conf_dtls_cookies(conf, mbedtls_ssl_cookie_write, mbedtls_ssl_cookie_check,
+        mbedtls_ssl_conf_dtls_cookies(conf, SslCookieWrite, SslCookieCheck,
                                       &g_caSslContext->cookieCtx);
     }
 #endif // __WITH_DTLS__
 
+#ifdef SSL_SESSION_TICKETS
+    // enabled per adapter by CAsetTlsSessionResumption()
+    mbedtls_ssl_conf_session_tickets(conf, MBEDTLS_SSL_SESSION_TICKETS_DISABLED);
+#endif
+
     /* Set TLS 1.2 as the minimum allowed version. */
     mbedtls_ssl_conf_min_version(conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
 
@@ -1709,6 +2389,21 @@ CAResult_t CAinitSslAdapter()
         return CA_STATUS_FAILED;
     }
 
+    // Create list of sessions kept as client
+    g_caSslContext->sessionList = u_arraylist_create();
+
+    if(NULL == g_caSslContext->sessionList)
+    {
+        OIC_LOG(ERROR, NET_SSL_TAG, "sessionList initialization failed!");
+        u_arraylist_free(&g_caSslContext->peerList);
+        OICFree(g_caSslContext);
+        g_caSslContext = NULL;
+        oc_mutex_unlock(g_sslContextMutex);
+        oc_mutex_free(g_sslContextMutex);
+        g_sslContextMutex = NULL;
+        return CA_STATUS_FAILED;
+    }
+
     /* Initialize TLS library
      */
 #if !defined(NDEBUG) || defined(TB_LOG)
@@ -1723,6 +2418,16 @@ CAResult_t CAinitSslAdapter()
 
     /* Entropy settings
      */
+    g_sslRndMutex = oc_mutex_new();
+    g_sslCookieMutex = oc_mutex_new();
+    g_sslPeerReleasedCond = oc_cond_new();
+    if (NULL == g_sslRndMutex || NULL == g_sslCookieMutex || NULL == g_sslPeerReleasedCond)
+    {
+        OIC_LOG(ERROR, NET_SSL_TAG, "oc_mutex_new or oc_cond_new failed");
+        oc_mutex_unlock(g_sslContextMutex);
+        CAdeinitSslAdapter();
+        return CA_MEMORY_ALLOC_FAILED;
+    }
     mbedtls_entropy_init(&g_caSslContext->entropy);
     mbedtls_ctr_drbg_init(&g_caSslContext->rnd);
 
@@ -1737,6 +2442,24 @@ CAResult_t CAinitSslAdapter()
     }
     mbedtls_ctr_drbg_set_prediction_resistance(&g_caSslContext->rnd, MBEDTLS_CTR_DRBG_PR_ON);
 
+    // Server side session resumption, used once enabled by CAsetTlsSessionResumption()
+#if defined(MBEDTLS_SSL_CACHE_C)
+    mbedtls_ssl_cache_init(&g_caSslContext->sessionCache);
+    mbedtls_ssl_cache_set_timeout(&g_caSslContext->sessionCache, SSL_SESSION_LIFETIME);
+    mbedtls_ssl_cache_set_max_entries(&g_caSslContext->sessionCache, SSL_MAX_SESSIONS);
+#endif
+#ifdef SSL_SESSION_TICKETS
+    mbedtls_ssl_ticket_init(&g_caSslContext->ticketCtx);
+    g_caSslContext->ticketsReady =
+        (0 == mbedtls_ssl_ticket_setup(&g_caSslContext->ticketCtx, SslRandom,
+                                       &g_caSslContext->rnd, MBEDTLS_CIPHER_AES_128_GCM,
+                                       SSL_SESSION_LIFETIME));
+    if (!g_caSslContext->ticketsReady)
+    {
+        OIC_LOG(ERROR, NET_SSL_TAG, "Session ticket setup failed!");
+    }
+#endif
+
 #ifdef __WITH_TLS__
     if (0 != InitConfig(&g_caSslContext->clientTlsConf,
                         MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_IS_CLIENT))
@@ -1886,33 +2609,7 @@ CAResult_t CAencryptSsl(const CAEndpoint_t *endpoint,
         return CA_STATUS_FAILED;
     }
 
-    if (MBEDTLS_SSL_HANDSHAKE_OVER == tep->ssl.state)
-    {
-        unsigned char *dataBuf = (unsigned char *)data;
-        size_t written = 0;
-
-        do
-        {
-            ret = mbedtls_ssl_write(&tep->ssl, dataBuf, dataLen - written);
-            if (ret < 0)
-            {
-                if (MBEDTLS_ERR_SSL_WANT_WRITE != ret)
-                {
-                    OIC_LOG_V(ERROR, NET_SSL_TAG, "mbedTLS write failed! returned 0x%x", -ret);
-                    RemovePeerFromList(&tep->sep.endpoint);
-                    oc_mutex_unlock(g_sslContextMutex);
-                    return CA_STATUS_FAILED;
-                }
-                continue;
-            }
-            OIC_LOG_V(DEBUG, NET_SSL_TAG, "mbedTLS write returned with sent bytes[%d]", ret);
-
-            dataBuf += ret;
-            written += ret;
-        } while (dataLen > written);
-
-    }
-    else
+    if (MBEDTLS_SSL_HANDSHAKE_OVER != tep->ssl.state)
     {
         SslCacheMessage_t * msg = NewCacheMessage((uint8_t*) data, dataLen);
         if (NULL == msg || !u_arraylist_add(tep->cacheList, (void *) msg))
@@ -1921,12 +2618,50 @@ CAResult_t CAencryptSsl(const CAEndpoint_t *endpoint,
             oc_mutex_unlock(g_sslContextMutex);
             return CA_STATUS_FAILED;
         }
+        oc_mutex_unlock(g_sslContextMutex);
+        OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
+        return CA_STATUS_OK;
     }
 
+    // The handshake is over, writing only needs the mutex of the peer
+    AcquireSslPeer(tep);
+    oc_mutex_unlock(g_sslContextMutex);
+
+    CAResult_t res = CA_STATUS_OK;
+    unsigned char *dataBuf = (unsigned char *)data;
+    size_t written = 0;
+
+    oc_mutex_lock(tep->mutex);
+    do
+    {
+        ret = mbedtls_ssl_write(&tep->ssl, dataBuf, dataLen - written);
+        if (ret < 0)
+        {
+            if (MBEDTLS_ERR_SSL_WANT_WRITE != ret)
+            {
+                OIC_LOG_V(ERROR, NET_SSL_TAG, "mbedTLS write failed! returned 0x%x", -ret);
+                res = CA_STATUS_FAILED;
+                break;
+            }
+            continue;
+        }
+        OIC_LOG_V(DEBUG, NET_SSL_TAG, "mbedTLS write returned with sent bytes[%d]", ret);
+
+        dataBuf += ret;
+        written += ret;
+    } while (dataLen > written);
+    oc_mutex_unlock(tep->mutex);
+
+    oc_mutex_lock(g_sslContextMutex);
+    if (CA_STATUS_OK != res)
+    {
+        RemoveSslPeer(tep);
+    }
+    ReleaseSslPeer(tep);
     oc_mutex_unlock(g_sslContextMutex);
 
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
-    return CA_STATUS_OK;
+    return res;
 }
 /**
  * Sends cached messages via TLS connection.
@@ -1942,6 +2677,7 @@ static void SendCacheMessages(SslEndPoint_t * tep)
 
     VERIFY_NON_NULL_VOID(tep, NET_SSL_TAG, "Param tep is NULL");
 
+    oc_mutex_lock(tep->mutex);
     size_t listIndex = 0;
     size_t listLength = 0;
     listLength = u_arraylist_length(tep->cacheList);
@@ -1990,6 +2726,7 @@ static void SendCacheMessages(SslEndPoint_t * tep)
             ++listIndex;
         }
     }
+    oc_mutex_unlock(tep->mutex);
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
 }
 
@@ -2006,6 +2743,82 @@ void CAsetSslHandshakeCallback(CAErrorCallback tlsHandshakeCallback)
 
 /* Read data from TLS connection
  */
+/**
+ * Decrypts a record received from a peer the handshake is over with and passes the data
+ * to the upper layer. Called without g_sslContextMutex, with a reference to the peer
+ * which is dropped.
+ *
+ * @param[in]  peer    endpoint with session info
+ * @param[in]  data    received record
+ * @param[in]  dataLen    record length
+ * @param[in]  recvCallback    callback of the adapter to pass the data to, NULL if the
+ *                             adapter is not supported
+ *
+ * @return  ::CA_STATUS_OK or ::CA_STATUS_FAILED
+ */
+static CAResult_t ReadSslRecord(SslEndPoint_t *peer, uint8_t *data, size_t dataLen,
+                                CAPacketReceivedCallback recvCallback)
+{
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "In %s", __func__);
+    int ret = 0;
+    bool closed = false;
+    uint8_t decryptBuffer[TLS_MSG_BUF_LEN] = {0};
+
+    oc_mutex_lock(peer->mutex);
+    peer->recBuf.buff = data;
+    peer->recBuf.len = dataLen;
+    peer->recBuf.loaded = 0;
+    do
+    {
+        ret = mbedtls_ssl_read(&peer->ssl, decryptBuffer, TLS_MSG_BUF_LEN);
+    } while (MBEDTLS_ERR_SSL_WANT_READ == ret);
+
+    if (MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY == ret ||
+        // TinyDTLS sends fatal close_notify alert
+        (MBEDTLS_ERR_SSL_FATAL_ALERT_MESSAGE == ret &&
+         MBEDTLS_SSL_ALERT_LEVEL_FATAL == peer->ssl.in_msg[0] &&
+         MBEDTLS_SSL_ALERT_MSG_CLOSE_NOTIFY == peer->ssl.in_msg[1]))
+    {
+        closed = true;
+    }
+    oc_mutex_unlock(peer->mutex);
+
+    CAResult_t res = CA_STATUS_OK;
+    if (closed)
+    {
+        OIC_LOG(INFO, NET_SSL_TAG, "Connection was closed gracefully");
+    }
+    else if (0 > ret)
+    {
+        OIC_LOG_V(ERROR, NET_SSL_TAG, "mbedtls_ssl_read returned -0x%x", -ret);
+        res = CA_STATUS_FAILED;
+    }
+    else if (0 < ret)
+    {
+        // Not holding the mutex of the peer, the upper layer may respond right away
+        if (NULL != recvCallback)
+        {
+            recvCallback(&peer->sep, decryptBuffer, ret);
+        }
+        else
+        {
+            OIC_LOG(ERROR, NET_SSL_TAG, "Unsuported adapter");
+            res = CA_STATUS_FAILED;
+        }
+    }
+
+    oc_mutex_lock(g_sslContextMutex);
+    if (closed || CA_STATUS_OK != res)
+    {
+        RemoveSslPeer(peer);
+    }
+    ReleaseSslPeer(peer);
+    oc_mutex_unlock(g_sslContextMutex);
+
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
+    return res;
+}
+
 CAResult_t CAdecryptSsl(const CASecureEndpoint_t *sep, uint8_t *data, size_t dataLen)
 {
     int ret = 0;
@@ -2023,6 +2836,19 @@ CAResult_t CAdecryptSsl(const CASecureEndpoint_t *sep, uint8_t *data, size_t dat
 
 
     SslEndPoint_t * peer = GetSslPeer(&sep->endpoint);
+    if (NULL != peer && MBEDTLS_SSL_HANDSHAKE_OVER == peer->ssl.state)
+    {
+        // The handshake is over, reading only needs the mutex of the peer
+        int adapterIndex = GetAdapterIndex(peer->sep.endpoint.adapter);
+        CAPacketReceivedCallback recvCallback = NULL;
+        if (0 <= adapterIndex && MAX_SUPPORTED_ADAPTERS > adapterIndex)
+        {
+            recvCallback = g_caSslContext->adapterCallbacks[adapterIndex].recvCallback;
+        }
+        AcquireSslPeer(peer);
+        oc_mutex_unlock(g_sslContextMutex);
+        return ReadSslRecord(peer, data, dataLen, recvCallback);
+    }
     if (NULL == peer)
     {
         mbedtls_ssl_config * config = (sep->endpoint.adapter == CA_ADAPTER_IP ||
@@ -2044,8 +2870,7 @@ CAResult_t CAdecryptSsl(const CASecureEndpoint_t *sep, uint8_t *data, size_t dat
             return CA_STATUS_FAILED;
         }
 
-        ret = u_arraylist_add(g_caSslContext->peerList, (void *) peer);
-        if (!ret)
+        if (!AddSslPeer(peer))
         {
             OIC_LOG(ERROR, NET_SSL_TAG, "u_arraylist_add failed!");
             DeleteSslEndPoint(peer);
@@ -2102,6 +2927,14 @@ CAResult_t CAdecryptSsl(const CASecureEndpoint_t *sep, uint8_t *data, size_t dat
         {
             memcpy(peer->master, peer->ssl.session_negotiate->master, sizeof(peer->master));
             g_caSslContext->selectedCipher = peer->ssl.session_negotiate->ciphersuite;
+            if (peer->ssl.handshake->resume)
+            {
+                /* An abbreviated handshake has no key exchange and the keys are derived
+                 * already, which swapped the randoms to server random first. */
+                peer->resumed = true;
+                memcpy(peer->random, peer->ssl.handshake->randbytes + RANDOM_LEN, RANDOM_LEN);
+                memcpy(peer->random + RANDOM_LEN, peer->ssl.handshake->randbytes, RANDOM_LEN);
+            }
         }
         if (MBEDTLS_SSL_CLIENT_KEY_EXCHANGE == peer->ssl.state)
         {
@@ -2110,9 +2943,22 @@ CAResult_t CAdecryptSsl(const CASecureEndpoint_t *sep, uint8_t *data, size_t dat
 
         if (MBEDTLS_SSL_HANDSHAKE_OVER == peer->ssl.state)
         {
+            if (peer->resumed)
+            {
+                g_caSslContext->resumedHandshakes++;
+            }
+            else
+            {
+                g_caSslContext->fullHandshakes++;
+            }
+            OIC_LOG_V(DEBUG, NET_SSL_TAG, "%s handshake, full: %u, resumed: %u",
+                      peer->resumed ? "Resumed" : "Full", g_caSslContext->fullHandshakes,
+                      g_caSslContext->resumedHandshakes);
+
             SSL_RES(peer, CA_STATUS_OK);
             if (MBEDTLS_SSL_IS_CLIENT == peer->ssl.conf->endpoint)
             {
+                SaveSslSession(peer);
                 SendCacheMessages(peer);
             }
 
@@ -2247,51 +3093,6 @@ CAResult_t CAdecryptSsl(const CASecureEndpoint_t *sep, uint8_t *data, size_t dat
         }
     }
 
-    if (MBEDTLS_SSL_HANDSHAKE_OVER == peer->ssl.state)
-    {
-        uint8_t decryptBuffer[TLS_MSG_BUF_LEN] = {0};
-        do
-        {
-            ret = mbedtls_ssl_read(&peer->ssl, decryptBuffer, TLS_MSG_BUF_LEN);
-        } while (MBEDTLS_ERR_SSL_WANT_READ == ret);
-
-        if (MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY == ret ||
-            // TinyDTLS sends fatal close_notify alert
-            (MBEDTLS_ERR_SSL_FATAL_ALERT_MESSAGE == ret &&
-             MBEDTLS_SSL_ALERT_LEVEL_FATAL == peer->ssl.in_msg[0] &&
-             MBEDTLS_SSL_ALERT_MSG_CLOSE_NOTIFY == peer->ssl.in_msg[1]))
-        {
-            OIC_LOG(INFO, NET_SSL_TAG, "Connection was closed gracefully");
-            RemovePeerFromList(&peer->sep.endpoint);
-            oc_mutex_unlock(g_sslContextMutex);
-            return CA_STATUS_OK;
-        }
-
-        if (0 > ret)
-        {
-            OIC_LOG_V(ERROR, NET_SSL_TAG, "mbedtls_ssl_read returned -0x%x", -ret);
-            //SSL_RES(peer, CA_STATUS_FAILED);
-            RemovePeerFromList(&peer->sep.endpoint);
-            oc_mutex_unlock(g_sslContextMutex);
-            return CA_STATUS_FAILED;
-        }
-        else if (0 < ret)
-        {
-            int adapterIndex = GetAdapterIndex(peer->sep.endpoint.adapter);
-            if (0 <= adapterIndex && MAX_SUPPORTED_ADAPTERS > adapterIndex)
-            {
-                g_caSslContext->adapterCallbacks[adapterIndex].recvCallback(&peer->sep, decryptBuffer, ret);
-            }
-            else
-            {
-                OIC_LOG(ERROR, NET_SSL_TAG, "Unsuported adapter");
-                RemovePeerFromList(&peer->sep.endpoint);
-                oc_mutex_unlock(g_sslContextMutex);
-                return CA_STATUS_FAILED;
-            }
-        }
-    }
-
     oc_mutex_unlock(g_sslContextMutex);
     OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
     return CA_STATUS_OK;
@@ -2432,6 +3233,57 @@ CAResult_t CAsetTlsCipherSuite(const uint32_t cipher)
     return CA_STATUS_OK;
 }
 
+CAResult_t CAsetTlsSessionResumption(CATransportAdapter_t adapter, uint32_t modes)
+{
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "In %s", __func__);
+    int adapterIndex = GetAdapterIndex(adapter);
+    if (0 > adapterIndex ||
+        0 != (modes & ~(uint32_t)(CA_SESSION_RESUMPTION_CACHE | CA_SESSION_RESUMPTION_TICKETS)))
+    {
+        OIC_LOG(ERROR, NET_SSL_TAG, "Invalid adapter or modes");
+        return CA_STATUS_INVALID_PARAM;
+    }
+    VERIFY_NON_NULL_RET(g_sslContextMutex, NET_SSL_TAG, "context mutex is NULL",
+                        CA_STATUS_NOT_INITIALIZED);
+
+    oc_mutex_lock(g_sslContextMutex);
+    if (NULL == g_caSslContext)
+    {
+        OIC_LOG(ERROR, NET_SSL_TAG, "SSL context is not initialized.");
+        oc_mutex_unlock(g_sslContextMutex);
+        return CA_STATUS_NOT_INITIALIZED;
+    }
+
+    g_caSslContext->sessionResumption[adapterIndex] = modes;
+    if (CA_SESSION_RESUMPTION_NONE == modes)
+    {
+        DeleteSessions(adapter);
+    }
+    ConfigureSessionResumption();
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "Session resumption of adapter %d: 0x%x", adapter, modes);
+
+    oc_mutex_unlock(g_sslContextMutex);
+    OIC_LOG_V(DEBUG, NET_SSL_TAG, "Out %s", __func__);
+    return CA_STATUS_OK;
+}
+
+void CAsslGetHandshakeStats(uint32_t *full, uint32_t *resumed)
+{
+    VERIFY_NON_NULL_VOID(full, NET_SSL_TAG, "full is NULL");
+    VERIFY_NON_NULL_VOID(resumed, NET_SSL_TAG, "resumed is NULL");
+    *full = 0;
+    *resumed = 0;
+    VERIFY_NON_NULL_VOID(g_sslContextMutex, NET_SSL_TAG, "context mutex is NULL");
+
+    oc_mutex_lock(g_sslContextMutex);
+    if (NULL != g_caSslContext)
+    {
+        *full = g_caSslContext->fullHandshakes;
+        *resumed = g_caSslContext->resumedHandshakes;
+    }
+    oc_mutex_unlock(g_sslContextMutex);
+}
+
 CAResult_t CAinitiateSslHandshake(const CAEndpoint_t *endpoint)
 {
     CAResult_t res = CA_STATUS_OK;
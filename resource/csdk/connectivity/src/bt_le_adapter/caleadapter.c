@@ -3612,6 +3612,21 @@ static void CALEErrorHandler(const char *remoteAddress,
 }
 
 #ifndef SINGLE_THREAD
+static bool CALECompareSendDataAddress(void *data, uint32_t size, void *ctx)
+{
+    (void)size;
+    CALEData_t *bleData = (CALEData_t *) data;
+    const char *address = (const char *) ctx;
+
+    if (bleData && bleData->remoteEndpoint
+        && !strcasecmp(bleData->remoteEndpoint->addr, address))
+    {
+        OIC_LOG(DEBUG, CALEADAPTER_TAG, "found the message of disconnected device");
+        return true;
+    }
+    return false;
+}
+
 static void CALERemoveSendQueueData(CAQueueingThread_t *queueHandle, oc_mutex mutex,
                                     const char* address)
 {
@@ -3621,32 +3636,7 @@ static void CALERemoveSendQueueData(CAQueueingThread_t *queueHandle, oc_mutex mu
     VERIFY_NON_NULL_VOID(address, CALEADAPTER_TAG, "address");
 
     oc_mutex_lock(mutex);
-    while (u_queue_get_size(queueHandle->dataQueue) > 0)
-    {
-        OIC_LOG(DEBUG, CALEADAPTER_TAG, "get data from queue");
-        u_queue_message_t *message = u_queue_get_element(queueHandle->dataQueue);
-        if (NULL != message)
-        {
-            CALEData_t *bleData = (CALEData_t *) message->msg;
-            if (bleData && bleData->remoteEndpoint)
-            {
-                if (!strcasecmp(bleData->remoteEndpoint->addr, address))
-                {
-                    OIC_LOG(DEBUG, CALEADAPTER_TAG, "found the message of disconnected device");
-                    if (NULL != queueHandle->destroy)
-                    {
-                        queueHandle->destroy(message->msg, message->size);
-                    }
-                    else
-                    {
-                        OICFree(message->msg);
-                    }
-
-                    OICFree(message);
-                }
-            }
-        }
-    }
+    CAQueueingThreadClearContextData(queueHandle, CALECompareSendDataAddress, (void *) address);
     oc_mutex_unlock(mutex);
 }
 
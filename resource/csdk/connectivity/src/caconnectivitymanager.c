@@ -30,6 +30,7 @@
 #include "caprotocolmessage.h"
 #include "canetworkconfigurator.h"
 #include "cainterfacecontroller.h"
+#include "caduplicatefilter.h"
 #include "logger.h"
 
 #if defined(__WITH_DTLS__) || defined(__WITH_TLS__)
@@ -228,6 +229,19 @@ CAResult_t CAregisterPkixInfoHandler(CAgetPkixInfoHandler getPkixInfoHandler)
     return CA_STATUS_OK;
 }
 
+CAResult_t CAinvalidatePkixInfo()
+{
+    OIC_LOG_V(DEBUG, TAG, "In %s", __func__);
+
+    if (!g_isInitialized)
+    {
+        return CA_STATUS_NOT_INITIALIZED;
+    }
+    CAsslInvalidatePkixInfo();
+    OIC_LOG_V(DEBUG, TAG, "Out %s", __func__);
+    return CA_STATUS_OK;
+}
+
 CAResult_t CAregisterGetCredentialTypesHandler(CAgetCredentialTypesHandler getCredTypesHandler)
 {
     OIC_LOG_V(DEBUG, TAG, "In %s", __func__);
@@ -505,6 +519,53 @@ CAResult_t CAHandleRequestResponse()
     return CA_STATUS_OK;
 }
 
+#ifndef SINGLE_THREAD
+CAResult_t CASetReceiveWorkerCount(uint8_t count)
+{
+    if (g_isInitialized)
+    {
+        OIC_LOG(ERROR, TAG, "receive workers must be set before CAInitialize");
+        return CA_STATUS_FAILED;
+    }
+
+    return CASetReceiveWorkers(count);
+}
+
+CAResult_t CARegisterProcessEvent(struct oc_event_t *event)
+{
+    return CAAddProcessEvent(event);
+}
+
+void CAUnregisterProcessEvent(struct oc_event_t *event)
+{
+    CARemoveProcessEvent(event);
+}
+#endif
+
+CAResult_t CASetExchangeLifetime(uint32_t lifetime)
+{
+    if (0 == lifetime)
+    {
+        OIC_LOG(ERROR, TAG, "invalid lifetime");
+        return CA_STATUS_INVALID_PARAM;
+    }
+
+    CADuplicateFilterSetLifetime(lifetime);
+    return CA_STATUS_OK;
+}
+
+CAResult_t CAGetDuplicateFilterStats(uint32_t *hits, uint32_t *misses)
+{
+    if (!hits || !misses)
+    {
+        OIC_LOG(ERROR, TAG, "Invalid Parameter");
+        return CA_STATUS_INVALID_PARAM;
+    }
+
+    CADuplicateFilterGetStats(hits, misses);
+    return CA_STATUS_OK;
+}
+
 CAResult_t CASelectCipherSuite(const uint16_t cipher, CATransportAdapter_t adapter)
 {
     (void)(adapter); // prevent unused-parameter warning when building release variant
@@ -525,6 +586,45 @@ CAResult_t CASelectCipherSuite(const uint16_t cipher, CATransportAdapter_t adapt
     return res;
 }
 
+CAResult_t CASetSessionResumption(CATransportAdapter_t adapter, uint32_t modes)
+{
+    OIC_LOG_V(DEBUG, TAG, "IN %s", __func__);
+    OIC_LOG_V(DEBUG, TAG, "modes : %u , CATransportAdapter : %d", modes, adapter);
+    CAResult_t res = CA_STATUS_FAILED;
+#if defined (__WITH_DTLS__) || defined(__WITH_TLS__)
+    res = CAsetTlsSessionResumption(adapter, modes);
+    if (CA_STATUS_OK != res)
+    {
+        OIC_LOG_V(ERROR, TAG, "Failed to CAsetTlsSessionResumption : %d", res);
+    }
+#else
+    (void)(adapter); // prevent unused-parameter warning
+    (void)(modes);
+    OIC_LOG(ERROR, TAG, "Method not supported");
+#endif
+    OIC_LOG_V(DEBUG, TAG, "Out %s", __func__);
+    return res;
+}
+
+CAResult_t CAGetHandshakeStats(uint32_t *full, uint32_t *resumed)
+{
+    OIC_LOG_V(DEBUG, TAG, "IN %s", __func__);
+    if (!full || !resumed)
+    {
+        OIC_LOG(ERROR, TAG, "Invalid Parameter");
+        return CA_STATUS_INVALID_PARAM;
+    }
+    CAResult_t res = CA_STATUS_FAILED;
+#if defined (__WITH_DTLS__) || defined(__WITH_TLS__)
+    CAsslGetHandshakeStats(full, resumed);
+    res = CA_STATUS_OK;
+#else
+    OIC_LOG(ERROR, TAG, "Method not supported");
+#endif
+    OIC_LOG_V(DEBUG, TAG, "Out %s", __func__);
+    return res;
+}
+
 CAResult_t CAEnableAnonECDHCipherSuite(const bool enable)
 {
     OIC_LOG(DEBUG, TAG, "CAEnableAnonECDHCipherSuite");
@@ -0,0 +1,295 @@
+/******************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "caduplicatefilter.h"
+#include "octhread.h"
+#include "uhashmap.h"
+#include "oic_malloc.h"
+#include "oic_time.h"
+#include "logger.h"
+#include <coap/utlist.h>
+
+#define TAG "OIC_CA_DUP_FILTER"
+
+/** kinds of keys stored in the filter. **/
+#define CA_DUPLICATE_KEY_ENDPOINT   0
+#define CA_DUPLICATE_KEY_ANY_FAMILY 1
+
+/** kind, message ID, ifindex, token length, token, port and address. **/
+#define CA_DUPLICATE_KEY_MAX (1 + sizeof(uint16_t) + sizeof(uint32_t) + 1 + CA_MAX_TOKEN_LEN \
+                              + sizeof(uint16_t) + MAX_ADDR_STR_SIZE_CA)
+
+typedef struct CADuplicateEntry
+{
+    struct CADuplicateEntry *prev;
+    struct CADuplicateEntry *next;
+    uint64_t received;              /**< time in msec when the message was received */
+    size_t keyLen;
+    unsigned char key[CA_DUPLICATE_KEY_MAX];
+} CADuplicateEntry_t;
+
+static oc_mutex g_filterMutex = NULL;
+
+/** key to entry, the entries are also listed oldest first. **/
+static u_hashmap_t *g_filterMap = NULL;
+static CADuplicateEntry_t *g_filterList = NULL;
+static size_t g_filterCount = 0;
+
+static uint32_t g_filterLifetime = CA_DEFAULT_EXCHANGE_LIFETIME_MSEC;
+static uint32_t g_filterHits = 0;
+static uint32_t g_filterMisses = 0;
+
+static size_t CABuildDuplicateKey(unsigned char *key, uint8_t kind, const CAEndpoint_t *ep,
+                                  uint16_t messageId, const CAToken_t token,
+                                  uint8_t tokenLength)
+{
+    size_t len = 0;
+
+    key[len++] = kind;
+    memcpy(key + len, &messageId, sizeof(messageId));
+    len += sizeof(messageId);
+    memcpy(key + len, &ep->ifindex, sizeof(ep->ifindex));
+    len += sizeof(ep->ifindex);
+    key[len++] = tokenLength;
+    if (token && tokenLength)
+    {
+        memcpy(key + len, token, tokenLength);
+        len += tokenLength;
+    }
+
+    if (CA_DUPLICATE_KEY_ENDPOINT == kind)
+    {
+        memcpy(key + len, &ep->port, sizeof(ep->port));
+        len += sizeof(ep->port);
+        size_t addrLen = strnlen(ep->addr, sizeof(ep->addr));
+        memcpy(key + len, ep->addr, addrLen);
+        len += addrLen;
+    }
+    return len;
+}
+
+static void CARemoveDuplicateEntry(CADuplicateEntry_t *entry)
+{
+    u_hashmap_remove(g_filterMap, entry->key, entry->keyLen);
+    DL_DELETE(g_filterList, entry);
+    g_filterCount--;
+    OICFree(entry);
+}
+
+static void CAPurgeDuplicateEntries(uint64_t now)
+{
+    // the list is ordered by reception time, so the expired entries lead it
+    // whatever the lifetime is.
+    while (g_filterList && g_filterList->received + g_filterLifetime <= now)
+    {
+        CARemoveDuplicateEntry(g_filterList);
+    }
+}
+
+static void CARememberDuplicateKey(const unsigned char *key, size_t keyLen, uint64_t now)
+{
+    if (CA_DUPLICATE_FILTER_MAX_ENTRIES <= g_filterCount)
+    {
+        // evict the oldest entry.
+        CARemoveDuplicateEntry(g_filterList);
+    }
+
+    CADuplicateEntry_t *entry = (CADuplicateEntry_t *) OICMalloc(sizeof(CADuplicateEntry_t));
+    if (!entry)
+    {
+        OIC_LOG(ERROR, TAG, "memory allocation failed");
+        return;
+    }
+
+    entry->received = now;
+    entry->keyLen = keyLen;
+    memcpy(entry->key, key, keyLen);
+
+    if (!u_hashmap_put(g_filterMap, entry->key, entry->keyLen, entry))
+    {
+        OIC_LOG(ERROR, TAG, "failed to add entry");
+        OICFree(entry);
+        return;
+    }
+    DL_APPEND(g_filterList, entry);
+    g_filterCount++;
+}
+
+CAResult_t CADuplicateFilterInitialize()
+{
+    if (!g_filterMutex)
+    {
+        g_filterMutex = oc_mutex_new();
+        if (!g_filterMutex)
+        {
+            OIC_LOG(ERROR, TAG, "oc_mutex_new has failed");
+            return CA_STATUS_FAILED;
+        }
+    }
+
+    oc_mutex_lock(g_filterMutex);
+    if (!g_filterMap)
+    {
+        g_filterMap = u_hashmap_create(0);
+    }
+    g_filterHits = 0;
+    g_filterMisses = 0;
+    oc_mutex_unlock(g_filterMutex);
+
+    if (!g_filterMap)
+    {
+        OIC_LOG(ERROR, TAG, "memory allocation failed");
+        return CA_MEMORY_ALLOC_FAILED;
+    }
+    return CA_STATUS_OK;
+}
+
+void CADuplicateFilterTerminate()
+{
+    if (!g_filterMutex)
+    {
+        return;
+    }
+
+    oc_mutex_lock(g_filterMutex);
+    CADuplicateEntry_t *entry = NULL;
+    CADuplicateEntry_t *tmp = NULL;
+    DL_FOREACH_SAFE(g_filterList, entry, tmp)
+    {
+        DL_DELETE(g_filterList, entry);
+        OICFree(entry);
+    }
+    g_filterCount = 0;
+    u_hashmap_free(&g_filterMap);
+    oc_mutex_unlock(g_filterMutex);
+
+    oc_mutex_free(g_filterMutex);
+    g_filterMutex = NULL;
+}
+
+bool CADuplicateFilterCheck(const CAEndpoint_t *ep, uint16_t messageId,
+                            const CAToken_t token, uint8_t tokenLength)
+{
+    if (!ep)
+    {
+        return true;
+    }
+    if (ep->adapter != CA_ADAPTER_IP)
+    {
+        return false;
+    }
+
+    if (tokenLength > CA_MAX_TOKEN_LEN)
+    {
+        /*
+         * If token length is more than CA_MAX_TOKEN_LEN,
+         * we compare the first CA_MAX_TOKEN_LEN bytes only.
+         */
+        tokenLength = CA_MAX_TOKEN_LEN;
+    }
+
+    unsigned char key[CA_DUPLICATE_KEY_MAX];
+    size_t keyLen = CABuildDuplicateKey(key, CA_DUPLICATE_KEY_ENDPOINT, ep, messageId,
+                                        token, tokenLength);
+
+    // Without a token two different clients could well pick the same message
+    // ID, so only tokened messages are matched across address families.
+    unsigned char anyKey[CA_DUPLICATE_KEY_MAX];
+    size_t anyKeyLen = 0;
+    if (token && tokenLength)
+    {
+        anyKeyLen = CABuildDuplicateKey(anyKey, CA_DUPLICATE_KEY_ANY_FAMILY, ep, messageId,
+                                        token, tokenLength);
+    }
+
+    if (!g_filterMutex)
+    {
+        return false;
+    }
+
+    oc_mutex_lock(g_filterMutex);
+    if (!g_filterMap)
+    {
+        oc_mutex_unlock(g_filterMutex);
+        return false;
+    }
+
+    uint64_t now = OICGetCurrentTime(TIME_IN_MS);
+    CAPurgeDuplicateEntries(now);
+
+    bool duplicate = u_hashmap_contains(g_filterMap, key, keyLen)
+                     || (anyKeyLen && u_hashmap_contains(g_filterMap, anyKey, anyKeyLen));
+    if (duplicate)
+    {
+        g_filterHits++;
+        OIC_LOG_V(INFO, TAG, "IPv%c duplicate message ignored",
+                  (ep->flags & CA_IPV6) ? '6' : '4');
+    }
+    else
+    {
+        g_filterMisses++;
+        CARememberDuplicateKey(key, keyLen, now);
+        if (anyKeyLen)
+        {
+            CARememberDuplicateKey(anyKey, anyKeyLen, now);
+        }
+    }
+    oc_mutex_unlock(g_filterMutex);
+
+    return duplicate;
+}
+
+void CADuplicateFilterSetLifetime(uint32_t lifetime)
+{
+    if (!g_filterMutex)
+    {
+        g_filterLifetime = lifetime;
+        return;
+    }
+
+    // entries already remembered expire with the new lifetime.
+    oc_mutex_lock(g_filterMutex);
+    g_filterLifetime = lifetime;
+    CAPurgeDuplicateEntries(OICGetCurrentTime(TIME_IN_MS));
+    oc_mutex_unlock(g_filterMutex);
+}
+
+void CADuplicateFilterGetStats(uint32_t *hits, uint32_t *misses)
+{
+    if (g_filterMutex)
+    {
+        oc_mutex_lock(g_filterMutex);
+    }
+    if (hits)
+    {
+        *hits = g_filterHits;
+    }
+    if (misses)
+    {
+        *misses = g_filterMisses;
+    }
+    if (g_filterMutex)
+    {
+        oc_mutex_unlock(g_filterMutex);
+    }
+}
@@ -38,6 +38,7 @@
 #include "cainterfacecontroller.h"
 #include "caretransmission.h"
 #include "oic_string.h"
+#include "caduplicatefilter.h"
 
 #ifdef WITH_BWT
 #include "cablockwisetransfer.h"
@@ -47,6 +48,8 @@
 #include "uqueue.h"
 #include "cathreadpool.h" /* for thread pool */
 #include "caqueueingthread.h"
+#include "uhashmap.h"
+#include "ocevent.h"
 
 #if defined(TCP_ADAPTER) && defined(WITH_CLOUD)
 #include "caconnectionmanager.h"
@@ -61,6 +64,16 @@ static ca_thread_pool_t g_threadPoolHandle = NULL;
 static CAQueueingThread_t g_sendThread;
 static CAQueueingThread_t g_receiveThread;
 
+// receive workers, used instead of g_receiveThread when configured
+static uint8_t g_receiveWorkerCount = 0;
+static uint8_t g_activeReceiveWorkers = 0;
+static CAQueueingThread_t g_receiveWorkers[CA_MAX_RECEIVE_WORKERS];
+
+// signaled when data is queued for CAHandleRequestResponse
+#define CA_MAX_PROCESS_EVENTS (4)
+static oc_event g_processEvents[CA_MAX_PROCESS_EVENTS];
+static oc_mutex g_processEventMutex = NULL;
+
 #else
 #define CA_MAX_RT_ARRAY_SIZE    3
 #endif  // SINGLE_THREAD
@@ -91,8 +104,6 @@ static void CAProcessReceivedData(CAData_t *data);
 #endif
 static void CADestroyData(void *data, uint32_t size);
 static void CALogPayloadInfo(CAInfo_t *info);
-static bool CADropSecondMessage(CAHistory_t *history, const CAEndpoint_t *endpoint, uint16_t id,
-                                CAToken_t token, uint8_t tokenLength);
 
 /**
  * print send / receive message of CoAP.
@@ -101,6 +112,74 @@ static bool CADropSecondMessage(CAHistory_t *history, const CAEndpoint_t *endpoi
  */
 static void CALogPDUInfo(const CAData_t *data, const coap_pdu_t *pdu);
 
+#ifndef SINGLE_THREAD
+/*
+ * Messages for the same endpoint and token always map to the same worker,
+ * so they are handled in the order they were received.
+ */
+static uint8_t CAGetReceiveWorkerIndex(const CAData_t *data)
+{
+    const CAInfo_t *info = NULL;
+    if (data->requestInfo)
+    {
+        info = &data->requestInfo->info;
+    }
+    else if (data->responseInfo)
+    {
+        info = &data->responseInfo->info;
+    }
+    else if (data->errorInfo)
+    {
+        info = &data->errorInfo->info;
+    }
+
+    uint32_t hash = 0;
+    if (data->remoteEndpoint)
+    {
+        const CAEndpoint_t *ep = data->remoteEndpoint;
+        hash = u_hashmap_hash(ep->addr, strlen(ep->addr));
+        hash ^= u_hashmap_hash(&ep->port, sizeof(ep->port)) + ep->adapter;
+    }
+    if (info && info->token && info->tokenLength)
+    {
+        hash = (hash * 31) ^ u_hashmap_hash(info->token, info->tokenLength);
+    }
+    return (uint8_t) (hash % g_activeReceiveWorkers);
+}
+
+static void CASignalProcessEvent()
+{
+    if (g_processEventMutex)
+    {
+        oc_mutex_lock(g_processEventMutex);
+    }
+    for (size_t i = 0; i < CA_MAX_PROCESS_EVENTS; i++)
+    {
+        if (g_processEvents[i])
+        {
+            oc_event_signal(g_processEvents[i]);
+        }
+    }
+    if (g_processEventMutex)
+    {
+        oc_mutex_unlock(g_processEventMutex);
+    }
+}
+
+static void CAAddDataToReceiveQueue(CAData_t *data)
+{
+    if (0 < g_activeReceiveWorkers)
+    {
+        CAQueueingThreadAddData(&g_receiveWorkers[CAGetReceiveWorkerIndex(data)],
+                                data, sizeof(CAData_t));
+        return;
+    }
+
+    CAQueueingThreadAddData(&g_receiveThread, data, sizeof(CAData_t));
+    CASignalProcessEvent();
+}
+#endif // SINGLE_THREAD
+
 #ifdef WITH_BWT
 void CAAddDataToSendThread(CAData_t *data)
 {
@@ -115,7 +194,7 @@ void CAAddDataToReceiveThread(CAData_t *data)
     VERIFY_NON_NULL_VOID(data, TAG, "data");
 
     // add thread
-    CAQueueingThreadAddData(&g_receiveThread, data, sizeof(CAData_t));
+    CAAddDataToReceiveQueue(data);
 }
 #endif
 
@@ -202,8 +281,8 @@ static CAData_t* CAGenerateHandlerData(const CAEndpoint_t *endpoint,
             goto exit;
         }
 
-        if (CADropSecondMessage(&caglobals.ca.requestHistory, endpoint, reqInfo->info.messageId,
-                                reqInfo->info.token, reqInfo->info.tokenLength))
+        if (CADuplicateFilterCheck(endpoint, reqInfo->info.messageId,
+                                   reqInfo->info.token, reqInfo->info.tokenLength))
         {
             OIC_LOG(INFO, TAG, "Second Request with same Token, Drop it");
             CADestroyRequestInfoInternal(reqInfo);
@@ -333,7 +412,7 @@ static void CATimeoutCallback(const CAEndpoint_t *endpoint, const void *pdu, uin
 #ifdef SINGLE_THREAD
     CAProcessReceivedData(cadata);
 #else
-    CAQueueingThreadAddData(&g_receiveThread, cadata, sizeof(CAData_t));
+    CAAddDataToReceiveQueue(cadata);
 #endif
 }
 
@@ -676,64 +755,6 @@ static void CASendThreadProcess(void *threadData)
 }
 #endif
 
-/*
- * If a second message arrives with the same message ID, token and the other address
- * family, drop it.  Typically, IPv6 beats IPv4, so the IPv4 message is dropped.
- */
-static bool CADropSecondMessage(CAHistory_t *history, const CAEndpoint_t *ep, uint16_t id,
-                                CAToken_t token, uint8_t tokenLength)
-{
-    if (!ep)
-    {
-        return true;
-    }
-    if (ep->adapter != CA_ADAPTER_IP)
-    {
-        return false;
-    }
-
-    if (tokenLength > CA_MAX_TOKEN_LEN)
-    {
-        /*
-         * If token length is more than CA_MAX_TOKEN_LEN,
-         * we compare the first CA_MAX_TOKEN_LEN bytes only.
-         */
-        tokenLength = CA_MAX_TOKEN_LEN;
-    }
-
-    bool ret = false;
-    CATransportFlags_t familyFlags = ep->flags & CA_IPFAMILY_MASK;
-
-    for (size_t i = 0; i < sizeof(history->items) / sizeof(history->items[0]); i++)
-    {
-        CAHistoryItem_t *item = &(history->items[i]);
-        if (id == item->messageId && tokenLength == item->tokenLength
-            && ep->ifindex == item->ifindex && memcmp(item->token, token, tokenLength) == 0)
-        {
-            OIC_LOG_V(INFO, TAG, "IPv%c duplicate message ignored",
-                      familyFlags & CA_IPV6 ? '6' : '4');
-            ret = true;
-            break;
-        }
-    }
-
-    history->items[history->nextIndex].flags = familyFlags;
-    history->items[history->nextIndex].messageId = id;
-    history->items[history->nextIndex].ifindex = ep->ifindex;
-    if (token && tokenLength)
-    {
-        memcpy(history->items[history->nextIndex].token, token, tokenLength);
-        history->items[history->nextIndex].tokenLength = tokenLength;
-    }
-
-    if (++history->nextIndex >= HISTORYSIZE)
-    {
-        history->nextIndex = 0;
-    }
-
-    return ret;
-}
-
 static void CAReceivedPacketCallback(const CASecureEndpoint_t *sep,
                                      const void *data, size_t dataLen)
 {
@@ -827,7 +848,7 @@ static void CAReceivedPacketCallback(const CASecureEndpoint_t *sep,
         if (CA_NOT_SUPPORTED == res || CA_REQUEST_TIMEOUT == res)
         {
             OIC_LOG(DEBUG, TAG, "this message does not have block option");
-            CAQueueingThreadAddData(&g_receiveThread, cadata, sizeof(CAData_t));
+            CAAddDataToReceiveQueue(cadata);
         }
         else
         {
@@ -837,7 +858,7 @@ static void CAReceivedPacketCallback(const CASecureEndpoint_t *sep,
     else
 #endif
     {
-        CAQueueingThreadAddData(&g_receiveThread, cadata, sizeof(CAData_t));
+        CAAddDataToReceiveQueue(cadata);
     }
 #endif // SINGLE_THREAD
 
@@ -850,31 +871,9 @@ exit:
     OIC_TRACE_END();
 }
 
-void CAHandleRequestResponseCallbacks()
+#ifndef SINGLE_THREAD
+static void CAHandleReceivedData(const CAData_t *td)
 {
-#ifdef SINGLE_THREAD
-    CAReadData();
-    CARetransmissionBaseRoutine((void *)&g_retransmissionContext);
-#else
-#ifdef SINGLE_HANDLE
-    // parse the data and call the callbacks.
-    // #1 parse the data
-    // #2 get endpoint
-
-    oc_mutex_lock(g_receiveThread.threadMutex);
-
-    u_queue_message_t *item = u_queue_get_element(g_receiveThread.dataQueue);
-
-    oc_mutex_unlock(g_receiveThread.threadMutex);
-
-    if (NULL == item || NULL == item->msg)
-    {
-        return;
-    }
-
-    // get endpoint
-    CAData_t *td = (CAData_t *) item->msg;
-
     if (td->requestInfo && g_requestHandler)
     {
         OIC_LOG_V(DEBUG, TAG, "request callback : %d", td->requestInfo->info.numOptions);
@@ -890,10 +889,107 @@ void CAHandleRequestResponseCallbacks()
         OIC_LOG_V(DEBUG, TAG, "error callback error: %d", td->errorInfo->result);
         g_errorHandler(td->remoteEndpoint, td->errorInfo);
     }
+}
+
+static void CAReceiveWorkerProcess(void *threadData)
+{
+    OIC_TRACE_BEGIN(%s:CAReceiveWorkerProcess, TAG);
+    CAHandleReceivedData((const CAData_t *) threadData);
+    OIC_TRACE_END();
+}
+
+CAResult_t CASetReceiveWorkers(uint8_t count)
+{
+    if (CA_MAX_RECEIVE_WORKERS < count)
+    {
+        OIC_LOG_V(ERROR, TAG, "too many receive workers: %u", count);
+        return CA_STATUS_INVALID_PARAM;
+    }
+
+    g_receiveWorkerCount = count;
+    return CA_STATUS_OK;
+}
+
+CAResult_t CAAddProcessEvent(oc_event event)
+{
+    VERIFY_NON_NULL(event, TAG, "event");
+
+    CAResult_t result = CA_MEMORY_ALLOC_FAILED;
+    if (g_processEventMutex)
+    {
+        oc_mutex_lock(g_processEventMutex);
+    }
+    for (size_t i = 0; i < CA_MAX_PROCESS_EVENTS; i++)
+    {
+        if (!g_processEvents[i] || g_processEvents[i] == event)
+        {
+            g_processEvents[i] = event;
+            result = CA_STATUS_OK;
+            break;
+        }
+    }
+    if (g_processEventMutex)
+    {
+        oc_mutex_unlock(g_processEventMutex);
+    }
+
+    if (CA_STATUS_OK != result)
+    {
+        OIC_LOG(ERROR, TAG, "too many process events");
+        return result;
+    }
+
+    // data may already be waiting.
+    oc_event_signal(event);
+    return CA_STATUS_OK;
+}
+
+void CARemoveProcessEvent(oc_event event)
+{
+    if (g_processEventMutex)
+    {
+        oc_mutex_lock(g_processEventMutex);
+    }
+    for (size_t i = 0; i < CA_MAX_PROCESS_EVENTS; i++)
+    {
+        if (g_processEvents[i] == event)
+        {
+            g_processEvents[i] = NULL;
+        }
+    }
+    if (g_processEventMutex)
+    {
+        oc_mutex_unlock(g_processEventMutex);
+    }
+}
+#endif // SINGLE_THREAD
+
+void CAHandleRequestResponseCallbacks()
+{
+#ifdef SINGLE_THREAD
+    CAReadData();
+    CARetransmissionBaseRoutine((void *)&g_retransmissionContext);
+#else
+#ifdef SINGLE_HANDLE
+    // handle a bounded batch, so a busy receive queue does not starve the
+    // rest of the caller's loop.
+    for (int i = 0; i < CA_HANDLE_BATCH_SIZE; i++)
+    {
+        void *msg = NULL;
+        uint32_t size = 0;
 
-    CADestroyData(item->msg, sizeof(CAData_t));
-    OICFree(item);
+        if (CA_STATUS_OK != CAQueueingThreadGetData(&g_receiveThread, &msg, &size)
+            || NULL == msg)
+        {
+            return;
+        }
 
+        CAHandleReceivedData((CAData_t *) msg);
+        CADestroyData(msg, size);
+    }
+
+    // more data is left for the next call.
+    CASignalProcessEvent();
 #endif // SINGLE_HANDLE
 #endif // SINGLE_THREAD
 }
@@ -984,7 +1080,7 @@ CAResult_t CADetachSendMessage(const CAEndpoint_t *endpoint, const void *sendMsg
 
 #ifdef ARDUINO
     // If max retransmission queue is reached, then don't handle new request
-    if (CA_MAX_RT_ARRAY_SIZE == u_arraylist_length(g_retransmissionContext.dataList))
+    if (CA_MAX_RT_ARRAY_SIZE == u_hashmap_length(g_retransmissionContext.dataMap))
     {
         OIC_LOG(ERROR, TAG, "max RT queue size reached!");
         return CA_SEND_FAILED;
@@ -1024,7 +1120,7 @@ CAResult_t CADetachSendMessage(const CAEndpoint_t *endpoint, const void *sendMsg
     {
         OIC_LOG(DEBUG, TAG,
                 "This is a loopback message. Transfer it to the receive queue directly");
-        CAQueueingThreadAddData(&g_receiveThread, data, sizeof(CAData_t));
+        CAAddDataToReceiveQueue(data);
         return CA_STATUS_OK;
     }
 #ifdef WITH_BWT
@@ -1072,9 +1168,24 @@ CAResult_t CAInitializeMessageHandler(CATransportAdapter_t transportType)
     CASetPacketReceivedCallback(CAReceivedPacketCallback);
     CASetErrorHandleCallback(CAErrorHandler);
 
+    // duplicate filter initialize
+    CAResult_t res = CADuplicateFilterInitialize();
+    if (CA_STATUS_OK != res)
+    {
+        OIC_LOG(ERROR, TAG, "Failed to Initialize duplicate filter.");
+        return res;
+    }
+
 #ifndef SINGLE_THREAD
+    g_processEventMutex = oc_mutex_new();
+    if (!g_processEventMutex)
+    {
+        OIC_LOG(ERROR, TAG, "Failed to create process event mutex.");
+        return CA_STATUS_FAILED;
+    }
+
     // create thread pool
-    CAResult_t res = ca_thread_pool_init(MAX_THREAD_POOL_SIZE, &g_threadPoolHandle);
+    res = ca_thread_pool_init(MAX_THREAD_POOL_SIZE, &g_threadPoolHandle);
     if (CA_STATUS_OK != res)
     {
         OIC_LOG(ERROR, TAG, "thread pool initialize error.");
@@ -1117,6 +1228,26 @@ CAResult_t CAInitializeMessageHandler(CATransportAdapter_t transportType)
     }
 #endif // SINGLE_HANDLE
 
+    // receive workers initialize and start
+    for (uint8_t i = 0; i < g_receiveWorkerCount; i++)
+    {
+        res = CAQueueingThreadInitialize(&g_receiveWorkers[i], g_threadPoolHandle,
+                                         CAReceiveWorkerProcess, CADestroyData);
+        if (CA_STATUS_OK != res)
+        {
+            OIC_LOG(ERROR, TAG, "Failed to Initialize receive worker");
+            return res;
+        }
+        g_activeReceiveWorkers++;
+
+        res = CAQueueingThreadStart(&g_receiveWorkers[i]);
+        if (CA_STATUS_OK != res)
+        {
+            OIC_LOG(ERROR, TAG, "thread start error(receive worker).");
+            return res;
+        }
+    }
+
     // retransmission initialize
     res = CARetransmissionInitialize(&g_retransmissionContext, g_threadPoolHandle,
                                      CASendUnicastData, CATimeoutCallback, NULL);
@@ -1153,8 +1284,8 @@ CAResult_t CAInitializeMessageHandler(CATransportAdapter_t transportType)
     }
 #else
     // retransmission initialize
-    CAResult_t res = CARetransmissionInitialize(&g_retransmissionContext, NULL, CASendUnicastData,
-                                                CATimeoutCallback, NULL);
+    res = CARetransmissionInitialize(&g_retransmissionContext, NULL, CASendUnicastData,
+                                     CATimeoutCallback, NULL);
     if (CA_STATUS_OK != res)
     {
         OIC_LOG(ERROR, TAG, "Failed to Initialize Retransmission.");
@@ -1195,6 +1326,11 @@ void CATerminateMessageHandler()
 #endif
     }
 
+    for (uint8_t i = 0; i < g_activeReceiveWorkers; i++)
+    {
+        CAQueueingThreadStop(&g_receiveWorkers[i]);
+    }
+
     // destroy thread pool
     if (NULL != g_threadPoolHandle)
     {
@@ -1208,9 +1344,17 @@ void CATerminateMessageHandler()
     CARetransmissionDestroy(&g_retransmissionContext);
     CAQueueingThreadDestroy(&g_sendThread);
     CAQueueingThreadDestroy(&g_receiveThread);
+    for (uint8_t i = 0; i < g_activeReceiveWorkers; i++)
+    {
+        CAQueueingThreadDestroy(&g_receiveWorkers[i]);
+    }
+    g_activeReceiveWorkers = 0;
 
     // terminate interface adapters by controller
     CATerminateAdapters();
+
+    oc_mutex_free(g_processEventMutex);
+    g_processEventMutex = NULL;
 #else
     // terminate interface adapters by controller
     CATerminateAdapters();
@@ -1219,6 +1363,8 @@ void CATerminateMessageHandler()
     CARetransmissionStop(&g_retransmissionContext);
     CARetransmissionDestroy(&g_retransmissionContext);
 #endif // SINGLE_THREAD
+
+    CADuplicateFilterTerminate();
 }
 
 static void CALogPayloadInfo(CAInfo_t *info)
@@ -1290,7 +1436,7 @@ void CAErrorHandler(const CAEndpoint_t *endpoint,
 
     cadata->errorInfo->result = result;
 
-    CAQueueingThreadAddData(&g_receiveThread, cadata, sizeof(CAData_t));
+    CAAddDataToReceiveQueue(cadata);
     coap_delete_pdu(pdu);
 #else
     (void)result;
@@ -1343,7 +1489,7 @@ static void CASendErrorInfo(const CAEndpoint_t *endpoint, const CAInfo_t *info,
     cadata->errorInfo = errorInfo;
     cadata->dataType = CA_ERROR_DATA;
 
-    CAQueueingThreadAddData(&g_receiveThread, cadata, sizeof(CAData_t));
+    CAAddDataToReceiveQueue(cadata);
 #endif
     OIC_LOG(DEBUG, TAG, "CASendErrorInfo OUT");
 }
@@ -30,11 +30,109 @@
 #endif
 
 #include "caqueueingthread.h"
+#include "ocatomic.h"
 #include "oic_malloc.h"
 #include "logger.h"
 
 #define TAG PCF("OIC_CA_QING")
 
+#define CA_QUEUEING_THREAD_RING_MASK (CA_QUEUEING_THREAD_RING_SIZE - 1)
+
+/*
+ * Messages are passed through a bounded ring of slots. Each slot carries a
+ * sequence number: a producer may fill the slot at position pos when the
+ * sequence equals pos, and publishes it by setting the sequence to pos + 1.
+ * The consumer takes the slot when the sequence equals pos + 1 and hands it
+ * back to the producers by setting it to pos + CA_QUEUEING_THREAD_RING_SIZE.
+ * Producers claim positions with a compare-and-swap on enqueuePos, so they
+ * never take threadMutex unless the ring is full or the consumer sleeps.
+ *
+ * When the ring is full, messages go to the dataQueue overflow list under
+ * threadMutex. Producers keep using the overflow list until the consumer
+ * has drained it, which preserves the order of a single producer.
+ */
+
+static int32_t CAAtomicLoad(volatile int32_t *value)
+{
+    return oc_atomic_add(value, 0);
+}
+
+static bool CAQueueingThreadRingPush(CAQueueingThread_t *thread, void *data, uint32_t size)
+{
+    CAQueueingThreadSlot_t *slot = NULL;
+    int32_t pos = CAAtomicLoad(&thread->enqueuePos);
+
+    for (;;)
+    {
+        slot = &thread->ring[pos & CA_QUEUEING_THREAD_RING_MASK];
+        int32_t diff = (int32_t) ((uint32_t) CAAtomicLoad(&slot->sequence) - (uint32_t) pos);
+        if (0 == diff)
+        {
+            if (oc_atomic_cmpxchg(&thread->enqueuePos, pos, (int32_t) ((uint32_t) pos + 1)))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // the consumer has not released this slot yet, the ring is full.
+            return false;
+        }
+        pos = CAAtomicLoad(&thread->enqueuePos);
+    }
+
+    slot->msg = data;
+    slot->size = size;
+
+    // publish the slot, this is a full barrier for the stores above.
+    oc_atomic_increment(&slot->sequence);
+    return true;
+}
+
+/* Must be called with threadMutex held. */
+static bool CAQueueingThreadPop(CAQueueingThread_t *thread, void **data, uint32_t *size)
+{
+    int32_t pos = thread->dequeuePos;
+    CAQueueingThreadSlot_t *slot = &thread->ring[pos & CA_QUEUEING_THREAD_RING_MASK];
+
+    if (CAAtomicLoad(&slot->sequence) == (int32_t) ((uint32_t) pos + 1))
+    {
+        *data = slot->msg;
+        *size = slot->size;
+        slot->msg = NULL;
+        oc_atomic_add(&slot->sequence, CA_QUEUEING_THREAD_RING_SIZE - 1);
+        thread->dequeuePos = (int32_t) ((uint32_t) pos + 1);
+        return true;
+    }
+
+    if (0 < CAAtomicLoad(&thread->overflowCount))
+    {
+        u_queue_message_t *message = u_queue_get_element(thread->dataQueue);
+        if (NULL != message)
+        {
+            *data = message->msg;
+            *size = message->size;
+            OICFree(message);
+            oc_atomic_decrement(&thread->overflowCount);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void CAQueueingThreadDestroyData(CAQueueingThread_t *thread, void *data, uint32_t size)
+{
+    if (NULL != thread->destroy)
+    {
+        thread->destroy(data, size);
+    }
+    else
+    {
+        OICFree(data);
+    }
+}
+
 static void CAQueueingThreadBaseRoutine(void *threadValue)
 {
     OIC_LOG(DEBUG, TAG, "message handler main thread start..");
@@ -49,51 +147,47 @@ static void CAQueueingThreadBaseRoutine(void *threadValue)
 
     while (!thread->isStop)
     {
+        void *data = NULL;
+        uint32_t size = 0;
+
         // mutex lock
         oc_mutex_lock(thread->threadMutex);
 
-        // if queue is empty, thread will wait
-        if (!thread->isStop && u_queue_get_size(thread->dataQueue) <= 0)
+        bool found = !thread->isStop && CAQueueingThreadPop(thread, &data, &size);
+
+        // if queue is empty, announce that we are going to sleep and check
+        // again, so a producer either sees the flag or we see its data.
+        if (!found && !thread->isStop)
         {
-            OIC_LOG(DEBUG, TAG, "wait..");
+            oc_atomic_or(&thread->isWaiting, 1);
 
-            // wait
-            oc_cond_wait(thread->threadCond, thread->threadMutex);
+            found = CAQueueingThreadPop(thread, &data, &size);
+            if (!found)
+            {
+                OIC_LOG(DEBUG, TAG, "wait..");
 
-            OIC_LOG(DEBUG, TAG, "wake up..");
-        }
+                // wait
+                oc_cond_wait(thread->threadCond, thread->threadMutex);
 
-        // check stop flag
-        if (thread->isStop)
-        {
-            // mutex unlock
-            oc_mutex_unlock(thread->threadMutex);
-            continue;
+                OIC_LOG(DEBUG, TAG, "wake up..");
+            }
+
+            oc_atomic_cmpxchg(&thread->isWaiting, 1, 0);
         }
 
-        // get data
-        u_queue_message_t *message = u_queue_get_element(thread->dataQueue);
         // mutex unlock
         oc_mutex_unlock(thread->threadMutex);
-        if (NULL == message)
+
+        if (!found)
         {
             continue;
         }
 
         // process data
-        thread->threadTask(message->msg);
+        thread->threadTask(data);
 
         // free
-        if (NULL != thread->destroy)
-        {
-            thread->destroy(message->msg, message->size);
-        }
-        else
-        {
-            OICFree(message->msg);
-        }
-
-        OICFree(message);
+        CAQueueingThreadDestroyData(thread, data, size);
     }
 
     oc_mutex_lock(thread->threadMutex);
@@ -103,6 +197,7 @@ static void CAQueueingThreadBaseRoutine(void *threadValue)
     OIC_LOG(DEBUG, TAG, "message handler main thread end..");
 }
 
+
 CAResult_t CAQueueingThreadInitialize(CAQueueingThread_t *thread, ca_thread_pool_t handle,
                                       CAThreadTask task, CADataDestroyFunction destroy)
 {
@@ -128,14 +223,28 @@ CAResult_t CAQueueingThreadInitialize(CAQueueingThread_t *thread, ca_thread_pool
     thread->isStop = true;
     thread->threadTask = task;
     thread->destroy = destroy;
-    if (NULL == thread->dataQueue || NULL == thread->threadMutex || NULL == thread->threadCond)
+    thread->ring = (CAQueueingThreadSlot_t *) OICCalloc(CA_QUEUEING_THREAD_RING_SIZE,
+                                                        sizeof(CAQueueingThreadSlot_t));
+    thread->enqueuePos = 0;
+    thread->dequeuePos = 0;
+    thread->overflowCount = 0;
+    thread->isWaiting = 0;
+    if (NULL == thread->dataQueue || NULL == thread->threadMutex || NULL == thread->threadCond
+        || NULL == thread->ring)
     {
         goto ERROR_MEM_FAILURE;
     }
 
+    for (int32_t i = 0; i < CA_QUEUEING_THREAD_RING_SIZE; i++)
+    {
+        thread->ring[i].sequence = i;
+    }
+
     return CA_STATUS_OK;
 
 ERROR_MEM_FAILURE:
+    OICFree(thread->ring);
+    thread->ring = NULL;
     if (thread->dataQueue)
     {
         u_queue_delete(thread->dataQueue);
@@ -209,6 +318,19 @@ CAResult_t CAQueueingThreadAddData(CAQueueingThread_t *thread, void *data, uint3
         return CA_STATUS_INVALID_PARAM;
     }
 
+    // fast path, no lock unless the consumer sleeps.
+    if (0 == CAAtomicLoad(&thread->overflowCount)
+        && CAQueueingThreadRingPush(thread, data, size))
+    {
+        if (CAAtomicLoad(&thread->isWaiting))
+        {
+            oc_mutex_lock(thread->threadMutex);
+            oc_cond_signal(thread->threadCond);
+            oc_mutex_unlock(thread->threadMutex);
+        }
+        return CA_STATUS_OK;
+    }
+
     // create thread data
     u_queue_message_t *message = (u_queue_message_t *) OICMalloc(sizeof(u_queue_message_t));
 
@@ -224,16 +346,100 @@ CAResult_t CAQueueingThreadAddData(CAQueueingThread_t *thread, void *data, uint3
     // mutex lock
     oc_mutex_lock(thread->threadMutex);
 
-    // add thread data into list
-    u_queue_add_element(thread->dataQueue, message);
+    // add thread data into overflow list
+    CAResult_t res = u_queue_add_element(thread->dataQueue, message);
+    if (CA_STATUS_OK == res)
+    {
+        oc_atomic_increment(&thread->overflowCount);
 
-    // notity the thread
-    oc_cond_signal(thread->threadCond);
+        // notity the thread
+        oc_cond_signal(thread->threadCond);
+    }
 
     // mutex unlock
     oc_mutex_unlock(thread->threadMutex);
 
-    return CA_STATUS_OK;
+    if (CA_STATUS_OK != res)
+    {
+        OIC_LOG(ERROR, TAG, "failed to add data to overflow queue");
+        OICFree(message);
+    }
+
+    return res;
+}
+
+CAResult_t CAQueueingThreadGetData(CAQueueingThread_t *thread, void **data, uint32_t *size)
+{
+    if (NULL == thread || NULL == data || NULL == size)
+    {
+        OIC_LOG(ERROR, TAG, "invalid parameter..");
+        return CA_STATUS_INVALID_PARAM;
+    }
+
+    oc_mutex_lock(thread->threadMutex);
+    bool found = CAQueueingThreadPop(thread, data, size);
+    oc_mutex_unlock(thread->threadMutex);
+
+    return found ? CA_STATUS_OK : CA_STATUS_FAILED;
+}
+
+CAResult_t CAQueueingThreadClearContextData(CAQueueingThread_t *thread,
+                                            CAQueueingThreadCompareFunc compareFunc,
+                                            void *ctx)
+{
+    if (NULL == thread || NULL == compareFunc)
+    {
+        OIC_LOG(ERROR, TAG, "invalid parameter..");
+        return CA_STATUS_INVALID_PARAM;
+    }
+
+    u_queue_t *kept = u_queue_create();
+    if (NULL == kept)
+    {
+        OIC_LOG(ERROR, TAG, "memory error!!");
+        return CA_MEMORY_ALLOC_FAILED;
+    }
+
+    oc_mutex_lock(thread->threadMutex);
+
+    // drain the ring and the overflow list in order, keeping what does not
+    // match in the overflow list.
+    CAResult_t res = CA_STATUS_OK;
+    void *data = NULL;
+    uint32_t size = 0;
+    while (CAQueueingThreadPop(thread, &data, &size))
+    {
+        if (compareFunc(data, size, ctx))
+        {
+            CAQueueingThreadDestroyData(thread, data, size);
+            continue;
+        }
+
+        u_queue_message_t *message = (u_queue_message_t *) OICMalloc(sizeof(u_queue_message_t));
+        if (NULL == message)
+        {
+            OIC_LOG(ERROR, TAG, "memory error!!");
+            CAQueueingThreadDestroyData(thread, data, size);
+            res = CA_MEMORY_ALLOC_FAILED;
+            continue;
+        }
+        message->msg = data;
+        message->size = size;
+        if (CA_STATUS_OK != u_queue_add_element(kept, message))
+        {
+            CAQueueingThreadDestroyData(thread, data, size);
+            OICFree(message);
+            res = CA_MEMORY_ALLOC_FAILED;
+        }
+    }
+
+    u_queue_delete(thread->dataQueue);
+    thread->dataQueue = kept;
+    oc_atomic_add(&thread->overflowCount, (int32_t) u_queue_get_size(kept));
+
+    oc_mutex_unlock(thread->threadMutex);
+
+    return res;
 }
 
 CAResult_t CAQueueingThreadDestroy(CAQueueingThread_t *thread)
@@ -250,29 +456,17 @@ CAResult_t CAQueueingThreadDestroy(CAQueueingThread_t *thread)
     oc_mutex_lock(thread->threadMutex);
 
     // remove all remained list data.
-    while (u_queue_get_size(thread->dataQueue) > 0)
+    void *data = NULL;
+    uint32_t size = 0;
+    while (CAQueueingThreadPop(thread, &data, &size))
     {
-        // get data
-        u_queue_message_t *message = u_queue_get_element(thread->dataQueue);
-
-        // free
-        if (NULL != message)
-        {
-            if (NULL != thread->destroy)
-            {
-                thread->destroy(message->msg, message->size);
-            }
-            else
-            {
-                OICFree(message->msg);
-            }
-
-            OICFree(message);
-        }
+        CAQueueingThreadDestroyData(thread, data, size);
     }
 
     u_queue_delete(thread->dataQueue);
     thread->dataQueue = NULL;
+    OICFree(thread->ring);
+    thread->ring = NULL;
 
     // mutex unlock
     oc_mutex_unlock(thread->threadMutex);
@@ -72,11 +72,16 @@
 #include "oic_time.h"
 #include "ocrandom.h"
 #include "logger.h"
+#include <coap/utlist.h>
 
 #define TAG "OIC_CA_RETRANS"
 
-typedef struct
+struct CARetransmissionData
 {
+    CARetransmissionData_t *next;       /**< next data in the same wheel slot */
+    CARetransmissionData_t *prev;       /**< previous data in the same wheel slot */
+    size_t slot;                        /**< wheel slot holding this data */
+    uint64_t deadline;                  /**< next retransmission time. microseconds */
     uint64_t timeStamp;                 /**< last sent time. microseconds */
 #ifndef SINGLE_THREAD
     uint64_t timeout;                   /**< timeout value. microseconds */
@@ -87,7 +92,10 @@ typedef struct
     CAEndpoint_t *endpoint;             /**< remote endpoint */
     void *pdu;                          /**< coap PDU */
     uint32_t size;                      /**< coap PDU size */
-} CARetransmissionData_t;
+};
+
+/** size of the data map key. (message id, transport adapter) **/
+#define CA_RETRANSMISSION_KEY_SIZE (sizeof(uint16_t) + sizeof(CATransportAdapter_t))
 
 static const uint64_t USECS_PER_SEC = 1000000;
 static const uint64_t USECS_PER_MSEC = 1000;
@@ -140,37 +148,76 @@ CAResult_t CARetransmissionStart(CARetransmission_t *context)
 }
 #endif
 
+static const uint64_t USECS_PER_TICK = RETRANSMISSION_WHEEL_TICK_MSEC * 1000;
+
 /**
- * @brief   check timeout routine
- * @param   currentTime     [IN]microseconds
+ * @brief   build the data map key of a retransmission data.
+ * @param   messageId       [IN]coap PDU message id
+ * @param   adapter         [IN]transport adapter of the remote endpoint
+ * @param   key             [OUT]key buffer of CA_RETRANSMISSION_KEY_SIZE bytes
+ */
+static void CAGetRetransmissionKey(uint16_t messageId, CATransportAdapter_t adapter,
+                                   unsigned char *key)
+{
+    memcpy(key, &messageId, sizeof(messageId));
+    memcpy(key + sizeof(messageId), &adapter, sizeof(adapter));
+}
+
+/**
+ * @brief   calculate the next retransmission time.
  * @param   retData         [IN]retransmission data
- * @return  true if the timeout period has elapsed, false otherwise
+ * @return  microseconds
  */
-static bool CACheckTimeout(uint64_t currentTime, CARetransmissionData_t *retData)
+static uint64_t CAGetRetransmissionDeadline(const CARetransmissionData_t *retData)
 {
 #ifndef SINGLE_THREAD
-    // #1. calculate timeout
     uint64_t milliTimeoutValue = retData->timeout / USECS_PER_MSEC;
     uint64_t timeout = (milliTimeoutValue << retData->triedCount) * USECS_PER_MSEC;
-
-    if (currentTime >= retData->timeStamp + timeout)
-    {
-        OIC_LOG_V(DEBUG, TAG, "%" PRIu64 " microseconds time out!!, tried count(%d)",
-                  timeout, retData->triedCount);
-        return true;
-    }
 #else
-    // #1. calculate timeout
-    uint64_t timeOut = (2 << retData->triedCount) * (uint64_t) USECS_PER_SEC;
+    uint64_t timeout = (2 << retData->triedCount) * (uint64_t) USECS_PER_SEC;
+#endif
+    return retData->timeStamp + timeout;
+}
 
-    if (currentTime >= retData->timeStamp + timeOut)
+/**
+ * @brief   put the data into the wheel slot of its deadline.
+ *          data already overdue goes to the slot checked next.
+ * @param   context         [IN]context for retransmission
+ * @param   retData         [IN]retransmission data
+ */
+static void CAScheduleRetransmission(CARetransmission_t *context,
+                                     CARetransmissionData_t *retData)
+{
+    uint64_t tick = retData->deadline / USECS_PER_TICK;
+    if (tick < context->wheelTick)
     {
-        OIC_LOG_V(DEBUG, TAG, "timeout=%d, tried cnt=%d",
-                  (2 << retData->triedCount), retData->triedCount);
-        return true;
+        tick = context->wheelTick;
     }
-#endif
-    return false;
+
+    retData->slot = (size_t) (tick % RETRANSMISSION_WHEEL_SLOTS);
+    DL_APPEND(context->timerWheel[retData->slot], retData);
+}
+
+/**
+ * @brief   remove the data from the wheel and the data map.
+ * @param   context         [IN]context for retransmission
+ * @param   retData         [IN]retransmission data
+ */
+static void CAUnlinkRetransmissionData(CARetransmission_t *context,
+                                       CARetransmissionData_t *retData)
+{
+    unsigned char key[CA_RETRANSMISSION_KEY_SIZE];
+    CAGetRetransmissionKey(retData->messageId, retData->endpoint->adapter, key);
+
+    DL_DELETE(context->timerWheel[retData->slot], retData);
+    u_hashmap_remove(context->dataMap, key, sizeof(key));
+}
+
+static void CAFreeRetransmissionData(CARetransmissionData_t *retData)
+{
+    CAFreeEndpoint(retData->endpoint);
+    OICFree(retData->pdu);
+    OICFree(retData);
 }
 
 static void CACheckRetransmissionList(CARetransmission_t *context)
@@ -184,71 +231,119 @@ static void CACheckRetransmissionList(CARetransmission_t *context)
     // mutex lock
     oc_mutex_lock(context->threadMutex);
 
-    size_t len = u_arraylist_length(context->dataList);
+    uint64_t currentTime = OICGetCurrentTime(TIME_IN_US);
+    uint64_t currentTick = currentTime / USECS_PER_TICK;
 
-    for (size_t i = 0; i < len; i++)
+    // #1. collect the expired data from the slots passed since the last check.
+    //     a full turn of the wheel visits every slot once.
+    uint64_t ticks = currentTick - context->wheelTick;
+    if (ticks >= RETRANSMISSION_WHEEL_SLOTS)
     {
-        CARetransmissionData_t *retData = u_arraylist_get(context->dataList, i);
-
-        if (NULL == retData)
-        {
-            continue;
-        }
+        ticks = RETRANSMISSION_WHEEL_SLOTS - 1;
+    }
 
-        uint64_t currentTime = OICGetCurrentTime(TIME_IN_US);
+    CARetransmissionData_t *expired = NULL;
+    for (uint64_t i = 0; i <= ticks; i++)
+    {
+        size_t slot = (size_t) ((context->wheelTick + i) % RETRANSMISSION_WHEEL_SLOTS);
+        CARetransmissionData_t *retData = NULL;
+        CARetransmissionData_t *tmp = NULL;
 
-        if (CACheckTimeout(currentTime, retData))
+        DL_FOREACH_SAFE(context->timerWheel[slot], retData, tmp)
         {
-            // #2. if time's up, send the data.
-            if (NULL != context->dataSendMethod)
+            // data scheduled for a later turn of the wheel stays in place.
+            if (retData->deadline <= currentTime)
             {
-                OIC_LOG_V(DEBUG, TAG, "retransmission CON data!!, msgid=%d",
-                          retData->messageId);
-                context->dataSendMethod(retData->endpoint, retData->pdu,
-                                        retData->size, retData->dataType);
+                DL_DELETE(context->timerWheel[slot], retData);
+                DL_APPEND(expired, retData);
             }
+        }
+    }
+    context->wheelTick = currentTick;
+
+    CARetransmissionData_t *retData = NULL;
+    CARetransmissionData_t *tmp = NULL;
+    DL_FOREACH_SAFE(expired, retData, tmp)
+    {
+        DL_DELETE(expired, retData);
+
+        OIC_LOG_V(DEBUG, TAG, "time out!!, tried count(%d)", retData->triedCount);
 
-            // #3. increase the retransmission count and update timestamp.
-            retData->timeStamp = currentTime;
-            retData->triedCount++;
+        // #2. if time's up, send the data.
+        if (NULL != context->dataSendMethod)
+        {
+            OIC_LOG_V(DEBUG, TAG, "retransmission CON data!!, msgid=%d",
+                      retData->messageId);
+            context->dataSendMethod(retData->endpoint, retData->pdu,
+                                    retData->size, retData->dataType);
         }
 
-        // #4. if tried count is max, remove the retransmission data from list.
+        // #3. increase the retransmission count and update timestamp.
+        retData->timeStamp = currentTime;
+        retData->triedCount++;
+
+        // #4. if tried count is max, remove the retransmission data.
         if (retData->triedCount >= context->config.tryingCount)
         {
-            CARetransmissionData_t *removedData = u_arraylist_remove(context->dataList, i);
-            if (NULL == removedData)
-            {
-                OIC_LOG(ERROR, TAG, "Removed data is NULL");
-                // mutex unlock
-                oc_mutex_unlock(context->threadMutex);
-                return;
-            }
+            unsigned char key[CA_RETRANSMISSION_KEY_SIZE];
+            CAGetRetransmissionKey(retData->messageId, retData->endpoint->adapter, key);
+            u_hashmap_remove(context->dataMap, key, sizeof(key));
+
             OIC_LOG_V(DEBUG, TAG, "max trying count, remove RTCON data,"
-                      "msgid=%d", removedData->messageId);
+                      "msgid=%d", retData->messageId);
 
             // callback for retransmit timeout
             if (NULL != context->timeoutCallback)
             {
-                context->timeoutCallback(removedData->endpoint, removedData->pdu,
-                                         removedData->size);
+                context->timeoutCallback(retData->endpoint, retData->pdu,
+                                         retData->size);
             }
 
-            CAFreeEndpoint(removedData->endpoint);
-            OICFree(removedData->pdu);
-
-            OICFree(removedData);
-
-            // modify loop value.
-            len = u_arraylist_length(context->dataList);
-            --i;
+            CAFreeRetransmissionData(retData);
+            continue;
         }
+
+        retData->deadline = CAGetRetransmissionDeadline(retData);
+        CAScheduleRetransmission(context, retData);
     }
 
     // mutex unlock
     oc_mutex_unlock(context->threadMutex);
 }
 
+#ifndef SINGLE_THREAD
+/**
+ * @brief   find the earliest retransmission time. must be called with the mutex held.
+ * @param   context         [IN]context for retransmission
+ * @return  microseconds, UINT64_MAX if there is no retransmission data
+ */
+static uint64_t CAGetNextRetransmissionTime(const CARetransmission_t *context)
+{
+    uint64_t next = UINT64_MAX;
+
+    for (uint64_t i = 0; i < RETRANSMISSION_WHEEL_SLOTS; i++)
+    {
+        size_t slot = (size_t) ((context->wheelTick + i) % RETRANSMISSION_WHEEL_SLOTS);
+        CARetransmissionData_t *retData = NULL;
+
+        DL_FOREACH(context->timerWheel[slot], retData)
+        {
+            if (retData->deadline < next)
+            {
+                next = retData->deadline;
+            }
+        }
+
+        // data due within the current turn is earlier than anything left in later slots.
+        if (next < (context->wheelTick + i + 1) * USECS_PER_TICK)
+        {
+            break;
+        }
+    }
+    return next;
+}
+#endif
+
 void CARetransmissionBaseRoutine(void *threadValue)
 {
     OIC_LOG(DEBUG, TAG, "retransmission main thread start");
@@ -276,9 +371,9 @@ void CARetransmissionBaseRoutine(void *threadValue)
         // mutex lock
         oc_mutex_lock(context->threadMutex);
 
-        if (!context->isStop && u_arraylist_length(context->dataList) <= 0)
+        if (!context->isStop && u_hashmap_length(context->dataMap) <= 0)
         {
-            // if list is empty, thread will wait
+            // if map is empty, thread will wait
             OIC_LOG(DEBUG, TAG, "wait..there is no retransmission data.");
 
             // wait
@@ -288,13 +383,19 @@ void CARetransmissionBaseRoutine(void *threadValue)
         }
         else if (!context->isStop)
         {
-            // check each RETRANSMISSION_CHECK_PERIOD_SEC time.
-            OIC_LOG_V(DEBUG, TAG, "wait..(%" PRIu64 ")microseconds",
-                      RETRANSMISSION_CHECK_PERIOD_SEC * (uint64_t) USECS_PER_SEC);
+            // sleep until the earliest retransmission is due.
+            uint64_t next = CAGetNextRetransmissionTime(context);
+            uint64_t currentTime = OICGetCurrentTime(TIME_IN_US);
 
-            // wait
-            uint64_t absTime = RETRANSMISSION_CHECK_PERIOD_SEC * (uint64_t) USECS_PER_SEC;
-            oc_cond_wait_for(context->threadCond, context->threadMutex, absTime );
+            if (next > currentTime)
+            {
+                OIC_LOG_V(DEBUG, TAG, "wait..(%" PRIu64 ")microseconds",
+                          next - currentTime);
+
+                // wait
+                oc_cond_wait_for(context->threadCond, context->threadMutex,
+                                 next - currentTime);
+            }
         }
         else
         {
@@ -344,14 +445,27 @@ CAResult_t CARetransmissionInitialize(CARetransmission_t *context,
 
     memset(context, 0, sizeof(CARetransmission_t));
 
-    CARetransmissionConfig_t cfg = { .supportType = DEFAULT_RETRANSMISSION_TYPE,
-                                     .tryingCount = DEFAULT_RETRANSMISSION_COUNT };
+    CARetransmissionConfig_t cfg = {
+        .supportType = (CATransportAdapter_t) DEFAULT_RETRANSMISSION_TYPE,
+        .tryingCount = DEFAULT_RETRANSMISSION_COUNT };
 
     if (config)
     {
         cfg = *config;
     }
 
+    context->dataMap = u_hashmap_create(0);
+    context->timerWheel = (CARetransmissionData_t **) OICCalloc(RETRANSMISSION_WHEEL_SLOTS,
+                                                                sizeof(CARetransmissionData_t *));
+    if (NULL == context->dataMap || NULL == context->timerWheel)
+    {
+        OIC_LOG(ERROR, TAG, "memory error");
+        u_hashmap_free(&context->dataMap);
+        OICFree(context->timerWheel);
+        context->timerWheel = NULL;
+        return CA_MEMORY_ALLOC_FAILED;
+    }
+
     // set send thread data
     context->threadPool = handle;
     context->threadMutex = oc_mutex_new();
@@ -360,7 +474,7 @@ CAResult_t CARetransmissionInitialize(CARetransmission_t *context,
     context->timeoutCallback = timeoutCallback;
     context->config = cfg;
     context->isStop = false;
-    context->dataList = u_arraylist_create();
+    context->wheelTick = OICGetCurrentTime(TIME_IN_US) / USECS_PER_TICK;
 
     return CA_STATUS_OK;
 }
@@ -436,48 +550,47 @@ CAResult_t CARetransmissionSentData(CARetransmission_t *context,
     retData->pdu = pduData;
     retData->size = size;
     retData->dataType = dataType;
-#ifndef SINGLE_THREAD
+    retData->deadline = CAGetRetransmissionDeadline(retData);
+
+    unsigned char key[CA_RETRANSMISSION_KEY_SIZE];
+    CAGetRetransmissionKey(messageId, endpoint->adapter, key);
+
     // mutex lock
     oc_mutex_lock(context->threadMutex);
 
-    size_t len = u_arraylist_length(context->dataList);
-
-    // #3. add data into list
-    for (size_t i = 0; i < len; i++)
+    // #3. add data into map and wheel
+    if (u_hashmap_contains(context->dataMap, key, sizeof(key)))
     {
-        CARetransmissionData_t *currData = u_arraylist_get(context->dataList, i);
+        OIC_LOG(ERROR, TAG, "Duplicate message ID");
 
-        if (NULL == currData)
-        {
-            continue;
-        }
+        // mutex unlock
+        oc_mutex_unlock(context->threadMutex);
 
-        // found index
-        if (NULL != currData->endpoint && currData->messageId == messageId
-            && (currData->endpoint->adapter == endpoint->adapter))
-        {
-            OIC_LOG(ERROR, TAG, "Duplicate message ID");
+        CAFreeRetransmissionData(retData);
+        return CA_STATUS_FAILED;
+    }
 
-            // mutex unlock
-            oc_mutex_unlock(context->threadMutex);
+    if (!u_hashmap_put(context->dataMap, key, sizeof(key), retData))
+    {
+        OIC_LOG(ERROR, TAG, "memory error");
 
-            OICFree(retData);
-            OICFree(pduData);
-            OICFree(remoteEndpoint);
-            return CA_STATUS_FAILED;
-        }
-    }
+        // mutex unlock
+        oc_mutex_unlock(context->threadMutex);
 
-    u_arraylist_add(context->dataList, (void *) retData);
+        CAFreeRetransmissionData(retData);
+        return CA_MEMORY_ALLOC_FAILED;
+    }
+    CAScheduleRetransmission(context, retData);
 
+#ifndef SINGLE_THREAD
     // notify the thread
     oc_cond_signal(context->threadCond);
 
     // mutex unlock
     oc_mutex_unlock(context->threadMutex);
-
 #else
-    u_arraylist_add(context->dataList, (void *) retData);
+    // mutex unlock
+    oc_mutex_unlock(context->threadMutex);
 
     CACheckRetransmissionList(context);
 #endif
@@ -517,82 +630,55 @@ CAResult_t CARetransmissionReceivedData(CARetransmission_t *context,
         return CA_STATUS_OK;
     }
 
+    unsigned char key[CA_RETRANSMISSION_KEY_SIZE];
+    CAGetRetransmissionKey(messageId, endpoint->adapter, key);
+
     // mutex lock
     oc_mutex_lock(context->threadMutex);
-    size_t len = u_arraylist_length(context->dataList);
 
-    for (size_t i = 0; i < len; i++)
+    CARetransmissionData_t *retData = (CARetransmissionData_t *) u_hashmap_get(context->dataMap,
+                                                                               key, sizeof(key));
+    if (NULL == retData)
     {
-        CARetransmissionData_t *retData = (CARetransmissionData_t *) u_arraylist_get(
-                context->dataList, i);
-
-        if (NULL == retData)
-        {
-            continue;
-        }
-
-        // found index
-        if (NULL != retData->endpoint && retData->messageId == messageId
-            && (retData->endpoint->adapter == endpoint->adapter))
-        {
-            // get pdu data for getting token when CA_EMPTY(RST/ACK) is received from remote device
-            // if retransmission was finish..token will be unavailable.
-            if (CA_EMPTY == CAGetCodeFromPduBinaryData(pdu, size))
-            {
-                OIC_LOG(DEBUG, TAG, "code is CA_EMPTY");
-
-                if (NULL == retData->pdu)
-                {
-                    OIC_LOG(ERROR, TAG, "retData->pdu is null");
-                    OICFree(retData);
-                    // mutex unlock
-                    oc_mutex_unlock(context->threadMutex);
-
-                    return CA_STATUS_FAILED;
-                }
-
-                // copy PDU data
-                (*retransmissionPdu) = (void *) OICCalloc(1, retData->size);
-                if ((*retransmissionPdu) == NULL)
-                {
-                    OICFree(retData);
-                    OIC_LOG(ERROR, TAG, "memory error");
-
-                    // mutex unlock
-                    oc_mutex_unlock(context->threadMutex);
-
-                    return CA_MEMORY_ALLOC_FAILED;
-                }
-                memcpy((*retransmissionPdu), retData->pdu, retData->size);
-            }
+        // mutex unlock
+        oc_mutex_unlock(context->threadMutex);
 
-            // #2. remove data from list
-            CARetransmissionData_t *removedData = u_arraylist_remove(context->dataList, i);
-            if (NULL == removedData)
-            {
-                OIC_LOG(ERROR, TAG, "Removed data is NULL");
+        OIC_LOG(DEBUG, TAG, "OUT");
+        return CA_STATUS_OK;
+    }
 
-                // mutex unlock
-                oc_mutex_unlock(context->threadMutex);
+    // #2. remove data from map and wheel
+    CAUnlinkRetransmissionData(context, retData);
 
-                return CA_STATUS_FAILED;
-            }
+    // mutex unlock
+    oc_mutex_unlock(context->threadMutex);
 
-            OIC_LOG_V(DEBUG, TAG, "remove RTCON data!!, msgid=%d", messageId);
+    OIC_LOG_V(DEBUG, TAG, "remove RTCON data!!, msgid=%d", messageId);
 
-            CAFreeEndpoint(removedData->endpoint);
-            OICFree(removedData->pdu);
-            OICFree(removedData);
+    // get pdu data for getting token when CA_EMPTY(RST/ACK) is received from remote device
+    // if retransmission was finish..token will be unavailable.
+    CAResult_t res = CA_STATUS_OK;
+    if (CA_EMPTY == code)
+    {
+        OIC_LOG(DEBUG, TAG, "code is CA_EMPTY");
 
-            break;
+        if (NULL == retData->pdu)
+        {
+            OIC_LOG(ERROR, TAG, "retData->pdu is null");
+            res = CA_STATUS_FAILED;
+        }
+        else
+        {
+            // hand over PDU data
+            (*retransmissionPdu) = retData->pdu;
+            retData->pdu = NULL;
         }
     }
 
-    // mutex unlock
-    oc_mutex_unlock(context->threadMutex);
+    CAFreeRetransmissionData(retData);
 
     OIC_LOG(DEBUG, TAG, "OUT");
-    return CA_STATUS_OK;
+    return res;
 }
 
 CAResult_t CARetransmissionStop(CARetransmission_t *context)
@@ -622,6 +708,15 @@ CAResult_t CARetransmissionStop(CARetransmission_t *context)
     return CA_STATUS_OK;
 }
 
+static bool CAFreeRetransmissionEntry(const void *key, size_t keyLen, void *value, void *ctx)
+{
+    (void) key;
+    (void) keyLen;
+    (void) ctx;
+    CAFreeRetransmissionData((CARetransmissionData_t *) value);
+    return true;
+}
+
 CAResult_t CARetransmissionDestroy(CARetransmission_t *context)
 {
     if (NULL == context)
@@ -633,24 +728,15 @@ CAResult_t CARetransmissionDestroy(CARetransmission_t *context)
     OIC_LOG(DEBUG, TAG, "retransmission context destroy..");
 
     oc_mutex_lock(context->threadMutex);
-    size_t len = u_arraylist_length(context->dataList);
-    for (size_t i = 0; i < len; i++)
-    {
-        CARetransmissionData_t *data = u_arraylist_get(context->dataList, i);
-        if (NULL == data)
-        {
-            continue;
-        }
-        CAFreeEndpoint(data->endpoint);
-        OICFree(data->pdu);
-        OICFree(data);
-    }
+    u_hashmap_foreach(context->dataMap, CAFreeRetransmissionEntry, NULL);
     oc_mutex_unlock(context->threadMutex);
 
     oc_mutex_free(context->threadMutex);
     context->threadMutex = NULL;
     oc_cond_free(context->threadCond);
-    u_arraylist_free(&context->dataList);
+    u_hashmap_free(&context->dataMap);
+    OICFree(context->timerWheel);
+    context->timerWheel = NULL;
 
     return CA_STATUS_OK;
 }
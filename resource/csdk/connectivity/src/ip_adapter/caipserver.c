@@ -60,6 +60,9 @@
 #include <linux/netlink.h>
 #include <linux/rtnetlink.h>
 #endif
+#if defined(HAVE_SYS_EPOLL_H) && !defined(WSA_WAIT_EVENT_0)
+#include <sys/epoll.h>
+#endif
 
 #include <coap/pdu.h>
 #include "caipinterface.h"
@@ -69,6 +72,7 @@
 #include "ca_adapter_net_ssl.h"
 #endif
 #include "octhread.h"
+#include "ocatomic.h"
 #include "oic_malloc.h"
 #include "oic_string.h"
 
@@ -77,6 +81,10 @@
 #undef USE_IP_MREQN
 #endif
 
+#if defined(HAVE_SYS_EPOLL_H) && !defined(WSA_WAIT_EVENT_0)
+#define USE_EPOLL
+#endif
+
 /*
  * Logging tag for module name
  */
@@ -89,6 +97,51 @@
 
 #define SELECT_TIMEOUT 1     // select() seconds (and termination latency)
 
+#if defined(HAVE_RECVMMSG) || defined(HAVE_SENDMMSG)
+#define IP_BATCH_SIZE 16     // datagrams per recvmmsg()/sendmmsg()
+
+typedef union
+{
+    struct cmsghdr cmsg;
+    unsigned char data[CMSG_SPACE(sizeof (struct in6_pktinfo))];
+} CAPktInfoControl_t;
+#endif
+
+/*
+ * Use recvmmsg()/sendmmsg() where available
+ */
+static bool g_batchedIO = true;
+
+#ifdef USE_EPOLL
+#define EPOLL_MAX_EVENTS 16  // events handled per epoll_wait()
+
+/*
+ * epoll instance of the receive thread, -1 if select() is used instead
+ */
+static int g_epollFd = -1;
+#endif
+
+/*
+ * Receive thread state. CAIPStopServer() waits for the thread to leave
+ * CAReceiveHandler() before it closes the descriptors the thread waits on.
+ */
+static oc_mutex g_receiveThreadMutex = NULL;
+static oc_cond g_receiveThreadCond = NULL;
+static bool g_receiveThreadRunning = false;
+
+#ifdef CA_IP_INTERFACE_SNAPSHOT
+/*
+ * Interface snapshots maintained by the network monitor. Readers pin the current
+ * slot with its reader count; a writer fills the other slot once its readers are
+ * gone and then makes it the current one, so readers never take a lock.
+ */
+static CAIPInterfaceSnapshot_t *g_ifSnapshots[2] = { NULL, NULL };
+static volatile int32_t g_ifSnapshotReaders[2] = { 0, 0 };
+static volatile int32_t g_ifSnapshotCurrent = -1;   // -1 until the server has started
+static oc_mutex g_ifSnapshotMutex = NULL;           // serializes the writers
+static uint32_t g_ifSnapshotVersion = 0;
+#endif
+
 #define IPv4_MULTICAST     "224.0.1.187"
 static struct in_addr IPv4MulticastAddress = { 0 };
 
@@ -164,6 +217,11 @@ static void CAReceiveHandler(void *data)
     {
         CAFindReadyMessage();
     }
+
+    oc_mutex_lock(g_receiveThreadMutex);
+    g_receiveThreadRunning = false;
+    oc_cond_signal(g_receiveThreadCond);
+    oc_mutex_unlock(g_receiveThreadMutex);
 }
 
 #define CLOSE_SOCKET(TYPE) \
@@ -188,9 +246,153 @@ static void CAReceiveHandler(void *data)
         flags = FLAGS; \
     }
 
+#ifdef USE_EPOLL
+
+#define EPOLL_ADD(TYPE) \
+    if (caglobals.ip.TYPE.fd != OC_INVALID_SOCKET) \
+    { \
+        CAEpollAdd(caglobals.ip.TYPE.fd); \
+    }
+
+#define IS_EPOLL_SOCKET(TYPE, SOCKET, FLAGS) \
+    if ((caglobals.ip.TYPE.fd != OC_INVALID_SOCKET) && (caglobals.ip.TYPE.fd == SOCKET)) \
+    { \
+        fd = caglobals.ip.TYPE.fd; \
+        flags = FLAGS; \
+    }
+
+static void CAEpollAdd(int fd)
+{
+    struct epoll_event event = { .events = EPOLLIN, .data.fd = fd };
+    if (-1 == epoll_ctl(g_epollFd, EPOLL_CTL_ADD, fd, &event))
+    {
+        OIC_LOG_V(ERROR, TAG, "epoll_ctl(%d) failed: %s", fd, CAIPS_GET_ERROR);
+    }
+}
+
+/*
+ * Sockets are level-triggered, so one datagram is read per socket and
+ * wakeup as with select(). Closed sockets leave the epoll set by themselves.
+ */
+static void CAInitializeEpoll()
+{
+    g_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (-1 == g_epollFd)
+    {
+        OIC_LOG_V(ERROR, TAG, "epoll_create1 failed, using select: %s", CAIPS_GET_ERROR);
+        return;
+    }
+
+    EPOLL_ADD(u6)
+    EPOLL_ADD(u6s)
+    EPOLL_ADD(u4)
+    EPOLL_ADD(u4s)
+    EPOLL_ADD(m6)
+    EPOLL_ADD(m6s)
+    EPOLL_ADD(m4)
+    EPOLL_ADD(m4s)
+
+    if (caglobals.ip.shutdownFds[0] != -1)
+    {
+        CAEpollAdd(caglobals.ip.shutdownFds[0]);
+    }
+    if (caglobals.ip.netlinkFd != OC_INVALID_SOCKET)
+    {
+        CAEpollAdd(caglobals.ip.netlinkFd);
+    }
+}
+
+static void CAEpollReturned(int socket)
+{
+    CASocketFd_t fd = OC_INVALID_SOCKET;
+    CATransportFlags_t flags = CA_DEFAULT_FLAGS;
+
+    IS_EPOLL_SOCKET(u6,  socket, CA_IPV6)
+    else IS_EPOLL_SOCKET(u6s, socket, CA_IPV6 | CA_SECURE)
+    else IS_EPOLL_SOCKET(u4,  socket, CA_IPV4)
+    else IS_EPOLL_SOCKET(u4s, socket, CA_IPV4 | CA_SECURE)
+    else IS_EPOLL_SOCKET(m6,  socket, CA_MULTICAST | CA_IPV6)
+    else IS_EPOLL_SOCKET(m6s, socket, CA_MULTICAST | CA_IPV6 | CA_SECURE)
+    else IS_EPOLL_SOCKET(m4,  socket, CA_MULTICAST | CA_IPV4)
+    else IS_EPOLL_SOCKET(m4s, socket, CA_MULTICAST | CA_IPV4 | CA_SECURE)
+    else if ((caglobals.ip.netlinkFd != OC_INVALID_SOCKET) && (caglobals.ip.netlinkFd == socket))
+    {
+#if NETWORK_INTERFACE_CHANGED_LOGGING
+        OIC_LOG_V(DEBUG, TAG, "Netlink event detacted");
+#endif
+        u_arraylist_t *iflist = CAFindInterfaceChange();
+        if (iflist)
+        {
+            size_t listLength = u_arraylist_length(iflist);
+            for (size_t i = 0; i < listLength; i++)
+            {
+                CAInterface_t *ifitem = (CAInterface_t *)u_arraylist_get(iflist, i);
+                if (ifitem)
+                {
+                    CAProcessNewInterface(ifitem);
+                }
+            }
+            u_arraylist_destroy(iflist);
+        }
+        return;
+    }
+    else if (caglobals.ip.shutdownFds[0] == socket)
+    {
+        char buf[10] = {0};
+        ssize_t len = read(caglobals.ip.shutdownFds[0], buf, sizeof (buf));
+        if (-1 == len)
+        {
+            OIC_LOG_V(DEBUG, TAG, "read failed: %s", CAIPS_GET_ERROR);
+        }
+        return;
+    }
+    else
+    {
+        // socket was closed after epoll_wait() returned.
+        return;
+    }
+    (void)CAReceiveMessage(fd, flags);
+}
+
+static void CAEpollFindReadyMessage()
+{
+    struct epoll_event events[EPOLL_MAX_EVENTS];
+    int timeout = caglobals.ip.selectTimeout == -1 ? -1 : caglobals.ip.selectTimeout * 1000;
+
+    int ret = epoll_wait(g_epollFd, events, EPOLL_MAX_EVENTS, timeout);
+
+    if (caglobals.ip.terminate)
+    {
+        OIC_LOG_V(DEBUG, TAG, "Packet receiver Stop request received.");
+        return;
+    }
+
+    if (0 > ret)
+    {
+        if (EINTR != errno)
+        {
+            OIC_LOG_V(FATAL, TAG, "epoll_wait error %s", CAIPS_GET_ERROR);
+        }
+        return;
+    }
+
+    for (int i = 0; (i < ret) && !caglobals.ip.terminate; i++)
+    {
+        CAEpollReturned(events[i].data.fd);
+    }
+}
+#endif // USE_EPOLL
 
 static void CAFindReadyMessage()
 {
+#ifdef USE_EPOLL
+    if (-1 != g_epollFd)
+    {
+        CAEpollFindReadyMessage();
+        return;
+    }
+#endif
+
     fd_set readFds;
     struct timeval timeout;
 
@@ -538,10 +740,166 @@ void CADeInitializeIPGlobals()
     CLOSE_SOCKET(m4s);
 
     CAUnregisterForAddressChanges();
+
+#ifdef CA_IP_INTERFACE_SNAPSHOT
+    if (g_ifSnapshotMutex)
+    {
+        oc_mutex_free(g_ifSnapshotMutex);
+        g_ifSnapshotMutex = NULL;
+    }
+#endif
+
+    if (g_receiveThreadMutex)
+    {
+        oc_mutex_free(g_receiveThreadMutex);
+        g_receiveThreadMutex = NULL;
+    }
+    if (g_receiveThreadCond)
+    {
+        oc_cond_free(g_receiveThreadCond);
+        g_receiveThreadCond = NULL;
+    }
+}
+
+static void CAHandleReceivedData(CATransportFlags_t flags,
+                                 struct sockaddr_storage *srcAddr, int namelen,
+                                 unsigned char *pktinfo, char *recvBuffer, size_t recvLen)
+{
+    CASecureEndpoint_t sep = {.endpoint = {.adapter = CA_ADAPTER_IP, .flags = flags}};
+
+    if (flags & CA_IPV6)
+    {
+        sep.endpoint.ifindex = ((struct in6_pktinfo *)pktinfo)->ipi6_ifindex;
+
+        if (flags & CA_MULTICAST)
+        {
+            struct in6_addr *addr = &(((struct in6_pktinfo *)pktinfo)->ipi6_addr);
+            unsigned char topbits = ((unsigned char *)addr)[0];
+            if (topbits != 0xff)
+            {
+                sep.endpoint.flags &= ~CA_MULTICAST;
+            }
+        }
+    }
+    else
+    {
+        sep.endpoint.ifindex = ((struct in_pktinfo *)pktinfo)->ipi_ifindex;
+
+        if (flags & CA_MULTICAST)
+        {
+            struct in_addr *addr = &((struct in_pktinfo *)pktinfo)->ipi_addr;
+            uint32_t host = ntohl(addr->s_addr);
+            unsigned char topbits = ((unsigned char *)&host)[3];
+            if (topbits < 224 || topbits > 239)
+            {
+                sep.endpoint.flags &= ~CA_MULTICAST;
+            }
+        }
+    }
+
+    CAConvertAddrToName(srcAddr, namelen, sep.endpoint.addr, &sep.endpoint.port);
+
+    if (flags & CA_SECURE)
+    {
+#ifdef __WITH_DTLS__
+#ifdef TB_LOG
+        int decryptResult =
+#endif
+        CAdecryptSsl(&sep, (uint8_t *)recvBuffer, recvLen);
+        OIC_LOG_V(DEBUG, TAG, "CAdecryptSsl returns [%d]", decryptResult);
+#else
+        OIC_LOG(ERROR, TAG, "Encrypted message but no DTLS");
+#endif // __WITH_DTLS__
+    }
+    else
+    {
+        if (g_packetReceivedCallback)
+        {
+            g_packetReceivedCallback(&sep, recvBuffer, recvLen);
+        }
+    }
+}
+
+#ifdef HAVE_RECVMMSG
+/*
+ * Receive buffers of the batched path. Only the receive thread uses them.
+ */
+static char g_recvBuffers[IP_BATCH_SIZE][COAP_MAX_PDU_SIZE];
+static struct sockaddr_storage g_recvAddrs[IP_BATCH_SIZE];
+static CAPktInfoControl_t g_recvControls[IP_BATCH_SIZE];
+
+/*
+ * Drain up to IP_BATCH_SIZE datagrams of a readable socket with one recvmmsg().
+ */
+static CAResult_t CAReceiveMessages(CASocketFd_t fd, CATransportFlags_t flags)
+{
+    int namelen = sizeof (struct sockaddr_in);
+    int level = IPPROTO_IP;
+    int type = IP_PKTINFO;
+    if (flags & CA_IPV6)
+    {
+        namelen = sizeof (struct sockaddr_in6);
+        level = IPPROTO_IPV6;
+        type = IPV6_PKTINFO;
+    }
+
+    struct iovec iovs[IP_BATCH_SIZE];
+    struct mmsghdr msgs[IP_BATCH_SIZE];
+    memset(msgs, 0, sizeof (msgs));
+    for (size_t i = 0; i < IP_BATCH_SIZE; i++)
+    {
+        iovs[i].iov_base = g_recvBuffers[i];
+        iovs[i].iov_len = sizeof (g_recvBuffers[i]);
+        msgs[i].msg_hdr.msg_name = &g_recvAddrs[i];
+        msgs[i].msg_hdr.msg_namelen = namelen;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_control = &g_recvControls[i];
+        msgs[i].msg_hdr.msg_controllen = sizeof (g_recvControls[i]);
+    }
+
+    // The socket is readable, so at least one datagram is returned without waiting.
+    int count = recvmmsg(fd, msgs, IP_BATCH_SIZE, MSG_DONTWAIT, NULL);
+    if (OC_SOCKET_ERROR == count)
+    {
+        OIC_LOG_V(ERROR, TAG, "recvmmsg failed %s", strerror(errno));
+        return CA_STATUS_FAILED;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        unsigned char *pktinfo = NULL;
+        for (struct cmsghdr *cmp = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmp != NULL;
+             cmp = CMSG_NXTHDR(&msgs[i].msg_hdr, cmp))
+        {
+            if (cmp->cmsg_level == level && cmp->cmsg_type == type)
+            {
+                pktinfo = CMSG_DATA(cmp);
+            }
+        }
+        if (!pktinfo)
+        {
+            OIC_LOG(ERROR, TAG, "pktinfo is null");
+            continue;
+        }
+
+        CAHandleReceivedData(flags, &g_recvAddrs[i], namelen, pktinfo,
+                             g_recvBuffers[i], msgs[i].msg_len);
+    }
+
+    return CA_STATUS_OK;
 }
+#endif // HAVE_RECVMMSG
 
 static CAResult_t CAReceiveMessage(CASocketFd_t fd, CATransportFlags_t flags)
 {
+#ifdef HAVE_RECVMMSG
+    if (g_batchedIO)
+    {
+        return CAReceiveMessages(fd, flags);
+    }
+#endif
+
     char recvBuffer[COAP_MAX_PDU_SIZE] = {0};
     int level = 0;
     int type = 0;
@@ -648,59 +1006,7 @@ static CAResult_t CAReceiveMessage(CASocketFd_t fd, CATransportFlags_t flags)
         return CA_STATUS_FAILED;
     }
 
-    CASecureEndpoint_t sep = {.endpoint = {.adapter = CA_ADAPTER_IP, .flags = flags}};
-
-    if (flags & CA_IPV6)
-    {
-        sep.endpoint.ifindex = ((struct in6_pktinfo *)pktinfo)->ipi6_ifindex;
-
-        if (flags & CA_MULTICAST)
-        {
-            struct in6_addr *addr = &(((struct in6_pktinfo *)pktinfo)->ipi6_addr);
-            unsigned char topbits = ((unsigned char *)addr)[0];
-            if (topbits != 0xff)
-            {
-                sep.endpoint.flags &= ~CA_MULTICAST;
-            }
-        }
-    }
-    else
-    {
-        sep.endpoint.ifindex = ((struct in_pktinfo *)pktinfo)->ipi_ifindex;
-
-        if (flags & CA_MULTICAST)
-        {
-            struct in_addr *addr = &((struct in_pktinfo *)pktinfo)->ipi_addr;
-            uint32_t host = ntohl(addr->s_addr);
-            unsigned char topbits = ((unsigned char *)&host)[3];
-            if (topbits < 224 || topbits > 239)
-            {
-                sep.endpoint.flags &= ~CA_MULTICAST;
-            }
-        }
-    }
-
-    CAConvertAddrToName(&srcAddr, namelen, sep.endpoint.addr, &sep.endpoint.port);
-
-    if (flags & CA_SECURE)
-    {
-#ifdef __WITH_DTLS__
-#ifdef TB_LOG
-        int decryptResult =
-#endif
-        CAdecryptSsl(&sep, (uint8_t *)recvBuffer, recvLen);
-        OIC_LOG_V(DEBUG, TAG, "CAdecryptSsl returns [%d]", decryptResult);
-#else
-        OIC_LOG(ERROR, TAG, "Encrypted message but no DTLS");
-#endif // __WITH_DTLS__
-    }
-    else
-    {
-        if (g_packetReceivedCallback)
-        {
-            g_packetReceivedCallback(&sep, recvBuffer, recvLen);
-        }
-    }
+    CAHandleReceivedData(flags, &srcAddr, namelen, pktinfo, recvBuffer, recvLen);
 
     return CA_STATUS_OK;
 }
@@ -918,6 +1224,207 @@ static void CAInitializeFastShutdownMechanism()
     OIC_LOG_V(DEBUG, TAG, "OUT %s", __func__);
 }
 
+static void CAIPDestroyInterfaceSnapshot(CAIPInterfaceSnapshot_t *snapshot)
+{
+    if (snapshot)
+    {
+        u_arraylist_destroy(snapshot->iflist);
+        OICFree(snapshot);
+    }
+}
+
+#ifdef CA_IP_INTERFACE_SNAPSHOT
+static bool CAIPCopyInterfaceItems(u_arraylist_t *dest, const u_arraylist_t *src,
+                                   uint32_t skipIndex)
+{
+    size_t len = u_arraylist_length(src);
+    for (size_t i = 0; i < len; i++)
+    {
+        CAInterface_t *ifitem = (CAInterface_t *)u_arraylist_get(src, i);
+        if (!ifitem || (skipIndex && ifitem->index == skipIndex))
+        {
+            continue;
+        }
+
+        CAInterface_t *copy = (CAInterface_t *)OICMalloc(sizeof (CAInterface_t));
+        if (!copy)
+        {
+            OIC_LOG(ERROR, TAG, "Malloc failed");
+            return false;
+        }
+        *copy = *ifitem;
+
+        if (!u_arraylist_add(dest, copy))
+        {
+            OIC_LOG(ERROR, TAG, "u_arraylist_add failed.");
+            OICFree(copy);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void CAIPWaitForInterfaceSnapshotReaders(int32_t slot)
+{
+    while (oc_atomic_add(&g_ifSnapshotReaders[slot], 0))
+    {
+        usleep(1000);
+    }
+}
+
+/*
+ * Must be called with g_ifSnapshotMutex held.
+ */
+static void CAIPPublishInterfaceSnapshot(CAIPInterfaceSnapshot_t *snapshot)
+{
+    int32_t current = oc_atomic_add(&g_ifSnapshotCurrent, 0);
+    int32_t next = (0 == current) ? 1 : 0;
+
+    // the other slot is only pinned by readers of an earlier snapshot.
+    CAIPWaitForInterfaceSnapshotReaders(next);
+    CAIPDestroyInterfaceSnapshot(g_ifSnapshots[next]);
+
+    snapshot->version = ++g_ifSnapshotVersion;
+    snapshot->slot = next;
+    g_ifSnapshots[next] = snapshot;
+    oc_atomic_cmpxchg(&g_ifSnapshotCurrent, current, next);
+}
+
+/*
+ * Must be called with g_ifSnapshotMutex held.
+ */
+static void CAIPClearInterfaceSnapshotLocked()
+{
+    int32_t current = oc_atomic_add(&g_ifSnapshotCurrent, 0);
+    oc_atomic_cmpxchg(&g_ifSnapshotCurrent, current, -1);
+
+    for (int32_t slot = 0; slot < 2; slot++)
+    {
+        CAIPWaitForInterfaceSnapshotReaders(slot);
+        CAIPDestroyInterfaceSnapshot(g_ifSnapshots[slot]);
+        g_ifSnapshots[slot] = NULL;
+    }
+}
+
+static void CAIPClearInterfaceSnapshot()
+{
+    if (g_ifSnapshotMutex)
+    {
+        oc_mutex_lock(g_ifSnapshotMutex);
+        CAIPClearInterfaceSnapshotLocked();
+        oc_mutex_unlock(g_ifSnapshotMutex);
+    }
+}
+#endif // CA_IP_INTERFACE_SNAPSHOT
+
+const CAIPInterfaceSnapshot_t *CAIPAcquireInterfaceSnapshot()
+{
+#ifdef CA_IP_INTERFACE_SNAPSHOT
+    for (;;)
+    {
+        int32_t current = oc_atomic_add(&g_ifSnapshotCurrent, 0);
+        if (current < 0)
+        {
+            break;
+        }
+
+        oc_atomic_increment(&g_ifSnapshotReaders[current]);
+        if (oc_atomic_add(&g_ifSnapshotCurrent, 0) == current)
+        {
+            return g_ifSnapshots[current];
+        }
+
+        // a writer published another snapshot meanwhile, the slot may be reused.
+        oc_atomic_decrement(&g_ifSnapshotReaders[current]);
+    }
+#endif
+
+    // not maintained by the network monitor, take a private snapshot.
+    u_arraylist_t *iflist = CAIPGetInterfaceInformation(0);
+    if (!iflist)
+    {
+        OIC_LOG_V(ERROR, TAG, "get interface info failed: %s", strerror(errno));
+        return NULL;
+    }
+
+    CAIPInterfaceSnapshot_t *snapshot =
+        (CAIPInterfaceSnapshot_t *)OICCalloc(1, sizeof (CAIPInterfaceSnapshot_t));
+    if (!snapshot)
+    {
+        OIC_LOG(ERROR, TAG, "Malloc failed");
+        u_arraylist_destroy(iflist);
+        return NULL;
+    }
+    snapshot->iflist = iflist;
+    snapshot->slot = -1;
+    return snapshot;
+}
+
+void CAIPReleaseInterfaceSnapshot(const CAIPInterfaceSnapshot_t *snapshot)
+{
+    if (!snapshot)
+    {
+        return;
+    }
+
+#ifdef CA_IP_INTERFACE_SNAPSHOT
+    if (snapshot->slot >= 0)
+    {
+        oc_atomic_decrement(&g_ifSnapshotReaders[snapshot->slot]);
+        return;
+    }
+#endif
+    CAIPDestroyInterfaceSnapshot((CAIPInterfaceSnapshot_t *)snapshot);
+}
+
+void CAIPUpdateInterfaceSnapshot(uint32_t ifindex, const u_arraylist_t *iflist)
+{
+#ifdef CA_IP_INTERFACE_SNAPSHOT
+    if (!g_ifSnapshotMutex)
+    {
+        OIC_LOG(DEBUG, TAG, "interface snapshot is not maintained");
+        return;
+    }
+    oc_mutex_lock(g_ifSnapshotMutex);
+
+    // changes of single interfaces are only tracked while the server is running.
+    int32_t current = oc_atomic_add(&g_ifSnapshotCurrent, 0);
+    if (ifindex && current < 0)
+    {
+        oc_mutex_unlock(g_ifSnapshotMutex);
+        return;
+    }
+
+    CAIPInterfaceSnapshot_t *snapshot =
+        (CAIPInterfaceSnapshot_t *)OICCalloc(1, sizeof (CAIPInterfaceSnapshot_t));
+    bool copied = false;
+    if (snapshot && (snapshot->iflist = u_arraylist_create()))
+    {
+        copied = (!ifindex
+                  || CAIPCopyInterfaceItems(snapshot->iflist, g_ifSnapshots[current]->iflist,
+                                            ifindex))
+                 && (!iflist || CAIPCopyInterfaceItems(snapshot->iflist, iflist, 0));
+    }
+
+    if (copied)
+    {
+        CAIPPublishInterfaceSnapshot(snapshot);
+    }
+    else
+    {
+        // senders enumerate the interfaces again rather than use a stale snapshot.
+        OIC_LOG(ERROR, TAG, "Failed to update interface snapshot");
+        CAIPDestroyInterfaceSnapshot(snapshot);
+        CAIPClearInterfaceSnapshotLocked();
+    }
+
+    oc_mutex_unlock(g_ifSnapshotMutex);
+#else
+    (void)ifindex;
+    (void)iflist;
+#endif
+}
+
 CAResult_t CAIPStartServer(const ca_thread_pool_t threadPool)
 {
     CAResult_t res = CA_STATUS_OK;
@@ -943,6 +1450,39 @@ CAResult_t CAIPStartServer(const ca_thread_pool_t threadPool)
         caglobals.ip.ipv4enabled = true;  // only needed to run CA tests
     }
 
+#ifdef CA_IP_INTERFACE_SNAPSHOT
+    // the receive thread updates the snapshot, so the mutex lives until
+    // CADeInitializeIPGlobals() rather than CAIPStopServer().
+    if (!g_ifSnapshotMutex)
+    {
+        g_ifSnapshotMutex = oc_mutex_new();
+        if (!g_ifSnapshotMutex)
+        {
+            OIC_LOG(ERROR, TAG, "Failed to create interface snapshot mutex");
+            return CA_STATUS_FAILED;
+        }
+    }
+#endif
+
+    if (!g_receiveThreadMutex)
+    {
+        g_receiveThreadMutex = oc_mutex_new();
+        if (!g_receiveThreadMutex)
+        {
+            OIC_LOG(ERROR, TAG, "Failed to create receive thread mutex");
+            return CA_STATUS_FAILED;
+        }
+    }
+    if (!g_receiveThreadCond)
+    {
+        g_receiveThreadCond = oc_cond_new();
+        if (!g_receiveThreadCond)
+        {
+            OIC_LOG(ERROR, TAG, "Failed to create receive thread condition");
+            return CA_STATUS_FAILED;
+        }
+    }
+
     if (caglobals.ip.ipv6enabled)
     {
         NEWSOCKET(AF_INET6, u6, false);
@@ -990,6 +1530,10 @@ CAResult_t CAIPStartServer(const ca_thread_pool_t threadPool)
 
     caglobals.ip.selectTimeout = CAGetPollingInterval(caglobals.ip.selectTimeout);
 
+#ifdef USE_EPOLL
+    CAInitializeEpoll();
+#endif
+
     res = CAIPStartListenServer();
     if (CA_STATUS_OK != res)
     {
@@ -998,10 +1542,12 @@ CAResult_t CAIPStartServer(const ca_thread_pool_t threadPool)
     }
 
     caglobals.ip.terminate = false;
+    g_receiveThreadRunning = true;
     res = ca_thread_pool_add_task(threadPool, CAReceiveHandler, NULL);
     if (CA_STATUS_OK != res)
     {
         OIC_LOG(ERROR, TAG, "thread_pool_add_task failed");
+        g_receiveThreadRunning = false;
         return res;
     }
     OIC_LOG(DEBUG, TAG, "CAReceiveHandler thread started successfully.");
@@ -1019,6 +1565,7 @@ void CAIPStopServer()
     if (caglobals.ip.shutdownFds[1] != -1)
     {
         close(caglobals.ip.shutdownFds[1]);
+        caglobals.ip.shutdownFds[1] = -1;
         // receive thread will stop immediately
     }
     else
@@ -1032,6 +1579,37 @@ void CAIPStopServer()
         OIC_LOG_V(DEBUG, TAG, "set shutdown event failed: %d", WSAGetLastError());
     }
 #endif
+
+    // the receive thread must not wait on descriptors that are closed and reused.
+    if (g_receiveThreadMutex)
+    {
+        oc_mutex_lock(g_receiveThreadMutex);
+        while (g_receiveThreadRunning)
+        {
+            oc_cond_wait(g_receiveThreadCond, g_receiveThreadMutex);
+        }
+        oc_mutex_unlock(g_receiveThreadMutex);
+
+#if !defined(WSA_WAIT_EVENT_0)
+        if (caglobals.ip.shutdownFds[0] != -1)
+        {
+            close(caglobals.ip.shutdownFds[0]);
+            caglobals.ip.shutdownFds[0] = -1;
+        }
+#endif
+    }
+
+#ifdef USE_EPOLL
+    if (-1 != g_epollFd)
+    {
+        close(g_epollFd);
+        g_epollFd = -1;
+    }
+#endif
+
+#ifdef CA_IP_INTERFACE_SNAPSHOT
+    CAIPClearInterfaceSnapshot();
+#endif
 }
 
 void CAWakeUpForChange()
@@ -1210,6 +1788,14 @@ CAResult_t CAIPStartListenServer()
         }
     }
 
+#ifdef CA_IP_INTERFACE_SNAPSHOT
+    if (OC_INVALID_SOCKET != caglobals.ip.netlinkFd)
+    {
+        // from now on kept current by the network monitor.
+        CAIPUpdateInterfaceSnapshot(0, iflist);
+    }
+#endif
+
     u_arraylist_destroy(iflist);
     OIC_LOG_V(DEBUG, TAG, "OUT %s", __func__);
     return CA_STATUS_OK;
@@ -1276,6 +1862,11 @@ void CAProcessNewInterface(CAInterface_t *ifitem)
     }
 }
 
+void CAIPSetBatchedIO(bool enable)
+{
+    g_batchedIO = enable;
+}
+
 void CAIPSetPacketReceiveCallback(CAIPPacketReceivedCallback callback)
 {
     g_packetReceivedCallback = callback;
@@ -1377,6 +1968,121 @@ static void sendData(CASocketFd_t fd, const CAEndpoint_t *endpoint,
 #endif
 }
 
+#ifdef HAVE_SENDMMSG
+/*
+ * Send the prepared datagrams, IP_BATCH_SIZE per sendmmsg().
+ */
+static void sendMessages(CASocketFd_t fd, const CAEndpoint_t *endpoint,
+                         struct mmsghdr *msgs, size_t count,
+                         const void *data, size_t dlen, const char *fam)
+{
+    (void)fam;  // eliminates release warning
+
+    size_t sent = 0;
+    while (sent < count)
+    {
+        int len = sendmmsg(fd, msgs + sent, (unsigned int)(count - sent), 0);
+        if (OC_SOCKET_ERROR == len)
+        {
+            if (g_ipErrorHandler)
+            {
+                g_ipErrorHandler(endpoint, data, dlen, CA_SEND_FAILED);
+            }
+            OIC_LOG_V(ERROR, TAG, "multicast %s sendmmsg failed: %s", fam, strerror(errno));
+            CALogSendStateInfo(endpoint->adapter, endpoint->addr, endpoint->port,
+                               -1, false, strerror(errno));
+            // skip the failing datagram, the others may still go out.
+            sent++;
+            continue;
+        }
+
+        OIC_LOG_V(INFO, TAG, "multicast %s sendmmsg is successful: %d datagrams", fam, len);
+        for (int i = 0; i < len; i++)
+        {
+            CALogSendStateInfo(endpoint->adapter, endpoint->addr, endpoint->port,
+                               msgs[sent + i].msg_len, true, NULL);
+        }
+        sent += len;
+    }
+}
+
+/*
+ * Send one copy of the data per interface with sendmmsg(). The outgoing
+ * interface of every copy is selected by its IP_PKTINFO/IPV6_PKTINFO, so no
+ * IP_MULTICAST_IF/IPV6_MULTICAST_IF switching is needed between sends.
+ */
+static void sendMulticastBatch(CASocketFd_t fd, int family, const u_arraylist_t *iflist,
+                               const CAEndpoint_t *endpoint,
+                               const void *data, size_t datalen, const char *fam)
+{
+    struct sockaddr_storage sock = { .ss_family = 0 };
+    CAConvertNameToAddr(endpoint->addr, endpoint->port, &sock);
+    socklen_t socklen = (AF_INET6 == family) ? sizeof(struct sockaddr_in6)
+                                             : sizeof(struct sockaddr_in);
+
+    struct iovec iov = { .iov_base = (void *)data, .iov_len = datalen };
+    struct mmsghdr msgs[IP_BATCH_SIZE];
+    CAPktInfoControl_t controls[IP_BATCH_SIZE];
+    size_t count = 0;
+
+    size_t len = u_arraylist_length(iflist);
+    for (size_t i = 0; i < len; i++)
+    {
+        CAInterface_t *ifitem = (CAInterface_t *)u_arraylist_get(iflist, i);
+        if (!ifitem)
+        {
+            continue;
+        }
+        if ((ifitem->flags & IFF_UP_RUNNING_FLAGS) != IFF_UP_RUNNING_FLAGS)
+        {
+            continue;
+        }
+        if (ifitem->family != family)
+        {
+            continue;
+        }
+
+        memset(&msgs[count], 0, sizeof (msgs[count]));
+        memset(&controls[count], 0, sizeof (controls[count]));
+        struct msghdr *msg = &msgs[count].msg_hdr;
+        msg->msg_name = &sock;
+        msg->msg_namelen = socklen;
+        msg->msg_iov = &iov;
+        msg->msg_iovlen = 1;
+        msg->msg_control = &controls[count];
+
+        struct cmsghdr *cmsg = &controls[count].cmsg;
+        if (AF_INET6 == family)
+        {
+            msg->msg_controllen = CMSG_SPACE(sizeof (struct in6_pktinfo));
+            cmsg->cmsg_level = IPPROTO_IPV6;
+            cmsg->cmsg_type = IPV6_PKTINFO;
+            cmsg->cmsg_len = CMSG_LEN(sizeof (struct in6_pktinfo));
+            ((struct in6_pktinfo *)CMSG_DATA(cmsg))->ipi6_ifindex = ifitem->index;
+        }
+        else
+        {
+            msg->msg_controllen = CMSG_SPACE(sizeof (struct in_pktinfo));
+            cmsg->cmsg_level = IPPROTO_IP;
+            cmsg->cmsg_type = IP_PKTINFO;
+            cmsg->cmsg_len = CMSG_LEN(sizeof (struct in_pktinfo));
+            ((struct in_pktinfo *)CMSG_DATA(cmsg))->ipi_ifindex = ifitem->index;
+        }
+
+        if (IP_BATCH_SIZE == ++count)
+        {
+            sendMessages(fd, endpoint, msgs, count, data, datalen, fam);
+            count = 0;
+        }
+    }
+
+    if (count)
+    {
+        sendMessages(fd, endpoint, msgs, count, data, datalen, fam);
+    }
+}
+#endif // HAVE_SENDMMSG
+
 static void sendMulticastData6(const u_arraylist_t *iflist,
                                CAEndpoint_t *endpoint,
                                const void *data, size_t datalen)
@@ -1397,6 +2103,14 @@ static void sendMulticastData6(const u_arraylist_t *iflist,
     OICStrcpy(endpoint->addr, sizeof(endpoint->addr), ipv6mcname);
     CASocketFd_t fd = caglobals.ip.u6.fd;
 
+#ifdef HAVE_SENDMMSG
+    if (g_batchedIO)
+    {
+        sendMulticastBatch(fd, AF_INET6, iflist, endpoint, data, datalen, "ipv6");
+        return;
+    }
+#endif
+
     size_t len = u_arraylist_length(iflist);
     for (size_t i = 0; i < len; i++)
     {
@@ -1442,6 +2156,14 @@ static void sendMulticastData4(const u_arraylist_t *iflist,
     OICStrcpy(endpoint->addr, sizeof(endpoint->addr), IPv4_MULTICAST);
     CASocketFd_t fd = caglobals.ip.u4.fd;
 
+#ifdef HAVE_SENDMMSG
+    if (g_batchedIO)
+    {
+        sendMulticastBatch(fd, AF_INET, iflist, endpoint, data, datalen, "ipv4");
+        return;
+    }
+#endif
+
     size_t len = u_arraylist_length(iflist);
     for (size_t i = 0; i < len; i++)
     {
@@ -1484,23 +2206,22 @@ void CAIPSendData(CAEndpoint_t *endpoint, const void *data, size_t datalen,
     {
         endpoint->port = isSecure ? CA_SECURE_COAP : CA_COAP;
 
-        u_arraylist_t *iflist = CAIPGetInterfaceInformation(0);
-        if (!iflist)
+        const CAIPInterfaceSnapshot_t *snapshot = CAIPAcquireInterfaceSnapshot();
+        if (!snapshot)
         {
-            OIC_LOG_V(ERROR, TAG, "get interface info failed: %s", strerror(errno));
             return;
         }
 
         if ((endpoint->flags & CA_IPV6) && caglobals.ip.ipv6enabled)
         {
-            sendMulticastData6(iflist, endpoint, data, datalen);
+            sendMulticastData6(snapshot->iflist, endpoint, data, datalen);
         }
         if ((endpoint->flags & CA_IPV4) && caglobals.ip.ipv4enabled)
         {
-            sendMulticastData4(iflist, endpoint, data, datalen);
+            sendMulticastData4(snapshot->iflist, endpoint, data, datalen);
         }
 
-        u_arraylist_destroy(iflist);
+        CAIPReleaseInterfaceSnapshot(snapshot);
     }
     else
     {
@@ -1534,12 +2255,12 @@ CAResult_t CAGetIPInterfaceInformation(CAEndpoint_t **info, size_t *size)
     VERIFY_NON_NULL(info, TAG, "info is NULL");
     VERIFY_NON_NULL(size, TAG, "size is NULL");
 
-    u_arraylist_t *iflist = CAIPGetInterfaceInformation(0);
-    if (!iflist)
+    const CAIPInterfaceSnapshot_t *snapshot = CAIPAcquireInterfaceSnapshot();
+    if (!snapshot)
     {
-        OIC_LOG_V(ERROR, TAG, "get interface info failed: %s", strerror(errno));
         return CA_STATUS_FAILED;
     }
+    const u_arraylist_t *iflist = snapshot->iflist;
 
 #ifdef __WITH_DTLS__
     const size_t endpointsPerInterface = 2;
@@ -1566,6 +2287,7 @@ CAResult_t CAGetIPInterfaceInformation(CAEndpoint_t **info, size_t *size)
     if (!interfaces)
     {
         OIC_LOG(DEBUG, TAG, "network interface size is zero");
+        CAIPReleaseInterfaceSnapshot(snapshot);
         return CA_STATUS_OK;
     }
 
@@ -1574,7 +2296,7 @@ CAResult_t CAGetIPInterfaceInformation(CAEndpoint_t **info, size_t *size)
     if (!eps)
     {
         OIC_LOG(ERROR, TAG, "Malloc Failed");
-        u_arraylist_destroy(iflist);
+        CAIPReleaseInterfaceSnapshot(snapshot);
         return CA_MEMORY_ALLOC_FAILED;
     }
 
@@ -1631,7 +2353,7 @@ CAResult_t CAGetIPInterfaceInformation(CAEndpoint_t **info, size_t *size)
     *info = eps;
     *size = totalEndpoints;
 
-    u_arraylist_destroy(iflist);
+    CAIPReleaseInterfaceSnapshot(snapshot);
 
     return CA_STATUS_OK;
 }
@@ -99,6 +99,18 @@ static void CARemoveNetworkMonitorList(int ifiindex);
  */
 static void CAIPPassNetworkChangesToAdapter(CANetworkStatus_t status);
 
+/**
+ * Get the addresses of the interfaces without updating the monitoring list.
+ */
+static u_arraylist_t *CAIPEnumerateInterfaces(int desiredIndex);
+
+#ifdef __linux__
+/**
+ * Replace the items of an interface in the interface snapshot of the IP server.
+ */
+static void CAIPRefreshInterfaceSnapshot(int ifiindex);
+#endif
+
 /**
  * Create new interface item.
  */
@@ -347,6 +359,14 @@ u_arraylist_t *CAFindInterfaceChange()
 
     for (nh = (struct nlmsghdr *)buf; NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len))
     {
+        if (RTM_NEWLINK == nh->nlmsg_type || RTM_DELLINK == nh->nlmsg_type)
+        {
+            // only the flags in the snapshot change, addresses have their own events.
+            struct ifinfomsg *ifi = (struct ifinfomsg *)NLMSG_DATA (nh);
+            CAIPRefreshInterfaceSnapshot(ifi->ifi_index);
+            continue;
+        }
+
         if (nh != NULL && (nh->nlmsg_type != RTM_DELADDR && nh->nlmsg_type != RTM_NEWADDR))
         {
             continue;
@@ -364,6 +384,8 @@ u_arraylist_t *CAFindInterfaceChange()
                     CARemoveNetworkMonitorList(ifiIndex);
                     CAIPPassNetworkChangesToAdapter(CA_INTERFACE_DOWN);
                 }
+                // other addresses of the interface may still be there.
+                CAIPRefreshInterfaceSnapshot(ifiIndex);
             }
             continue;
         }
@@ -373,19 +395,21 @@ u_arraylist_t *CAFindInterfaceChange()
         if (ifa)
         {
             int ifiIndex = ifa->ifa_index;
+            u_arraylist_destroy(iflist);
             iflist = CAIPGetInterfaceInformation(ifiIndex);
             if (!iflist)
             {
                 OIC_LOG_V(ERROR, TAG, "get interface info failed: %s", strerror(errno));
                 return NULL;
             }
+            CAIPUpdateInterfaceSnapshot(ifiIndex, iflist);
         }
     }
 #endif
     return iflist;
 }
 
-u_arraylist_t *CAIPGetInterfaceInformation(int desiredIndex)
+static u_arraylist_t *CAIPEnumerateInterfaces(int desiredIndex)
 {
 #if NETWORK_INTERFACE_CHANGED_LOGGING
     OIC_LOG_V(DEBUG, TAG, "IN %s: desiredIndex = %d", __func__, desiredIndex);
@@ -487,23 +511,9 @@ u_arraylist_t *CAIPGetInterfaceInformation(int desiredIndex)
         if (!result)
         {
             OIC_LOG(ERROR, TAG, "u_arraylist_add failed.");
+            OICFree(ifitem);
             goto exit;
         }
-
-        bool isFound = CACmpNetworkList(ifitem->index);
-        if (!isFound)
-        {
-            CAInterface_t *newifitem = CANewInterfaceItem(ifitem->index, ifitem->name, ifitem->family,
-                                                          ifitem->addr, ifitem->flags);
-            CAResult_t ret = CAAddNetworkMonitorList(newifitem);
-            if (CA_STATUS_OK != ret)
-            {
-                OICFree(newifitem);
-                goto exit;
-            }
-            CAIPPassNetworkChangesToAdapter(CA_INTERFACE_UP);
-            OIC_LOG_V(DEBUG, TAG, "Added interface: %s (%d)", ifitem->name, ifitem->family);
-        }
     }
     freeifaddrs(ifp);
 #if NETWORK_INTERFACE_CHANGED_LOGGING
@@ -520,6 +530,52 @@ exit:
     return NULL;
 }
 
+u_arraylist_t *CAIPGetInterfaceInformation(int desiredIndex)
+{
+    u_arraylist_t *iflist = CAIPEnumerateInterfaces(desiredIndex);
+    if (!iflist)
+    {
+        return NULL;
+    }
+
+    size_t len = u_arraylist_length(iflist);
+    for (size_t i = 0; i < len; i++)
+    {
+        CAInterface_t *ifitem = (CAInterface_t *)u_arraylist_get(iflist, i);
+        if (!ifitem || CACmpNetworkList(ifitem->index))
+        {
+            continue;
+        }
+
+        CAInterface_t *newifitem = CANewInterfaceItem(ifitem->index, ifitem->name, ifitem->family,
+                                                      ifitem->addr, ifitem->flags);
+        CAResult_t ret = CAAddNetworkMonitorList(newifitem);
+        if (CA_STATUS_OK != ret)
+        {
+            OICFree(newifitem);
+            u_arraylist_destroy(iflist);
+            return NULL;
+        }
+        CAIPPassNetworkChangesToAdapter(CA_INTERFACE_UP);
+        OIC_LOG_V(DEBUG, TAG, "Added interface: %s (%d)", ifitem->name, ifitem->family);
+    }
+    return iflist;
+}
+
+#ifdef __linux__
+static void CAIPRefreshInterfaceSnapshot(int ifiindex)
+{
+    u_arraylist_t *iflist = CAIPEnumerateInterfaces(ifiindex);
+    if (!iflist)
+    {
+        OIC_LOG_V(ERROR, TAG, "get interface info failed: %s", strerror(errno));
+        return;
+    }
+    CAIPUpdateInterfaceSnapshot(ifiindex, iflist);
+    u_arraylist_destroy(iflist);
+}
+#endif
+
 CAResult_t CAGetLinkLocalZoneIdInternal(uint32_t ifindex, char **zoneId)
 {
     if (!zoneId || (*zoneId != NULL))
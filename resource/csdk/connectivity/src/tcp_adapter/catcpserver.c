@@ -36,6 +36,9 @@
 #ifdef HAVE_SYS_POLL_H
 #include <sys/poll.h>
 #endif
+#if defined(HAVE_SYS_EPOLL_H) && !defined(WSA_WAIT_EVENT_0)
+#include <sys/epoll.h>
+#endif
 #include <stdio.h>
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
@@ -60,6 +63,7 @@
 #include "catcpinterface.h"
 #include "caipnwmonitor.h"
 #include "caadapterutils.h"
+#include "uhashmap.h"
 #include "octhread.h"
 #include "oic_malloc.h"
 #include "oic_string.h"
@@ -87,6 +91,15 @@
  */
 #define TLS_HEADER_SIZE 5
 
+#if defined(HAVE_SYS_EPOLL_H) && !defined(WSA_WAIT_EVENT_0)
+#define USE_EPOLL
+
+/**
+ * Maximum number of events handled per epoll_wait().
+ */
+#define EPOLL_MAX_EVENTS 64
+#endif
+
 /**
  * Mutex to synchronize device object list.
  */
@@ -97,6 +110,12 @@ static oc_mutex g_mutexObjectList = NULL;
  */
 static oc_cond g_condObjectList = NULL;
 
+/**
+ * Set while CAReceiveHandler() runs, cleared under g_mutexObjectList
+ * when it returns.
+ */
+static bool g_receiveThreadRunning = false;
+
 /**
  * Maintains the callback to be notified when data received from remote device.
  */
@@ -117,6 +136,20 @@ static CATCPConnectionHandleCallback g_connectionCallback = NULL;
  */
 static CATCPSessionInfo_t *g_sessionList = NULL;
 
+#ifdef USE_EPOLL
+/**
+ * epoll instance of the receive thread, -1 if select() is used instead.
+ */
+static int g_epollFd = -1;
+
+/**
+ * Sessions registered with the epoll instance, keyed by session pointer.
+ * Validates the context pointer of an event against sessions that were
+ * disconnected after epoll_wait() returned.
+ */
+static u_hashmap_t *g_epollSessions = NULL;
+#endif
+
 static CAResult_t CATCPCreateMutex();
 static void CATCPDestroyMutex();
 static CAResult_t CATCPCreateCond();
@@ -132,6 +165,10 @@ static void CASocketEventReturned(CASocketFd_t socket, long networkEvents);
 static CAResult_t CAReceiveMessage(CATCPSessionInfo_t *svritem);
 static void CAReceiveHandler(void *data);
 static CAResult_t CATCPCreateSocket(int family, CATCPSessionInfo_t *svritem);
+#ifdef USE_EPOLL
+static void CAEpollAddSession(CATCPSessionInfo_t *session);
+static void CAEpollRemoveSession(CATCPSessionInfo_t *session);
+#endif
 
 #if defined(WSA_WAIT_EVENT_0)
 #define CHECKFD(FD)
@@ -217,6 +254,7 @@ static void CAReceiveHandler(void *data)
     }
 
     oc_mutex_lock(g_mutexObjectList);
+    g_receiveThreadRunning = false;
     oc_cond_signal(g_condObjectList);
     oc_mutex_unlock(g_mutexObjectList);
 
@@ -225,8 +263,219 @@ static void CAReceiveHandler(void *data)
 
 #if !defined(WSA_WAIT_EVENT_0)
 
+#ifdef USE_EPOLL
+static void CAEpollAdd(int fd, uint32_t events, void *context)
+{
+    struct epoll_event event = { .events = events, .data.ptr = context };
+    if (-1 == epoll_ctl(g_epollFd, EPOLL_CTL_ADD, fd, &event))
+    {
+        OIC_LOG_V(ERROR, TAG, "epoll_ctl(%d) failed: %s", fd, strerror(errno));
+    }
+}
+
+/**
+ * Accept sockets and pipes are level-triggered and use their global as
+ * context. Sessions are added by ::CAEpollAddSession.
+ */
+static void CAInitializeEpoll()
+{
+    g_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (-1 == g_epollFd)
+    {
+        OIC_LOG_V(ERROR, TAG, "epoll_create1 failed, using select: %s", strerror(errno));
+        return;
+    }
+
+    g_epollSessions = u_hashmap_create(0);
+    if (!g_epollSessions)
+    {
+        OIC_LOG(ERROR, TAG, "Out of memory, using select");
+        close(g_epollFd);
+        g_epollFd = -1;
+        return;
+    }
+
+    CASocket_t *sockets[] = { &caglobals.tcp.ipv4, &caglobals.tcp.ipv4s,
+                              &caglobals.tcp.ipv6, &caglobals.tcp.ipv6s };
+    for (size_t i = 0; i < sizeof(sockets) / sizeof(sockets[0]); i++)
+    {
+        if (OC_INVALID_SOCKET != sockets[i]->fd)
+        {
+            CAEpollAdd(sockets[i]->fd, EPOLLIN, sockets[i]);
+        }
+    }
+    if (OC_INVALID_SOCKET != caglobals.tcp.shutdownFds[0])
+    {
+        CAEpollAdd(caglobals.tcp.shutdownFds[0], EPOLLIN, caglobals.tcp.shutdownFds);
+    }
+    if (OC_INVALID_SOCKET != caglobals.tcp.connectionFds[0])
+    {
+        CAEpollAdd(caglobals.tcp.connectionFds[0], EPOLLIN, caglobals.tcp.connectionFds);
+    }
+}
+
+/**
+ * Called after the receive thread returned. Senders still check g_epollFd
+ * under g_mutexObjectList when they connect a session.
+ */
+static void CADeinitializeEpoll()
+{
+    oc_mutex_lock(g_mutexObjectList);
+    if (-1 != g_epollFd)
+    {
+        close(g_epollFd);
+        g_epollFd = -1;
+    }
+    u_hashmap_free(&g_epollSessions);
+    oc_mutex_unlock(g_mutexObjectList);
+}
+
+/**
+ * Register a connected session. Sessions are edge-triggered, so the
+ * receive thread drains them until no data is pending.
+ * Called with g_mutexObjectList held.
+ */
+static void CAEpollAddSession(CATCPSessionInfo_t *session)
+{
+    if (-1 == g_epollFd || OC_INVALID_SOCKET == session->fd)
+    {
+        return;
+    }
+
+    if (!u_hashmap_put(g_epollSessions, &session, sizeof(session), session))
+    {
+        OIC_LOG(ERROR, TAG, "Out of memory");
+        return;
+    }
+    CAEpollAdd(session->fd, EPOLLIN | EPOLLRDHUP | EPOLLET, session);
+}
+
+/**
+ * Unregister a session before its socket is closed.
+ * Called with g_mutexObjectList held.
+ */
+static void CAEpollRemoveSession(CATCPSessionInfo_t *session)
+{
+    if (u_hashmap_remove(g_epollSessions, &session, sizeof(session))
+        && OC_INVALID_SOCKET != session->fd)
+    {
+        epoll_ctl(g_epollFd, EPOLL_CTL_DEL, session->fd, NULL);
+    }
+}
+
+static void CAEpollSessionReturned(CATCPSessionInfo_t *session, uint32_t events)
+{
+    oc_mutex_lock(g_mutexObjectList);
+
+    if (!u_hashmap_contains(g_epollSessions, &session, sizeof(session)))
+    {
+        // disconnected after epoll_wait() returned.
+        oc_mutex_unlock(g_mutexObjectList);
+        return;
+    }
+
+    // a hang-up is reported once, so read until recv() sees it.
+    bool hangup = (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0;
+    CAResult_t res = CA_STATUS_OK;
+    int pending = 0;
+    do
+    {
+        res = CAReceiveMessage(session);
+    } while (CA_STATUS_OK == res
+             && (hangup
+                 || (0 == ioctl(session->fd, FIONREAD, &pending) && 0 < pending)));
+
+    //disconnect session and clean-up data if any error occurs
+    if (CA_STATUS_OK != res
+        && u_hashmap_contains(g_epollSessions, &session, sizeof(session)))
+    {
+#ifdef __WITH_TLS__
+        if (CA_STATUS_OK != CAcloseSslConnection(&session->sep.endpoint))
+        {
+            OIC_LOG(ERROR, TAG, "Failed to close TLS session");
+        }
+#endif
+        LL_DELETE(g_sessionList, session);
+        CADisconnectTCPSession(session);
+    }
+
+    oc_mutex_unlock(g_mutexObjectList);
+}
+
+static void CAEpollFindReadyMessage()
+{
+    struct epoll_event events[EPOLL_MAX_EVENTS];
+
+    int ret = epoll_wait(g_epollFd, events, EPOLL_MAX_EVENTS,
+                         caglobals.tcp.selectTimeout * 1000);
+
+    if (caglobals.tcp.terminate)
+    {
+        OIC_LOG_V(DEBUG, TAG, "Packet receiver Stop request received.");
+        return;
+    }
+
+    if (0 > ret)
+    {
+        if (EINTR != errno)
+        {
+            OIC_LOG_V(FATAL, TAG, "epoll_wait error %s", strerror(errno));
+        }
+        return;
+    }
+
+    for (int i = 0; (i < ret) && !caglobals.tcp.terminate; i++)
+    {
+        void *context = events[i].data.ptr;
+
+        if (context == &caglobals.tcp.ipv4)
+        {
+            CAAcceptConnection(CA_IPV4, &caglobals.tcp.ipv4);
+        }
+        else if (context == &caglobals.tcp.ipv4s)
+        {
+            CAAcceptConnection(CA_IPV4 | CA_SECURE, &caglobals.tcp.ipv4s);
+        }
+        else if (context == &caglobals.tcp.ipv6)
+        {
+            CAAcceptConnection(CA_IPV6, &caglobals.tcp.ipv6);
+        }
+        else if (context == &caglobals.tcp.ipv6s)
+        {
+            CAAcceptConnection(CA_IPV6 | CA_SECURE, &caglobals.tcp.ipv6s);
+        }
+        else if (context == caglobals.tcp.connectionFds)
+        {
+            // sessions are registered when connected, just drain the pipe.
+            char buf[MAX_ADDR_STR_SIZE_CA] = {0};
+            ssize_t len = read(caglobals.tcp.connectionFds[0], buf, sizeof (buf));
+            if (-1 != len)
+            {
+                OIC_LOG_V(DEBUG, TAG, "Received new connection event with [%s]", buf);
+            }
+        }
+        else if (context == caglobals.tcp.shutdownFds)
+        {
+            return;
+        }
+        else
+        {
+            CAEpollSessionReturned((CATCPSessionInfo_t *) context, events[i].events);
+        }
+    }
+}
+#endif // USE_EPOLL
+
 static void CAFindReadyMessage()
 {
+#ifdef USE_EPOLL
+    if (-1 != g_epollFd)
+    {
+        CAEpollFindReadyMessage();
+        return;
+    }
+#endif
+
     fd_set readFds;
     struct timeval timeout = { .tv_sec = caglobals.tcp.selectTimeout };
 
@@ -596,6 +845,9 @@ static void CAAcceptConnection(CATransportFlags_t flag, CASocket_t *sock)
 
         oc_mutex_lock(g_mutexObjectList);
         LL_APPEND(g_sessionList, svritem);
+#ifdef USE_EPOLL
+        CAEpollAddSession(svritem);
+#endif
         oc_mutex_unlock(g_mutexObjectList);
 
         CHECKFD(sockfd);
@@ -919,6 +1171,11 @@ static CAResult_t CATCPCreateSocket(int family, CATCPSessionInfo_t *svritem)
     OIC_LOG(DEBUG, TAG, "connect socket success");
     svritem->state = CONNECTED;
     CHECKFD(svritem->fd);
+#ifdef USE_EPOLL
+    oc_mutex_lock(g_mutexObjectList);
+    CAEpollAddSession(svritem);
+    oc_mutex_unlock(g_mutexObjectList);
+#endif
 #if !defined(WSA_WAIT_EVENT_0)
     ssize_t len = CAWakeUpForReadFdsUpdate(svritem->sep.endpoint.addr);
     if (-1 == len)
@@ -1121,11 +1378,17 @@ CAResult_t CATCPStartServer(const ca_thread_pool_t threadPool)
     CHECKFD(caglobals.tcp.connectionFds[1]);
 #endif
 
+#ifdef USE_EPOLL
+    CAInitializeEpoll();
+#endif
+
     caglobals.tcp.terminate = false;
+    g_receiveThreadRunning = true;
     res = ca_thread_pool_add_task(threadPool, CAReceiveHandler, NULL);
     if (CA_STATUS_OK != res)
     {
         OIC_LOG(ERROR, TAG, "thread_pool_add_task failed");
+        g_receiveThreadRunning = false;
         return res;
     }
     OIC_LOG(DEBUG, TAG, "CAReceiveHandler thread started successfully.");
@@ -1174,11 +1437,12 @@ void CATCPStopServer()
     CLOSE_SOCKET(ipv6);
     CLOSE_SOCKET(ipv6s);
 
-    if (caglobals.tcp.started)
+    // the receive thread must return before its descriptors are closed.
+    while (g_receiveThreadRunning)
     {
         oc_cond_wait(g_condObjectList, g_mutexObjectList);
-        caglobals.tcp.started = false;
     }
+    caglobals.tcp.started = false;
 
 #if !defined(WSA_WAIT_EVENT_0)
     close(caglobals.tcp.connectionFds[1]);
@@ -1194,6 +1458,9 @@ void CATCPStopServer()
     oc_mutex_unlock(g_mutexObjectList);
 
     CATCPDisconnectAll();
+#ifdef USE_EPOLL
+    CADeinitializeEpoll();
+#endif
     CATCPDestroyMutex();
     CATCPDestroyCond();
 
@@ -1469,6 +1736,10 @@ CAResult_t CADisconnectTCPSession(CATCPSessionInfo_t *removedData)
 
     VERIFY_NON_NULL(removedData, TAG, "removedData is NULL");
 
+#ifdef USE_EPOLL
+    CAEpollRemoveSession(removedData);
+#endif
+
     // close the socket and remove session info in list.
     if (removedData->fd != OC_INVALID_SOCKET)
     {
@@ -0,0 +1,174 @@
+//******************************************************************
+//
+// Copyright 2017 Samsung Electronics All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include <string.h>
+
+#include "caduplicatefilter.h"
+#include "logger.h"
+
+#define TAG "CA_DUPLICATE_FILTER_TEST"
+
+static char g_token[] = "token01";
+static const uint8_t TOKEN_LENGTH = sizeof(g_token) - 1;
+
+class CADuplicateFilterF : public testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        ASSERT_EQ(CA_STATUS_OK, CADuplicateFilterInitialize());
+
+        memset(&ep4, 0, sizeof(ep4));
+        ep4.adapter = CA_ADAPTER_IP;
+        ep4.flags = CA_IPV4;
+        ep4.port = 5683;
+        ep4.ifindex = 2;
+        strcpy(ep4.addr, "192.168.0.2");
+
+        ep6 = ep4;
+        ep6.flags = CA_IPV6;
+        strcpy(ep6.addr, "fe80::2");
+    }
+
+    virtual void TearDown()
+    {
+        CADuplicateFilterSetLifetime(CA_DEFAULT_EXCHANGE_LIFETIME_MSEC);
+        CADuplicateFilterTerminate();
+    }
+
+    CAEndpoint_t ep4;
+    CAEndpoint_t ep6;
+};
+
+TEST_F(CADuplicateFilterF, DropsRetransmission)
+{
+    EXPECT_FALSE(CADuplicateFilterCheck(&ep4, 1, g_token, TOKEN_LENGTH));
+    EXPECT_TRUE(CADuplicateFilterCheck(&ep4, 1, g_token, TOKEN_LENGTH));
+
+    // different message ID
+    EXPECT_FALSE(CADuplicateFilterCheck(&ep4, 2, g_token, TOKEN_LENGTH));
+}
+
+TEST_F(CADuplicateFilterF, DropsOtherFamilyCopy)
+{
+    EXPECT_FALSE(CADuplicateFilterCheck(&ep6, 1, g_token, TOKEN_LENGTH));
+    EXPECT_TRUE(CADuplicateFilterCheck(&ep4, 1, g_token, TOKEN_LENGTH));
+}
+
+TEST_F(CADuplicateFilterF, KeepsUntokenedFromOtherSource)
+{
+    CAEndpoint_t other = ep4;
+    strcpy(other.addr, "192.168.0.3");
+
+    EXPECT_FALSE(CADuplicateFilterCheck(&ep4, 1, NULL, 0));
+    EXPECT_FALSE(CADuplicateFilterCheck(&other, 1, NULL, 0));
+    EXPECT_TRUE(CADuplicateFilterCheck(&other, 1, NULL, 0));
+}
+
+TEST_F(CADuplicateFilterF, IgnoresOtherAdapters)
+{
+    ep4.adapter = CA_ADAPTER_GATT_BTLE;
+    EXPECT_FALSE(CADuplicateFilterCheck(&ep4, 1, g_token, TOKEN_LENGTH));
+    EXPECT_FALSE(CADuplicateFilterCheck(&ep4, 1, g_token, TOKEN_LENGTH));
+    EXPECT_TRUE(CADuplicateFilterCheck(NULL, 1, g_token, TOKEN_LENGTH));
+}
+
+TEST_F(CADuplicateFilterF, ExpiresAfterLifetime)
+{
+    CADuplicateFilterSetLifetime(50);
+
+    EXPECT_FALSE(CADuplicateFilterCheck(&ep4, 1, g_token, TOKEN_LENGTH));
+    EXPECT_TRUE(CADuplicateFilterCheck(&ep4, 1, g_token, TOKEN_LENGTH));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_FALSE(CADuplicateFilterCheck(&ep4, 1, g_token, TOKEN_LENGTH));
+}
+
+TEST_F(CADuplicateFilterF, LifetimeAppliesToRememberedMessages)
+{
+    EXPECT_FALSE(CADuplicateFilterCheck(&ep4, 1, g_token, TOKEN_LENGTH));
+    EXPECT_FALSE(CADuplicateFilterCheck(&ep4, 2, g_token, TOKEN_LENGTH));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CADuplicateFilterSetLifetime(50);
+    EXPECT_FALSE(CADuplicateFilterCheck(&ep4, 1, g_token, TOKEN_LENGTH));
+    EXPECT_FALSE(CADuplicateFilterCheck(&ep4, 2, g_token, TOKEN_LENGTH));
+
+    // a longer lifetime keeps the messages remembered since.
+    CADuplicateFilterSetLifetime(CA_DEFAULT_EXCHANGE_LIFETIME_MSEC);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_TRUE(CADuplicateFilterCheck(&ep4, 1, g_token, TOKEN_LENGTH));
+    EXPECT_TRUE(CADuplicateFilterCheck(&ep4, 2, g_token, TOKEN_LENGTH));
+}
+
+TEST_F(CADuplicateFilterF, Stats)
+{
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+
+    CADuplicateFilterCheck(&ep4, 1, g_token, TOKEN_LENGTH);
+    CADuplicateFilterCheck(&ep4, 1, g_token, TOKEN_LENGTH);
+    CADuplicateFilterCheck(&ep6, 1, g_token, TOKEN_LENGTH);
+    CADuplicateFilterCheck(&ep4, 2, g_token, TOKEN_LENGTH);
+
+    CADuplicateFilterGetStats(&hits, &misses);
+    EXPECT_EQ(2u, hits);
+    EXPECT_EQ(2u, misses);
+}
+
+TEST_F(CADuplicateFilterF, EvictsOldest)
+{
+    // each tokened message takes two entries.
+    for (uint16_t id = 0; id <= CA_DUPLICATE_FILTER_MAX_ENTRIES / 2; id++)
+    {
+        EXPECT_FALSE(CADuplicateFilterCheck(&ep4, id, g_token, TOKEN_LENGTH));
+    }
+    EXPECT_FALSE(CADuplicateFilterCheck(&ep4, 0, g_token, TOKEN_LENGTH));
+    EXPECT_TRUE(CADuplicateFilterCheck(&ep4, CA_DUPLICATE_FILTER_MAX_ENTRIES / 2,
+                                       g_token, TOKEN_LENGTH));
+}
+
+TEST_F(CADuplicateFilterF, CheckCost)
+{
+    // a full filter is the worst case for the old linear history scan.
+    const uint16_t count = CA_DUPLICATE_FILTER_MAX_ENTRIES / 2;
+    for (uint16_t id = 0; id < count; id++)
+    {
+        CADuplicateFilterCheck(&ep4, id, g_token, TOKEN_LENGTH);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < 100; round++)
+    {
+        for (uint16_t id = 0; id < count; id++)
+        {
+            EXPECT_TRUE(CADuplicateFilterCheck(&ep4, id, g_token, TOKEN_LENGTH));
+        }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    OIC_LOG_V(INFO, TAG, "%u lookups in a filter of %u entries: %lld us",
+              (unsigned)(100 * count), (unsigned)(2 * count), (long long)elapsed.count());
+}
@@ -0,0 +1,484 @@
+//******************************************************************
+//
+// Copyright 2017 Samsung Electronics All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include "iotivity_config.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <thread>
+#include <vector>
+
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <unistd.h>
+
+#include "cacommon.h"
+#include "caipinterface.h"
+#include "caipnwmonitor.h"
+#include "cathreadpool.h"
+#include "logger.h"
+#include "oic_malloc.h"
+#include "oic_string.h"
+
+#define TAG "CA_IP_SERVER_TEST"
+
+static std::atomic<size_t> g_received(0);
+
+static void PacketReceived(const CASecureEndpoint_t *sep, const void *data, size_t dataLength)
+{
+    (void)sep;
+    (void)data;
+    (void)dataLength;
+    g_received++;
+}
+
+static void AdapterStateChanged(CATransportAdapter_t adapter, CANetworkStatus_t status)
+{
+    (void)adapter;
+    (void)status;
+}
+
+class IPServerF : public testing::Test
+{
+public:
+    IPServerF() :
+        testing::Test(),
+        threadPool(NULL)
+    {
+    }
+
+protected:
+    virtual void SetUp()
+    {
+        caglobals.ip.u6.fd  = OC_INVALID_SOCKET;
+        caglobals.ip.u6s.fd = OC_INVALID_SOCKET;
+        caglobals.ip.u4.fd  = OC_INVALID_SOCKET;
+        caglobals.ip.u4s.fd = OC_INVALID_SOCKET;
+        caglobals.ip.m6.fd  = OC_INVALID_SOCKET;
+        caglobals.ip.m6s.fd = OC_INVALID_SOCKET;
+        caglobals.ip.m4.fd  = OC_INVALID_SOCKET;
+        caglobals.ip.m4s.fd = OC_INVALID_SOCKET;
+        caglobals.ip.u4.port  = 0;
+        caglobals.ip.u4s.port = 0;
+        caglobals.ip.m4.port  = CA_COAP;
+        caglobals.ip.m4s.port = CA_SECURE_COAP;
+        caglobals.ip.ipv4enabled = true;
+        caglobals.ip.ipv6enabled = false;
+
+        ASSERT_EQ(CA_STATUS_OK, ca_thread_pool_init(2, &threadPool));
+        ASSERT_EQ(CA_STATUS_OK, CAIPStartNetworkMonitor(AdapterStateChanged, CA_ADAPTER_IP));
+        CAIPSetPacketReceiveCallback(PacketReceived);
+        g_received = 0;
+    }
+
+    virtual void TearDown()
+    {
+        CAIPStopNetworkMonitor(CA_ADAPTER_IP);
+        CAIPStopServer();
+        ca_thread_pool_free(threadPool);
+        CAIPSetPacketReceiveCallback(NULL);
+        CAIPSetBatchedIO(true);
+        CADeInitializeIPGlobals();
+    }
+
+    // Send datagrams to the IPv4 unicast socket, wait until they stop arriving
+    // and return the receive rate in packets per second.
+    double MeasureLoopback(size_t count)
+    {
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        EXPECT_NE(-1, fd);
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(caglobals.ip.u4.port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        const char payload[64] = { 0x50 };
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i)
+        {
+            sendto(fd, payload, sizeof(payload), 0, (struct sockaddr *)&addr, sizeof(addr));
+        }
+
+        // UDP may drop under load, so stop once nothing arrived for a while.
+        size_t received = 0;
+        auto last = std::chrono::steady_clock::now();
+        while (received < count
+               && std::chrono::steady_clock::now() - last < std::chrono::milliseconds(500))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            if (g_received != received)
+            {
+                received = g_received;
+                last = std::chrono::steady_clock::now();
+            }
+        }
+        close(fd);
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(last - start);
+        OIC_LOG_V(INFO, TAG, "%u of %u datagrams received in %lld us",
+                  (unsigned)received, (unsigned)count, (long long)elapsed.count());
+        EXPECT_LT(0u, received);
+        return elapsed.count() ? (received * 1000000.0) / elapsed.count() : 0;
+    }
+
+    ca_thread_pool_t threadPool;
+};
+
+TEST_F(IPServerF, LoopbackUnbatched)
+{
+    CAIPSetBatchedIO(false);
+    ASSERT_EQ(CA_STATUS_OK, CAIPStartServer(threadPool));
+
+    double pps = MeasureLoopback(20000);
+    OIC_LOG_V(INFO, TAG, "unbatched receive: %.0f packets/sec", pps);
+}
+
+TEST_F(IPServerF, LoopbackBatched)
+{
+    CAIPSetBatchedIO(true);
+    ASSERT_EQ(CA_STATUS_OK, CAIPStartServer(threadPool));
+
+    double pps = MeasureLoopback(20000);
+    OIC_LOG_V(INFO, TAG, "batched receive: %.0f packets/sec", pps);
+}
+
+static void SendDatagram(uint16_t port)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_NE(-1, fd);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    const char payload[64] = { 0x50 };
+    EXPECT_EQ((ssize_t)sizeof(payload),
+              sendto(fd, payload, sizeof(payload), 0, (struct sockaddr *)&addr, sizeof(addr)));
+    close(fd);
+}
+
+static bool WaitForReceived(size_t count)
+{
+    for (int i = 0; i < 1000 && g_received < count; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return g_received >= count;
+}
+
+TEST_F(IPServerF, StartReceiveStop)
+{
+    for (int cycle = 0; cycle < 3; cycle++)
+    {
+        SCOPED_TRACE(cycle);
+        g_received = 0;
+        ASSERT_EQ(CA_STATUS_OK, CAIPStartServer(threadPool));
+        uint16_t port = caglobals.ip.u4.port;
+        ASSERT_NE(0, port);
+
+        SendDatagram(port);
+        EXPECT_TRUE(WaitForReceived(1));
+
+        // the receive thread has returned once the server is stopped.
+        CAIPStopServer();
+        SendDatagram(port);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        EXPECT_EQ(1u, g_received);
+
+        CADeInitializeIPGlobals();
+        caglobals.ip.u4.fd = OC_INVALID_SOCKET;
+        caglobals.ip.u4.port = 0;
+    }
+}
+
+TEST_F(IPServerF, StopIsIdempotent)
+{
+    ASSERT_EQ(CA_STATUS_OK, CAIPStartServer(threadPool));
+    CAIPStopServer();
+    CAIPStopServer();
+
+    ASSERT_EQ(CA_STATUS_OK, CAIPStartServer(threadPool));
+    SendDatagram(caglobals.ip.u4.port);
+    EXPECT_TRUE(WaitForReceived(1));
+}
+
+#ifdef CA_IP_INTERFACE_SNAPSHOT
+static void AddInterface(u_arraylist_t *iflist, uint32_t index, const char *addr)
+{
+    CAInterface_t *ifitem = (CAInterface_t *)OICCalloc(1, sizeof (CAInterface_t));
+    ASSERT_TRUE(NULL != ifitem);
+    snprintf(ifitem->name, sizeof(ifitem->name), "test%u", (unsigned)index);
+    ifitem->index = index;
+    ifitem->family = AF_INET;
+    ifitem->flags = IFF_UP | IFF_RUNNING;
+    OICStrcpy(ifitem->addr, sizeof(ifitem->addr), addr);
+    ASSERT_TRUE(u_arraylist_add(iflist, ifitem));
+}
+
+static const CAInterface_t *FindInterface(const CAIPInterfaceSnapshot_t *snapshot,
+                                          uint32_t index)
+{
+    for (size_t i = 0; i < u_arraylist_length(snapshot->iflist); i++)
+    {
+        const CAInterface_t *ifitem = (const CAInterface_t *)u_arraylist_get(snapshot->iflist, i);
+        if (ifitem->index == index)
+        {
+            return ifitem;
+        }
+    }
+    return NULL;
+}
+
+TEST_F(IPServerF, InterfaceSnapshotIsPrivateWithoutServer)
+{
+    const CAIPInterfaceSnapshot_t *snapshot = CAIPAcquireInterfaceSnapshot();
+    ASSERT_TRUE(NULL != snapshot);
+    EXPECT_EQ(-1, snapshot->slot);
+    EXPECT_TRUE(NULL != snapshot->iflist);
+
+    // not published without a running server.
+    u_arraylist_t *iflist = u_arraylist_create();
+    AddInterface(iflist, 1, "192.168.1.1");
+    CAIPUpdateInterfaceSnapshot(0, iflist);
+    const CAIPInterfaceSnapshot_t *other = CAIPAcquireInterfaceSnapshot();
+    ASSERT_TRUE(NULL != other);
+    EXPECT_EQ(-1, other->slot);
+    EXPECT_NE(snapshot, other);
+
+    CAIPReleaseInterfaceSnapshot(other);
+    CAIPReleaseInterfaceSnapshot(snapshot);
+    u_arraylist_destroy(iflist);
+}
+
+TEST_F(IPServerF, InterfaceSnapshotIsShared)
+{
+    ASSERT_EQ(CA_STATUS_OK, CAIPStartServer(threadPool));
+
+    u_arraylist_t *iflist = u_arraylist_create();
+    AddInterface(iflist, 1, "192.168.1.1");
+    AddInterface(iflist, 2, "10.0.0.1");
+    CAIPUpdateInterfaceSnapshot(0, iflist);
+    u_arraylist_destroy(iflist);
+
+    const CAIPInterfaceSnapshot_t *first = CAIPAcquireInterfaceSnapshot();
+    const CAIPInterfaceSnapshot_t *second = CAIPAcquireInterfaceSnapshot();
+    ASSERT_TRUE(NULL != first);
+    EXPECT_EQ(first, second);
+    EXPECT_LE(0, first->slot);
+    EXPECT_EQ(2u, u_arraylist_length(first->iflist));
+    CAIPReleaseInterfaceSnapshot(second);
+    CAIPReleaseInterfaceSnapshot(first);
+
+    // cleared when the server stops.
+    CAIPStopServer();
+    const CAIPInterfaceSnapshot_t *stopped = CAIPAcquireInterfaceSnapshot();
+    ASSERT_TRUE(NULL != stopped);
+    EXPECT_EQ(-1, stopped->slot);
+    CAIPReleaseInterfaceSnapshot(stopped);
+}
+
+TEST_F(IPServerF, InterfaceSnapshotUpdatesSingleInterface)
+{
+    ASSERT_EQ(CA_STATUS_OK, CAIPStartServer(threadPool));
+
+    u_arraylist_t *iflist = u_arraylist_create();
+    AddInterface(iflist, 1, "192.168.1.1");
+    AddInterface(iflist, 2, "10.0.0.1");
+    CAIPUpdateInterfaceSnapshot(0, iflist);
+    u_arraylist_destroy(iflist);
+
+    iflist = u_arraylist_create();
+    AddInterface(iflist, 2, "10.0.0.2");
+    CAIPUpdateInterfaceSnapshot(2, iflist);
+    u_arraylist_destroy(iflist);
+
+    const CAIPInterfaceSnapshot_t *snapshot = CAIPAcquireInterfaceSnapshot();
+    ASSERT_TRUE(NULL != snapshot);
+    EXPECT_EQ(2u, u_arraylist_length(snapshot->iflist));
+    ASSERT_TRUE(NULL != FindInterface(snapshot, 1));
+    ASSERT_TRUE(NULL != FindInterface(snapshot, 2));
+    EXPECT_STREQ("192.168.1.1", FindInterface(snapshot, 1)->addr);
+    EXPECT_STREQ("10.0.0.2", FindInterface(snapshot, 2)->addr);
+    uint32_t version = snapshot->version;
+    CAIPReleaseInterfaceSnapshot(snapshot);
+
+    // an interface without items is removed.
+    CAIPUpdateInterfaceSnapshot(2, NULL);
+    snapshot = CAIPAcquireInterfaceSnapshot();
+    ASSERT_TRUE(NULL != snapshot);
+    EXPECT_LT(version, snapshot->version);
+    EXPECT_EQ(1u, u_arraylist_length(snapshot->iflist));
+    EXPECT_TRUE(NULL == FindInterface(snapshot, 2));
+    CAIPReleaseInterfaceSnapshot(snapshot);
+}
+
+TEST_F(IPServerF, InterfaceSnapshotSlotHandOff)
+{
+    ASSERT_EQ(CA_STATUS_OK, CAIPStartServer(threadPool));
+
+    u_arraylist_t *iflist = u_arraylist_create();
+    AddInterface(iflist, 1, "192.168.1.1");
+    CAIPUpdateInterfaceSnapshot(0, iflist);
+
+    const CAIPInterfaceSnapshot_t *old = CAIPAcquireInterfaceSnapshot();
+    ASSERT_TRUE(NULL != old);
+    ASSERT_LE(0, old->slot);
+
+    // the next snapshot goes to the other slot, the old one stays valid.
+    AddInterface(iflist, 2, "10.0.0.1");
+    CAIPUpdateInterfaceSnapshot(0, iflist);
+    const CAIPInterfaceSnapshot_t *current = CAIPAcquireInterfaceSnapshot();
+    ASSERT_TRUE(NULL != current);
+    EXPECT_NE(old->slot, current->slot);
+    EXPECT_LT(old->version, current->version);
+    EXPECT_EQ(1u, u_arraylist_length(old->iflist));
+    EXPECT_STREQ("192.168.1.1", FindInterface(old, 1)->addr);
+    EXPECT_EQ(2u, u_arraylist_length(current->iflist));
+    int32_t oldSlot = old->slot;
+    CAIPReleaseInterfaceSnapshot(current);
+
+    // reusing the old slot has to wait for its reader.
+    std::atomic<bool> updated(false);
+    std::thread writer([&]()
+    {
+        CAIPUpdateInterfaceSnapshot(1, NULL);
+        updated = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_FALSE(updated);
+    EXPECT_EQ(1u, u_arraylist_length(old->iflist));
+    CAIPReleaseInterfaceSnapshot(old);
+    writer.join();
+    EXPECT_TRUE(updated);
+
+    current = CAIPAcquireInterfaceSnapshot();
+    ASSERT_TRUE(NULL != current);
+    EXPECT_EQ(oldSlot, current->slot);
+    EXPECT_EQ(1u, u_arraylist_length(current->iflist));
+    EXPECT_TRUE(NULL == FindInterface(current, 1));
+    CAIPReleaseInterfaceSnapshot(current);
+    u_arraylist_destroy(iflist);
+}
+
+#ifdef HAVE_SENDMMSG
+/*
+ * sendmmsg() of this executable takes precedence over the C library, so the
+ * multicast batching path can be observed and fed partial results. Calls go
+ * to the kernel unless a test queued results.
+ */
+static std::vector<unsigned int> g_sendmmsgBatches;
+static std::vector<int> g_sentIfindexes;
+static std::deque<int> g_sendmmsgResults;
+static size_t g_sendErrors = 0;
+
+extern "C" int sendmmsg(int fd, struct mmsghdr *msgs, unsigned int vlen, int flags)
+{
+    if (g_sendmmsgResults.empty())
+    {
+        return (int)syscall(SYS_sendmmsg, fd, msgs, vlen, flags);
+    }
+
+    int result = g_sendmmsgResults.front();
+    g_sendmmsgResults.pop_front();
+    g_sendmmsgBatches.push_back(vlen);
+    if (result < 0)
+    {
+        errno = ENOBUFS;
+        return -1;
+    }
+    for (int i = 0; i < result && (unsigned int)i < vlen; i++)
+    {
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr);
+        g_sentIfindexes.push_back(((struct in_pktinfo *)CMSG_DATA(cmsg))->ipi_ifindex);
+        msgs[i].msg_len = msgs[i].msg_hdr.msg_iov[0].iov_len;
+    }
+    return result;
+}
+
+static void SendError(const CAEndpoint_t *endpoint, const void *data, size_t dataLength,
+                      CAResult_t result)
+{
+    (void)endpoint;
+    (void)data;
+    (void)dataLength;
+    EXPECT_EQ(CA_SEND_FAILED, result);
+    g_sendErrors++;
+}
+
+TEST_F(IPServerF, MulticastSendIsBatchedPerInterface)
+{
+    CAIPSetBatchedIO(true);
+    ASSERT_EQ(CA_STATUS_OK, CAIPStartServer(threadPool));
+    CAIPSetErrorHandler(SendError);
+
+    // 20 interfaces need two sendmmsg() batches of at most 16 datagrams.
+    u_arraylist_t *iflist = u_arraylist_create();
+    for (uint32_t i = 1; i <= 20; i++)
+    {
+        char addr[16];
+        snprintf(addr, sizeof(addr), "10.0.0.%u", (unsigned)i);
+        AddInterface(iflist, i, addr);
+    }
+    CAIPUpdateInterfaceSnapshot(0, iflist);
+    u_arraylist_destroy(iflist);
+
+    // the first batch is sent partially, then the next datagram fails.
+    g_sendmmsgBatches.clear();
+    g_sentIfindexes.clear();
+    g_sendErrors = 0;
+    g_sendmmsgResults = { 10, -1, 5, 4 };
+
+    CAEndpoint_t endpoint;
+    memset(&endpoint, 0, sizeof(endpoint));
+    endpoint.adapter = CA_ADAPTER_IP;
+    endpoint.flags = CA_IPV4;
+    const char payload[] = "multicast";
+    CAIPSendData(&endpoint, payload, sizeof(payload), true);
+    CAIPSetErrorHandler(NULL);
+
+    EXPECT_TRUE(g_sendmmsgResults.empty());
+    std::vector<unsigned int> batches = { 16, 6, 5, 4 };
+    EXPECT_EQ(batches, g_sendmmsgBatches);
+    EXPECT_EQ(1u, g_sendErrors);
+
+    // the remainder of a partial send is retried and only the failed datagram is skipped.
+    std::vector<int> ifindexes;
+    for (int i = 1; i <= 20; i++)
+    {
+        if (11 != i)
+        {
+            ifindexes.push_back(i);
+        }
+    }
+    EXPECT_EQ(ifindexes, g_sentIfindexes);
+}
+#endif // HAVE_SENDMMSG
+#endif // CA_IP_INTERFACE_SNAPSHOT
@@ -0,0 +1,339 @@
+//******************************************************************
+//
+// Copyright 2017 Samsung Electronics All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "caqueueingthread.h"
+#include "oic_malloc.h"
+#include "logger.h"
+
+#define TAG "CA_QUEUEING_THREAD_TEST"
+
+static const size_t PRODUCERS = 4;
+static const size_t MESSAGES_PER_PRODUCER = 100000;
+
+static std::atomic<size_t> g_processed(0);
+static int g_items[CA_QUEUEING_THREAD_RING_SIZE * 2];
+
+static void CountTask(void *data)
+{
+    (void)data;
+    g_processed++;
+}
+
+static void NoDestroy(void *data, uint32_t size)
+{
+    (void)data;
+    (void)size;
+}
+
+static bool IsEven(void *data, uint32_t size, void *ctx)
+{
+    (void)size;
+    (void)ctx;
+    return (*static_cast<int *>(data) % 2) == 0;
+}
+
+class CAQueueingThreadF : public testing::Test
+{
+public:
+    CAQueueingThreadF() :
+        testing::Test(),
+        threadPool(NULL)
+    {
+    }
+
+protected:
+    virtual void SetUp()
+    {
+        ASSERT_EQ(CA_STATUS_OK, ca_thread_pool_init(2, &threadPool));
+        ASSERT_EQ(CA_STATUS_OK, CAQueueingThreadInitialize(&thread, threadPool,
+                                                           CountTask, NoDestroy));
+        g_processed = 0;
+        for (size_t i = 0; i < sizeof(g_items) / sizeof(g_items[0]); ++i)
+        {
+            g_items[i] = (int)i;
+        }
+    }
+
+    virtual void TearDown()
+    {
+        CAQueueingThreadStop(&thread);
+        CAQueueingThreadDestroy(&thread);
+        ca_thread_pool_free(threadPool);
+    }
+
+    bool WaitProcessed(size_t count)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (g_processed < count)
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    ca_thread_pool_t threadPool;
+    CAQueueingThread_t thread;
+};
+
+// The mutex, condition variable and per-message allocation scheme the queueing
+// thread used before the lock-free ring, kept here as a baseline.
+class LockedQueue
+{
+public:
+    LockedQueue() :
+        queue(u_queue_create()),
+        mutex(oc_mutex_new()),
+        cond(oc_cond_new()),
+        stop(false)
+    {
+    }
+
+    ~LockedQueue()
+    {
+        u_queue_delete(queue);
+        oc_mutex_free(mutex);
+        oc_cond_free(cond);
+    }
+
+    void Add(void *data, uint32_t size)
+    {
+        u_queue_message_t *message = (u_queue_message_t *) OICMalloc(sizeof(u_queue_message_t));
+        message->msg = data;
+        message->size = size;
+
+        oc_mutex_lock(mutex);
+        u_queue_add_element(queue, message);
+        oc_cond_signal(cond);
+        oc_mutex_unlock(mutex);
+    }
+
+    void Run()
+    {
+        while (!stop)
+        {
+            oc_mutex_lock(mutex);
+            if (!stop && u_queue_get_size(queue) <= 0)
+            {
+                oc_cond_wait(cond, mutex);
+            }
+            u_queue_message_t *message = u_queue_get_element(queue);
+            oc_mutex_unlock(mutex);
+
+            if (message)
+            {
+                CountTask(message->msg);
+                OICFree(message);
+            }
+        }
+    }
+
+    void Stop()
+    {
+        oc_mutex_lock(mutex);
+        stop = true;
+        oc_cond_signal(cond);
+        oc_mutex_unlock(mutex);
+    }
+
+    u_queue_t *queue;
+    oc_mutex mutex;
+    oc_cond cond;
+    bool stop;
+};
+
+TEST_F(CAQueueingThreadF, ProcessesAllData)
+{
+    ASSERT_EQ(CA_STATUS_OK, CAQueueingThreadStart(&thread));
+
+    for (size_t i = 0; i < sizeof(g_items) / sizeof(g_items[0]); ++i)
+    {
+        EXPECT_EQ(CA_STATUS_OK, CAQueueingThreadAddData(&thread, &g_items[i], sizeof(int)));
+    }
+    EXPECT_TRUE(WaitProcessed(sizeof(g_items) / sizeof(g_items[0])));
+}
+
+TEST_F(CAQueueingThreadF, OverflowKeepsOrder)
+{
+    size_t count = sizeof(g_items) / sizeof(g_items[0]);
+
+    // the thread is not started, so the ring fills up and spills over.
+    for (size_t i = 0; i < count; ++i)
+    {
+        ASSERT_EQ(CA_STATUS_OK, CAQueueingThreadAddData(&thread, &g_items[i], sizeof(int)));
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        void *data = NULL;
+        uint32_t size = 0;
+        ASSERT_EQ(CA_STATUS_OK, CAQueueingThreadGetData(&thread, &data, &size));
+        EXPECT_EQ(&g_items[i], data);
+        EXPECT_EQ(sizeof(int), size);
+    }
+
+    void *data = NULL;
+    uint32_t size = 0;
+    EXPECT_EQ(CA_STATUS_FAILED, CAQueueingThreadGetData(&thread, &data, &size));
+}
+
+TEST_F(CAQueueingThreadF, ClearContextData)
+{
+    size_t count = sizeof(g_items) / sizeof(g_items[0]);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        ASSERT_EQ(CA_STATUS_OK, CAQueueingThreadAddData(&thread, &g_items[i], sizeof(int)));
+    }
+
+    EXPECT_EQ(CA_STATUS_OK, CAQueueingThreadClearContextData(&thread, IsEven, NULL));
+
+    for (size_t i = 1; i < count; i += 2)
+    {
+        void *data = NULL;
+        uint32_t size = 0;
+        ASSERT_EQ(CA_STATUS_OK, CAQueueingThreadGetData(&thread, &data, &size));
+        EXPECT_EQ(&g_items[i], data);
+    }
+
+    // new data goes behind what was kept.
+    EXPECT_EQ(CA_STATUS_OK, CAQueueingThreadAddData(&thread, &g_items[0], sizeof(int)));
+    void *data = NULL;
+    uint32_t size = 0;
+    EXPECT_EQ(CA_STATUS_OK, CAQueueingThreadGetData(&thread, &data, &size));
+    EXPECT_EQ(&g_items[0], data);
+}
+
+TEST_F(CAQueueingThreadF, EnqueueDequeueCost)
+{
+    // enqueue and dequeue in ring sized bursts on one thread, which measures
+    // the per message cost without scheduler noise.
+    const size_t rounds = 2000;
+    const size_t burst = CA_QUEUEING_THREAD_RING_SIZE;
+    void *data = NULL;
+    uint32_t size = 0;
+
+    LockedQueue locked;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r)
+    {
+        for (size_t i = 0; i < burst; ++i)
+        {
+            locked.Add(&g_items[i], sizeof(int));
+        }
+        for (size_t i = 0; i < burst; ++i)
+        {
+            oc_mutex_lock(locked.mutex);
+            u_queue_message_t *message = u_queue_get_element(locked.queue);
+            oc_mutex_unlock(locked.mutex);
+            OICFree(message);
+        }
+    }
+    auto lockedTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; ++r)
+    {
+        for (size_t i = 0; i < burst; ++i)
+        {
+            CAQueueingThreadAddData(&thread, &g_items[i], sizeof(int));
+        }
+        for (size_t i = 0; i < burst; ++i)
+        {
+            CAQueueingThreadGetData(&thread, &data, &size);
+        }
+    }
+    auto ringTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    EXPECT_EQ(CA_STATUS_FAILED, CAQueueingThreadGetData(&thread, &data, &size));
+    OIC_LOG_V(INFO, TAG, "%u messages: locked queue %lld us, ring %lld us",
+              (unsigned)(rounds * burst),
+              (long long)lockedTime.count(), (long long)ringTime.count());
+}
+
+TEST_F(CAQueueingThreadF, Throughput)
+{
+    size_t total = PRODUCERS * MESSAGES_PER_PRODUCER;
+    std::vector<std::thread> producers;
+
+    // baseline
+    LockedQueue locked;
+    std::thread consumer(&LockedQueue::Run, &locked);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t p = 0; p < PRODUCERS; ++p)
+    {
+        producers.push_back(std::thread([&locked]()
+        {
+            for (size_t i = 0; i < MESSAGES_PER_PRODUCER; ++i)
+            {
+                locked.Add(&g_items[i % CA_QUEUEING_THREAD_RING_SIZE], sizeof(int));
+            }
+        }));
+    }
+    for (auto &producer : producers)
+    {
+        producer.join();
+    }
+    EXPECT_TRUE(WaitProcessed(total));
+    auto lockedTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    locked.Stop();
+    consumer.join();
+
+    // queueing thread
+    producers.clear();
+    g_processed = 0;
+    ASSERT_EQ(CA_STATUS_OK, CAQueueingThreadStart(&thread));
+    start = std::chrono::steady_clock::now();
+    for (size_t p = 0; p < PRODUCERS; ++p)
+    {
+        producers.push_back(std::thread([this]()
+        {
+            for (size_t i = 0; i < MESSAGES_PER_PRODUCER; ++i)
+            {
+                CAQueueingThreadAddData(&thread, &g_items[i % CA_QUEUEING_THREAD_RING_SIZE],
+                                        sizeof(int));
+            }
+        }));
+    }
+    for (auto &producer : producers)
+    {
+        producer.join();
+    }
+    EXPECT_TRUE(WaitProcessed(total));
+    auto ringTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    OIC_LOG_V(INFO, TAG, "%u producers, %u messages: locked queue %lld us, ring %lld us",
+              (unsigned)PRODUCERS, (unsigned)total,
+              (long long)lockedTime.count(), (long long)ringTime.count());
+}
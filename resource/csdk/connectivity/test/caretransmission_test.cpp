@@ -0,0 +1,328 @@
+//******************************************************************
+//
+// Copyright 2017 Samsung Electronics All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The timer wheel is private to caretransmission.c, so include it and rename its API to
+// keep it apart from the copy in the connectivity library.
+#define CARetransmissionStart CARetransmissionStartTest
+#define CARetransmissionInitialize CARetransmissionInitializeTest
+#define CARetransmissionSentData CARetransmissionSentDataTest
+#define CARetransmissionReceivedData CARetransmissionReceivedDataTest
+#define CARetransmissionStop CARetransmissionStopTest
+#define CARetransmissionDestroy CARetransmissionDestroyTest
+#define CARetransmissionBaseRoutine CARetransmissionBaseRoutineTest
+
+extern "C"
+{
+#include "../src/caretransmission.c"
+}
+
+#undef TAG
+#define TAG "CA_RETRANSMISSION_TEST"
+
+/** CoAP message types in the first header byte. **/
+static const uint8_t COAP_VERSION_CON = 0x40;
+static const uint8_t COAP_VERSION_ACK = 0x60;
+static const uint8_t COAP_VERSION_RST = 0x70;
+
+/** CoAP GET and 2.05 Content codes. **/
+static const uint8_t COAP_CODE_GET = 0x01;
+static const uint8_t COAP_CODE_CONTENT = 0x45;
+
+/** Short ACK timeout so that a few retransmissions fit in a test. microseconds **/
+static const uint64_t TEST_TIMEOUT_USEC = 150 * 1000;
+
+static std::mutex g_eventMutex;
+static std::vector<uint64_t> g_sendTimes;
+static std::vector<uint16_t> g_timedOutIds;
+
+static uint16_t GetMessageId(const void *pdu)
+{
+    const uint8_t *data = (const uint8_t *) pdu;
+    return (uint16_t) ((data[2] << 8) | data[3]);
+}
+
+static CAResult_t CountSend(const CAEndpoint_t *endpoint, const void *pdu, uint32_t size,
+                            CADataType_t dataType)
+{
+    (void) endpoint;
+    (void) pdu;
+    (void) size;
+    (void) dataType;
+    std::lock_guard<std::mutex> lock(g_eventMutex);
+    g_sendTimes.push_back(OICGetCurrentTime(TIME_IN_US));
+    return CA_STATUS_OK;
+}
+
+static void CountTimeout(const CAEndpoint_t *endpoint, const void *pdu, uint32_t size)
+{
+    (void) endpoint;
+    (void) size;
+    std::lock_guard<std::mutex> lock(g_eventMutex);
+    g_timedOutIds.push_back(GetMessageId(pdu));
+}
+
+class CARetransmissionTests : public testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        g_sendTimes.clear();
+        g_timedOutIds.clear();
+        memset(&m_endpoint, 0, sizeof(m_endpoint));
+        m_endpoint.adapter = CA_ADAPTER_IP;
+        m_endpoint.flags = CA_IPV4;
+        m_endpoint.port = 5683;
+        strcpy(m_endpoint.addr, "127.0.0.1");
+        m_threadPool = NULL;
+    }
+
+    virtual void TearDown()
+    {
+        if (m_threadPool)
+        {
+            EXPECT_EQ(CA_STATUS_OK, CARetransmissionStop(&m_context));
+            EXPECT_EQ(CA_STATUS_OK, CARetransmissionDestroy(&m_context));
+            ca_thread_pool_free(m_threadPool);
+        }
+    }
+
+    void Start(uint8_t tryingCount)
+    {
+        CARetransmissionConfig_t config = { CA_ADAPTER_IP, tryingCount };
+        ASSERT_EQ(CA_STATUS_OK, ca_thread_pool_init(1, &m_threadPool));
+        ASSERT_EQ(CA_STATUS_OK, CARetransmissionInitialize(&m_context, m_threadPool,
+                                                           CountSend, CountTimeout,
+                                                           &config));
+        ASSERT_EQ(CA_STATUS_OK, CARetransmissionStart(&m_context));
+    }
+
+    static void MakePdu(uint8_t *pdu, uint8_t version, uint8_t code, uint16_t messageId)
+    {
+        pdu[0] = version;
+        pdu[1] = code;
+        pdu[2] = (uint8_t) (messageId >> 8);
+        pdu[3] = (uint8_t) messageId;
+    }
+
+    CAResult_t Send(uint16_t messageId)
+    {
+        uint8_t pdu[4];
+        MakePdu(pdu, COAP_VERSION_CON, COAP_CODE_GET, messageId);
+        return CARetransmissionSentData(&m_context, &m_endpoint, CA_REQUEST_DATA,
+                                        pdu, sizeof(pdu));
+    }
+
+    CARetransmissionData_t *Find(uint16_t messageId, CATransportAdapter_t adapter)
+    {
+        unsigned char key[CA_RETRANSMISSION_KEY_SIZE];
+        CAGetRetransmissionKey(messageId, adapter, key);
+        return (CARetransmissionData_t *) u_hashmap_get(m_context.dataMap, key, sizeof(key));
+    }
+
+    size_t Pending()
+    {
+        oc_mutex_lock(m_context.threadMutex);
+        size_t pending = u_hashmap_length(m_context.dataMap);
+        oc_mutex_unlock(m_context.threadMutex);
+        return pending;
+    }
+
+    /** Replace the random ACK timeout of a pending message and reschedule it. **/
+    void SetTimeout(uint16_t messageId, uint64_t timeout)
+    {
+        oc_mutex_lock(m_context.threadMutex);
+        CARetransmissionData_t *retData = Find(messageId, m_endpoint.adapter);
+        ASSERT_TRUE(NULL != retData);
+        DL_DELETE(m_context.timerWheel[retData->slot], retData);
+        retData->timeout = timeout;
+        retData->deadline = CAGetRetransmissionDeadline(retData);
+        CAScheduleRetransmission(&m_context, retData);
+        oc_cond_signal(m_context.threadCond);
+        oc_mutex_unlock(m_context.threadMutex);
+    }
+
+    /** Wait until the timeout callback ran count times or the limit passed. **/
+    static size_t WaitForTimeouts(size_t count, std::chrono::milliseconds limit)
+    {
+        auto end = std::chrono::steady_clock::now() + limit;
+        for (;;)
+        {
+            {
+                std::lock_guard<std::mutex> lock(g_eventMutex);
+                if (g_timedOutIds.size() >= count || std::chrono::steady_clock::now() > end)
+                {
+                    return g_timedOutIds.size();
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    CARetransmission_t m_context;
+    ca_thread_pool_t m_threadPool;
+    CAEndpoint_t m_endpoint;
+};
+
+TEST_F(CARetransmissionTests, AckRemovesPendingData)
+{
+    Start(DEFAULT_RETRANSMISSION_COUNT);
+    ASSERT_EQ(CA_STATUS_OK, Send(0x1234));
+    ASSERT_EQ(CA_STATUS_OK, Send(0x1235));
+    EXPECT_EQ(CA_STATUS_FAILED, Send(0x1234));
+    EXPECT_EQ(2u, Pending());
+
+    uint8_t pdu[4];
+    void *retransmissionPdu = NULL;
+
+    // a reset with a response code and an ACK from another transport keep the data.
+    MakePdu(pdu, COAP_VERSION_RST, COAP_CODE_CONTENT, 0x1234);
+    EXPECT_EQ(CA_STATUS_OK, CARetransmissionReceivedData(&m_context, &m_endpoint, pdu,
+                                                         sizeof(pdu), &retransmissionPdu));
+    CAEndpoint_t other = m_endpoint;
+    other.adapter = CA_ADAPTER_GATT_BTLE;
+    MakePdu(pdu, COAP_VERSION_ACK, CA_EMPTY, 0x1234);
+    EXPECT_EQ(CA_STATUS_OK, CARetransmissionReceivedData(&m_context, &other, pdu,
+                                                         sizeof(pdu), &retransmissionPdu));
+    EXPECT_EQ(2u, Pending());
+    EXPECT_TRUE(NULL == retransmissionPdu);
+
+    // an empty ACK hands the request back so that its token can be looked up.
+    EXPECT_EQ(CA_STATUS_OK, CARetransmissionReceivedData(&m_context, &m_endpoint, pdu,
+                                                         sizeof(pdu), &retransmissionPdu));
+    ASSERT_TRUE(NULL != retransmissionPdu);
+    EXPECT_EQ(COAP_VERSION_CON, ((uint8_t *) retransmissionPdu)[0]);
+    EXPECT_EQ(0x1234, GetMessageId(retransmissionPdu));
+    OICFree(retransmissionPdu);
+    retransmissionPdu = NULL;
+
+    // a piggybacked response removes the data without handing it back.
+    MakePdu(pdu, COAP_VERSION_ACK, COAP_CODE_CONTENT, 0x1235);
+    EXPECT_EQ(CA_STATUS_OK, CARetransmissionReceivedData(&m_context, &m_endpoint, pdu,
+                                                         sizeof(pdu), &retransmissionPdu));
+    EXPECT_TRUE(NULL == retransmissionPdu);
+    EXPECT_EQ(0u, Pending());
+
+    oc_mutex_lock(m_context.threadMutex);
+    for (size_t i = 0; i < RETRANSMISSION_WHEEL_SLOTS; i++)
+    {
+        EXPECT_TRUE(NULL == m_context.timerWheel[i]);
+    }
+    oc_mutex_unlock(m_context.threadMutex);
+
+    std::lock_guard<std::mutex> lock(g_eventMutex);
+    EXPECT_TRUE(g_sendTimes.empty());
+}
+
+TEST_F(CARetransmissionTests, RetransmissionsFireAcrossWheelSlots)
+{
+    const uint8_t tryingCount = 3;
+    Start(tryingCount);
+    ASSERT_EQ(CA_STATUS_OK, Send(0x2000));
+
+    // record the slot and deadline of every retransmission as it gets rescheduled.
+    std::vector<size_t> slots;
+    std::vector<uint64_t> deadlines;
+    oc_mutex_lock(m_context.threadMutex);
+    uint64_t sentTime = Find(0x2000, m_endpoint.adapter)->timeStamp;
+    oc_mutex_unlock(m_context.threadMutex);
+    SetTimeout(0x2000, TEST_TIMEOUT_USEC);
+
+    auto end = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::chrono::steady_clock::now() < end)
+    {
+        oc_mutex_lock(m_context.threadMutex);
+        CARetransmissionData_t *retData = Find(0x2000, m_endpoint.adapter);
+        if (retData && (deadlines.empty() || deadlines.back() != retData->deadline))
+        {
+            slots.push_back(retData->slot);
+            deadlines.push_back(retData->deadline);
+        }
+        oc_mutex_unlock(m_context.threadMutex);
+        if (!retData)
+        {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    EXPECT_EQ(1u, WaitForTimeouts(1, std::chrono::seconds(1)));
+
+    std::lock_guard<std::mutex> lock(g_eventMutex);
+    ASSERT_EQ((size_t) tryingCount, g_sendTimes.size());
+    ASSERT_EQ((size_t) tryingCount, deadlines.size());
+
+    // the backoff doubles the interval, so each retransmission lands in a later slot.
+    uint64_t expected = sentTime;
+    for (size_t i = 0; i < tryingCount; i++)
+    {
+        expected += TEST_TIMEOUT_USEC << i;
+        EXPECT_LE(deadlines[i], g_sendTimes[i]);
+        EXPECT_LE(expected, g_sendTimes[i]);
+        EXPECT_EQ((size_t) ((deadlines[i] / USECS_PER_TICK) % RETRANSMISSION_WHEEL_SLOTS),
+                  slots[i]);
+        if (i > 0)
+        {
+            EXPECT_NE(slots[i - 1], slots[i]);
+        }
+    }
+}
+
+TEST_F(CARetransmissionTests, MaxRetryExpiry)
+{
+    const uint8_t tryingCount = 2;
+    Start(tryingCount);
+    ASSERT_EQ(CA_STATUS_OK, Send(0x3000));
+    ASSERT_EQ(CA_STATUS_OK, Send(0x3001));
+    SetTimeout(0x3000, TEST_TIMEOUT_USEC);
+
+    // only the message with the short timeout expires.
+    EXPECT_EQ(1u, WaitForTimeouts(1, std::chrono::seconds(3)));
+    EXPECT_EQ(1u, Pending());
+
+    std::lock_guard<std::mutex> lock(g_eventMutex);
+    EXPECT_EQ((size_t) tryingCount, g_sendTimes.size());
+    ASSERT_EQ(1u, g_timedOutIds.size());
+    EXPECT_EQ(0x3000, g_timedOutIds[0]);
+}
+
+TEST_F(CARetransmissionTests, DataBeyondOneTurnWaitsForItsDeadline)
+{
+    Start(DEFAULT_RETRANSMISSION_COUNT);
+    ASSERT_EQ(CA_STATUS_OK, Send(0x4000));
+
+    // a deadline more than one turn away shares its slot with data due in this turn.
+    const uint64_t turn = RETRANSMISSION_WHEEL_SLOTS * USECS_PER_TICK;
+    SetTimeout(0x4000, turn + USECS_PER_TICK);
+    CACheckRetransmissionList(&m_context);
+    std::this_thread::sleep_for(std::chrono::milliseconds(3 * RETRANSMISSION_WHEEL_TICK_MSEC));
+    CACheckRetransmissionList(&m_context);
+
+    EXPECT_EQ(1u, Pending());
+    std::lock_guard<std::mutex> lock(g_eventMutex);
+    EXPECT_TRUE(g_sendTimes.empty());
+}
@@ -0,0 +1,164 @@
+//******************************************************************
+//
+// Copyright 2017 Samsung Electronics All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include "cacommon.h"
+#include "catcpinterface.h"
+#include "cathreadpool.h"
+
+static std::atomic<size_t> g_receivedBytes(0);
+
+static void PacketReceived(const CASecureEndpoint_t *sep, const void *data, size_t dataLength)
+{
+    (void)sep;
+    (void)data;
+    g_receivedBytes += dataLength;
+}
+
+static void ConnectionChanged(const CAEndpoint_t *endpoint, bool isConnected, bool isClient)
+{
+    (void)endpoint;
+    (void)isConnected;
+    (void)isClient;
+}
+
+class TCPServerF : public testing::Test
+{
+public:
+    TCPServerF() :
+        testing::Test(),
+        threadPool(NULL)
+    {
+    }
+
+protected:
+    virtual void SetUp()
+    {
+        ResetGlobals();
+        caglobals.tcp.ipv4tcpenabled = true;
+        caglobals.tcp.ipv6tcpenabled = false;
+
+        ASSERT_EQ(CA_STATUS_OK, ca_thread_pool_init(2, &threadPool));
+        CATCPSetPacketReceiveCallback(PacketReceived);
+        CATCPSetConnectionChangedCallback(ConnectionChanged);
+        g_receivedBytes = 0;
+    }
+
+    virtual void TearDown()
+    {
+        CATCPStopServer();
+        ca_thread_pool_free(threadPool);
+        CATCPSetPacketReceiveCallback(NULL);
+        CATCPSetConnectionChangedCallback(NULL);
+    }
+
+    static void ResetGlobals()
+    {
+        caglobals.tcp.ipv4.fd  = OC_INVALID_SOCKET;
+        caglobals.tcp.ipv4s.fd = OC_INVALID_SOCKET;
+        caglobals.tcp.ipv6.fd  = OC_INVALID_SOCKET;
+        caglobals.tcp.ipv6s.fd = OC_INVALID_SOCKET;
+        caglobals.tcp.ipv4.port  = 0;
+        caglobals.tcp.ipv4s.port = 0;
+        caglobals.tcp.ipv6.port  = 0;
+        caglobals.tcp.ipv6s.port = 0;
+        caglobals.tcp.shutdownFds[0] = OC_INVALID_SOCKET;
+        caglobals.tcp.shutdownFds[1] = OC_INVALID_SOCKET;
+        caglobals.tcp.connectionFds[0] = OC_INVALID_SOCKET;
+        caglobals.tcp.connectionFds[1] = OC_INVALID_SOCKET;
+        caglobals.tcp.listenBacklog = 8;
+    }
+
+    // Connect to the IPv4 accept socket and send a small message.
+    int Send(uint16_t port, size_t length)
+    {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        EXPECT_NE(-1, fd);
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        EXPECT_EQ(0, connect(fd, (struct sockaddr *)&addr, sizeof(addr)));
+
+        const unsigned char payload[16] = { 0x50 };
+        EXPECT_EQ((ssize_t)length, send(fd, payload, length, 0));
+        return fd;
+    }
+
+    static bool WaitForReceived(size_t bytes)
+    {
+        for (int i = 0; i < 1000 && g_receivedBytes < bytes; i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return g_receivedBytes >= bytes;
+    }
+
+    ca_thread_pool_t threadPool;
+};
+
+TEST_F(TCPServerF, StartReceiveStop)
+{
+    for (int cycle = 0; cycle < 3; cycle++)
+    {
+        SCOPED_TRACE(cycle);
+        g_receivedBytes = 0;
+        ASSERT_EQ(CA_STATUS_OK, CATCPStartServer(threadPool));
+        uint16_t port = caglobals.tcp.ipv4.port;
+        ASSERT_NE(0, port);
+
+        int fd = Send(port, 4);
+        EXPECT_TRUE(WaitForReceived(4));
+
+        // the receive thread has returned and the session is gone once stopped.
+        CATCPStopServer();
+        EXPECT_FALSE(caglobals.tcp.started);
+        send(fd, "late", 4, MSG_NOSIGNAL);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        EXPECT_EQ(4u, g_receivedBytes.load());
+        close(fd);
+
+        ResetGlobals();
+    }
+}
+
+TEST_F(TCPServerF, StopWithoutStart)
+{
+    CATCPStopServer();
+    EXPECT_FALSE(caglobals.tcp.started);
+
+    ASSERT_EQ(CA_STATUS_OK, CATCPStartServer(threadPool));
+    int fd = Send(caglobals.tcp.ipv4.port, 8);
+    EXPECT_TRUE(WaitForReceived(8));
+    close(fd);
+}
@@ -23,7 +23,12 @@
 #pragma warning(disable : 4200)
 #endif
 
+#include <atomic>
 #include <cinttypes>
+#include <chrono>
+#include <deque>
+#include <thread>
+#include <vector>
 #include "iotivity_config.h"
 #include <gtest/gtest.h>
 #include "time.h"
@@ -44,6 +49,9 @@
 #define CAsetSslHandshakeCallback CAsetSslHandshakeCallbackTest
 #define CAsetTlsCipherSuite CAsetTlsCipherSuiteTest
 #define CAsslGenerateOwnerPsk CAsslGenerateOwnerPskTest
+#define CAsslInvalidatePkixInfo CAsslInvalidatePkixInfoTest
+#define CAsetTlsSessionResumption CAsetTlsSessionResumptionTest
+#define CAsslGetHandshakeStats CAsslGetHandshakeStatsTest
 #define CAcloseSslConnectionAll CAcloseSslConnectionAllTest
 #define GetCASecureEndpointData GetCASecureEndpointDataTest
 #define SetCASecureEndpointAttribute SetCASecureEndpointAttributeTest
@@ -1884,6 +1892,7 @@ static void * test0CAinitiateSslHandshake(void * arg)
     serverAddr.ifindex = 0;
 
     g_sslContextMutex = oc_mutex_new_recursive();
+    g_sslRndMutex = oc_mutex_new();
     oc_mutex_lock(g_sslContextMutex);
     g_caSslContext = (SslContext_t *)OICCalloc(1, sizeof(SslContext_t));
     g_caSslContext->peerList = u_arraylist_create();
@@ -1964,6 +1973,8 @@ static void * test0CAinitiateSslHandshake(void * arg)
     oc_mutex_unlock(g_sslContextMutex);
     oc_mutex_free(g_sslContextMutex);
     g_sslContextMutex = NULL;
+    oc_mutex_free(g_sslRndMutex);
+    g_sslRndMutex = NULL;
 
     socketClose();
 
@@ -2950,6 +2961,7 @@ TEST(TLSAdapter, Test_11)
     ASSERT_FALSE(socket_error) << "Server: socket error";
 
     g_sslContextMutex = oc_mutex_new_recursive();
+    g_sslRndMutex = oc_mutex_new();
     oc_mutex_lock(g_sslContextMutex);
     g_caSslContext = (SslContext_t *)OICCalloc(1, sizeof(SslContext_t));
     g_caSslContext->peerList = u_arraylist_create();
@@ -3042,3 +3054,600 @@ TEST(TLSAdapter, TestCertsValid)
     EXPECT_EQ(0, ret) << "Failed to parse CA cert";
     mbedtls_x509_crt_free(&cert);
 }
+
+/* **************************
+ *
+ *
+ * Handshake rate over loopback
+ *
+ *
+ * *************************/
+
+#define LOOPBACK_CLIENT_PORT 4434
+#define LOOPBACK_HANDSHAKES 50
+
+typedef struct
+{
+    bool toServer;
+    std::vector<uint8_t> record;
+} LoopbackRecord_t;
+
+static std::deque<LoopbackRecord_t> loopbackRecords;
+static int loopbackHandshakesDone = 0;
+static int loopbackHandshakesFailed = 0;
+static int pkixInfoLoads = 0;
+
+static void countingInfoCallback(PkiInfo_t * inf)
+{
+    pkixInfoLoads++;
+    infoCallback_that_loads_x509(inf);
+}
+
+static void pskAndCertificates(bool * list, const char *deviceId)
+{
+    OC_UNUSED(deviceId);
+
+    list[0] = true;
+    list[1] = true;
+}
+
+static int32_t GetLoopbackPskCredentials(CADtlsPskCredType_t,
+              const unsigned char *, size_t,
+              unsigned char *result, size_t resultLength)
+{
+    if (NULL == result || resultLength < UUID_LENGTH)
+    {
+        return -1;
+    }
+    memcpy(result, RS_CLIENT_PSK, UUID_LENGTH);
+    return UUID_LENGTH;
+}
+
+// Records of both sides are queued and delivered by PumpLoopback(), one per CAdecryptSsl()
+static ssize_t LoopbackPacketSendCB(CAEndpoint_t *endpoint, const void *buf, size_t buflen)
+{
+    LoopbackRecord_t record;
+    record.toServer = (SERVER_PORT == endpoint->port);
+    record.record.assign((const uint8_t *)buf, (const uint8_t *)buf + buflen);
+    loopbackRecords.push_back(record);
+    return (ssize_t)buflen;
+}
+
+static void LoopbackPacketReceivedCB(const CASecureEndpoint_t *, const void *, size_t)
+{
+}
+
+static void LoopbackHandshakeCB(const CAEndpoint_t *, const CAErrorInfo_t *errorInfo)
+{
+    if (CA_STATUS_OK == errorInfo->result)
+    {
+        loopbackHandshakesDone++;
+    }
+    else
+    {
+        loopbackHandshakesFailed++;
+    }
+}
+
+static void PumpLoopback(const CAEndpoint_t *serverAddr, const CAEndpoint_t *clientAddr)
+{
+    while (!loopbackRecords.empty())
+    {
+        LoopbackRecord_t record = loopbackRecords.front();
+        loopbackRecords.pop_front();
+
+        // the receiving side sees the record coming from the other one
+        CASecureEndpoint_t sep;
+        memset(&sep, 0, sizeof(sep));
+        sep.endpoint = record.toServer ? *clientAddr : *serverAddr;
+        CAdecryptSsl(&sep, record.record.data(), record.record.size());
+    }
+}
+
+static long long RunLoopbackHandshakes(bool invalidate, int count = LOOPBACK_HANDSHAKES)
+{
+    CAEndpoint_t serverAddr;
+    memset(&serverAddr, 0, sizeof(serverAddr));
+    serverAddr.adapter = CA_ADAPTER_TCP;
+    serverAddr.flags = CA_SECURE;
+    serverAddr.port = SERVER_PORT;
+    strcpy(serverAddr.addr, "127.0.0.1");
+
+    CAEndpoint_t clientAddr = serverAddr;
+    clientAddr.port = LOOPBACK_CLIENT_PORT;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++)
+    {
+        if (invalidate)
+        {
+            CAsslInvalidatePkixInfo();
+        }
+        CAinitiateSslHandshake(&serverAddr);
+        PumpLoopback(&serverAddr, &clientAddr);
+
+        CAcloseSslConnection(&serverAddr);
+        CAcloseSslConnection(&clientAddr);
+        loopbackRecords.clear();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    return (long long)elapsed.count();
+}
+
+TEST(TLSAdapter, LoopbackHandshakeRate)
+{
+    ASSERT_EQ(CA_STATUS_OK, CAinitSslAdapter());
+
+    CAsetSslAdapterCallbacks(LoopbackPacketReceivedCB, LoopbackPacketSendCB, CA_ADAPTER_TCP);
+    CAsetSslHandshakeCallback(LoopbackHandshakeCB);
+    CAsetPkixInfoCallback(countingInfoCallback);
+    CAsetCredentialTypesCallback(pskAndCertificates);
+    CAsetPskCredentialsCallback(GetLoopbackPskCredentials);
+    CAsetTlsCipherSuite(MBEDTLS_TLS_ECDHE_PSK_WITH_AES_128_CBC_SHA256);
+
+    // the PKIX info is invalidated before every handshake and loaded once for it,
+    // the server side reuses what the client side loaded into the shared context
+    loopbackHandshakesDone = 0;
+    loopbackHandshakesFailed = 0;
+    pkixInfoLoads = 0;
+    long long uncached = RunLoopbackHandshakes(true);
+    EXPECT_EQ(2 * LOOPBACK_HANDSHAKES, loopbackHandshakesDone);
+    EXPECT_EQ(0, loopbackHandshakesFailed);
+    EXPECT_EQ(LOOPBACK_HANDSHAKES, pkixInfoLoads);
+
+    // the PKIX info is loaded once and reused until it is invalidated
+    loopbackHandshakesDone = 0;
+    loopbackHandshakesFailed = 0;
+    pkixInfoLoads = 0;
+    long long cached = RunLoopbackHandshakes(false);
+    EXPECT_EQ(2 * LOOPBACK_HANDSHAKES, loopbackHandshakesDone);
+    EXPECT_EQ(0, loopbackHandshakesFailed);
+    EXPECT_EQ(0, pkixInfoLoads);
+
+    mbedtls_printf("%d handshakes: %lld us reloading the PKIX info, %lld us with cached PKIX info\n",
+                   LOOPBACK_HANDSHAKES, uncached, cached);
+
+    CAsetSslHandshakeCallback(NULL);
+    CAdeinitSslAdapter();
+}
+
+static void infoCallback_without_own_cert(PkiInfo_t * inf)
+{
+    infoCallback_that_loads_x509(inf);
+    DEINIT_BYTE_ARRAY(inf->crt);
+    DEINIT_BYTE_ARRAY(inf->key);
+}
+
+TEST(TLSAdapter, ReloadWithoutOwnCertificate)
+{
+    ASSERT_EQ(CA_STATUS_OK, CAinitSslAdapter());
+
+    CAsetPkixInfoCallback(infoCallback_that_loads_x509);
+    EXPECT_EQ(0, InitPKIX(CA_ADAPTER_TCP));
+    EXPECT_TRUE(g_caSslContext->ownCertConfigured[1]);
+
+    // the now empty own certificate is removed from the configs, the CA chain is kept
+    CAsetPkixInfoCallback(infoCallback_without_own_cert);
+    EXPECT_EQ(0, InitPKIX(CA_ADAPTER_TCP));
+    EXPECT_FALSE(g_caSslContext->pkixOwnCert);
+    EXPECT_TRUE(g_caSslContext->pkixLoaded);
+    EXPECT_FALSE(g_caSslContext->ownCertConfigured[1]);
+    EXPECT_TRUE(NULL == g_caSslContext->serverTlsConf.key_cert);
+    EXPECT_TRUE(NULL == g_caSslContext->clientTlsConf.key_cert);
+
+    CAsetPkixInfoCallback(infoCallback_that_loads_x509);
+    EXPECT_EQ(0, InitPKIX(CA_ADAPTER_TCP));
+    EXPECT_TRUE(g_caSslContext->pkixOwnCert);
+    EXPECT_TRUE(g_caSslContext->ownCertConfigured[1]);
+    EXPECT_TRUE(NULL != g_caSslContext->serverTlsConf.key_cert);
+
+    CAdeinitSslAdapter();
+}
+
+TEST(TLSAdapter, SessionResumptionConfig)
+{
+    EXPECT_EQ(CA_STATUS_NOT_INITIALIZED,
+              CAsetTlsSessionResumption(CA_ADAPTER_TCP, CA_SESSION_RESUMPTION_CACHE));
+
+    ASSERT_EQ(CA_STATUS_OK, CAinitSslAdapter());
+
+    EXPECT_EQ(CA_STATUS_INVALID_PARAM,
+              CAsetTlsSessionResumption(CA_ADAPTER_NFC, CA_SESSION_RESUMPTION_CACHE));
+    EXPECT_EQ(CA_STATUS_INVALID_PARAM, CAsetTlsSessionResumption(CA_ADAPTER_TCP, 1 << 2));
+    EXPECT_EQ(CA_STATUS_OK, CAsetTlsSessionResumption(CA_ADAPTER_TCP,
+              CA_SESSION_RESUMPTION_CACHE | CA_SESSION_RESUMPTION_TICKETS));
+    EXPECT_EQ(CA_STATUS_OK, CAsetTlsSessionResumption(CA_ADAPTER_IP, CA_SESSION_RESUMPTION_CACHE));
+
+    CAsetSslAdapterCallbacks(LoopbackPacketReceivedCB, LoopbackPacketSendCB, CA_ADAPTER_TCP);
+    CAsetSslHandshakeCallback(LoopbackHandshakeCB);
+    CAsetPkixInfoCallback(countingInfoCallback);
+    CAsetCredentialTypesCallback(pskAndCertificates);
+    CAsetPskCredentialsCallback(GetLoopbackPskCredentials);
+    CAsetTlsCipherSuite(MBEDTLS_TLS_ECDHE_PSK_WITH_AES_128_CBC_SHA256);
+
+    // PSK sessions are never resumed, even with resumption enabled
+    loopbackHandshakesDone = 0;
+    loopbackHandshakesFailed = 0;
+    RunLoopbackHandshakes(false);
+    EXPECT_EQ(2 * LOOPBACK_HANDSHAKES, loopbackHandshakesDone);
+    EXPECT_EQ(0, loopbackHandshakesFailed);
+    EXPECT_EQ(0u, u_arraylist_length(g_caSslContext->sessionList));
+
+    uint32_t full = 0;
+    uint32_t resumed = 0;
+    CAsslGetHandshakeStats(&full, &resumed);
+    EXPECT_EQ(2u * LOOPBACK_HANDSHAKES, full);
+    EXPECT_EQ(0u, resumed);
+
+    EXPECT_EQ(CA_STATUS_OK, CAsetTlsSessionResumption(CA_ADAPTER_TCP, CA_SESSION_RESUMPTION_NONE));
+
+    CAsetSslHandshakeCallback(NULL);
+    CAdeinitSslAdapter();
+
+    CAsslGetHandshakeStats(&full, &resumed);
+    EXPECT_EQ(0u, full);
+    EXPECT_EQ(0u, resumed);
+}
+
+static void certificatesOnly(bool * list, const char *deviceId)
+{
+    OC_UNUSED(deviceId);
+
+    list[0] = false;
+    list[1] = true;
+}
+
+// The test certificates expired in 2019, everything else is still verified
+static int IgnoreCertExpiry(void *, mbedtls_x509_crt *, int, uint32_t *flags)
+{
+    *flags &= ~(MBEDTLS_X509_BADCERT_EXPIRED | MBEDTLS_X509_BADCERT_FUTURE);
+    return 0;
+}
+
+static void InitCertLoopback(uint32_t modes)
+{
+    ASSERT_EQ(CA_STATUS_OK, CAinitSslAdapter());
+
+    CAsetSslAdapterCallbacks(LoopbackPacketReceivedCB, LoopbackPacketSendCB, CA_ADAPTER_TCP);
+    CAsetSslHandshakeCallback(LoopbackHandshakeCB);
+    CAsetPkixInfoCallback(infoCallback_that_loads_x509);
+    CAsetCredentialTypesCallback(certificatesOnly);
+    CAsetTlsCipherSuite(MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CBC_SHA256);
+    mbedtls_ssl_conf_verify(&g_caSslContext->clientTlsConf, IgnoreCertExpiry, NULL);
+    mbedtls_ssl_conf_verify(&g_caSslContext->serverTlsConf, IgnoreCertExpiry, NULL);
+    ASSERT_EQ(CA_STATUS_OK, CAsetTlsSessionResumption(CA_ADAPTER_TCP, modes));
+
+    loopbackHandshakesDone = 0;
+    loopbackHandshakesFailed = 0;
+}
+
+static void ExpectCertSessionsResumed(uint32_t modes)
+{
+    InitCertLoopback(modes);
+
+    // the first connection has nothing to resume
+    RunLoopbackHandshakes(false, 1);
+    EXPECT_EQ(2, loopbackHandshakesDone);
+    EXPECT_EQ(1u, u_arraylist_length(g_caSslContext->sessionList));
+
+    uint32_t full = 0;
+    uint32_t resumed = 0;
+    CAsslGetHandshakeStats(&full, &resumed);
+    EXPECT_EQ(2u, full);
+    EXPECT_EQ(0u, resumed);
+
+    // reconnects resume the kept session
+    RunLoopbackHandshakes(false);
+    EXPECT_EQ(2 * (LOOPBACK_HANDSHAKES + 1), loopbackHandshakesDone);
+    EXPECT_EQ(0, loopbackHandshakesFailed);
+    EXPECT_EQ(1u, u_arraylist_length(g_caSslContext->sessionList));
+
+    CAsslGetHandshakeStats(&full, &resumed);
+    EXPECT_EQ(2u, full);
+    EXPECT_EQ(2u * LOOPBACK_HANDSHAKES, resumed);
+
+    CAsetSslHandshakeCallback(NULL);
+    CAdeinitSslAdapter();
+}
+
+#if defined(MBEDTLS_SSL_CACHE_C)
+TEST(TLSAdapter, SessionResumptionCache)
+{
+    ExpectCertSessionsResumed(CA_SESSION_RESUMPTION_CACHE);
+}
+#endif
+
+#ifdef SSL_SESSION_TICKETS
+TEST(TLSAdapter, SessionResumptionTickets)
+{
+    ExpectCertSessionsResumed(CA_SESSION_RESUMPTION_TICKETS);
+}
+#endif
+
+TEST(TLSAdapter, InvalidatePkixInfoForcesFullHandshake)
+{
+    InitCertLoopback(CA_SESSION_RESUMPTION_CACHE | CA_SESSION_RESUMPTION_TICKETS);
+
+    RunLoopbackHandshakes(false, 2);
+    EXPECT_EQ(4, loopbackHandshakesDone);
+
+    uint32_t full = 0;
+    uint32_t resumed = 0;
+    CAsslGetHandshakeStats(&full, &resumed);
+    EXPECT_EQ(2u, full);
+    EXPECT_EQ(2u, resumed);
+
+    // sessions were authenticated with the old credentials
+    CAsslInvalidatePkixInfo();
+    EXPECT_EQ(0u, u_arraylist_length(g_caSslContext->sessionList));
+
+    RunLoopbackHandshakes(false, 1);
+    EXPECT_EQ(6, loopbackHandshakesDone);
+    EXPECT_EQ(0, loopbackHandshakesFailed);
+
+    CAsslGetHandshakeStats(&full, &resumed);
+    EXPECT_EQ(4u, full);
+    EXPECT_EQ(2u, resumed);
+
+    CAsetSslHandshakeCallback(NULL);
+    CAdeinitSslAdapter();
+}
+
+// Peer without session, the peer table only looks at the endpoint
+static SslEndPoint_t *NewTablePeer(const CAEndpoint_t *endpoint)
+{
+    SslEndPoint_t *tep = (SslEndPoint_t *)OICCalloc(1, sizeof(SslEndPoint_t));
+    if (NULL != tep)
+    {
+        tep->sep.endpoint = *endpoint;
+        tep->mutex = oc_mutex_new_recursive();
+    }
+    return tep;
+}
+
+TEST(TLSAdapter, PeerTable)
+{
+    const int peerCount = 3 * SSL_PEER_TABLE_SIZE;
+
+    ASSERT_EQ(CA_STATUS_OK, CAinitSslAdapter());
+    oc_mutex_lock(g_sslContextMutex);
+
+    CAEndpoint_t endpoint;
+    memset(&endpoint, 0, sizeof(endpoint));
+    endpoint.adapter = CA_ADAPTER_IP;
+    endpoint.flags = CA_SECURE;
+    strcpy(endpoint.addr, "192.168.0.1");
+    for (int i = 0; i < peerCount; i++)
+    {
+        endpoint.port = (uint16_t)(5000 + i);
+        SslEndPoint_t *tep = NewTablePeer(&endpoint);
+        ASSERT_TRUE(NULL != tep);
+        ASSERT_TRUE(AddSslPeer(tep));
+    }
+
+    for (int i = 0; i < peerCount; i++)
+    {
+        endpoint.port = (uint16_t)(5000 + i);
+        SslEndPoint_t *tep = GetSslPeer(&endpoint);
+        ASSERT_TRUE(NULL != tep);
+        EXPECT_EQ(endpoint.port, tep->sep.endpoint.port);
+    }
+    endpoint.port = (uint16_t)(5000 + peerCount);
+    EXPECT_TRUE(NULL == GetSslPeer(&endpoint));
+    endpoint.adapter = CA_ADAPTER_TCP;
+    endpoint.port = 5000;
+    EXPECT_TRUE(NULL == GetSslPeer(&endpoint));
+
+    // every other peer is removed
+    endpoint.adapter = CA_ADAPTER_IP;
+    for (int i = 0; i < peerCount; i += 2)
+    {
+        endpoint.port = (uint16_t)(5000 + i);
+        RemovePeerFromList(&endpoint);
+    }
+    EXPECT_EQ((size_t)(peerCount / 2), u_arraylist_length(g_caSslContext->peerList));
+    for (size_t i = 0; i < u_arraylist_length(g_caSslContext->peerList); i++)
+    {
+        SslEndPoint_t *listed = (SslEndPoint_t *)u_arraylist_get(g_caSslContext->peerList, i);
+        ASSERT_TRUE(NULL != listed);
+        EXPECT_EQ(i, listed->listIndex);
+    }
+    for (int i = 0; i < peerCount; i++)
+    {
+        endpoint.port = (uint16_t)(5000 + i);
+        EXPECT_EQ(0 != (i % 2), NULL != GetSslPeer(&endpoint));
+    }
+
+    // BLE peers are found by address, whatever the port
+    CAEndpoint_t blePeer;
+    memset(&blePeer, 0, sizeof(blePeer));
+    blePeer.adapter = CA_ADAPTER_GATT_BTLE;
+    strcpy(blePeer.addr, "00:11:22:33:44:55");
+    blePeer.port = 1;
+    SslEndPoint_t *tep = NewTablePeer(&blePeer);
+    ASSERT_TRUE(NULL != tep);
+    ASSERT_TRUE(AddSslPeer(tep));
+    blePeer.port = 2;
+    EXPECT_EQ(tep, GetSslPeer(&blePeer));
+
+    oc_mutex_unlock(g_sslContextMutex);
+
+    CAcloseSslConnectionAll(CA_ADAPTER_IP);
+    oc_mutex_lock(g_sslContextMutex);
+    EXPECT_EQ(1u, u_arraylist_length(g_caSslContext->peerList));
+    endpoint.port = 5001;
+    EXPECT_TRUE(NULL == GetSslPeer(&endpoint));
+    EXPECT_EQ(tep, GetSslPeer(&blePeer));
+    oc_mutex_unlock(g_sslContextMutex);
+
+    CAdeinitSslAdapter();
+}
+
+#define PARALLEL_PEERS 4
+#define PARALLEL_MESSAGES 200
+#define PARALLEL_SERVER_PORT 5500
+#define PARALLEL_CLIENT_PORT 5600
+
+typedef struct
+{
+    CAEndpoint_t from;
+    std::vector<uint8_t> record;
+} ParallelRecord_t;
+
+// Every thread delivers the records it sent itself
+static thread_local std::deque<ParallelRecord_t> parallelRecords;
+static std::atomic<int> parallelReceived[PARALLEL_PEERS];
+static std::atomic<int> parallelMismatches(0);
+
+static bool IsParallelServerPort(uint16_t port)
+{
+    return PARALLEL_SERVER_PORT <= port && PARALLEL_SERVER_PORT + PARALLEL_PEERS > port;
+}
+
+// Pair i connects PARALLEL_CLIENT_PORT + i to PARALLEL_SERVER_PORT + i
+static ssize_t ParallelPacketSendCB(CAEndpoint_t *endpoint, const void *buf, size_t buflen)
+{
+    ParallelRecord_t record;
+    record.from = *endpoint;
+    record.from.port = IsParallelServerPort(endpoint->port) ?
+        (uint16_t)(endpoint->port - PARALLEL_SERVER_PORT + PARALLEL_CLIENT_PORT) :
+        (uint16_t)(endpoint->port - PARALLEL_CLIENT_PORT + PARALLEL_SERVER_PORT);
+    record.record.assign((const uint8_t *)buf, (const uint8_t *)buf + buflen);
+    parallelRecords.push_back(record);
+    return (ssize_t)buflen;
+}
+
+static void ParallelPacketReceivedCB(const CASecureEndpoint_t *sep, const void *data, size_t dataLength)
+{
+    int pair = sep->endpoint.port - PARALLEL_CLIENT_PORT;
+    if (0 > pair || PARALLEL_PEERS <= pair || 0 == dataLength || pair != ((const uint8_t *)data)[0])
+    {
+        parallelMismatches++;
+        return;
+    }
+    parallelReceived[pair]++;
+}
+
+static void PumpParallel()
+{
+    while (!parallelRecords.empty())
+    {
+        ParallelRecord_t record = parallelRecords.front();
+        parallelRecords.pop_front();
+
+        CASecureEndpoint_t sep;
+        memset(&sep, 0, sizeof(sep));
+        sep.endpoint = record.from;
+        CAdecryptSsl(&sep, record.record.data(), record.record.size());
+    }
+}
+
+static CAEndpoint_t ParallelEndpoint(uint16_t port)
+{
+    CAEndpoint_t endpoint;
+    memset(&endpoint, 0, sizeof(endpoint));
+    endpoint.adapter = CA_ADAPTER_TCP;
+    endpoint.flags = CA_SECURE;
+    endpoint.port = port;
+    strcpy(endpoint.addr, "127.0.0.1");
+    return endpoint;
+}
+
+static void ConnectParallelPeers()
+{
+    ASSERT_EQ(CA_STATUS_OK, CAinitSslAdapter());
+
+    CAsetSslAdapterCallbacks(ParallelPacketReceivedCB, ParallelPacketSendCB, CA_ADAPTER_TCP);
+    CAsetSslHandshakeCallback(LoopbackHandshakeCB);
+    CAsetPkixInfoCallback(infoCallback_that_loads_x509);
+    CAsetCredentialTypesCallback(pskAndCertificates);
+    CAsetPskCredentialsCallback(GetLoopbackPskCredentials);
+    CAsetTlsCipherSuite(MBEDTLS_TLS_ECDHE_PSK_WITH_AES_128_CBC_SHA256);
+
+    loopbackHandshakesDone = 0;
+    loopbackHandshakesFailed = 0;
+    for (int i = 0; i < PARALLEL_PEERS; i++)
+    {
+        CAEndpoint_t server = ParallelEndpoint((uint16_t)(PARALLEL_SERVER_PORT + i));
+        CAinitiateSslHandshake(&server);
+        PumpParallel();
+    }
+    EXPECT_EQ(2 * PARALLEL_PEERS, loopbackHandshakesDone);
+    EXPECT_EQ(0, loopbackHandshakesFailed);
+}
+
+TEST(TLSAdapter, ParallelEncryptDecrypt)
+{
+    ConnectParallelPeers();
+    for (int i = 0; i < PARALLEL_PEERS; i++)
+    {
+        parallelReceived[i] = 0;
+    }
+    parallelMismatches = 0;
+
+    // each pair is used by its own thread, only the peers involved are locked
+    std::vector<std::thread> threads;
+    for (int i = 0; i < PARALLEL_PEERS; i++)
+    {
+        threads.push_back(std::thread([i]()
+        {
+            CAEndpoint_t server = ParallelEndpoint((uint16_t)(PARALLEL_SERVER_PORT + i));
+            uint8_t payload[64];
+            memset(payload, i, sizeof(payload));
+            for (int m = 0; m < PARALLEL_MESSAGES; m++)
+            {
+                EXPECT_EQ(CA_STATUS_OK, CAencryptSsl(&server, payload, sizeof(payload)));
+                PumpParallel();
+            }
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        threads[i].join();
+    }
+
+    EXPECT_EQ(0, parallelMismatches.load());
+    for (int i = 0; i < PARALLEL_PEERS; i++)
+    {
+        EXPECT_EQ(PARALLEL_MESSAGES, parallelReceived[i].load());
+    }
+
+    CAsetSslHandshakeCallback(NULL);
+    CAdeinitSslAdapter();
+    parallelRecords.clear();
+}
+
+TEST(TLSAdapter, DeinitWaitsForReleasedPeers)
+{
+    ConnectParallelPeers();
+
+    CAEndpoint_t server = ParallelEndpoint(PARALLEL_SERVER_PORT);
+    oc_mutex_lock(g_sslContextMutex);
+    SslEndPoint_t *tep = GetSslPeer(&server);
+    ASSERT_TRUE(NULL != tep);
+    AcquireSslPeer(tep);
+    oc_mutex_unlock(g_sslContextMutex);
+
+    std::atomic<bool> done(false);
+    std::thread deinit([&done]()
+    {
+        CAdeinitSslAdapter();
+        done = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_FALSE(done);
+
+    // the peer is no longer listed, but stays usable until released
+    oc_mutex_lock(g_sslContextMutex);
+    EXPECT_EQ(SSL_PEER_UNLISTED, tep->listIndex);
+    EXPECT_EQ(1u, tep->refCount);
+    ReleaseSslPeer(tep);
+    oc_mutex_unlock(g_sslContextMutex);
+
+    deinit.join();
+    EXPECT_TRUE(done);
+    EXPECT_TRUE(NULL == g_caSslContext);
+    parallelRecords.clear();
+}
@@ -210,6 +210,33 @@ TEST_F(UArrayListF, Remove)
     ASSERT_EQ(static_cast<size_t>(500), u_arraylist_length(list));
 }
 
+TEST_F(UArrayListF, SwapRemove)
+{
+    int dummy[10] = {0};
+    size_t cap = sizeof(dummy) / sizeof(dummy[0]);
+
+    for (size_t i = 0; i < cap; ++i)
+    {
+        bool rc = u_arraylist_add(list, &dummy[i]);
+        ASSERT_TRUE(rc);
+    }
+
+    // the last element takes the place of the removed one
+    EXPECT_EQ(&dummy[2], u_arraylist_swap_remove(list, 2));
+    ASSERT_EQ(cap - 1, u_arraylist_length(list));
+    EXPECT_EQ(&dummy[9], u_arraylist_get(list, 2));
+    EXPECT_EQ(&dummy[8], u_arraylist_get(list, 8));
+
+    // removing the last element moves nothing
+    EXPECT_EQ(&dummy[8], u_arraylist_swap_remove(list, 8));
+    ASSERT_EQ(cap - 2, u_arraylist_length(list));
+    EXPECT_EQ(&dummy[7], u_arraylist_get(list, 7));
+
+    EXPECT_TRUE(NULL == u_arraylist_swap_remove(list, cap - 2));
+    EXPECT_TRUE(NULL == u_arraylist_swap_remove(NULL, 0));
+    ASSERT_EQ(cap - 2, u_arraylist_length(list));
+}
+
 TEST_F(UArrayListF, Contains)
 {
     ASSERT_EQ(static_cast<size_t>(0), u_arraylist_length(list));
@@ -0,0 +1,165 @@
+//******************************************************************
+//
+// Copyright 2017 Samsung Electronics All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "uhashmap.h"
+
+class UHashMapF : public testing::Test {
+public:
+  UHashMapF() :
+      testing::Test(),
+      map(NULL)
+  {
+  }
+
+protected:
+    virtual void SetUp()
+    {
+        map = u_hashmap_create(0);
+        ASSERT_TRUE(map != NULL);
+    }
+
+    virtual void TearDown()
+    {
+        u_hashmap_free(&map);
+        ASSERT_EQ(NULL, map);
+    }
+
+    u_hashmap_t *map;
+};
+
+static bool RemoveOdd(const void *key, size_t keyLen, void *value, void *ctx)
+{
+    (void)key;
+    (void)keyLen;
+    (void)ctx;
+    return (*static_cast<int *>(value) % 2) != 0;
+}
+
+TEST(UHashMap, Base)
+{
+    u_hashmap_t *map = u_hashmap_create(0);
+    ASSERT_TRUE(map != NULL);
+
+    u_hashmap_free(&map);
+    ASSERT_EQ(NULL, map);
+}
+
+TEST(UHashMap, FreeNull)
+{
+    u_hashmap_free(NULL);
+}
+
+TEST_F(UHashMapF, PutGet)
+{
+    ASSERT_EQ(static_cast<size_t>(0), u_hashmap_length(map));
+
+    int dummy[1000] = {0};
+    size_t cap = sizeof(dummy) / sizeof(dummy[0]);
+    char key[32];
+
+    for (size_t i = 0; i < cap; ++i)
+    {
+        snprintf(key, sizeof(key), "/a/light/%u", (unsigned)i);
+        ASSERT_TRUE(u_hashmap_put(map, key, strlen(key), &dummy[i]));
+    }
+    ASSERT_EQ(cap, u_hashmap_length(map));
+
+    for (size_t i = 0; i < cap; ++i)
+    {
+        snprintf(key, sizeof(key), "/a/light/%u", (unsigned)i);
+        ASSERT_EQ(&dummy[i], u_hashmap_get(map, key, strlen(key)));
+    }
+
+    EXPECT_EQ(NULL, u_hashmap_get(map, "/a/missing", strlen("/a/missing")));
+}
+
+TEST_F(UHashMapF, Replace)
+{
+    int first = 1;
+    int second = 2;
+
+    ASSERT_TRUE(u_hashmap_put(map, "key", 3, &first));
+    ASSERT_TRUE(u_hashmap_put(map, "key", 3, &second));
+
+    EXPECT_EQ(static_cast<size_t>(1), u_hashmap_length(map));
+    EXPECT_EQ(&second, u_hashmap_get(map, "key", 3));
+}
+
+TEST_F(UHashMapF, BinaryKeys)
+{
+    int dummy[2] = {0};
+    const unsigned char a[] = { 0x00, 0x01, 0x02 };
+    const unsigned char b[] = { 0x00, 0x01 };
+
+    ASSERT_TRUE(u_hashmap_put(map, a, sizeof(a), &dummy[0]));
+    ASSERT_TRUE(u_hashmap_put(map, b, sizeof(b), &dummy[1]));
+
+    EXPECT_EQ(&dummy[0], u_hashmap_get(map, a, sizeof(a)));
+    EXPECT_EQ(&dummy[1], u_hashmap_get(map, b, sizeof(b)));
+    EXPECT_TRUE(u_hashmap_contains(map, a, sizeof(a)));
+}
+
+TEST_F(UHashMapF, Remove)
+{
+    int dummy[100] = {0};
+    size_t cap = sizeof(dummy) / sizeof(dummy[0]);
+
+    for (size_t i = 0; i < cap; ++i)
+    {
+        ASSERT_TRUE(u_hashmap_put(map, &i, sizeof(i), &dummy[i]));
+    }
+
+    for (size_t i = 0; i < cap; i += 2)
+    {
+        EXPECT_EQ(&dummy[i], u_hashmap_remove(map, &i, sizeof(i)));
+    }
+    EXPECT_EQ(cap / 2, u_hashmap_length(map));
+
+    for (size_t i = 0; i < cap; ++i)
+    {
+        EXPECT_EQ((i % 2) != 0, u_hashmap_contains(map, &i, sizeof(i)));
+    }
+
+    size_t missing = cap;
+    EXPECT_EQ(NULL, u_hashmap_remove(map, &missing, sizeof(missing)));
+}
+
+TEST_F(UHashMapF, ForeachRemove)
+{
+    int dummy[100] = {0};
+    size_t cap = sizeof(dummy) / sizeof(dummy[0]);
+
+    for (size_t i = 0; i < cap; ++i)
+    {
+        dummy[i] = (int)i;
+        ASSERT_TRUE(u_hashmap_put(map, &i, sizeof(i), &dummy[i]));
+    }
+
+    u_hashmap_foreach(map, RemoveOdd, NULL);
+    EXPECT_EQ(cap / 2, u_hashmap_length(map));
+
+    u_hashmap_clear(map);
+    EXPECT_EQ(static_cast<size_t>(0), u_hashmap_length(map));
+}
@@ -1688,6 +1688,13 @@ typedef struct
 
     /** An array of the received vendor specific header options.*/
     OCHeaderOption rcvdVendorSpecificHeaderOptions[MAX_HEADER_OPTIONS];
+
+    /** The undecoded representation payload, set instead of payload for handlers registered
+     * with OCRegisterRawPayloadHandler. Only valid during the callback.*/
+    const uint8_t *rawPayload;
+
+    /** Size of rawPayload.*/
+    size_t rawPayloadSize;
 } OCClientResponse;
 
 /**
@@ -1467,6 +1467,9 @@ static bool UpdatePersistentStorage(const OicSecCred_t *cred)
     bool ret = false;
     OIC_LOG(DEBUG, TAG, "IN Cred UpdatePersistentStorage");
 
+    // Certificates and keys parsed for earlier (D)TLS handshakes are out of date now.
+    CAinvalidatePkixInfo();
+
     // Convert Cred data into JSON for update to persistent storage
     if (cred)
     {
@@ -2791,6 +2794,7 @@ OCStackResult DeInitCredResource()
     OCStackResult result = OCDeleteResource(gCredHandle);
     DeleteCredList(gCred);
     gCred = NULL;
+    CAinvalidatePkixInfo();
     return result;
 }
 
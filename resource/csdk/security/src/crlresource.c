@@ -19,6 +19,7 @@
 //-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 
 #include "utlist.h"
+#include "cainterface.h"
 #include "crl_logging.h"
 #include "payload_logging.h"
 #include "psinterface.h"
@@ -428,6 +429,7 @@ OCStackResult UpdateCRLResource(OicSecCrl_t *crl)
         OIC_LOG(ERROR, TAG, "Can't update global crl");
         return OC_STACK_ERROR;
     }
+    CAinvalidatePkixInfo();
 
     char currentTime[32] = {0};
     getCurrentUTCTime(currentTime, sizeof(currentTime));
@@ -31,6 +31,7 @@
 #include "ocstack.h"
 #include "ocresource.h"
 #include "cacommon.h"
+#include <stdint.h>
 
 
 #ifdef __cplusplus
@@ -62,6 +63,11 @@ typedef struct OCPresence
  */
 typedef struct resourcetype_t OCResourceType;
 
+/**
+ * Value of ClientCB::timeoutIndex for nodes that are not waiting for a timeout.
+ */
+#define CB_NO_TIMEOUT_INDEX (SIZE_MAX)
+
 /**
  * Data structure for holding client's callback context, methods and Time to Live,
  * connectivity Types, presence and resource type, request uri etc.
@@ -128,6 +134,15 @@ typedef struct ClientCB {
      * can be explicitly cancelled.*/
     uint32_t TTL;
 
+    /** Position of this node in the timeout heap, or CB_NO_TIMEOUT_INDEX if TTL is 0.*/
+    size_t timeoutIndex;
+
+    /** Number of pins keeping this node allocated while its callback runs.*/
+    uint32_t refCount;
+
+    /** Set when the node was deleted while pinned; the last unpin frees it.*/
+    bool deleted;
+
     /** next node in this list.*/
     struct ClientCB    *next;
 } ClientCB;
@@ -189,11 +204,49 @@ OCStackResult AddClientCB(ClientCB** clientCB,
  */
 void DeleteClientCB(ClientCB *cbNode);
 
+/**
+ * Keep a callback node allocated while its callback runs without the stack lock.
+ * DeleteClientCB still removes a pinned node from cbList, but frees it (and calls
+ * its context deleter) only when the last pin is dropped.
+ *
+ * @param[in]  cbNode               Address to client callback node.
+ */
+void PinClientCB(ClientCB *cbNode);
+
+/**
+ * Drop a pin taken with PinClientCB, freeing the node if it was deleted meanwhile.
+ *
+ * @param[in]  cbNode               Address to client callback node.
+ */
+void UnpinClientCB(ClientCB *cbNode);
+
 /**
  * This method is used to clear the cbList.
  */
 void DeleteClientCBList();
 
+/**
+ * This method is used to change the time to live of a cb node.
+ *
+ * @param[in]  cbNode               Address to client callback node.
+ * @param[in]  ttl                  New time to live in coap_ticks, 0 to disable the timeout.
+ */
+void UpdateClientCBTTL(ClientCB *cbNode, uint32_t ttl);
+
+/**
+ * This method is used to delete all cb nodes in cbList whose time to live has passed.
+ * Nodes are kept ordered by TTL, so only the expired nodes are visited.
+ */
+void DeleteTimedOutClientCBs();
+
+/**
+ * This method is used to get the time until the first cb node times out.
+ *
+ * @return  milliseconds until ::DeleteTimedOutClientCBs has work, UINT32_MAX if no
+ *          cb node has a time to live.
+ */
+uint32_t GetClientCBTimeoutDelay();
+
 /**
  * This method is used to search and retrieve a cb node in cbList using token.
  *
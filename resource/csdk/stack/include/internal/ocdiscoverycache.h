@@ -0,0 +1,126 @@
+//******************************************************************
+//
+// Copyright 2017 Intel Mobile Communications GmbH All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+/**
+ * @file
+ *
+ * This file contains the cache of encoded discovery (/oic/res) responses.
+ *
+ * A discovery response only depends on the resources of the stack, the query of the
+ * request, the accepted content format and the transport the request came in on. The
+ * encoded response is kept per combination of these, so repeated discovery requests
+ * are answered without walking the resource list and encoding the payload again.
+ * Any change to the resources or network interfaces invalidates the whole cache.
+ */
+
+#ifndef OC_DISCOVERY_CACHE_H_
+#define OC_DISCOVERY_CACHE_H_
+
+#include "octypes.h"
+#include "cacommon.h"
+#include "ocresourcehandler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Number of encoded responses kept, the least recently used one is replaced. */
+#define OC_DISCOVERY_CACHE_SIZE             (8)
+
+/** Larger responses are not cached. */
+#define OC_DISCOVERY_CACHE_MAX_PAYLOAD_SIZE (16384)
+
+/**
+ * Everything a discovery response depends on besides the resources themselves.
+ */
+typedef struct
+{
+    /** Type of the virtual resource requested. */
+    OCVirtualResources uri;
+    /** Interface filter of the request, may be NULL. */
+    const char *interfaceQuery;
+    /** Resource type filter of the request, may be NULL. */
+    const char *resourceTypeQuery;
+    /** Content format accepted by the requester. */
+    OCPayloadFormat acceptFormat;
+    /** Content format version accepted by the requester. */
+    uint16_t acceptVersion;
+    /** Address of the requester, selects the endpoints of the response. */
+    const OCDevAddr *devAddr;
+    /** Device ID reported in the response. */
+    const char *deviceId;
+    /** Local endpoints from CAGetNetworkInformation(). */
+    const CAEndpoint_t *networkInfo;
+    /** Number of local endpoints. */
+    size_t infoSize;
+} OCDiscoveryCacheKey;
+
+/**
+ * Initialize the discovery cache.
+ *
+ * @return ::OC_STACK_OK on success, some other value upon failure.
+ */
+OCStackResult OCDiscoveryCacheInit();
+
+/**
+ * Free all entries and the discovery cache itself.
+ */
+void OCDiscoveryCacheTerminate();
+
+/**
+ * Look up the encoded response for a discovery request.
+ *
+ * @param[in] key   Parameters of the request.
+ *
+ * @return Copy of the encoded response, wrapped in an ::OCSecurityPayload so it is sent as
+ *         is, or NULL if there is none. Caller shall free it with OCPayloadDestroy().
+ */
+OCPayload *OCDiscoveryCacheLookup(const OCDiscoveryCacheKey *key);
+
+/**
+ * Store the encoded response for a discovery request.
+ *
+ * @param[in] key           Parameters of the request.
+ * @param[in] payload       Encoded response.
+ * @param[in] payloadSize   Size of the encoded response.
+ *
+ * @return ::OC_STACK_OK on success, some other value upon failure.
+ */
+OCStackResult OCDiscoveryCacheStore(const OCDiscoveryCacheKey *key,
+                                    const uint8_t *payload, size_t payloadSize);
+
+/**
+ * Drop all cached responses. Called whenever the resources or their properties change.
+ */
+void OCDiscoveryCacheInvalidate();
+
+/**
+ * Get the number of lookups answered from the cache and of those which were not.
+ *
+ * @param[out] hits     Number of lookups that found a response.
+ * @param[out] misses   Number of lookups that did not.
+ */
+void OCDiscoveryCacheGetStats(uint32_t *hits, uint32_t *misses);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OC_DISCOVERY_CACHE_H_
@@ -137,6 +137,19 @@ OCStackResult SendAllObserverNotification (OCMethod method, OCResource *resPtr,
         OCQualityOfService qos);
 #endif
 
+/**
+ * Determine observe QOS based on the QOS of the request.
+ * The qos passed as a parameter overrides what the client requested.
+ *
+ * @param method           RESTful method.
+ * @param resourceObserver Observer.
+ * @param appQoS           Quality of service requested by the application.
+ *
+ * @return The quality of service of the notification for this observer.
+ */
+OCQualityOfService DetermineObserverQoS(OCMethod method,
+        ResourceObserver * resourceObserver, OCQualityOfService appQoS);
+
 /**
  * Notify specific observers with updated value of representation.
  *
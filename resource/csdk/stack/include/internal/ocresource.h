@@ -250,6 +250,12 @@ typedef struct OCResource {
 
     /** Resource endpoint type(s). */
     OCTpsSchemeFlags endpointType;
+
+    /** Number of pins keeping this resource allocated while the stack lock is released. */
+    uint32_t refCount;
+
+    /** Set when the resource was deleted while pinned; the last unpin frees it. */
+    bool deleted;
 } OCResource;
 
 /**
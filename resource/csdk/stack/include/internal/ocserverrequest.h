@@ -121,6 +121,21 @@ typedef struct OCServerRequest
     /** Payload format retrieved from the received request PDU. */
     OCPayloadFormat payloadFormat;
 
+    /** Further observers that receive the response of this notification (grouped mode).*/
+    OCObservationId *groupObserverIds;
+
+    /** Number of entries in groupObserverIds.*/
+    size_t numGroupObservers;
+
+    /** Quality of service requested by the application for a grouped notification.*/
+    OCQualityOfService groupQos;
+
+    /** Number of pins keeping this request allocated while an entity handler runs.*/
+    uint32_t refCount;
+
+    /** Set when the request was deleted while pinned; the last unpin frees it.*/
+    bool deleted;
+
     /** Payload Size.*/
     size_t payloadSize;
 
@@ -217,6 +232,23 @@ OCServerRequest * GetServerRequestUsingToken (const CAToken_t token, uint8_t tok
  */
 void DeleteServerRequest(OCServerRequest * serverRequest);
 
+/**
+ * Keep a server request allocated while an entity handler runs without the stack
+ * lock. DeleteServerRequest still removes a pinned request from the request list,
+ * but frees it only when the last pin is dropped.
+ *
+ * @param[in]  serverRequest    server request to pin, or NULL.
+ */
+void PinServerRequest(OCServerRequest * serverRequest);
+
+/**
+ * Drop a pin taken with PinServerRequest, freeing the request if it was deleted
+ * meanwhile.
+ *
+ * @param[in]  serverRequest    server request to unpin, or NULL.
+ */
+void UnpinServerRequest(OCServerRequest * serverRequest);
+
 /**
  * Handler function for sending a response from a single resource
  *
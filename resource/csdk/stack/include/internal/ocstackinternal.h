@@ -167,6 +167,72 @@ typedef uint8_t ServerID[16];
 
 OCStackResult OCStackFeedBack(CAToken_t token, uint8_t tokenLength, uint8_t status);
 
+/**
+ * Take the stack lock. It protects the resource, observer, server request and
+ * client callback lists against receive workers (see OCSetReceiveWorkerCount).
+ * The lock is recursive.
+ */
+void OCLockStack();
+
+/**
+ * Release the stack lock taken by OCLockStack.
+ */
+void OCUnlockStack();
+
+/**
+ * Release the stack lock completely before calling into the application, however
+ * often the calling thread holds it. Entity handlers and client callbacks run
+ * without the lock, so they may block on application locks that another thread
+ * holds while calling into the stack.
+ *
+ * @return Lock depth to pass to OCResumeStackLock.
+ */
+uint32_t OCSuspendStackLock();
+
+/**
+ * Take the stack lock again after OCSuspendStackLock.
+ *
+ * @param depth     Value returned by OCSuspendStackLock.
+ */
+void OCResumeStackLock(uint32_t depth);
+
+/**
+ * Keep a resource allocated while the stack lock is released. OCDeleteResource
+ * still removes a pinned resource from the resource list, but frees it only when
+ * the last pin is dropped. Must be called with the stack lock held.
+ *
+ * @param resource  Resource to pin, or NULL.
+ */
+void PinResource(OCResource *resource);
+
+/**
+ * Drop a pin taken with PinResource, freeing the resource if it was deleted
+ * meanwhile. Must be called with the stack lock held.
+ *
+ * @param resource  Resource to unpin, or NULL.
+ */
+void UnpinResource(OCResource *resource);
+
+/**
+ * Call the entity handler of a resource without the stack lock. The handler and
+ * its callback parameter are read, and the resource pinned, before the lock is
+ * released. Must be called with the stack lock held.
+ *
+ * @param resource  Resource whose entity handler is called.
+ * @param flag      Entity handler flag.
+ * @param ehRequest Request passed to the entity handler.
+ *
+ * @return Result of the entity handler, or ::OC_EH_ERROR if the resource has none.
+ */
+OCEntityHandlerResult OCCallEntityHandler(OCResource *resource, OCEntityHandlerFlag flag,
+                                          OCEntityHandlerRequest *ehRequest);
+
+/**
+ * Wake up the threads waiting on the events registered with OCRegisterProcessEvent,
+ * because OCProcessEvent has new work or an earlier deadline.
+ */
+void OCSignalProcessEvent();
+
 
 /**
  * Handler function to execute stack requests
@@ -178,6 +244,30 @@ OCStackResult OCStackFeedBack(CAToken_t token, uint8_t tokenLength, uint8_t stat
  */
 OCStackResult HandleStackRequests(OCServerProtocolRequest * protocolRequest);
 
+/**
+ * This function will be called back by CA layer when a response is received.
+ *
+ * @param endPoint CA remote endpoint.
+ * @param responseInfo CA response info.
+ */
+void HandleCAResponses(const CAEndpoint_t* endPoint, const CAResponseInfo_t* responseInfo);
+
+/**
+ * This function will be called back by CA layer when a request is received.
+ *
+ * @param endPoint CA remote endpoint.
+ * @param requestInfo CA request info.
+ */
+void HandleCARequests(const CAEndpoint_t* endPoint, const CARequestInfo_t* requestInfo);
+
+/**
+ * This function will be called back by CA layer when an error is received.
+ *
+ * @param endPoint CA remote endpoint.
+ * @param errorInfo CA error info.
+ */
+void HandleCAErrorResponse(const CAEndpoint_t *endPoint, const CAErrorInfo_t *errorInfo);
+
 OCStackResult SendDirectStackResponse(const CAEndpoint_t* endPoint, const uint16_t coapID,
         const CAResponseResult_t responseResult, const CAMessageType_t type,
         const uint8_t numOptions, const CAHeaderOption_t *options,
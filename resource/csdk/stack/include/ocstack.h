@@ -34,6 +34,8 @@
 
 #include "platform_features.h"
 
+struct oc_event_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif // __cplusplus
@@ -130,6 +132,75 @@ OCStackResult OC_CALL OCStopMulticastServer();
  */
 OCStackResult OC_CALL OCProcess();
 
+/**
+ * Event based alternative to polling ::OCProcess.
+ *
+ * Does the same processing as ::OCProcess and returns how long the caller may wait
+ * for an event registered with ::OCRegisterProcessEvent before calling it again.
+ * The event is signalled as soon as there is work to do earlier.
+ *
+ * @param nextEventTime    milliseconds until the next scheduled work, UINT32_MAX
+ *                         when nothing is scheduled.
+ *
+ * @return ::OC_STACK_OK on success, some other value upon failure.
+ */
+OCStackResult OC_CALL OCProcessEvent(uint32_t *nextEventTime);
+
+/**
+ * Register an event that is signalled when ::OCProcessEvent has work to do,
+ * for example because a message was received or a timeout is due earlier.
+ * Several events may be registered, for example one per processing thread;
+ * all of them are signalled.
+ *
+ * @param event    event to signal. The event must stay valid until it is
+ *                 unregistered with ::OCUnregisterProcessEvent.
+ *
+ * @return ::OC_STACK_OK on success, some other value upon failure.
+ */
+OCStackResult OC_CALL OCRegisterProcessEvent(struct oc_event_t *event);
+
+/**
+ * Unregister an event registered with ::OCRegisterProcessEvent. Other
+ * registered events are still signalled.
+ *
+ * @param event    event to unregister.
+ */
+void OC_CALL OCUnregisterProcessEvent(struct oc_event_t *event);
+
+/**
+ * Register a response handler that decodes representation payloads itself.
+ *
+ * Responses with a representation payload are passed to this handler undecoded, in
+ * OCClientResponse::rawPayload, and OCClientResponse::payload is NULL. This avoids
+ * building an ::OCRepPayload that the handler only converts into its own types.
+ * Responses to batch interface requests are always decoded.
+ *
+ * @param handler    response handler passed in ::OCCallbackData.
+ *
+ * @return ::OC_STACK_OK on success, some other value upon failure.
+ */
+OCStackResult OC_CALL OCRegisterRawPayloadHandler(OCClientResponseHandler handler);
+
+/**
+ * Set the number of worker threads that handle incoming requests and responses.
+ *
+ * With workers, received messages are no longer handled from ::OCProcess. They are
+ * dispatched to the workers instead, so receiving and parsing messages from different
+ * endpoints runs in parallel. Messages from the same endpoint with the same token are
+ * always handled in order by the same worker. Entity handlers and client response
+ * callbacks are called without the stack lock, so they may run in parallel, also for
+ * the same resource or request (e.g. responses to a multicast discovery), and must be
+ * safe to call from several threads at once. A handle may be deleted by another thread
+ * while its handler runs; the stack keeps it allocated until the handler returns.
+ * This must be called before OCInit. The default is 0, which handles everything
+ * from ::OCProcess.
+ *
+ * @param count    number of workers.
+ *
+ * @return ::OC_STACK_OK on success, some other value upon failure.
+ */
+OCStackResult OC_CALL OCSetReceiveWorkerCount(uint8_t count);
+
 /**
  * This function discovers or Perform requests on a specified resource
  * (specified by that Resource's respective URI).
@@ -609,6 +680,22 @@ OCEntityHandler OC_CALL OCGetResourceHandler(OCResourceHandle handle);
  */
 OCStackResult OC_CALL OCNotifyAllObservers(OCResourceHandle handle, OCQualityOfService qos);
 
+/**
+ * Enable or disable grouped observer notifications for OCNotifyAllObservers().
+ *
+ * When enabled, observers of a resource are grouped by accept format, accept version and
+ * query. The entity handler is called once per group, the payload is encoded once and the
+ * same response is sent to every member of the group with its own token and message type.
+ * The entity handler only sees the first observer of each group, so it must not tailor the
+ * notification payload to the requesting endpoint. Collection resources are always
+ * notified per observer. Disabled by default and reset by ::OCStop.
+ *
+ * @param enable   true to group notifications, false to notify each observer separately.
+ *
+ * @return ::OC_STACK_OK on success, some other value upon failure.
+ */
+OCStackResult OC_CALL OCSetGroupedObserverNotification(bool enable);
+
 /**
  * Notify specific observers with updated value of representation.
  * Before this API is invoked by entity handler it has finished processing
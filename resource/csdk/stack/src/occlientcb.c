@@ -20,6 +20,7 @@
 
 #include "iotivity_config.h"
 #include "occlientcb.h"
+#include "ocstackinternal.h"
 #include <coap/coap.h>
 #include "logger.h"
 #include "trace.h"
@@ -35,6 +36,7 @@
 
 #include "cacommon.h"
 #include "cainterface.h"
+#include "uhashmap.h"
 
 /// Module Name
 #define TAG "OIC_RI_CLIENTCB"
@@ -46,20 +48,149 @@
 //      This should be static variable after we make a presence feature separately.
 struct ClientCB *g_cbList = NULL;
 
+/** Index of g_cbList keyed by token bytes. */
+static u_hashmap_t *g_cbTokenMap = NULL;
+
+/** Index of g_cbList keyed by invocation handle. */
+static u_hashmap_t *g_cbHandleMap = NULL;
+
+/** Set of live nodes keyed by node address, used to validate DeleteClientCB() arguments. */
+static u_hashmap_t *g_cbNodeMap = NULL;
+
+/** Binary min-heap of the nodes with a non-zero TTL, ordered by TTL. */
+static ClientCB **g_cbTimeoutHeap = NULL;
+static size_t g_cbTimeoutHeapSize = 0;
+static size_t g_cbTimeoutHeapCapacity = 0;
+
 //-------------------------------------------------------------------------------------------------
 // Local functions
 //-------------------------------------------------------------------------------------------------
-static void DeleteClientCBInternal(ClientCB * cbNode)
+static bool InitClientCBMaps()
+{
+    if (g_cbTokenMap && g_cbHandleMap && g_cbNodeMap)
+    {
+        return true;
+    }
+
+    if (!g_cbTokenMap)
+    {
+        g_cbTokenMap = u_hashmap_create(0);
+    }
+    if (!g_cbHandleMap)
+    {
+        g_cbHandleMap = u_hashmap_create(0);
+    }
+    if (!g_cbNodeMap)
+    {
+        g_cbNodeMap = u_hashmap_create(0);
+    }
+    return g_cbTokenMap && g_cbHandleMap && g_cbNodeMap;
+}
+
+static void SwapTimeoutHeapNodes(size_t a, size_t b)
+{
+    ClientCB *tmp = g_cbTimeoutHeap[a];
+    g_cbTimeoutHeap[a] = g_cbTimeoutHeap[b];
+    g_cbTimeoutHeap[b] = tmp;
+    g_cbTimeoutHeap[a]->timeoutIndex = a;
+    g_cbTimeoutHeap[b]->timeoutIndex = b;
+}
+
+static void SiftUpTimeoutHeap(size_t index)
+{
+    while (index > 0)
+    {
+        size_t parent = (index - 1) / 2;
+        if (g_cbTimeoutHeap[parent]->TTL <= g_cbTimeoutHeap[index]->TTL)
+        {
+            break;
+        }
+        SwapTimeoutHeapNodes(parent, index);
+        index = parent;
+    }
+}
+
+static void SiftDownTimeoutHeap(size_t index)
+{
+    for (;;)
+    {
+        size_t smallest = index;
+        size_t left = (2 * index) + 1;
+        size_t right = left + 1;
+
+        if (left < g_cbTimeoutHeapSize
+            && g_cbTimeoutHeap[left]->TTL < g_cbTimeoutHeap[smallest]->TTL)
+        {
+            smallest = left;
+        }
+        if (right < g_cbTimeoutHeapSize
+            && g_cbTimeoutHeap[right]->TTL < g_cbTimeoutHeap[smallest]->TTL)
+        {
+            smallest = right;
+        }
+        if (smallest == index)
+        {
+            break;
+        }
+        SwapTimeoutHeapNodes(smallest, index);
+        index = smallest;
+    }
+}
+
+static bool InsertTimeoutHeap(ClientCB *cbNode)
 {
     assert(cbNode);
+    assert(CB_NO_TIMEOUT_INDEX == cbNode->timeoutIndex);
 
-    OIC_TRACE_BEGIN(%s:DeleteClientCB, TAG);
-    OIC_LOG(INFO, TAG, "Deleting token");
-    OIC_LOG_BUFFER(INFO, TAG, (const uint8_t *)cbNode->token, cbNode->tokenLength);
-    OIC_TRACE_BUFFER("OIC_RI_CLIENTCB:DeleteClientCB:token:",
-                     (const uint8_t *)cbNode->token, cbNode->tokenLength);
+    if (g_cbTimeoutHeapSize == g_cbTimeoutHeapCapacity)
+    {
+        size_t newCapacity = g_cbTimeoutHeapCapacity ? (g_cbTimeoutHeapCapacity * 2) : 16;
+        ClientCB **tmp = (ClientCB **) OICRealloc(g_cbTimeoutHeap,
+                                                  newCapacity * sizeof(g_cbTimeoutHeap[0]));
+        if (!tmp)
+        {
+            OIC_LOG(ERROR, TAG, "Failed to grow timeout heap");
+            return false;
+        }
+        g_cbTimeoutHeap = tmp;
+        g_cbTimeoutHeapCapacity = newCapacity;
+    }
 
-    LL_DELETE(g_cbList, cbNode);
+    cbNode->timeoutIndex = g_cbTimeoutHeapSize;
+    g_cbTimeoutHeap[g_cbTimeoutHeapSize++] = cbNode;
+    SiftUpTimeoutHeap(cbNode->timeoutIndex);
+
+    if (0 == cbNode->timeoutIndex)
+    {
+        // the first timeout is due earlier now.
+        OCSignalProcessEvent();
+    }
+    return true;
+}
+
+static void RemoveTimeoutHeap(ClientCB *cbNode)
+{
+    assert(cbNode);
+
+    size_t index = cbNode->timeoutIndex;
+    if (CB_NO_TIMEOUT_INDEX == index)
+    {
+        return;
+    }
+
+    size_t last = --g_cbTimeoutHeapSize;
+    if (index != last)
+    {
+        g_cbTimeoutHeap[index] = g_cbTimeoutHeap[last];
+        g_cbTimeoutHeap[index]->timeoutIndex = index;
+        SiftDownTimeoutHeap(index);
+        SiftUpTimeoutHeap(index);
+    }
+    cbNode->timeoutIndex = CB_NO_TIMEOUT_INDEX;
+}
+
+static void FreeClientCB(ClientCB * cbNode)
+{
     CADestroyToken(cbNode->token);
     OICFree(cbNode->devAddr);
     OICFree(cbNode->handle);
@@ -104,33 +235,38 @@ static void DeleteClientCBInternal(ClientCB * cbNode)
 
     OICFree(cbNode);
     cbNode = NULL;
-
-    OIC_TRACE_END();
 }
 
-/*
- * This function checks if the node is past its time to live and
- * deletes it if timed-out. Calling this function with a  presence or observe
- * callback with ttl set to 0 will not delete anything as presence nodes have
- * their own mechanisms for timeouts. A null argument will cause the function to
- * silently return.
- */
-static void CheckAndDeleteTimedOutCB(ClientCB * cbNode)
+static void DeleteClientCBInternal(ClientCB * cbNode)
 {
     assert(cbNode);
 
-    if (cbNode->TTL == 0)
+    OIC_TRACE_BEGIN(%s:DeleteClientCB, TAG);
+    OIC_LOG(INFO, TAG, "Deleting token");
+    OIC_LOG_BUFFER(INFO, TAG, (const uint8_t *)cbNode->token, cbNode->tokenLength);
+    OIC_TRACE_BUFFER("OIC_RI_CLIENTCB:DeleteClientCB:token:",
+                     (const uint8_t *)cbNode->token, cbNode->tokenLength);
+
+    LL_DELETE(g_cbList, cbNode);
+    RemoveTimeoutHeap(cbNode);
+    if (cbNode == u_hashmap_get(g_cbTokenMap, cbNode->token, cbNode->tokenLength))
     {
-        return;
+        u_hashmap_remove(g_cbTokenMap, cbNode->token, cbNode->tokenLength);
     }
-    coap_tick_t now;
-    coap_ticks(&now);
+    u_hashmap_remove(g_cbHandleMap, &cbNode->handle, sizeof(cbNode->handle));
+    u_hashmap_remove(g_cbNodeMap, &cbNode, sizeof(cbNode));
 
-    if (cbNode->TTL < now)
+    if (cbNode->refCount)
     {
-        OIC_LOG(INFO, TAG, "Deleting timed-out callback");
-        DeleteClientCBInternal(cbNode);
+        // Its callback is still running; the last UnpinClientCB frees the node.
+        cbNode->deleted = true;
     }
+    else
+    {
+        FreeClientCB(cbNode);
+    }
+
+    OIC_TRACE_END();
 }
 
 #ifdef WITH_PRESENCE
@@ -190,6 +326,12 @@ OCStackResult AddClientCB(ClientCB** clientCB, OCCallbackData* cbData,
     if (!cbNode)// If it does not already exist, create new node.
 #endif // WITH_PRESENCE
     {
+        if (!InitClientCBMaps())
+        {
+            *clientCB = NULL;
+            goto exit;
+        }
+
         cbNode = (ClientCB*) OICMalloc(sizeof(ClientCB));
         if (!cbNode)
         {
@@ -271,8 +413,31 @@ OCStackResult AddClientCB(ClientCB** clientCB, OCCallbackData* cbData,
         {
             cbNode->TTL = ttl;
         }
+        cbNode->timeoutIndex = CB_NO_TIMEOUT_INDEX;
+        cbNode->refCount = 0;
+        cbNode->deleted = false;
         cbNode->requestUri = requestUri;    // I own it now
         cbNode->devAddr = devAddr;          // I own it now
+
+        if (!u_hashmap_put(g_cbTokenMap, token, tokenLength, cbNode)
+            || !u_hashmap_put(g_cbHandleMap, &cbNode->handle, sizeof(cbNode->handle), cbNode)
+            || !u_hashmap_put(g_cbNodeMap, &cbNode, sizeof(cbNode), cbNode)
+            || (cbNode->TTL && !InsertTimeoutHeap(cbNode)))
+        {
+            OIC_LOG(ERROR, TAG, "Failed to index callback");
+            if (cbNode == u_hashmap_get(g_cbTokenMap, token, tokenLength))
+            {
+                u_hashmap_remove(g_cbTokenMap, token, tokenLength);
+            }
+            u_hashmap_remove(g_cbHandleMap, &cbNode->handle, sizeof(cbNode->handle));
+            u_hashmap_remove(g_cbNodeMap, &cbNode, sizeof(cbNode));
+            OICFree(cbNode->options);
+            OICFree(cbNode->payload);
+            OICFree(cbNode);
+            *clientCB = NULL;
+            goto exit;
+        }
+
         OIC_LOG_V(INFO, TAG, "Added Callback for uri : %s", requestUri);
         OIC_TRACE_MARK(%s:AddClientCB:uri:%s, TAG, requestUri);
         LL_APPEND(g_cbList, cbNode);
@@ -321,19 +486,34 @@ exit:
 }
 
 void DeleteClientCB(ClientCB * cbNode)
+{
+    // The node may already have been deleted from within an application callback.
+    if (cbNode && u_hashmap_contains(g_cbNodeMap, &cbNode, sizeof(cbNode)))
+    {
+        DeleteClientCBInternal(cbNode);
+    }
+}
+
+void PinClientCB(ClientCB *cbNode)
 {
     if (cbNode)
     {
-        ClientCB* out = NULL;
-        ClientCB* tmp = NULL;
-        LL_FOREACH_SAFE(g_cbList, out, tmp)
-        {
-            if (cbNode == out)
-            {
-                DeleteClientCBInternal(out);
-                break;
-            }
-        }
+        cbNode->refCount++;
+    }
+}
+
+void UnpinClientCB(ClientCB *cbNode)
+{
+    if (!cbNode)
+    {
+        return;
+    }
+
+    assert(cbNode->refCount);
+    cbNode->refCount--;
+    if (!cbNode->refCount && cbNode->deleted)
+    {
+        FreeClientCB(cbNode);
     }
 }
 
@@ -346,6 +526,67 @@ void DeleteClientCBList()
         DeleteClientCBInternal(out);
     }
     g_cbList = NULL;
+
+    u_hashmap_free(&g_cbTokenMap);
+    u_hashmap_free(&g_cbHandleMap);
+    u_hashmap_free(&g_cbNodeMap);
+    OICFree(g_cbTimeoutHeap);
+    g_cbTimeoutHeap = NULL;
+    g_cbTimeoutHeapSize = 0;
+    g_cbTimeoutHeapCapacity = 0;
+}
+
+void UpdateClientCBTTL(ClientCB *cbNode, uint32_t ttl)
+{
+    if (!cbNode)
+    {
+        return;
+    }
+
+    RemoveTimeoutHeap(cbNode);
+    cbNode->TTL = ttl;
+    if (ttl && !InsertTimeoutHeap(cbNode))
+    {
+        // Without a heap slot the node can only be removed explicitly.
+        OIC_LOG(ERROR, TAG, "Callback will not time out");
+    }
+}
+
+void DeleteTimedOutClientCBs()
+{
+    if (!g_cbTimeoutHeapSize)
+    {
+        return;
+    }
+
+    coap_tick_t now;
+    coap_ticks(&now);
+
+    while (g_cbTimeoutHeapSize && g_cbTimeoutHeap[0]->TTL < now)
+    {
+        OIC_LOG(INFO, TAG, "Deleting timed-out callback");
+        DeleteClientCBInternal(g_cbTimeoutHeap[0]);
+    }
+}
+
+uint32_t GetClientCBTimeoutDelay()
+{
+    if (!g_cbTimeoutHeapSize)
+    {
+        return UINT32_MAX;
+    }
+
+    coap_tick_t now;
+    coap_ticks(&now);
+
+    // a node is deleted once its TTL has passed.
+    coap_tick_t ttl = g_cbTimeoutHeap[0]->TTL;
+    if (ttl < now)
+    {
+        return 0;
+    }
+    uint64_t delay = ((uint64_t)(ttl - now + 1) * MILLISECONDS_PER_SECOND) / COAP_TICKS_PER_SECOND;
+    return (delay < UINT32_MAX) ? (uint32_t)delay : UINT32_MAX;
 }
 
 ClientCB* GetClientCBUsingToken(const CAToken_t token,
@@ -360,18 +601,11 @@ ClientCB* GetClientCBUsingToken(const CAToken_t token,
     OIC_LOG (INFO, TAG, "Looking for token");
     OIC_LOG_BUFFER(INFO, TAG, (const uint8_t *)token, tokenLength);
 
-    ClientCB* out = NULL;
-    ClientCB* tmp = NULL;
-    LL_FOREACH_SAFE(g_cbList, out, tmp)
+    ClientCB* out = (ClientCB *) u_hashmap_get(g_cbTokenMap, token, tokenLength);
+    if (out)
     {
-        /* de-annotate below line if want to see all token in g_cbList */
-        //OIC_LOG_BUFFER(INFO, TAG, (const uint8_t *)out->token, tokenLength);
-        if (memcmp(out->token, token, tokenLength) == 0)
-        {
-            OIC_LOG(INFO, TAG, "Found in callback list");
-            return out;
-        }
-        CheckAndDeleteTimedOutCB(out);
+        OIC_LOG(INFO, TAG, "Found in callback list");
+        return out;
     }
 
     OIC_LOG(INFO, TAG, "Callback Not found!");
@@ -388,16 +622,11 @@ ClientCB* GetClientCBUsingHandle(const OCDoHandle handle)
 
     OIC_LOG(INFO, TAG,  "Looking for handle");
 
-    ClientCB* out = NULL;
-    ClientCB* tmp = NULL;
-    LL_FOREACH_SAFE(g_cbList, out, tmp)
+    ClientCB* out = (ClientCB *) u_hashmap_get(g_cbHandleMap, &handle, sizeof(handle));
+    if (out)
     {
-        if (out->handle == handle)
-        {
-            OIC_LOG(INFO, TAG, "Found in callback list");
-            return out;
-        }
-        CheckAndDeleteTimedOutCB(out);
+        OIC_LOG(INFO, TAG, "Found in callback list");
+        return out;
     }
 
     OIC_LOG(INFO, TAG, "Callback Not found!");
@@ -426,7 +655,6 @@ ClientCB* GetClientCBUsingUri(const char *requestUri)
             OIC_LOG(INFO, TAG, "Found in callback list");
             return out;
         }
-        CheckAndDeleteTimedOutCB(out);
     }
 
     OIC_LOG(INFO, TAG, "Callback Not found!");
@@ -211,39 +211,65 @@ static OCStackResult HandleBatchInterface(OCEntityHandlerRequest *ehRequest)
             OIC_LOG_V(DEBUG, TAG, "Query : %s", ehRequest->query);
         }
 
-        uint8_t numRes = 0;
+        // The child entity handlers run without the stack lock, so the children may be
+        // unbound or deleted meanwhile. Pin them up front.
+        size_t numChildren = 0;
         for (OCChildResource *tempChildResource = collResource->rsrcChildResourcesHead;
-            tempChildResource; tempChildResource = tempChildResource->next, numRes++)
+            tempChildResource && tempChildResource->rsrcResource;
+            tempChildResource = tempChildResource->next)
         {
-            OCResource* tempRsrcResource = tempChildResource->rsrcResource;
-            if (tempRsrcResource)
+            numChildren++;
+        }
+
+        OCResource **children = NULL;
+        if (numChildren)
+        {
+            children = (OCResource **) OICMalloc(numChildren * sizeof(*children));
+            if (!children)
             {
-                // Note that all entity handlers called through a collection
-                // will get the same pointer to ehRequest, the only difference
-                // is ehRequest->resource
-                ehRequest->resource = (OCResourceHandle) tempRsrcResource;
-                OCEntityHandlerResult ehResult = tempRsrcResource->entityHandler(OC_REQUEST_FLAG,
-                                           ehRequest, tempRsrcResource->entityHandlerCallbackParam);
-
-                // The default collection handler is returning as OK
-                if (stackRet != OC_STACK_SLOW_RESOURCE)
-                {
-                    stackRet = OC_STACK_OK;
-                }
-                // if a single resource is slow, then entire response will be treated
-                // as slow response
-                if (ehResult == OC_EH_SLOW)
-                {
-                    OIC_LOG(INFO, TAG, "This is a slow resource");
-                    ((OCServerRequest *)ehRequest->requestHandle)->slowFlag = 1;
-                    stackRet = EntityHandlerCodeToOCStackCode(ehResult);
-                }
+                ehRequest->query = storeQuery;
+                return OC_STACK_NO_MEMORY;
             }
-            else
+        }
+
+        size_t numRes = 0;
+        for (OCChildResource *tempChildResource = collResource->rsrcChildResourcesHead;
+            numRes < numChildren; tempChildResource = tempChildResource->next, numRes++)
+        {
+            children[numRes] = tempChildResource->rsrcResource;
+            PinResource(children[numRes]);
+        }
+
+        for (numRes = 0; numRes < numChildren; numRes++)
+        {
+            OCResource* tempRsrcResource = children[numRes];
+            // Note that all entity handlers called through a collection
+            // will get the same pointer to ehRequest, the only difference
+            // is ehRequest->resource
+            ehRequest->resource = (OCResourceHandle) tempRsrcResource;
+            OCEntityHandlerResult ehResult = OCCallEntityHandler(tempRsrcResource,
+                                                                 OC_REQUEST_FLAG, ehRequest);
+
+            // The default collection handler is returning as OK
+            if (stackRet != OC_STACK_SLOW_RESOURCE)
             {
-                break;
+                stackRet = OC_STACK_OK;
             }
+            // if a single resource is slow, then entire response will be treated
+            // as slow response
+            if (ehResult == OC_EH_SLOW)
+            {
+                OIC_LOG(INFO, TAG, "This is a slow resource");
+                ((OCServerRequest *)ehRequest->requestHandle)->slowFlag = 1;
+                stackRet = EntityHandlerCodeToOCStackCode(ehResult);
+            }
+        }
+
+        for (numRes = 0; numRes < numChildren; numRes++)
+        {
+            UnpinResource(children[numRes]);
         }
+        OICFree(children);
         ehRequest->resource = (OCResourceHandle) collResource;
     }
     ehRequest->query = storeQuery;
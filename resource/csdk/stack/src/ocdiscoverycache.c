@@ -0,0 +1,308 @@
+//******************************************************************
+//
+// Copyright 2017 Intel Mobile Communications GmbH All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include "ocdiscoverycache.h"
+#include <string.h>
+#include "ocpayload.h"
+#include "octhread.h"
+#include "oic_malloc.h"
+#include "oic_string.h"
+#include "logger.h"
+
+#define TAG "OIC_RI_DISCOVERYCACHE"
+
+#define FNV_OFFSET_BASIS (2166136261U)
+#define FNV_PRIME        (16777619U)
+
+typedef struct
+{
+    uint8_t *payload;               /**< Encoded response, NULL if the entry is unused. */
+    size_t payloadSize;
+    uint32_t lastUsed;
+    OCVirtualResources uri;
+    char *interfaceQuery;
+    char *resourceTypeQuery;
+    OCPayloadFormat acceptFormat;
+    uint16_t acceptVersion;
+    OCTransportAdapter adapter;
+    OCTransportFlags flags;
+    uint32_t ifindex;
+    char *deviceId;
+    uint32_t networkHash;
+} OCDiscoveryCacheEntry;
+
+static oc_mutex g_discoveryCacheMutex = NULL;
+static OCDiscoveryCacheEntry g_discoveryCache[OC_DISCOVERY_CACHE_SIZE];
+static uint32_t g_discoveryCacheClock = 0;
+static uint32_t g_discoveryCacheHits = 0;
+static uint32_t g_discoveryCacheMisses = 0;
+
+static uint32_t HashBytes(uint32_t hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/*
+ * Hash the fields of the endpoints that end up in the response, a change of the network
+ * interfaces changes the hash.
+ */
+static uint32_t HashNetworkInfo(const CAEndpoint_t *networkInfo, size_t infoSize)
+{
+    uint32_t hash = FNV_OFFSET_BASIS;
+    for (size_t i = 0; networkInfo && i < infoSize; i++)
+    {
+        const CAEndpoint_t *info = networkInfo + i;
+        hash = HashBytes(hash, &info->adapter, sizeof(info->adapter));
+        hash = HashBytes(hash, &info->flags, sizeof(info->flags));
+        hash = HashBytes(hash, &info->port, sizeof(info->port));
+        hash = HashBytes(hash, &info->ifindex, sizeof(info->ifindex));
+        hash = HashBytes(hash, info->addr, strnlen(info->addr, sizeof(info->addr)));
+    }
+    return hash;
+}
+
+static bool StringsEqual(const char *a, const char *b)
+{
+    if (!a || !b)
+    {
+        return a == b;
+    }
+    return 0 == strcmp(a, b);
+}
+
+static OCTransportFlags KeyFlags(const OCDevAddr *devAddr)
+{
+    // unicast and multicast requests get the same response.
+    return (OCTransportFlags)(devAddr->flags & ~OC_MULTICAST);
+}
+
+static bool EntryMatches(const OCDiscoveryCacheEntry *entry, const OCDiscoveryCacheKey *key,
+                         uint32_t networkHash)
+{
+    return entry->payload &&
+           entry->uri == key->uri &&
+           entry->acceptFormat == key->acceptFormat &&
+           entry->acceptVersion == key->acceptVersion &&
+           entry->adapter == key->devAddr->adapter &&
+           entry->flags == KeyFlags(key->devAddr) &&
+           entry->ifindex == key->devAddr->ifindex &&
+           entry->networkHash == networkHash &&
+           StringsEqual(entry->interfaceQuery, key->interfaceQuery) &&
+           StringsEqual(entry->resourceTypeQuery, key->resourceTypeQuery) &&
+           StringsEqual(entry->deviceId, key->deviceId);
+}
+
+static void ClearEntry(OCDiscoveryCacheEntry *entry)
+{
+    OICFree(entry->payload);
+    OICFree(entry->interfaceQuery);
+    OICFree(entry->resourceTypeQuery);
+    OICFree(entry->deviceId);
+    memset(entry, 0, sizeof(*entry));
+}
+
+static void ClearAllEntries()
+{
+    for (size_t i = 0; i < OC_DISCOVERY_CACHE_SIZE; i++)
+    {
+        ClearEntry(&g_discoveryCache[i]);
+    }
+}
+
+OCStackResult OCDiscoveryCacheInit()
+{
+    if (!g_discoveryCacheMutex)
+    {
+        g_discoveryCacheMutex = oc_mutex_new();
+        if (!g_discoveryCacheMutex)
+        {
+            OIC_LOG(ERROR, TAG, "Failed to create mutex");
+            return OC_STACK_ERROR;
+        }
+    }
+    return OC_STACK_OK;
+}
+
+void OCDiscoveryCacheTerminate()
+{
+    if (!g_discoveryCacheMutex)
+    {
+        return;
+    }
+
+    ClearAllEntries();
+    OIC_LOG_V(INFO, TAG, "Discovery cache hits: %u, misses: %u",
+              g_discoveryCacheHits, g_discoveryCacheMisses);
+    g_discoveryCacheHits = 0;
+    g_discoveryCacheMisses = 0;
+
+    oc_mutex_free(g_discoveryCacheMutex);
+    g_discoveryCacheMutex = NULL;
+}
+
+OCPayload *OCDiscoveryCacheLookup(const OCDiscoveryCacheKey *key)
+{
+    if (!key || !key->devAddr || !g_discoveryCacheMutex)
+    {
+        return NULL;
+    }
+
+    uint32_t networkHash = HashNetworkInfo(key->networkInfo, key->infoSize);
+    OCPayload *payload = NULL;
+
+    oc_mutex_lock(g_discoveryCacheMutex);
+    for (size_t i = 0; i < OC_DISCOVERY_CACHE_SIZE; i++)
+    {
+        OCDiscoveryCacheEntry *entry = &g_discoveryCache[i];
+        if (EntryMatches(entry, key, networkHash))
+        {
+            entry->lastUsed = ++g_discoveryCacheClock;
+            payload = (OCPayload *)OCSecurityPayloadCreate(entry->payload, entry->payloadSize);
+            break;
+        }
+    }
+
+    if (payload)
+    {
+        g_discoveryCacheHits++;
+    }
+    else
+    {
+        g_discoveryCacheMisses++;
+    }
+    OIC_LOG_V(DEBUG, TAG, "Discovery cache %s (hits: %u, misses: %u)", payload ? "hit" : "miss",
+              g_discoveryCacheHits, g_discoveryCacheMisses);
+    oc_mutex_unlock(g_discoveryCacheMutex);
+
+    return payload;
+}
+
+OCStackResult OCDiscoveryCacheStore(const OCDiscoveryCacheKey *key,
+                                    const uint8_t *payload, size_t payloadSize)
+{
+    if (!key || !key->devAddr || !payload || !payloadSize)
+    {
+        return OC_STACK_INVALID_PARAM;
+    }
+    if (!g_discoveryCacheMutex)
+    {
+        return OC_STACK_ERROR;
+    }
+    if (payloadSize > OC_DISCOVERY_CACHE_MAX_PAYLOAD_SIZE)
+    {
+        OIC_LOG_V(DEBUG, TAG, "Discovery response of %zu bytes not cached", payloadSize);
+        return OC_STACK_ERROR;
+    }
+
+    OCDiscoveryCacheEntry entry = { .payload = NULL };
+    entry.payload = (uint8_t *)OICMalloc(payloadSize);
+    entry.interfaceQuery = key->interfaceQuery ? OICStrdup(key->interfaceQuery) : NULL;
+    entry.resourceTypeQuery = key->resourceTypeQuery ? OICStrdup(key->resourceTypeQuery) : NULL;
+    entry.deviceId = key->deviceId ? OICStrdup(key->deviceId) : NULL;
+    if (!entry.payload ||
+        (key->interfaceQuery && !entry.interfaceQuery) ||
+        (key->resourceTypeQuery && !entry.resourceTypeQuery) ||
+        (key->deviceId && !entry.deviceId))
+    {
+        OIC_LOG(ERROR, TAG, "Failed to allocate discovery cache entry");
+        ClearEntry(&entry);
+        return OC_STACK_NO_MEMORY;
+    }
+
+    memcpy(entry.payload, payload, payloadSize);
+    entry.payloadSize = payloadSize;
+    entry.uri = key->uri;
+    entry.acceptFormat = key->acceptFormat;
+    entry.acceptVersion = key->acceptVersion;
+    entry.adapter = key->devAddr->adapter;
+    entry.flags = KeyFlags(key->devAddr);
+    entry.ifindex = key->devAddr->ifindex;
+    entry.networkHash = HashNetworkInfo(key->networkInfo, key->infoSize);
+
+    oc_mutex_lock(g_discoveryCacheMutex);
+
+    // replace an entry for the same request, else an unused or the least recently used one.
+    OCDiscoveryCacheEntry *victim = &g_discoveryCache[0];
+    for (size_t i = 0; i < OC_DISCOVERY_CACHE_SIZE; i++)
+    {
+        OCDiscoveryCacheEntry *candidate = &g_discoveryCache[i];
+        if (EntryMatches(candidate, key, entry.networkHash))
+        {
+            victim = candidate;
+            break;
+        }
+        if (victim->payload &&
+            (!candidate->payload || candidate->lastUsed < victim->lastUsed))
+        {
+            victim = candidate;
+        }
+    }
+
+    ClearEntry(victim);
+    entry.lastUsed = ++g_discoveryCacheClock;
+    *victim = entry;
+
+    oc_mutex_unlock(g_discoveryCacheMutex);
+    return OC_STACK_OK;
+}
+
+void OCDiscoveryCacheInvalidate()
+{
+    if (!g_discoveryCacheMutex)
+    {
+        return;
+    }
+
+    oc_mutex_lock(g_discoveryCacheMutex);
+    ClearAllEntries();
+    oc_mutex_unlock(g_discoveryCacheMutex);
+}
+
+void OCDiscoveryCacheGetStats(uint32_t *hits, uint32_t *misses)
+{
+    if (!g_discoveryCacheMutex)
+    {
+        if (hits)
+        {
+            *hits = 0;
+        }
+        if (misses)
+        {
+            *misses = 0;
+        }
+        return;
+    }
+
+    oc_mutex_lock(g_discoveryCacheMutex);
+    if (hits)
+    {
+        *hits = g_discoveryCacheHits;
+    }
+    if (misses)
+    {
+        *misses = g_discoveryCacheMisses;
+    }
+    oc_mutex_unlock(g_discoveryCacheMutex);
+}
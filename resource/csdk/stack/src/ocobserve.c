@@ -42,6 +42,11 @@
 
 #define VERIFY_NON_NULL(arg) { if (!arg) {OIC_LOG(FATAL, TAG, #arg " is NULL"); goto exit;} }
 
+/**
+ * Whether OCNotifyAllObservers() groups observers sharing format, version and query.
+ */
+static bool g_groupedNotification = false;
+
 /**
  * Determine observe QOS based on the QOS of the request.
  * The qos passed as a parameter overrides what the client requested.
@@ -53,7 +58,7 @@
  * @param appQoS Quality of service.
  * @return The quality of service of the observer.
  */
-static OCQualityOfService DetermineObserverQoS(OCMethod method,
+OCQualityOfService DetermineObserverQoS(OCMethod method,
         ResourceObserver * resourceObserver, OCQualityOfService appQoS)
 {
     if (!resourceObserver)
@@ -100,12 +105,19 @@ static OCQualityOfService DetermineObserverQoS(OCMethod method,
  *
  * @param observer Observer that need to be notified.
  * @param qos Quality of service of resource.
+ * @param groupIds Further observers that receive the same response, or NULL.
+ *                 Ownership is taken in all cases.
+ * @param numGroupIds Number of entries in groupIds.
+ * @param groupQos Quality of service requested by the application for the group.
  *
  * @return ::OC_STACK_OK on success, some other value upon failure.
  */
 static OCStackResult SendObserveNotification(ResourceObserver *observer,
                                              uint32_t sequenceNum,
-                                             OCQualityOfService qos)
+                                             OCQualityOfService qos,
+                                             OCObservationId *groupIds,
+                                             size_t numGroupIds,
+                                             OCQualityOfService groupQos)
 {
     OCStackResult result = OC_STACK_ERROR;
     OCServerRequest * request = NULL;
@@ -117,8 +129,15 @@ static OCStackResult SendObserveNotification(ResourceObserver *observer,
                               observer->resUri, 0, observer->acceptFormat,
                               observer->acceptVersion, &observer->devAddr);
 
-    if (request)
+    if (!request)
     {
+        OICFree(groupIds);
+    }
+    else
+    {
+        request->groupObserverIds = groupIds;
+        request->numGroupObservers = numGroupIds;
+        request->groupQos = groupQos;
         request->observeResult = OC_STACK_OK;
         if (result == OC_STACK_OK)
         {
@@ -127,16 +146,172 @@ static OCStackResult SendObserveNotification(ResourceObserver *observer,
             result = DetermineResourceHandling (request, &resHandling, &resource);
             if (result == OC_STACK_OK)
             {
-                result = ProcessRequest(resHandling, resource, request);
-                // Reset Observer TTL.
+                // Reset Observer TTL. The entity handler runs without the stack lock
+                // and may cancel the observation, so observer is not used afterwards.
                 observer->TTL = GetTicks(MAX_OBSERVER_TTL_SECONDS * MILLISECONDS_PER_SECOND);
+                result = ProcessRequest(resHandling, resource, request);
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Check whether two observers can share one notification response.
+ */
+static bool IsSameNotificationGroup(const ResourceObserver *a, const ResourceObserver *b)
+{
+    if (a->acceptFormat != b->acceptFormat || a->acceptVersion != b->acceptVersion)
+    {
+        return false;
+    }
+#if defined (ROUTING_GATEWAY) || defined (ROUTING_EP)
+    // The route option is added once for the whole group.
+    if (0 != memcmp(a->devAddr.routeData, b->devAddr.routeData, sizeof(a->devAddr.routeData)))
+    {
+        return false;
+    }
+#endif
+    if (!a->query || !b->query)
+    {
+        return a->query == b->query;
+    }
+    return 0 == strcmp(a->query, b->query);
+}
+
+/**
+ * Notify all observers of a resource, calling the entity handler once per group of
+ * observers that share accept format, accept version and query.
+ *
+ * The groups are formed before the first entity handler is called. Entity handlers run
+ * without the stack lock, so observers are looked up again by ID when their group is
+ * notified, and observers cancelled meanwhile are skipped.
+ *
+ * @param method RESTful method.
+ * @param resPtr Observed resource.
+ * @param appQoS Quality of service requested by the application.
+ *
+ * @return ::OC_STACK_OK on success, some other value upon failure.
+ */
+static OCStackResult SendGroupedObserverNotification(OCMethod method, OCResource *resPtr,
+                                                     OCQualityOfService appQoS)
+{
+    ResourceObserver *observer = NULL;
+    size_t count = 0;
+
+    LL_FOREACH(resPtr->observersHead, observer)
+    {
+        count++;
+    }
+
+    ResourceObserver **observers = (ResourceObserver **) OICMalloc(count * sizeof(*observers));
+    // Observer IDs ordered by group, and the number of observers in each group.
+    OCObservationId *ids = (OCObservationId *) OICMalloc(count * sizeof(*ids));
+    size_t *groupSizes = (size_t *) OICMalloc(count * sizeof(*groupSizes));
+    if (!observers || !ids || !groupSizes)
+    {
+        OICFree(observers);
+        OICFree(ids);
+        OICFree(groupSizes);
+        return OC_STACK_NO_MEMORY;
+    }
+
+    size_t index = 0;
+    LL_FOREACH(resPtr->observersHead, observer)
+    {
+        observers[index++] = observer;
+    }
+
+    size_t numIds = 0;
+    size_t numGroups = 0;
+    for (size_t leader = 0; leader < count; leader++)
+    {
+        if (!observers[leader])
+        {
+            continue;
+        }
+
+        size_t groupStart = numIds;
+        ids[numIds++] = observers[leader]->observeId;
+        for (size_t member = leader + 1; member < count; member++)
+        {
+            if (observers[member] && IsSameNotificationGroup(observers[leader], observers[member]))
+            {
+                ids[numIds++] = observers[member]->observeId;
+                observers[member] = NULL;
+            }
+        }
+        groupSizes[numGroups++] = numIds - groupStart;
+    }
+    OICFree(observers);
+
+    OCStackResult result = OC_STACK_ERROR;
+    bool observeErrorFlag = false;
+    size_t groupStart = 0;
+
+    for (size_t group = 0; group < numGroups; group++)
+    {
+        size_t groupEnd = groupStart + groupSizes[group];
+        size_t next = groupStart;
+
+        while (next < groupEnd)
+        {
+            ResourceObserver *leader = GetObserverUsingId(resPtr, ids[next++]);
+            if (!leader)
+            {
+                // Cancelled while an earlier entity handler was running.
+                continue;
             }
+
+            // The remaining members are looked up again when the response is sent.
+            OCObservationId *groupIds = NULL;
+            size_t numGroupIds = groupEnd - next;
+            if (numGroupIds)
+            {
+                groupIds = (OCObservationId *) OICMalloc(numGroupIds * sizeof(*groupIds));
+                if (groupIds)
+                {
+                    memcpy(groupIds, &ids[next], numGroupIds * sizeof(*groupIds));
+                }
+                else
+                {
+                    // Remaining members are notified as their own group.
+                    numGroupIds = 0;
+                }
+            }
+
+            OCQualityOfService qos = DetermineObserverQoS(method, leader, appQoS);
+            result = SendObserveNotification(leader, resPtr->sequenceNum, qos,
+                                             groupIds, numGroupIds, appQoS);
+
+            // Since we are in a loop, set an error flag to indicate at least one error occurred.
+            if (result != OC_STACK_OK)
+            {
+                observeErrorFlag = true;
+            }
+            next += numGroupIds;
         }
+        groupStart = groupEnd;
     }
 
+    OICFree(ids);
+    OICFree(groupSizes);
+
+    if (observeErrorFlag)
+    {
+        OIC_LOG(ERROR, TAG, "Observer notification error");
+        result = OC_STACK_ERROR;
+    }
     return result;
 }
 
+OCStackResult OC_CALL OCSetGroupedObserverNotification(bool enable)
+{
+    g_groupedNotification = enable;
+    return OC_STACK_OK;
+}
+
 #ifdef WITH_PRESENCE
 OCStackResult SendAllObserverNotification (OCMethod method, OCResource *resPtr, uint32_t maxAge,
         OCPresenceTrigger trigger, OCResourceType *resourceType, OCQualityOfService qos)
@@ -157,19 +332,62 @@ OCStackResult SendAllObserverNotification (OCMethod method, OCResource *resPtr,
     }
 
     OCStackResult result = OC_STACK_ERROR;
-    ResourceObserver * resourceObserver = resPtr->observersHead;
+    ResourceObserver * resourceObserver = NULL;
     OCServerRequest * request = NULL;
     bool observeErrorFlag = false;
 
+    // Entity handlers run without the stack lock and may delete the resource.
+    PinResource(resPtr);
+
+    if (g_groupedNotification && !resPtr->rsrcChildResourcesHead
+#ifdef WITH_PRESENCE
+        && method != OC_REST_PRESENCE
+#endif
+        )
+    {
+        result = SendGroupedObserverNotification(method, resPtr, qos);
+        if (OC_STACK_NO_MEMORY != result)
+        {
+            UnpinResource(resPtr);
+            return result;
+        }
+        OIC_LOG(WARNING, TAG, "Falling back to per-observer notification");
+    }
+
+    // Entity handlers may also add or cancel observers, so walk a snapshot of the
+    // observer IDs rather than the list itself.
+    size_t count = 0;
+    LL_FOREACH(resPtr->observersHead, resourceObserver)
+    {
+        count++;
+    }
+    OCObservationId *ids = (OCObservationId *) OICMalloc(count * sizeof(*ids));
+    if (!ids)
+    {
+        UnpinResource(resPtr);
+        return OC_STACK_NO_MEMORY;
+    }
+    size_t index = 0;
+    LL_FOREACH(resPtr->observersHead, resourceObserver)
+    {
+        ids[index++] = resourceObserver->observeId;
+    }
+
     // Find clients that are observing this resource
-    while (resourceObserver)
+    for (index = 0; index < count; index++)
     {
+        resourceObserver = GetObserverUsingId(resPtr, ids[index]);
+        if (!resourceObserver)
+        {
+            continue;
+        }
 #ifdef WITH_PRESENCE
         if (method != OC_REST_PRESENCE)
         {
 #endif
             qos = DetermineObserverQoS(method, resourceObserver, qos);
-            result = SendObserveNotification(resourceObserver, resPtr->sequenceNum, qos);
+            result = SendObserveNotification(resourceObserver, resPtr->sequenceNum, qos,
+                                             NULL, 0, qos);
 #ifdef WITH_PRESENCE
         }
         else
@@ -193,6 +411,8 @@ OCStackResult SendAllObserverNotification (OCMethod method, OCResource *resPtr,
 
                 if (!presenceResBuf)
                 {
+                    OICFree(ids);
+                    UnpinResource(resPtr);
                     return OC_STACK_NO_MEMORY;
                 }
 
@@ -217,10 +437,11 @@ OCStackResult SendAllObserverNotification (OCMethod method, OCResource *resPtr,
         {
             observeErrorFlag = true;
         }
-
-        resourceObserver = resourceObserver->next;
     }
 
+    OICFree(ids);
+    UnpinResource(resPtr);
+
     if (observeErrorFlag)
     {
         OIC_LOG(ERROR, TAG, "Observer notification error");
@@ -449,7 +670,8 @@ static void CheckTimedOutObserver(ResourceObserver* observer, OCResource *resour
     {
         // Send confirmable notification message to observer.
         OIC_LOG(INFO, TAG, "Sending High-QoS notification to observer");
-        SendObserveNotification(observer, resource->sequenceNum, OC_HIGH_QOS);
+        SendObserveNotification(observer, resource->sequenceNum, OC_HIGH_QOS,
+                                NULL, 0, OC_HIGH_QOS);
     }
 }
 
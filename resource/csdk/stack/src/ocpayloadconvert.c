@@ -36,7 +36,8 @@
 
 #define TAG "OIC_RI_PAYLOADCONVERT"
 
-// Arbitrarily chosen size that seems to contain the majority of packages
+// Arbitrarily chosen size that seems to contain the majority of packages, the
+// first encoding pass uses a buffer of this size on the stack.
 #define INIT_SIZE (255)
 
 // Discovery Links Map Length.
@@ -81,8 +82,10 @@ OCStackResult OCConvertPayload(OCPayload* payload, OCPayloadFormat format,
 
     OCStackResult ret = OC_STACK_INVALID_PARAM;
     int64_t err = CborErrorOutOfMemory;
+    uint8_t scratch[INIT_SIZE];
+    uint8_t *buffer = scratch;
     uint8_t *out = NULL;
-    size_t curSize = INIT_SIZE;
+    size_t curSize = sizeof(scratch);
 
     VERIFY_PARAM_NON_NULL(TAG, payload, "Input param, payload is NULL");
     VERIFY_PARAM_NON_NULL(TAG, outPayload, "OutPayload parameter is NULL");
@@ -108,11 +111,21 @@ OCStackResult OCConvertPayload(OCPayload* payload, OCPayloadFormat format,
 
     ret = OC_STACK_NO_MEMORY;
 
-    for (;;)
+    if (curSize > sizeof(scratch))
     {
-        out = (uint8_t *)OICCalloc(1, curSize);
+        // the size of pre-encoded payloads is known.
+        out = (uint8_t *)OICMalloc(curSize);
         VERIFY_PARAM_NON_NULL(TAG, out, "Failed to allocate payload");
-        err = OCConvertPayloadHelper(payload, format, out, &curSize);
+        buffer = out;
+    }
+
+    // Small payloads are encoded into the scratch buffer in one pass. For larger
+    // ones tinycbor keeps counting once the buffer is full, so the first pass
+    // yields the exact size and the payload is encoded once more into a buffer
+    // of that size.
+    for (;;)
+    {
+        err = OCConvertPayloadHelper(payload, format, buffer, &curSize);
 
         if (CborErrorOutOfMemory != err)
         {
@@ -120,17 +133,19 @@ OCStackResult OCConvertPayload(OCPayload* payload, OCPayloadFormat format,
         }
 
         OICFree(out);
+        out = (uint8_t *)OICMalloc(curSize);
+        VERIFY_PARAM_NON_NULL(TAG, out, "Failed to allocate payload");
+        buffer = out;
     }
 
     if (err == CborNoError)
     {
-        if ((curSize < INIT_SIZE) &&
-            (PAYLOAD_TYPE_SECURITY != payload->type) &&
-            (PAYLOAD_TYPE_INTROSPECTION != payload->type))
+        if (!out)
         {
-            uint8_t *out2 = (uint8_t *)OICRealloc(out, curSize);
-            VERIFY_PARAM_NON_NULL(TAG, out2, "Failed to increase payload size");
-            out = out2;
+            // an empty security payload still gets a buffer.
+            out = (uint8_t *)OICMalloc(curSize ? curSize : 1);
+            VERIFY_PARAM_NON_NULL(TAG, out, "Failed to allocate payload");
+            memcpy(out, scratch, curSize);
         }
 
         *size = curSize;
@@ -51,12 +51,14 @@
 #include "cacommon.h"
 #include "cainterface.h"
 #include "oickeepalive.h"
+#include "uhashmap.h"
 #include "platform_features.h"
 #include "payload_logging.h"
 #include "ocendpoint.h"
 #include "ocstackinternal.h"
 #include "oickeepalive.h"
 #include "ocpayloadcbor.h"
+#include "ocdiscoverycache.h"
 #include "psinterface.h"
 
 #ifdef ROUTING_GATEWAY
@@ -84,6 +86,7 @@ static const uint16_t CBOR_SIZE = 512;
 static const uint16_t CBOR_MAX_SIZE = 4400;
 
 extern OCResource *headResource;
+extern u_hashmap_t *resourceUriIndex;
 extern bool g_multicastServerStopped;
 
 /**
@@ -1306,14 +1309,11 @@ OCResource *OC_CALL FindResourceByUri(const char* resourceUri)
         return NULL;
     }
 
-    OCResource * pointer = headResource;
-    while (pointer)
+    OCResource *pointer = (OCResource *) u_hashmap_get(resourceUriIndex, resourceUri,
+                                                       strlen(resourceUri));
+    if (pointer)
     {
-        if (strcmp(resourceUri, pointer->uri) == 0)
-        {
-            return pointer;
-        }
-        pointer = pointer->next;
+        return pointer;
     }
     OIC_LOG_V(INFO, TAG, "Resource %s not found", resourceUri);
     return NULL;
@@ -1739,6 +1739,65 @@ exit:
     return OC_STACK_NO_MEMORY;
 }
 
+static bool isDiscoveryResponseCacheable(const OCServerRequest *request)
+{
+#ifdef RD_SERVER
+    // resources published to the resource directory do not invalidate the cache.
+    OC_UNUSED(request);
+    return false;
+#else
+    switch (request->acceptFormat)
+    {
+        case OC_FORMAT_UNDEFINED:
+        case OC_FORMAT_CBOR:
+        case OC_FORMAT_VND_OCF_CBOR:
+            return true;
+        default:
+            return false;
+    }
+#endif
+}
+
+/**
+ * Encode the discovery payload once, keep it in the discovery cache and replace
+ * the payload by the encoded response so it is not encoded again when sent.
+ */
+static OCStackResult encodeAndCacheDiscoveryPayload(const OCDiscoveryCacheKey *cacheKey,
+                                                    OCPayload **payload)
+{
+    if (!*payload)
+    {
+        return OC_STACK_OK;
+    }
+
+    uint8_t *encoded = NULL;
+    size_t size = 0;
+    OCStackResult result = OCConvertPayload(*payload, cacheKey->acceptFormat, &encoded, &size);
+    if (OC_STACK_OK != result)
+    {
+        OIC_LOG(ERROR, TAG, "Error converting discovery payload");
+        return result;
+    }
+
+    OCDiscoveryCacheStore(cacheKey, encoded, size);
+
+    OCSecurityPayload *encodedPayload = (OCSecurityPayload *)OICCalloc(1, sizeof(*encodedPayload));
+    if (!encodedPayload)
+    {
+        // the payload is encoded once more when it is sent.
+        OICFree(encoded);
+        return OC_STACK_OK;
+    }
+    encodedPayload->base.type = PAYLOAD_TYPE_SECURITY;
+    encodedPayload->securityData = encoded;
+    encodedPayload->payloadSize = size;
+
+    OIC_LOG_PAYLOAD(DEBUG, *payload);
+    OCPayloadDestroy(*payload);
+    *payload = (OCPayload *)encodedPayload;
+    return OC_STACK_OK;
+}
+
 static bool isUnicast(OCServerRequest *request)
 {
     bool isMulticast = request->devAddr.flags & OC_MULTICAST;
@@ -1933,6 +1992,27 @@ static OCStackResult HandleVirtualResource (OCServerRequest *request, OCResource
             interfaceQuery = OICStrdup(OC_RSRVD_INTERFACE_LL);
         }
 
+        OCDiscoveryCacheKey cacheKey = { .uri = virtualUriInRequest,
+                                         .interfaceQuery = interfaceQuery,
+                                         .resourceTypeQuery = resourceTypeQuery,
+                                         .acceptFormat = request->acceptFormat,
+                                         .acceptVersion = request->acceptVersion,
+                                         .devAddr = &request->devAddr,
+                                         .deviceId = OCGetServerInstanceIDString(),
+                                         .networkInfo = networkInfo,
+                                         .infoSize = infoSize };
+        bool cacheable = isDiscoveryResponseCacheable(request);
+        if (cacheable)
+        {
+            payload = OCDiscoveryCacheLookup(&cacheKey);
+            if (payload)
+            {
+                OICFree(networkInfo);
+                discoveryResult = OC_STACK_OK;
+                goto send;
+            }
+        }
+
         discoveryResult = discoveryPayloadCreateAndAddDeviceId(&payload);
         VERIFY_PARAM_NON_NULL(TAG, payload, "Failed creating Discovery Payload.");
         VERIFY_SUCCESS(discoveryResult);
@@ -1984,6 +2064,11 @@ static OCStackResult HandleVirtualResource (OCServerRequest *request, OCResource
             payload = NULL;
         }
 
+        if (cacheable && OC_STACK_OK == discoveryResult)
+        {
+            discoveryResult = encodeAndCacheDiscoveryPayload(&cacheKey, &payload);
+        }
+
         if (networkInfo)
         {
             OICFree(networkInfo);
@@ -2028,6 +2113,7 @@ static OCStackResult HandleVirtualResource (OCServerRequest *request, OCResource
         discoveryResult = BuildIntrospectionPayloadResponse(resourcePtr, &payload, &request->devAddr);
         OIC_LOG(INFO, TAG, "Request is for Introspection Payload");
     }
+send:
     /**
      * Step 2: Send the discovery response
      *
@@ -2124,8 +2210,12 @@ HandleDefaultDeviceEntityHandler(OCServerRequest *request)
     VERIFY_SUCCESS(result);
 
     // At this point we know for sure that defaultDeviceHandler exists
-    ehResult = defaultDeviceHandler(OC_REQUEST_FLAG, &ehRequest,
-                                  (char*) request->resourceUrl, defaultDeviceHandlerCallbackParameter);
+    OCDeviceEntityHandler deviceHandler = defaultDeviceHandler;
+    void *callbackParam = defaultDeviceHandlerCallbackParameter;
+    uint32_t depth = OCSuspendStackLock();
+    ehResult = deviceHandler(OC_REQUEST_FLAG, &ehRequest,
+                             (char*) request->resourceUrl, callbackParam);
+    OCResumeStackLock(depth);
     if(ehResult == OC_EH_SLOW)
     {
         OIC_LOG(INFO, TAG, "This is a slow resource");
@@ -2270,7 +2360,9 @@ HandleResourceWithEntityHandler(OCServerRequest *request,
         goto exit;
     }
 
-    ehResult = resource->entityHandler(ehFlag, &ehRequest, resource->entityHandlerCallbackParam);
+    // ProcessRequest keeps request and resource allocated while the entity handler
+    // runs without the stack lock.
+    ehResult = OCCallEntityHandler(resource, ehFlag, &ehRequest);
     if(ehResult == OC_EH_SLOW)
     {
         OIC_LOG(INFO, TAG, "This is a slow resource");
@@ -2310,6 +2402,10 @@ ProcessRequest(ResourceHandling resHandling, OCResource *resource, OCServerReque
 {
     OCStackResult ret = OC_STACK_OK;
 
+    // Entity handlers run without the stack lock; keep both allocated until they return.
+    PinResource(resource);
+    PinServerRequest(request);
+
     switch (resHandling)
     {
         case OC_RESOURCE_VIRTUAL:
@@ -2325,7 +2421,8 @@ ProcessRequest(ResourceHandling resHandling, OCResource *resource, OCServerReque
         case OC_RESOURCE_NOT_COLLECTION_DEFAULT_ENTITYHANDLER:
         {
             OIC_LOG(INFO, TAG, "OC_RESOURCE_NOT_COLLECTION_DEFAULT_ENTITYHANDLER");
-            return OC_STACK_ERROR;
+            ret = OC_STACK_ERROR;
+            break;
         }
         case OC_RESOURCE_NOT_COLLECTION_WITH_ENTITYHANDLER:
         {
@@ -2350,9 +2447,13 @@ ProcessRequest(ResourceHandling resHandling, OCResource *resource, OCServerReque
         default:
         {
             OIC_LOG(INFO, TAG, "Invalid Resource Determination");
-            return OC_STACK_ERROR;
+            ret = OC_STACK_ERROR;
+            break;
         }
     }
+
+    UnpinServerRequest(request);
+    UnpinResource(resource);
     return ret;
 }
 
@@ -2619,6 +2720,9 @@ static OCStackResult SetAttributeInternal(OCResource *resource,
     }
     VERIFY_PARAM_NON_NULL(TAG, resAttrib->attrValue, "Failed allocating attribute value");
 
+    // the device name is part of baseline discovery responses.
+    OCDiscoveryCacheInvalidate();
+
     // The resource has changed from what is stored in the database. Update the database to
     // reflect the new value.
     if (updateDatabase)
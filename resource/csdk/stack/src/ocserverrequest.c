@@ -18,6 +18,7 @@
  *
  ******************************************************************/
 
+#include <assert.h>
 #include <string.h>
 
 #include "ocstack.h"
@@ -156,6 +157,27 @@ static void DeleteServerResponse (OCServerResponse * serverResponse)
     }
 }
 
+/**
+ * Ensure no accept header option is included when sending responses.
+ *
+ * @param[in]  object           CA remote endpoint.
+ * @param[in]  responseInfo     CA response info.
+ *
+ * @return ::OC_STACK_OK on success, some other value upon failure.
+ */
+static OCStackResult SendResponseInfo(const CAEndpoint_t *object, CAResponseInfo_t *responseInfo)
+{
+    // Do not include the accept header option
+    responseInfo->info.acceptFormat = CA_FORMAT_UNDEFINED;
+    CAResult_t result = CASendResponse(object, responseInfo);
+    if(CA_STATUS_OK != result)
+    {
+        OIC_LOG_V(ERROR, TAG, "CASendResponse failed with CA error %u", result);
+        return CAResultToOCResult(result);
+    }
+    return OC_STACK_OK;
+}
+
 /**
  * Ensure no accept header option is included when sending responses and add routing info to
  * outgoing response.
@@ -177,15 +199,60 @@ static OCStackResult OCSendResponse (const CAEndpoint_t *object, CAResponseInfo_
     }
 #endif
 
-    // Do not include the accept header option
-    responseInfo->info.acceptFormat = CA_FORMAT_UNDEFINED;
-    CAResult_t result = CASendResponse(object, responseInfo);
-    if(CA_STATUS_OK != result)
+    return SendResponseInfo(object, responseInfo);
+}
+
+/**
+ * Send an already encoded notification to the remaining observers of a grouped notification.
+ * Only the fields that differ per observer (endpoint, token, message type and ID) are
+ * changed in responseInfo; payload and options are shared. Group members share the route
+ * of the first observer, so the route option added for it is sent unchanged.
+ *
+ * @param[in]  serverRequest    Server request of the first observer of the group.
+ * @param[in]  responseInfo     CA response info that was sent to the first observer.
+ *
+ * @return ::OC_STACK_OK on success, some other value upon failure.
+ */
+static OCStackResult SendGroupedResponse(const OCServerRequest *serverRequest,
+                                         CAResponseInfo_t *responseInfo)
+{
+    OCResource *resource = FindResourceByUri(serverRequest->resourceUrl);
+    if (!resource)
     {
-        OIC_LOG_V(ERROR, TAG, "CASendResponse failed with CA error %u", result);
-        return CAResultToOCResult(result);
+        return OC_STACK_NO_RESOURCE;
     }
-    return OC_STACK_OK;
+
+    OCStackResult result = OC_STACK_OK;
+    for (size_t i = 0; i < serverRequest->numGroupObservers; i++)
+    {
+        ResourceObserver *observer = GetObserverUsingId(resource,
+                                                        serverRequest->groupObserverIds[i]);
+        if (!observer)
+        {
+            // Observer was cancelled while the entity handler was running.
+            continue;
+        }
+
+        OCQualityOfService qos = DetermineObserverQoS(OC_REST_OBSERVE, observer,
+                                                      serverRequest->groupQos);
+        responseInfo->info.type = (OC_HIGH_QOS == qos) ? CA_MSG_CONFIRM : CA_MSG_NONCONFIRM;
+        responseInfo->info.messageId = 0;
+        memcpy(responseInfo->info.token, observer->token, observer->tokenLength);
+        responseInfo->info.tokenLength = observer->tokenLength;
+
+        CAEndpoint_t responseEndpoint = {.adapter = CA_DEFAULT_ADAPTER};
+        CopyDevAddrToEndpoint(&observer->devAddr, &responseEndpoint);
+
+        OCStackResult sendResult = SendResponseInfo(&responseEndpoint, responseInfo);
+        if (OC_STACK_OK != sendResult)
+        {
+            OIC_LOG_V(ERROR, TAG, "Error notifying observer id %d", observer->observeId);
+            result = sendResult;
+        }
+        // Reset Observer TTL.
+        observer->TTL = GetTicks(MAX_OBSERVER_TTL_SECONDS * MILLISECONDS_PER_SECOND);
+    }
+    return result;
 }
 
 static CAPayloadFormat_t OCToCAPayloadFormat (OCPayloadFormat ocFormat)
@@ -404,18 +471,55 @@ OCServerRequest * GetServerRequestUsingToken (const CAToken_t token, uint8_t tok
     return out;
 }
 
+static void FreeServerRequest(OCServerRequest * serverRequest)
+{
+    OICFree(serverRequest->requestToken);
+    OICFree(serverRequest->groupObserverIds);
+    OICFree(serverRequest);
+}
+
 void DeleteServerRequest(OCServerRequest * serverRequest)
 {
-    if (serverRequest)
+    if (serverRequest && !serverRequest->deleted)
     {
         RBL_REMOVE(ServerRequestTree, &g_serverRequestTree, serverRequest);
-        OICFree(serverRequest->requestToken);
-        OICFree(serverRequest);
+        if (serverRequest->refCount)
+        {
+            // An entity handler is still running; the last UnpinServerRequest frees it.
+            serverRequest->deleted = true;
+        }
+        else
+        {
+            FreeServerRequest(serverRequest);
+        }
         serverRequest = NULL;
         OIC_LOG(INFO, TAG, "Server Request Removed");
     }
 }
 
+void PinServerRequest(OCServerRequest * serverRequest)
+{
+    if (serverRequest)
+    {
+        serverRequest->refCount++;
+    }
+}
+
+void UnpinServerRequest(OCServerRequest * serverRequest)
+{
+    if (!serverRequest)
+    {
+        return;
+    }
+
+    assert(serverRequest->refCount);
+    serverRequest->refCount--;
+    if (!serverRequest->refCount && serverRequest->deleted)
+    {
+        FreeServerRequest(serverRequest);
+    }
+}
+
 OCStackResult FormOCEntityHandlerRequest(OCEntityHandlerRequest * entityHandlerRequest,
                                          OCRequestHandle request,
                                          OCMethod method,
@@ -736,6 +840,15 @@ OCStackResult HandleSingleResponse(OCEntityHandlerResponse * ehResponse)
     result = OCSendResponse(&responseEndpoint, &responseInfo);
 #endif
 
+    if (serverRequest->numGroupObservers)
+    {
+        OCStackResult groupResult = SendGroupedResponse(serverRequest, &responseInfo);
+        if (OC_STACK_OK != groupResult)
+        {
+            result = groupResult;
+        }
+    }
+
     OICFree(responseInfo.info.payload);
     OICFree(responseInfo.info.options);
     //Delete the request
@@ -63,12 +63,16 @@
 #include "cainterface.h"
 #include "ocpayload.h"
 #include "ocpayloadcbor.h"
+#include "ocdiscoverycache.h"
 #include "cautilinterface.h"
 #include "cainterface.h"
 #include "caprotocolmessage.h"
 #include "oicgroup.h"
 #include "ocendpoint.h"
 #include "ocatomic.h"
+#include "octhread.h"
+#include "ocevent.h"
+#include "uhashmap.h"
 #include "platform_features.h"
 #include "oic_platform.h"
 
@@ -140,6 +144,10 @@ static OCStackState stackState = OC_STACK_UNINITIALIZED;
 
 OCResource *headResource = NULL;
 static OCResource *tailResource = NULL;
+/** Index of the resource list keyed by resource URI. */
+u_hashmap_t *resourceUriIndex = NULL;
+/** Set of valid resource handles keyed by handle address. */
+static u_hashmap_t *resourceHandleIndex = NULL;
 static OCResourceHandle platformResource = {0};
 static OCResourceHandle deviceResource = {0};
 static OCResourceHandle introspectionResource = {0};
@@ -179,6 +187,33 @@ volatile int32_t g_ocStackStartStopThreadCount = 0;
 
 bool g_multicastServerStopped = false;
 
+// Recursive lock serializing stack state between the application thread and
+// receive workers.
+static oc_mutex g_ocStackLock = NULL;
+
+// Number of times the owner of g_ocStackLock holds it. Only changed with the lock held.
+static uint32_t g_ocStackLockDepth = 0;
+
+// Events signalled when OCProcessEvent has work, see OCRegisterProcessEvent.
+#define MAX_PROCESS_EVENTS (4)
+static oc_event g_processEvents[MAX_PROCESS_EVENTS];
+
+// Response handlers that decode representation payloads themselves,
+// see OCRegisterRawPayloadHandler.
+#define MAX_RAW_PAYLOAD_HANDLERS (8)
+static OCClientResponseHandler g_rawPayloadHandlers[MAX_RAW_PAYLOAD_HANDLERS];
+
+#if defined(TCP_ADAPTER) || defined(ROUTING_GATEWAY)
+// Keepalive and routing work is periodic, so OCProcessEvent never waits longer.
+#define PROCESS_EVENT_MAX_DELAY_MS  (1000)
+#endif
+
+#ifdef WITH_PRESENCE
+// Due presence work is done by the next OCProcess; OCProcessEvent still waits this
+// long so a presence node that makes no progress cannot make the caller spin.
+#define PRESENCE_MIN_DELAY_MS  (10)
+#endif
+
 //-----------------------------------------------------------------------------
 // Macros
 //-----------------------------------------------------------------------------
@@ -223,11 +258,14 @@ static OCStackResult initResources();
  * Add a resource to the end of the linked list of resources.
  *
  * @param resource Resource to be added
+ * @return ::OC_STACK_OK on success, ::OC_STACK_NO_MEMORY if the handle could not be indexed.
  */
-static void insertResource(OCResource *resource);
+static OCStackResult insertResource(OCResource *resource);
 
 /**
  * Find a resource in the linked list of resources.
+ * Validity is checked against the handle index, so the cost does not depend
+ * on the number of resources.
  *
  * @param resource Resource to be found.
  * @return Pointer to resource that was found in the linked list or NULL if the resource was not
@@ -370,22 +408,16 @@ static OCStackResult HandlePresenceResponse(const CAEndpoint_t *endPoint,
         const CAResponseInfo_t *responseInfo);
 
 /**
- * This function will be called back by CA layer when a response is received.
+ * Call the application callback of a client callback node without the stack lock.
  *
- * @param endPoint CA remote endpoint.
- * @param responseInfo CA response info.
- */
-static void HandleCAResponses(const CAEndpoint_t* endPoint,
-        const CAResponseInfo_t* responseInfo);
-
-/**
- * This function will be called back by CA layer when a request is received.
+ * @param cbNode        Client callback node.
+ * @param response      Response passed to the callback.
+ * @param appResult     Value returned by the callback.
  *
- * @param endPoint CA remote endpoint.
- * @param requestInfo CA request info.
+ * @return true if cbNode is still in the callback list afterwards.
  */
-static void HandleCARequests(const CAEndpoint_t* endPoint,
-        const CARequestInfo_t* requestInfo);
+static bool CallClientCB(ClientCB *cbNode, OCClientResponse *response,
+                         OCStackApplicationResult *appResult);
 
 /**
  * Extract query from a URI.
@@ -733,13 +765,13 @@ OCStackResult OCStackFeedBack(CAToken_t token, uint8_t tokenLength, uint8_t stat
             return result;
         }
 
-        if (resource->entityHandler)
+        PinResource(resource);
+        OCCallEntityHandler(resource, OC_OBSERVE_FLAG, &ehRequest);
+        if (!resource->deleted)
         {
-            resource->entityHandler(OC_OBSERVE_FLAG, &ehRequest,
-                                    resource->entityHandlerCallbackParam);
+            DeleteObserverUsingToken(resource, token, tokenLength);
         }
-
-        DeleteObserverUsingToken(resource, token, tokenLength);
+        UnpinResource(resource);
         break;
 
     case OC_OBSERVER_STILL_INTERESTED:
@@ -769,13 +801,13 @@ OCStackResult OCStackFeedBack(CAToken_t token, uint8_t tokenLength, uint8_t stat
                 return OC_STACK_ERROR;
             }
 
-            if (resource->entityHandler)
+            PinResource(resource);
+            OCCallEntityHandler(resource, OC_OBSERVE_FLAG, &ehRequest);
+            if (!resource->deleted)
             {
-                resource->entityHandler(OC_OBSERVE_FLAG, &ehRequest,
-                                        resource->entityHandlerCallbackParam);
+                DeleteObserverUsingToken(resource, token, tokenLength);
             }
-
-            DeleteObserverUsingToken(resource, token, tokenLength);
+            UnpinResource(resource);
         }
         else
         {
@@ -997,6 +1029,9 @@ static OCStackResult ResetPresenceTTL(ClientCB *cbNode, uint32_t maxAgeSeconds)
     cbNode->presence->TTLlevel = 0;
 
     OIC_LOG_V(DEBUG, TAG, "this TTL level %d", cbNode->presence->TTLlevel);
+
+    // the next presence timeout may be due earlier now.
+    OCSignalProcessEvent();
     return OC_STACK_OK;
 }
 
@@ -1370,9 +1405,7 @@ OCStackResult HandlePresenceResponse(const CAEndpoint_t *endpoint,
 
     OIC_LOG(INFO, TAG, "Callback for presence");
 
-    cbResult = cbNode->callBack(cbNode->context, cbNode->handle, response);
-
-    if (cbResult == OC_STACK_DELETE_TRANSACTION)
+    if (CallClientCB(cbNode, response, &cbResult) && cbResult == OC_STACK_DELETE_TRANSACTION)
     {
         DeleteClientCB(cbNode);
     }
@@ -1383,6 +1416,43 @@ exit:
     return result;
 }
 
+static bool IsRawPayloadHandler(OCClientResponseHandler handler)
+{
+    for (size_t i = 0; i < MAX_RAW_PAYLOAD_HANDLERS && g_rawPayloadHandlers[i]; i++)
+    {
+        if (g_rawPayloadHandlers[i] == handler)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Return true if the request uri selects the batch interface. The response to such a
+ * request is rearranged by HandleBatchResponse, so it is always parsed.
+ */
+static bool IsBatchRequestUri(const char *requestUri)
+{
+    static const char batchQuery[] = OC_RSRVD_INTERFACE "=" OC_RSRVD_INTERFACE_BATCH;
+    const char *query = requestUri ? strchr(requestUri, '?') : NULL;
+
+    while (query)
+    {
+        query++;
+        if (0 == strncmp(query, batchQuery, sizeof(batchQuery) - 1))
+        {
+            char end = query[sizeof(batchQuery) - 1];
+            if ('\0' == end || '&' == end || ';' == end)
+            {
+                return true;
+            }
+        }
+        query = strpbrk(query, "&;");
+    }
+    return false;
+}
+
 OCStackResult HandleBatchResponse(char *requestUri, OCRepPayload **payload)
 {
     if (requestUri && *payload)
@@ -1661,9 +1731,11 @@ void OC_CALL OCHandleResponse(const CAEndpoint_t* endPoint, const CAResponseInfo
             response->identity.id_length = responseInfo->info.identity.id_length;
 
             response->result = CAResponseToOCStackResult(responseInfo->result);
-            cbNode->callBack(cbNode->context,
-                    cbNode->handle, response);
-            DeleteClientCB(cbNode);
+            OCStackApplicationResult appFeedback = OC_STACK_DELETE_TRANSACTION;
+            if (CallClientCB(cbNode, response, &appFeedback))
+            {
+                DeleteClientCB(cbNode);
+            }
             OICFree(response);
         }
         else if ((cbNode->method == OC_REST_OBSERVE || cbNode->method == OC_REST_OBSERVE_ALL)
@@ -1690,10 +1762,11 @@ void OC_CALL OCHandleResponse(const CAEndpoint_t* endPoint, const CAResponseInfo
 
             OIC_LOG(DEBUG, TAG, "This is response of observer cancel or observer request fail");
 
-            cbNode->callBack(cbNode->context,
-                             cbNode->handle,
-                             response);
-            DeleteClientCB(cbNode);
+            OCStackApplicationResult appFeedback = OC_STACK_DELETE_TRANSACTION;
+            if (CallClientCB(cbNode, response, &appFeedback))
+            {
+                DeleteClientCB(cbNode);
+            }
             OICFree(response);
         }
         else
@@ -1822,9 +1895,17 @@ void OC_CALL OCHandleResponse(const CAEndpoint_t* endPoint, const CAResponseInfo
                     return;
                 }
 
+                if (PAYLOAD_TYPE_REPRESENTATION == type && IsRawPayloadHandler(cbNode->callBack)
+                        && !IsBatchRequestUri(cbNode->requestUri))
+                {
+                    // The handler decodes the representation itself, skip building
+                    // the OCRepPayload tree.
+                    response->rawPayload = responseInfo->info.payload;
+                    response->rawPayloadSize = responseInfo->info.payloadSize;
+                }
                 // In case of error, still want application to receive the error message.
-                if (OCResultToSuccess(response->result) || PAYLOAD_TYPE_REPRESENTATION == type ||
-                        PAYLOAD_TYPE_DIAGNOSTIC == type)
+                else if (OCResultToSuccess(response->result) ||
+                        PAYLOAD_TYPE_REPRESENTATION == type || PAYLOAD_TYPE_DIAGNOSTIC == type)
                 {
                     if (OC_STACK_OK != OCParsePayload(&response->payload,
                             CAToOCPayloadFormat(responseInfo->info.payloadFormat),
@@ -1841,7 +1922,7 @@ void OC_CALL OCHandleResponse(const CAEndpoint_t* endPoint, const CAResponseInfo
                     // Check endpoints has link-local ipv6 address.
                     // if there is, map zone-id which parsed from ifindex
 #if defined (IP_ADAPTER) && !defined (WITH_ARDUINO)
-                    if (PAYLOAD_TYPE_DISCOVERY == response->payload->type)
+                    if (response->payload && PAYLOAD_TYPE_DISCOVERY == response->payload->type)
                     {
                         OCDiscoveryPayload *disPayload = (OCDiscoveryPayload*)(response->payload);
                         if (OC_STACK_OK !=
@@ -1950,20 +2031,22 @@ void OC_CALL OCHandleResponse(const CAEndpoint_t* endPoint, const CAResponseInfo
                     HandleBatchResponse(cbNode->requestUri, (OCRepPayload **)&response->payload);
                 }
 
-                OCStackApplicationResult appFeedback = cbNode->callBack(cbNode->context,
-                                                                        cbNode->handle,
-                                                                        response);
-                cbNode->sequenceNumber = response->sequenceNumber;
-
-                if (appFeedback == OC_STACK_DELETE_TRANSACTION)
-                {
-                    DeleteClientCB(cbNode);
-                }
-                else
+                // The application may cancel the request from within the callback.
+                OCStackApplicationResult appFeedback = OC_STACK_DELETE_TRANSACTION;
+                if (CallClientCB(cbNode, response, &appFeedback))
                 {
-                    // To keep discovery callbacks active.
-                    cbNode->TTL = GetTicks(MAX_CB_TIMEOUT_SECONDS *
-                                            MILLISECONDS_PER_SECOND);
+                    cbNode->sequenceNumber = response->sequenceNumber;
+
+                    if (appFeedback == OC_STACK_DELETE_TRANSACTION)
+                    {
+                        DeleteClientCB(cbNode);
+                    }
+                    else
+                    {
+                        // To keep discovery callbacks active.
+                        UpdateClientCBTTL(cbNode, GetTicks(MAX_CB_TIMEOUT_SECONDS *
+                                                           MILLISECONDS_PER_SECOND));
+                    }
                 }
             }
 
@@ -2086,7 +2169,9 @@ void HandleCAResponses(const CAEndpoint_t* endPoint, const CAResponseInfo_t* res
         (CAEndpoint_t *)endPoint);
 #endif
 
+    OCLockStack();
     OCHandleResponse(endPoint, responseInfo);
+    OCUnlockStack();
 
     OIC_LOG(INFO, TAG, "Exit HandleCAResponses");
     OIC_TRACE_END();
@@ -2104,6 +2189,7 @@ void HandleCAErrorResponse(const CAEndpoint_t *endPoint, const CAErrorInfo_t *er
     OIC_LOG(INFO, TAG, "Enter HandleCAErrorResponse");
     OIC_TRACE_BEGIN(%s:HandleCAErrorResponse, TAG);
 
+    OCLockStack();
     ClientCB *cbNode = GetClientCBUsingToken(errorInfo->info.token,
                                              errorInfo->info.tokenLength);
     if (cbNode)
@@ -2114,6 +2200,7 @@ void HandleCAErrorResponse(const CAEndpoint_t *endPoint, const CAErrorInfo_t *er
         if (!response)
         {
             OIC_LOG(ERROR, TAG, "Allocating memory for response failed");
+            OCUnlockStack();
             OIC_TRACE_END();
             return;
         }
@@ -2127,7 +2214,8 @@ void HandleCAErrorResponse(const CAEndpoint_t *endPoint, const CAErrorInfo_t *er
         response->identity.id_length = errorInfo->info.identity.id_length;
         response->result = CAResultToOCResult(errorInfo->result);
 
-        cbNode->callBack(cbNode->context, cbNode->handle, response);
+        OCStackApplicationResult appFeedback = OC_STACK_DELETE_TRANSACTION;
+        CallClientCB(cbNode, response, &appFeedback);
         OICFree(response);
     }
 
@@ -2144,6 +2232,7 @@ void HandleCAErrorResponse(const CAEndpoint_t *endPoint, const CAErrorInfo_t *er
                             OC_OBSERVER_FAILED_COMM);
         }
     }
+    OCUnlockStack();
 
     OIC_LOG(INFO, TAG, "Exit HandleCAErrorResponse");
     OIC_TRACE_END();
@@ -2541,6 +2630,89 @@ void OCHandleRequests(const CAEndpoint_t* endPoint, const CARequestInfo_t* reque
     OIC_LOG(INFO, TAG, "Exit OCHandleRequests");
 }
 
+void OCLockStack()
+{
+    if (g_ocStackLock)
+    {
+        oc_mutex_lock(g_ocStackLock);
+        g_ocStackLockDepth++;
+    }
+}
+
+void OCUnlockStack()
+{
+    if (g_ocStackLock)
+    {
+        g_ocStackLockDepth--;
+        oc_mutex_unlock(g_ocStackLock);
+    }
+}
+
+uint32_t OCSuspendStackLock()
+{
+    uint32_t depth = g_ocStackLock ? g_ocStackLockDepth : 0;
+    for (uint32_t i = 0; i < depth; i++)
+    {
+        OCUnlockStack();
+    }
+    return depth;
+}
+
+void OCResumeStackLock(uint32_t depth)
+{
+    for (uint32_t i = 0; i < depth; i++)
+    {
+        OCLockStack();
+    }
+}
+
+OCEntityHandlerResult OCCallEntityHandler(OCResource *resource, OCEntityHandlerFlag flag,
+                                          OCEntityHandlerRequest *ehRequest)
+{
+    OCEntityHandler entityHandler = resource->entityHandler;
+    void *callbackParam = resource->entityHandlerCallbackParam;
+    if (!entityHandler)
+    {
+        return OC_EH_ERROR;
+    }
+
+    PinResource(resource);
+    uint32_t depth = OCSuspendStackLock();
+    OCEntityHandlerResult ehResult = entityHandler(flag, ehRequest, callbackParam);
+    OCResumeStackLock(depth);
+    UnpinResource(resource);
+    return ehResult;
+}
+
+bool CallClientCB(ClientCB *cbNode, OCClientResponse *response,
+                  OCStackApplicationResult *appResult)
+{
+    OCClientResponseHandler callBack = cbNode->callBack;
+    void *context = cbNode->context;
+    OCDoHandle handle = cbNode->handle;
+
+    PinClientCB(cbNode);
+    uint32_t depth = OCSuspendStackLock();
+    *appResult = callBack(context, handle, response);
+    OCResumeStackLock(depth);
+    bool live = !cbNode->deleted;
+    UnpinClientCB(cbNode);
+    return live;
+}
+
+void OCSignalProcessEvent()
+{
+    OCLockStack();
+    for (size_t i = 0; i < MAX_PROCESS_EVENTS; i++)
+    {
+        if (g_processEvents[i])
+        {
+            oc_event_signal(g_processEvents[i]);
+        }
+    }
+    OCUnlockStack();
+}
+
 //This function will be called back by CA layer when a request is received
 void HandleCARequests(const CAEndpoint_t* endPoint, const CARequestInfo_t* requestInfo)
 {
@@ -2602,14 +2774,18 @@ void HandleCARequests(const CAEndpoint_t* endPoint, const CARequestInfo_t* reque
         CAResponseInfo_t respInfo = {.result = CA_EMPTY,
                                      .info.messageId = requestInfo->info.messageId,
                                      .info.type = CA_MSG_ACKNOWLEDGE};
+        OCLockStack();
         OCHandleResponse(endPoint, &respInfo);
+        OCUnlockStack();
     }
     else
 #endif
 #endif
     {
         // Normal handling of the packet
+        OCLockStack();
         OCHandleRequests(endPoint, requestInfo);
+        OCUnlockStack();
     }
     OIC_LOG(INFO, TAG, "Exit HandleCARequests");
     OIC_TRACE_END();
@@ -2706,6 +2882,16 @@ OCStackResult OCInitializeInternal(OCMode mode, OCTransportFlags serverFlags,
     OIC_LOG_V(INFO, TAG, "IoTivity version is v%s", IOTIVITY_VERSION);
     OCStackResult result = OC_STACK_ERROR;
 
+    if (!g_ocStackLock)
+    {
+        g_ocStackLock = oc_mutex_new_recursive();
+        if (!g_ocStackLock)
+        {
+            OIC_LOG(ERROR, TAG, "Failed to create stack lock");
+            return OC_STACK_NO_MEMORY;
+        }
+    }
+
     // Validate mode
     if (!((mode == OC_CLIENT) || (mode == OC_SERVER) || (mode == OC_CLIENT_SERVER)
         || (mode == OC_GATEWAY)))
@@ -2827,8 +3013,12 @@ exit:
     {
         OIC_LOG(ERROR, TAG, "Stack initialization error");
         TerminateScheduleResourceList();
+        OCLockStack();
         deleteAllResources();
+        OCUnlockStack();
         CATerminate();
+        oc_mutex_free(g_ocStackLock);
+        g_ocStackLock = NULL;
         stackState = OC_STACK_UNINITIALIZED;
     }
     return result;
@@ -2895,12 +3085,19 @@ OCStackResult OCDeInitializeInternal()
     }
 
     TerminateScheduleResourceList();
+    OCLockStack();
     // Free memory dynamically allocated for resources
     deleteAllResources();
     // Remove all the client callbacks
     DeleteClientCBList();
+    // The next OCInit starts with per-observer notifications again.
+    OCSetGroupedObserverNotification(false);
+    OCUnlockStack();
     // Terminate connectivity-abstraction layer.
     CATerminate();
+    // Receive workers are stopped now.
+    oc_mutex_free(g_ocStackLock);
+    g_ocStackLock = NULL;
 
 #if defined(TCP_ADAPTER) && defined(WITH_CLOUD)
     // Terminate the Connection Manager
@@ -3239,16 +3436,16 @@ static void assertRolesCB(void* ctx, bool hasError)
 /**
  * Discover or Perform requests on a specified resource
  */
-OCStackResult OC_CALL OCDoRequest(OCDoHandle *handle,
-                                  OCMethod method,
-                                  const char *requestUri,
-                                  const OCDevAddr *destination,
-                                  OCPayload* payload,
-                                  OCConnectivityType connectivityType,
-                                  OCQualityOfService qos,
-                                  OCCallbackData *cbData,
-                                  OCHeaderOption *options,
-                                  uint8_t numOptions)
+static OCStackResult OCDoRequestInternal(OCDoHandle *handle,
+                                         OCMethod method,
+                                         const char *requestUri,
+                                         const OCDevAddr *destination,
+                                         OCPayload* payload,
+                                         OCConnectivityType connectivityType,
+                                         OCQualityOfService qos,
+                                         OCCallbackData *cbData,
+                                         OCHeaderOption *options,
+                                         uint8_t numOptions)
 {
     OIC_LOG(INFO, TAG, "Entering OCDoResource");
 
@@ -3699,8 +3896,26 @@ exit:
     return result;
 }
 
-OCStackResult OC_CALL OCCancel(OCDoHandle handle, OCQualityOfService qos, OCHeaderOption * options,
-        uint8_t numOptions)
+OCStackResult OC_CALL OCDoRequest(OCDoHandle *handle,
+                                  OCMethod method,
+                                  const char *requestUri,
+                                  const OCDevAddr *destination,
+                                  OCPayload* payload,
+                                  OCConnectivityType connectivityType,
+                                  OCQualityOfService qos,
+                                  OCCallbackData *cbData,
+                                  OCHeaderOption *options,
+                                  uint8_t numOptions)
+{
+    OCLockStack();
+    OCStackResult result = OCDoRequestInternal(handle, method, requestUri, destination, payload,
+                                               connectivityType, qos, cbData, options, numOptions);
+    OCUnlockStack();
+    return result;
+}
+
+static OCStackResult OCCancelInternal(OCDoHandle handle, OCQualityOfService qos,
+        OCHeaderOption * options, uint8_t numOptions)
 {
     /*
      * This ftn is implemented one of two ways in the case of observation:
@@ -3806,6 +4021,15 @@ OCStackResult OC_CALL OCCancel(OCDoHandle handle, OCQualityOfService qos, OCHead
     return ret;
 }
 
+OCStackResult OC_CALL OCCancel(OCDoHandle handle, OCQualityOfService qos, OCHeaderOption * options,
+        uint8_t numOptions)
+{
+    OCLockStack();
+    OCStackResult result = OCCancelInternal(handle, qos, options, numOptions);
+    OCUnlockStack();
+    return result;
+}
+
 /**
  * @brief   Register Persistent storage callback.
  * @param   persistentStorageHandler [IN] Pointers to open, read, write, close & unlink handlers.
@@ -3865,7 +4089,8 @@ OCStackResult OCProcessPresence()
 
         if (cbNode->presence->TTLlevel > PresenceTimeOutSize)
         {
-            goto exit;
+            // the presence timeout was already reported for this node.
+            continue;
         }
 
         if (cbNode->presence->TTLlevel < PresenceTimeOutSize)
@@ -3882,6 +4107,8 @@ OCStackResult OCProcessPresence()
             clientResponse.devAddr = *cbNode->devAddr;
             FixUpClientResponse(&clientResponse);
             clientResponse.payload = NULL;
+            clientResponse.rawPayload = NULL;
+            clientResponse.rawPayloadSize = 0;
 
             // Increment the TTLLevel (going to a next state), so we don't keep
             // sending presence notification to client.
@@ -3889,11 +4116,16 @@ OCStackResult OCProcessPresence()
             OIC_LOG_V(DEBUG, TAG, "moving to TTL level %d",
                                         cbNode->presence->TTLlevel);
 
-            cbResult = cbNode->callBack(cbNode->context, cbNode->handle, &clientResponse);
-            if (cbResult == OC_STACK_DELETE_TRANSACTION)
+            if (CallClientCB(cbNode, &clientResponse, &cbResult)
+                && cbResult == OC_STACK_DELETE_TRANSACTION)
             {
                 DeleteClientCB(cbNode);
             }
+            // Do not read timeOut[] again: TTLlevel is past its end now. The
+            // callback ran without the stack lock, so cbTemp may have been
+            // deleted meanwhile. Start over from the head of the list.
+            cbTemp = g_cbList;
+            continue;
         }
 
         if (now < cbNode->presence->timeOut[cbNode->presence->TTLlevel])
@@ -3916,16 +4148,19 @@ OCStackResult OCProcessPresence()
         requestInfo.method = CA_GET;
         requestInfo.info = requestData;
 
-        result = OCSendRequest(&endpoint, &requestInfo);
-        if (OC_STACK_OK != result)
+        OCStackResult sendResult = OCSendRequest(&endpoint, &requestInfo);
+        if (OC_STACK_OK != sendResult)
         {
-            goto exit;
+            // count it as an unanswered request, so this node still moves on
+            // to the timeout and the other nodes are served.
+            OIC_LOG_V(ERROR, TAG, "Presence request failed: %d", sendResult);
+            result = sendResult;
         }
 
         cbNode->presence->TTLlevel++;
         OIC_LOG_V(DEBUG, TAG, "moving to TTL level %d", cbNode->presence->TTLlevel);
     }
-exit:
+
     if (result != OC_STACK_OK)
     {
         OIC_LOG(ERROR, TAG, "OCProcessPresence error");
@@ -3942,11 +4177,16 @@ OCStackResult OC_CALL OCProcess()
         OIC_LOG(ERROR, TAG, "OCProcess has failed. ocstack is not initialized");
         return OC_STACK_ERROR;
     }
+    OCLockStack();
 #ifdef WITH_PRESENCE
     OCProcessPresence();
 #endif
+    DeleteTimedOutClientCBs();
+    OCUnlockStack();
+
     CAHandleRequestResponse();
 
+    OCLockStack();
 #ifdef ROUTING_GATEWAY
     RMProcess();
 #endif
@@ -3954,11 +4194,181 @@ OCStackResult OC_CALL OCProcess()
 #ifdef TCP_ADAPTER
     ProcessKeepAlive();
 #endif
+    OCUnlockStack();
     return OC_STACK_OK;
 }
 
 #ifdef WITH_PRESENCE
-OCStackResult OC_CALL OCStartPresence(const uint32_t ttl)
+static uint32_t GetPresenceTimeoutDelay()
+{
+    uint32_t delay = UINT32_MAX;
+    uint32_t now = GetTicks(0);
+    ClientCB* cbNode = NULL;
+
+    LL_FOREACH(g_cbList, cbNode)
+    {
+        if (OC_REST_PRESENCE != cbNode->method || !cbNode->presence)
+        {
+            continue;
+        }
+
+        if (cbNode->presence->TTLlevel == PresenceTimeOutSize)
+        {
+            // the presence timeout callback is pending.
+            return PRESENCE_MIN_DELAY_MS;
+        }
+        if (cbNode->presence->TTLlevel > PresenceTimeOutSize)
+        {
+            continue;
+        }
+
+        uint32_t timeOut = cbNode->presence->timeOut[cbNode->presence->TTLlevel];
+        if (timeOut <= now)
+        {
+            return PRESENCE_MIN_DELAY_MS;
+        }
+
+        uint64_t nodeDelay = ((uint64_t)(timeOut - now) * MILLISECONDS_PER_SECOND) /
+                             COAP_TICKS_PER_SECOND + 1;
+        if (nodeDelay < PRESENCE_MIN_DELAY_MS)
+        {
+            nodeDelay = PRESENCE_MIN_DELAY_MS;
+        }
+        if (nodeDelay < delay)
+        {
+            delay = (uint32_t)nodeDelay;
+        }
+    }
+    return delay;
+}
+#endif // WITH_PRESENCE
+
+OCStackResult OC_CALL OCProcessEvent(uint32_t *nextEventTime)
+{
+    if (!nextEventTime)
+    {
+        return OC_STACK_INVALID_PARAM;
+    }
+
+    OCStackResult result = OCProcess();
+    if (OC_STACK_OK != result)
+    {
+        return result;
+    }
+
+    OCLockStack();
+    uint32_t delay = GetClientCBTimeoutDelay();
+#ifdef WITH_PRESENCE
+    uint32_t presenceDelay = GetPresenceTimeoutDelay();
+    if (presenceDelay < delay)
+    {
+        delay = presenceDelay;
+    }
+#endif
+#if defined(TCP_ADAPTER) || defined(ROUTING_GATEWAY)
+    if (PROCESS_EVENT_MAX_DELAY_MS < delay)
+    {
+        delay = PROCESS_EVENT_MAX_DELAY_MS;
+    }
+#endif
+    OCUnlockStack();
+
+    *nextEventTime = delay;
+    return OC_STACK_OK;
+}
+
+OCStackResult OC_CALL OCRegisterProcessEvent(oc_event event)
+{
+    VERIFY_NON_NULL(event, ERROR, OC_STACK_INVALID_PARAM);
+
+    OCStackResult result = OC_STACK_NO_MEMORY;
+    OCLockStack();
+    for (size_t i = 0; i < MAX_PROCESS_EVENTS; i++)
+    {
+        if (!g_processEvents[i] || g_processEvents[i] == event)
+        {
+            g_processEvents[i] = event;
+            result = OC_STACK_OK;
+            break;
+        }
+    }
+    OCUnlockStack();
+
+    if (OC_STACK_OK != result)
+    {
+        OIC_LOG(ERROR, TAG, "Too many process events");
+        return result;
+    }
+
+#ifndef SINGLE_THREAD
+    result = CAResultToOCResult(CARegisterProcessEvent(event));
+    if (OC_STACK_OK != result)
+    {
+        OCUnregisterProcessEvent(event);
+    }
+#endif
+    return result;
+}
+
+void OC_CALL OCUnregisterProcessEvent(oc_event event)
+{
+    OCLockStack();
+    for (size_t i = 0; i < MAX_PROCESS_EVENTS; i++)
+    {
+        if (g_processEvents[i] == event)
+        {
+            g_processEvents[i] = NULL;
+        }
+    }
+    OCUnlockStack();
+
+#ifndef SINGLE_THREAD
+    CAUnregisterProcessEvent(event);
+#endif
+}
+
+OCStackResult OC_CALL OCRegisterRawPayloadHandler(OCClientResponseHandler handler)
+{
+    VERIFY_NON_NULL(handler, ERROR, OC_STACK_INVALID_PARAM);
+
+    OCStackResult result = OC_STACK_NO_MEMORY;
+    OCLockStack();
+    for (size_t i = 0; i < MAX_RAW_PAYLOAD_HANDLERS; i++)
+    {
+        if (!g_rawPayloadHandlers[i] || g_rawPayloadHandlers[i] == handler)
+        {
+            g_rawPayloadHandlers[i] = handler;
+            result = OC_STACK_OK;
+            break;
+        }
+    }
+    OCUnlockStack();
+
+    if (OC_STACK_OK != result)
+    {
+        OIC_LOG(ERROR, TAG, "Too many raw payload handlers");
+    }
+    return result;
+}
+
+OCStackResult OC_CALL OCSetReceiveWorkerCount(uint8_t count)
+{
+#ifndef SINGLE_THREAD
+    if (stackState == OC_STACK_INITIALIZED)
+    {
+        OIC_LOG(ERROR, TAG, "OCSetReceiveWorkerCount must be called before OCInit");
+        return OC_STACK_ERROR;
+    }
+
+    return CAResultToOCResult(CASetReceiveWorkerCount(count));
+#else
+    (void)count;
+    return OC_STACK_NOTIMPL;
+#endif
+}
+
+#ifdef WITH_PRESENCE
+static OCStackResult OCStartPresenceInternal(const uint32_t ttl)
 {
     OIC_LOG(INFO, TAG, "Entering OCStartPresence");
     uint8_t tokenLength = CA_MAX_TOKEN_LEN;
@@ -4011,7 +4421,15 @@ OCStackResult OC_CALL OCStartPresence(const uint32_t ttl)
             OC_PRESENCE_TRIGGER_CREATE);
 }
 
-OCStackResult OC_CALL OCStopPresence()
+OCStackResult OC_CALL OCStartPresence(const uint32_t ttl)
+{
+    OCLockStack();
+    OCStackResult result = OCStartPresenceInternal(ttl);
+    OCUnlockStack();
+    return result;
+}
+
+static OCStackResult OCStopPresenceInternal()
 {
     OIC_LOG(INFO, TAG, "Entering OCStopPresence");
     OCStackResult result = OC_STACK_ERROR;
@@ -4035,6 +4453,14 @@ OCStackResult OC_CALL OCStopPresence()
 
     return SendStopNotification();
 }
+
+OCStackResult OC_CALL OCStopPresence()
+{
+    OCLockStack();
+    OCStackResult result = OCStopPresenceInternal();
+    OCUnlockStack();
+    return result;
+}
 #endif
 
 OCStackResult OC_CALL OCSetDefaultDeviceEntityHandler(OCDeviceEntityHandler entityHandler,
@@ -4067,7 +4493,7 @@ OCStackResult OC_CALL OCCreateResource(OCResourceHandle *handle,
                                   OC_ALL);
 }
 
-OCStackResult OC_CALL OCCreateResourceWithEp(OCResourceHandle *handle,
+static OCStackResult OCCreateResourceWithEpInternal(OCResourceHandle *handle,
         const char *resourceTypeName,
         const char *resourceInterfaceName,
         const char *uri, OCEntityHandler entityHandler,
@@ -4151,22 +4577,13 @@ OCStackResult OC_CALL OCCreateResourceWithEp(OCResourceHandle *handle,
         return OC_STACK_INVALID_PARAM;
     }
 
-    // If the headResource is NULL, then no resources have been created...
-    pointer = headResource;
-    if (pointer)
+    // Repeated URLs are not allowed.  If a repeat is found, exit with an error
+    if (u_hashmap_contains(resourceUriIndex, uri, strlen(uri)))
     {
-        // At least one resources is in the resource list, so we need to search for
-        // repeated URLs, which are not allowed.  If a repeat is found, exit with an error
-        while (pointer)
-        {
-            if (strncmp(uri, pointer->uri, MAX_URI_LENGTH) == 0)
-            {
-                OIC_LOG_V(ERROR, TAG, "Resource %s already exists", uri);
-                return OC_STACK_INVALID_PARAM;
-            }
-            pointer = pointer->next;
-        }
+        OIC_LOG_V(ERROR, TAG, "Resource %s already exists", uri);
+        return OC_STACK_INVALID_PARAM;
     }
+
     // Create the pointer and insert it into the resource list
     pointer = (OCResource *) OICCalloc(1, sizeof(OCResource));
     if (!pointer)
@@ -4176,7 +4593,11 @@ OCStackResult OC_CALL OCCreateResourceWithEp(OCResourceHandle *handle,
     }
     pointer->sequenceNum = OC_OFFSET_SEQUENCE_NUMBER;
 
-    insertResource(pointer);
+    if (OC_STACK_OK != insertResource(pointer))
+    {
+        OICFree(pointer);
+        return OC_STACK_NO_MEMORY;
+    }
 
     // Set the uri
     pointer->uri = OICStrdup(uri);
@@ -4186,6 +4607,12 @@ OCStackResult OC_CALL OCCreateResourceWithEp(OCResourceHandle *handle,
         goto exit;
     }
 
+    if (!u_hashmap_put(resourceUriIndex, pointer->uri, strlen(pointer->uri), pointer))
+    {
+        result = OC_STACK_NO_MEMORY;
+        goto exit;
+    }
+
     // Set resource to nonsecure if caller did not specify
     if ((resourceProperties & OC_MASK_RESOURCE_SECURE) == 0)
     {
@@ -4240,6 +4667,7 @@ OCStackResult OC_CALL OCCreateResourceWithEp(OCResourceHandle *handle,
 
     *handle = pointer;
     result = OC_STACK_OK;
+    OCDiscoveryCacheInvalidate();
 
 #ifdef WITH_PRESENCE
     if (presenceResource.handle)
@@ -4257,7 +4685,24 @@ exit:
     return result;
 }
 
-OCStackResult OC_CALL OCBindResource(
+OCStackResult OC_CALL OCCreateResourceWithEp(OCResourceHandle *handle,
+        const char *resourceTypeName,
+        const char *resourceInterfaceName,
+        const char *uri, OCEntityHandler entityHandler,
+        void *callbackParam,
+        uint8_t resourceProperties,
+        OCTpsSchemeFlags resourceTpsTypes)
+{
+    OCLockStack();
+    OCStackResult result = OCCreateResourceWithEpInternal(handle, resourceTypeName,
+                                                          resourceInterfaceName, uri, entityHandler,
+                                                          callbackParam, resourceProperties,
+                                                          resourceTpsTypes);
+    OCUnlockStack();
+    return result;
+}
+
+static OCStackResult OCBindResourceInternal(
         OCResourceHandle collectionHandle, OCResourceHandle resourceHandle)
 {
     OCResource *resource = NULL;
@@ -4328,7 +4773,16 @@ OCStackResult OC_CALL OCBindResource(
     return OC_STACK_OK;
 }
 
-OCStackResult OC_CALL OCUnBindResource(
+OCStackResult OC_CALL OCBindResource(
+        OCResourceHandle collectionHandle, OCResourceHandle resourceHandle)
+{
+    OCLockStack();
+    OCStackResult result = OCBindResourceInternal(collectionHandle, resourceHandle);
+    OCUnlockStack();
+    return result;
+}
+
+static OCStackResult OCUnBindResourceInternal(
         OCResourceHandle collectionHandle, OCResourceHandle resourceHandle)
 {
     OCResource *resource = NULL;
@@ -4422,6 +4876,15 @@ OCStackResult OC_CALL OCUnBindResource(
     return OC_STACK_ERROR;
 }
 
+OCStackResult OC_CALL OCUnBindResource(
+        OCResourceHandle collectionHandle, OCResourceHandle resourceHandle)
+{
+    OCLockStack();
+    OCStackResult result = OCUnBindResourceInternal(collectionHandle, resourceHandle);
+    OCUnlockStack();
+    return result;
+}
+
 static bool ValidateResourceTypeInterface(const char *resourceItemName)
 {
     if (!resourceItemName)
@@ -4584,7 +5047,7 @@ OCStackResult BindTpsTypeToResource(OCResource* resource,
     return result;
 }
 
-OCStackResult OC_CALL OCBindResourceTypeToResource(OCResourceHandle handle,
+static OCStackResult OCBindResourceTypeToResourceInternal(OCResourceHandle handle,
         const char *resourceTypeName)
 {
 
@@ -4599,6 +5062,7 @@ OCStackResult OC_CALL OCBindResourceTypeToResource(OCResourceHandle handle,
     }
 
     result = BindResourceTypeToResource(resource, resourceTypeName);
+    OCDiscoveryCacheInvalidate();
 
 #ifdef WITH_PRESENCE
     if(presenceResource.handle)
@@ -4611,7 +5075,16 @@ OCStackResult OC_CALL OCBindResourceTypeToResource(OCResourceHandle handle,
     return result;
 }
 
-OCStackResult OC_CALL OCBindResourceInterfaceToResource(OCResourceHandle handle,
+OCStackResult OC_CALL OCBindResourceTypeToResource(OCResourceHandle handle,
+        const char *resourceTypeName)
+{
+    OCLockStack();
+    OCStackResult result = OCBindResourceTypeToResourceInternal(handle, resourceTypeName);
+    OCUnlockStack();
+    return result;
+}
+
+static OCStackResult OCBindResourceInterfaceToResourceInternal(OCResourceHandle handle,
         const char *resourceInterfaceName)
 {
 
@@ -4626,6 +5099,7 @@ OCStackResult OC_CALL OCBindResourceInterfaceToResource(OCResourceHandle handle,
     }
 
     result = BindResourceInterfaceToResource(resource, resourceInterfaceName);
+    OCDiscoveryCacheInvalidate();
 
 #ifdef WITH_PRESENCE
     if (presenceResource.handle)
@@ -4638,6 +5112,16 @@ OCStackResult OC_CALL OCBindResourceInterfaceToResource(OCResourceHandle handle,
     return result;
 }
 
+OCStackResult OC_CALL OCBindResourceInterfaceToResource(OCResourceHandle handle,
+        const char *resourceInterfaceName)
+{
+    OCLockStack();
+    OCStackResult result = OCBindResourceInterfaceToResourceInternal(handle,
+                                                                     resourceInterfaceName);
+    OCUnlockStack();
+    return result;
+}
+
 OCStackResult OC_CALL OCGetNumberOfResources(uint8_t *numResources)
 {
     OCResource *pointer = headResource;
@@ -4654,16 +5138,18 @@ OCStackResult OC_CALL OCGetNumberOfResources(uint8_t *numResources)
 
 OCResourceHandle OC_CALL OCGetResourceHandle(uint8_t index)
 {
+    OCLockStack();
     OCResource *pointer = headResource;
 
     for( uint8_t i = 0; i < index && pointer; ++i)
     {
         pointer = pointer->next;
     }
+    OCUnlockStack();
     return (OCResourceHandle) pointer;
 }
 
-OCStackResult OC_CALL OCDeleteResource(OCResourceHandle handle)
+static OCStackResult OCDeleteResourceInternal(OCResourceHandle handle)
 {
     if (!handle)
     {
@@ -4687,6 +5173,14 @@ OCStackResult OC_CALL OCDeleteResource(OCResourceHandle handle)
     return OC_STACK_OK;
 }
 
+OCStackResult OC_CALL OCDeleteResource(OCResourceHandle handle)
+{
+    OCLockStack();
+    OCStackResult result = OCDeleteResourceInternal(handle);
+    OCUnlockStack();
+    return result;
+}
+
 const char *OC_CALL OCGetResourceUri(OCResourceHandle handle)
 {
     OCResource *resource = NULL;
@@ -4711,7 +5205,8 @@ OCResourceProperty OC_CALL OCGetResourceProperties(OCResourceHandle handle)
     return (OCResourceProperty)-1;
 }
 
-OCStackResult OC_CALL OCSetResourceProperties(OCResourceHandle handle, uint8_t resourceProperties)
+static OCStackResult OCSetResourcePropertiesInternal(OCResourceHandle handle,
+                                                     uint8_t resourceProperties)
 {
     OCResource *resource = NULL;
 
@@ -4722,10 +5217,20 @@ OCStackResult OC_CALL OCSetResourceProperties(OCResourceHandle handle, uint8_t r
         return OC_STACK_NO_RESOURCE;
     }
     resource->resourceProperties = (OCResourceProperty) (resource->resourceProperties | resourceProperties);
+    OCDiscoveryCacheInvalidate();
     return OC_STACK_OK;
 }
 
-OCStackResult OC_CALL OCClearResourceProperties(OCResourceHandle handle, uint8_t resourceProperties)
+OCStackResult OC_CALL OCSetResourceProperties(OCResourceHandle handle, uint8_t resourceProperties)
+{
+    OCLockStack();
+    OCStackResult result = OCSetResourcePropertiesInternal(handle, resourceProperties);
+    OCUnlockStack();
+    return result;
+}
+
+static OCStackResult OCClearResourcePropertiesInternal(OCResourceHandle handle,
+                                                       uint8_t resourceProperties)
 {
     OCResource *resource = NULL;
 
@@ -4736,9 +5241,18 @@ OCStackResult OC_CALL OCClearResourceProperties(OCResourceHandle handle, uint8_t
         return OC_STACK_NO_RESOURCE;
     }
     resource->resourceProperties = (OCResourceProperty) (resource->resourceProperties & ~resourceProperties);
+    OCDiscoveryCacheInvalidate();
     return OC_STACK_OK;
 }
 
+OCStackResult OC_CALL OCClearResourceProperties(OCResourceHandle handle, uint8_t resourceProperties)
+{
+    OCLockStack();
+    OCStackResult result = OCClearResourcePropertiesInternal(handle, resourceProperties);
+    OCUnlockStack();
+    return result;
+}
+
 OCStackResult OC_CALL OCGetNumberOfResourceTypes(OCResourceHandle handle,
         uint8_t *numResourceTypes)
 {
@@ -4944,7 +5458,7 @@ OCStackResult SendStopNotification()
 }
 
 #endif // WITH_PRESENCE
-OCStackResult OC_CALL OCNotifyAllObservers(OCResourceHandle handle, OCQualityOfService qos)
+static OCStackResult OCNotifyAllObserversInternal(OCResourceHandle handle, OCQualityOfService qos)
 {
     OCResource *resPtr = NULL;
     OCStackResult result = OC_STACK_ERROR;
@@ -4982,12 +5496,19 @@ OCStackResult OC_CALL OCNotifyAllObservers(OCResourceHandle handle, OCQualityOfS
     }
 }
 
-OCStackResult
-OC_CALL OCNotifyListOfObservers (OCResourceHandle handle,
-                                 OCObservationId  *obsIdList,
-                                 uint8_t          numberOfIds,
-                                 const OCRepPayload       *payload,
-                                 OCQualityOfService qos)
+OCStackResult OC_CALL OCNotifyAllObservers(OCResourceHandle handle, OCQualityOfService qos)
+{
+    OCLockStack();
+    OCStackResult result = OCNotifyAllObserversInternal(handle, qos);
+    OCUnlockStack();
+    return result;
+}
+
+static OCStackResult OCNotifyListOfObserversInternal(OCResourceHandle handle,
+                                                     OCObservationId  *obsIdList,
+                                                     uint8_t          numberOfIds,
+                                                     const OCRepPayload       *payload,
+                                                     OCQualityOfService qos)
 {
     OIC_LOG(INFO, TAG, "Entering OCNotifyListOfObservers");
 
@@ -5012,7 +5533,21 @@ OC_CALL OCNotifyListOfObservers (OCResourceHandle handle,
             payload, maxAge, qos));
 }
 
-OCStackResult OC_CALL OCDoResponse(OCEntityHandlerResponse *ehResponse)
+OCStackResult
+OC_CALL OCNotifyListOfObservers (OCResourceHandle handle,
+                                 OCObservationId  *obsIdList,
+                                 uint8_t          numberOfIds,
+                                 const OCRepPayload       *payload,
+                                 OCQualityOfService qos)
+{
+    OCLockStack();
+    OCStackResult result = OCNotifyListOfObserversInternal(handle, obsIdList, numberOfIds, payload,
+                                                           qos);
+    OCUnlockStack();
+    return result;
+}
+
+static OCStackResult OCDoResponseInternal(OCEntityHandlerResponse *ehResponse)
 {
     OIC_TRACE_BEGIN(%s:OCDoResponse, TAG);
     OCStackResult result = OC_STACK_ERROR;
@@ -5027,7 +5562,12 @@ OCStackResult OC_CALL OCDoResponse(OCEntityHandlerResponse *ehResponse)
     // Normal response
     // Get pointer to request info
     serverRequest = (OCServerRequest *)ehResponse->requestHandle;
-    if(serverRequest)
+    if (serverRequest && serverRequest->deleted)
+    {
+        // Already answered while the entity handler was still running.
+        OIC_LOG(ERROR, TAG, "Request was already responded to");
+    }
+    else if(serverRequest)
     {
         // response handler in ocserverrequest.c. Usually HandleSingleResponse.
         result = serverRequest->ehResponseHandler(ehResponse);
@@ -5037,6 +5577,14 @@ OCStackResult OC_CALL OCDoResponse(OCEntityHandlerResponse *ehResponse)
     return result;
 }
 
+OCStackResult OC_CALL OCDoResponse(OCEntityHandlerResponse *ehResponse)
+{
+    OCLockStack();
+    OCStackResult result = OCDoResponseInternal(ehResponse);
+    OCUnlockStack();
+    return result;
+}
+
 //#ifdef DIRECT_PAIRING
 const OCDPDev_t* OC_CALL OCDiscoverDirectPairingDevices(unsigned short waittime)
 {
@@ -5109,6 +5657,7 @@ OCStackResult OCChangeResourceProperty(OCResourceProperty * inputProperty,
         OIC_LOG(ERROR, TAG, "Invalid property");
         return OC_STACK_INVALID_PARAM;
     }
+    OCLockStack();
     if(!enable)
     {
         *inputProperty = (OCResourceProperty) (*inputProperty & ~(resourceProperties));
@@ -5117,6 +5666,7 @@ OCStackResult OCChangeResourceProperty(OCResourceProperty * inputProperty,
     {
         *inputProperty = (OCResourceProperty) (*inputProperty | resourceProperties);
     }
+    OCUnlockStack();
     return OC_STACK_OK;
 }
 #endif
@@ -5127,6 +5677,22 @@ OCStackResult initResources()
 
     headResource = NULL;
     tailResource = NULL;
+
+    resourceUriIndex = u_hashmap_create(0);
+    resourceHandleIndex = u_hashmap_create(0);
+    if (!resourceUriIndex || !resourceHandleIndex)
+    {
+        OIC_LOG(ERROR, TAG, "Failed to create resource index");
+        u_hashmap_free(&resourceUriIndex);
+        u_hashmap_free(&resourceHandleIndex);
+        return OC_STACK_NO_MEMORY;
+    }
+    if (OC_STACK_OK != OCDiscoveryCacheInit())
+    {
+        u_hashmap_free(&resourceUriIndex);
+        u_hashmap_free(&resourceHandleIndex);
+        return OC_STACK_ERROR;
+    }
     // Init Virtual Resources
 #ifdef WITH_PRESENCE
     presenceResource.presenceTTL = OC_DEFAULT_PRESENCE_TTL_SECONDS;
@@ -5268,8 +5834,14 @@ OCStackResult initResources()
     return result;
 }
 
-void insertResource(OCResource *resource)
+OCStackResult insertResource(OCResource *resource)
 {
+    if (!u_hashmap_put(resourceHandleIndex, &resource, sizeof(resource), resource))
+    {
+        OIC_LOG(ERROR, TAG, "Failed to index resource handle");
+        return OC_STACK_NO_MEMORY;
+    }
+
     if (!headResource)
     {
         headResource = resource;
@@ -5281,40 +5853,31 @@ void insertResource(OCResource *resource)
         tailResource = resource;
     }
     resource->next = NULL;
+    return OC_STACK_OK;
 }
 
 OCResource *findResource(OCResource *resource)
 {
-    OCResource *pointer = headResource;
-
-    while (pointer)
-    {
-        if (pointer == resource)
-        {
-            return resource;
-        }
-        pointer = pointer->next;
-    }
-    return NULL;
+    return (OCResource *) u_hashmap_get(resourceHandleIndex, &resource, sizeof(resource));
 }
 
 void deleteAllResources()
 {
     OCResource *pointer = headResource;
-    OCResource *temp = NULL;
 
     while (pointer)
     {
-        temp = pointer->next;
 #ifdef WITH_PRESENCE
-        if (pointer != (OCResource *) presenceResource.handle)
+        if (pointer == (OCResource *) presenceResource.handle)
         {
-#endif // WITH_PRESENCE
-            deleteResource(pointer);
-#ifdef WITH_PRESENCE
+            pointer = pointer->next;
+            continue;
         }
 #endif // WITH_PRESENCE
-        pointer = temp;
+        deleteResource(pointer);
+        // Entity handlers notified of the deletion run without the stack lock, so the
+        // rest of the list may have changed meanwhile.
+        pointer = headResource;
     }
     memset(&platformResource, 0, sizeof(platformResource));
     memset(&deviceResource, 0, sizeof(deviceResource));
@@ -5331,6 +5894,10 @@ void deleteAllResources()
     deleteResource((OCResource *) presenceResource.handle);
     memset(&presenceResource, 0, sizeof(presenceResource));
 #endif // WITH_PRESENCE
+
+    u_hashmap_free(&resourceUriIndex);
+    u_hashmap_free(&resourceHandleIndex);
+    OCDiscoveryCacheTerminate();
 }
 
 OCStackResult deleteResource(OCResource *resource)
@@ -5345,27 +5912,42 @@ OCStackResult deleteResource(OCResource *resource)
 
     OIC_LOG_V (INFO, TAG, "Deleting resource %s", resource->uri);
 
-    temp = headResource;
-    while (temp)
+    if (!findResource(resource))
     {
-        if (temp == resource)
-        {
-            // Invalidate all Resource Properties.
-            resource->resourceProperties = (OCResourceProperty) 0;
+        return OC_STACK_ERROR;
+    }
+
+    // Invalidate all Resource Properties.
+    resource->resourceProperties = (OCResourceProperty) 0;
+    OCDiscoveryCacheInvalidate();
 #ifdef WITH_PRESENCE
-            if(resource != (OCResource *) presenceResource.handle)
-            {
+    if(resource != (OCResource *) presenceResource.handle)
+    {
 #endif // WITH_PRESENCE
-                OCNotifyAllObservers((OCResourceHandle)resource, OC_HIGH_QOS);
+        PinResource(resource);
+        OCNotifyAllObservers((OCResourceHandle)resource, OC_HIGH_QOS);
+        UnpinResource(resource);
+        // The entity handlers run without the stack lock, so another thread may
+        // have deleted the resource meanwhile.
+        if (!findResource(resource))
+        {
+            return OC_STACK_ERROR;
+        }
 #ifdef WITH_PRESENCE
-            }
+    }
 
-            if(presenceResource.handle)
-            {
-                ((OCResource *)presenceResource.handle)->sequenceNum = OCGetRandom();
-                SendPresenceNotification(resource->rsrcType, OC_PRESENCE_TRIGGER_DELETE);
-            }
+    if(presenceResource.handle)
+    {
+        ((OCResource *)presenceResource.handle)->sequenceNum = OCGetRandom();
+        SendPresenceNotification(resource->rsrcType, OC_PRESENCE_TRIGGER_DELETE);
+    }
 #endif
+
+    temp = headResource;
+    while (temp)
+    {
+        if (temp == resource)
+        {
             // Only resource in list.
             if (temp == headResource && temp == tailResource)
             {
@@ -5388,6 +5970,18 @@ OCStackResult deleteResource(OCResource *resource)
                 prev->next = temp->next;
             }
 
+            u_hashmap_remove(resourceHandleIndex, &temp, sizeof(temp));
+            if (temp->uri && (temp == u_hashmap_get(resourceUriIndex, temp->uri, strlen(temp->uri))))
+            {
+                u_hashmap_remove(resourceUriIndex, temp->uri, strlen(temp->uri));
+            }
+
+            if (temp->refCount)
+            {
+                // An entity handler is still running; the last UnpinResource frees it.
+                temp->deleted = true;
+                return OC_STACK_OK;
+            }
             deleteResourceElements(temp);
             OICFree(temp);
             temp = NULL;
@@ -5403,6 +5997,30 @@ OCStackResult deleteResource(OCResource *resource)
     return OC_STACK_ERROR;
 }
 
+void PinResource(OCResource *resource)
+{
+    if (resource)
+    {
+        resource->refCount++;
+    }
+}
+
+void UnpinResource(OCResource *resource)
+{
+    if (!resource)
+    {
+        return;
+    }
+
+    assert(resource->refCount);
+    resource->refCount--;
+    if (!resource->refCount && resource->deleted)
+    {
+        deleteResourceElements(resource);
+        OICFree(resource);
+    }
+}
+
 void deleteResourceElements(OCResource *resource)
 {
     if (!resource)
@@ -6179,6 +6797,7 @@ OCStackResult OC_CALL OCGetHeaderOption(OCHeaderOption* ocHdrOpt, size_t numOpti
 void OCDefaultAdapterStateChangedHandler(CATransportAdapter_t adapter, bool enabled)
 {
     OIC_LOG(DEBUG, TAG, "OCDefaultAdapterStateChangedHandler");
+    OCDiscoveryCacheInvalidate();
     if (g_adapterHandler)
     {
         g_adapterHandler(adapter, enabled);
@@ -27,6 +27,7 @@ extern "C"
     #include "ocpayloadcbor.h"
     #include "logger.h"
     #include "oic_malloc.h"
+    #include "oic_string.h"
 }
 
 #include <gtest/gtest.h>
@@ -46,6 +47,8 @@ extern "C"
 #include <string.h>
 
 #include <iostream>
+#include <atomic>
+#include <chrono>
 #include <stdint.h>
 
 #include "gtest_helper.h"
@@ -433,3 +436,129 @@ TEST(CborEmptyArrayTest, EmptyArrayArraySetGetTest)
     OCRepPayloadDestroy(payload_in);
 }
 
+
+static std::atomic<size_t> g_allocations(0);
+
+static void CountAllocation(size_t size)
+{
+    OC_UNUSED(size);
+    g_allocations++;
+}
+
+class CborEncodeBenchmark : public ::testing::Test {
+    protected:
+        virtual void SetUp()
+        {
+            OICSetAllocationHook(CountAllocation);
+        }
+
+        virtual void TearDown()
+        {
+            OICSetAllocationHook(NULL);
+        }
+
+        // Encode the payload repeatedly and log bytes/sec and allocations per encode.
+        void Measure(const char *name, OCPayload *payload)
+        {
+            const size_t rounds = 10000;
+            size_t bytes = 0;
+            size_t allocations = g_allocations;
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < rounds; ++i)
+            {
+                uint8_t *cbor = NULL;
+                size_t size = 0;
+                ASSERT_EQ(OC_STACK_OK, OCConvertPayload(payload, OC_FORMAT_CBOR, &cbor, &size));
+                bytes += size;
+                OICFree(cbor);
+            }
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start);
+            double bytesPerSec = elapsed.count() ? (bytes * 1000000.0) / elapsed.count() : 0;
+            allocations = g_allocations - allocations;
+
+            std::cout << name << ": " << bytes / rounds << " bytes, " << bytesPerSec
+                      << " bytes/sec, " << (double)allocations / rounds
+                      << " allocations/encode" << std::endl;
+
+            // the first pass runs in the scratch buffer and yields the exact size,
+            // so only the output buffer is allocated.
+            EXPECT_GE(rounds, allocations);
+        }
+};
+
+TEST_F(CborEncodeBenchmark, Discovery)
+{
+    OCDiscoveryPayload *payload = OCDiscoveryPayloadCreate();
+    ASSERT_TRUE(payload != NULL);
+    payload->sid = OICStrdup("0685B960-736F-46F7-BEC0-9E6CBD61ADC1");
+    payload->name = OICStrdup("MyDevice");
+    OCResourcePayloadAddStringLL(&payload->type, OC_RSRVD_RESOURCE_TYPE_RES);
+    OCResourcePayloadAddStringLL(&payload->iface, OC_RSRVD_INTERFACE_LL);
+    OCResourcePayloadAddStringLL(&payload->iface, OC_RSRVD_INTERFACE_DEFAULT);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        OCResourcePayload *resource = (OCResourcePayload *)OICCalloc(1, sizeof(OCResourcePayload));
+        ASSERT_TRUE(resource != NULL);
+        char uri[32];
+        snprintf(uri, sizeof(uri), "/a/light/%d", i);
+        resource->uri = OICStrdup(uri);
+        OCResourcePayloadAddStringLL(&resource->types, "core.light");
+        OCResourcePayloadAddStringLL(&resource->types, "core.brightlight");
+        OCResourcePayloadAddStringLL(&resource->interfaces, OC_RSRVD_INTERFACE_DEFAULT);
+        OCResourcePayloadAddStringLL(&resource->interfaces, OC_RSRVD_INTERFACE_READ);
+        resource->bitmap = OC_DISCOVERABLE | OC_OBSERVABLE;
+        resource->secure = (i % 2) == 0;
+        resource->port = 49152;
+        OCDiscoveryPayloadAddNewResource(payload, resource);
+    }
+
+    Measure("discovery", (OCPayload *)payload);
+    OCDiscoveryPayloadDestroy(payload);
+}
+
+TEST_F(CborEncodeBenchmark, Representation)
+{
+    OCRepPayload *payload = OCRepPayloadCreate();
+    ASSERT_TRUE(payload != NULL);
+    OCRepPayloadSetUri(payload, "/a/light");
+    OCRepPayloadAddResourceType(payload, "core.light");
+    OCRepPayloadAddInterface(payload, OC_RSRVD_INTERFACE_DEFAULT);
+    OCRepPayloadSetPropBool(payload, "state", true);
+    OCRepPayloadSetPropInt(payload, "power", 10);
+    OCRepPayloadSetPropDouble(payload, "temperature", 21.5);
+    OCRepPayloadSetPropString(payload, "name", "living room light");
+
+    double values[32];
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i)
+    {
+        values[i] = i * 0.5;
+    }
+    size_t dimensions[MAX_REP_ARRAY_DEPTH] = {sizeof(values) / sizeof(values[0]), 0, 0};
+    OCRepPayloadSetDoubleArray(payload, "history", values, dimensions);
+
+    OCRepPayload *child = OCRepPayloadCreate();
+    ASSERT_TRUE(child != NULL);
+    OCRepPayloadSetPropInt(child, "red", 255);
+    OCRepPayloadSetPropInt(child, "green", 128);
+    OCRepPayloadSetPropInt(child, "blue", 0);
+    OCRepPayloadSetPropObjectAsOwner(payload, "color", child);
+
+    Measure("representation", (OCPayload *)payload);
+    OCRepPayloadDestroy(payload);
+}
+
+TEST_F(CborEncodeBenchmark, Security)
+{
+    uint8_t data[512];
+    for (size_t i = 0; i < sizeof(data); ++i)
+    {
+        data[i] = (uint8_t)i;
+    }
+    OCSecurityPayload *payload = OCSecurityPayloadCreate(data, sizeof(data));
+    ASSERT_TRUE(payload != NULL);
+
+    Measure("security", (OCPayload *)payload);
+    OCSecurityPayloadDestroy(payload);
+}
@@ -28,12 +28,25 @@ extern "C"
     #include "oic_malloc.h"
     #include "oic_string.h"
     #include "oic_time.h"
+    #include "ocevent.h"
     #include "ocresourcehandler.h"
+    #include "ocobserve.h"
+    #include "ocdiscoverycache.h"
+    #include "occlientcb.h"
 }
 
 #include <gtest/gtest.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#ifdef HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+#ifdef HAVE_NETINET_IN_H
+#include <netinet/in.h>
+#endif
+#ifdef HAVE_ARPA_INET_H
+#include <arpa/inet.h>
+#endif
 #include <errno.h>
 #include <fcntl.h>
 #ifdef HAVE_UNISTD_H
@@ -47,8 +60,12 @@ extern "C"
 #include <stdio.h>
 #include <string.h>
 
+#include <atomic>
 #include <iostream>
+#include <mutex>
 #include <stdint.h>
+#include <thread>
+#include <vector>
 
 #include "gtest_helper.h"
 
@@ -303,6 +320,74 @@ TEST(StackStart, StackStartSuccessiveInits)
     EXPECT_EQ(0u, g_ocStackStartCount);
 }
 
+TEST(StackStart, StackStartWithReceiveWorkers)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    EXPECT_EQ(OC_STACK_OK, OCSetReceiveWorkerCount(4));
+    EXPECT_EQ(OC_STACK_OK, OCInit("127.0.0.1", 5683, OC_CLIENT_SERVER));
+    EXPECT_EQ(OC_STACK_ERROR, OCSetReceiveWorkerCount(2));
+    EXPECT_EQ(OC_STACK_OK, OCProcess());
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+    EXPECT_NE(OC_STACK_OK, OCSetReceiveWorkerCount(255));
+    EXPECT_EQ(OC_STACK_OK, OCSetReceiveWorkerCount(0));
+}
+
+TEST(StackStart, StackProcessEvent)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    uint32_t nextEventTime = 0;
+    EXPECT_EQ(OC_STACK_INVALID_PARAM, OCProcessEvent(NULL));
+    EXPECT_EQ(OC_STACK_ERROR, OCProcessEvent(&nextEventTime));
+
+    oc_event event = oc_event_new();
+    ASSERT_TRUE(NULL != event);
+    EXPECT_EQ(OC_STACK_OK, OCInit("127.0.0.1", 5683, OC_CLIENT_SERVER));
+    EXPECT_EQ(OC_STACK_INVALID_PARAM, OCRegisterProcessEvent(NULL));
+    EXPECT_EQ(OC_STACK_OK, OCRegisterProcessEvent(event));
+    // registering signals the event in case work is already pending.
+    EXPECT_EQ(OC_WAIT_SUCCESS, oc_event_wait_for(event, 1000));
+
+    EXPECT_EQ(OC_STACK_OK, OCProcessEvent(&nextEventTime));
+    EXPECT_LT(0u, nextEventTime);
+
+    OCUnregisterProcessEvent(event);
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+    oc_event_free(event);
+}
+
+TEST(StackStart, StackProcessEventClientServer)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    EXPECT_EQ(OC_STACK_OK, OCInit("127.0.0.1", 5683, OC_CLIENT_SERVER));
+
+    // In client/server mode the client and server processing threads each
+    // register their own event.
+    oc_event clientEvent = oc_event_new();
+    oc_event serverEvent = oc_event_new();
+    ASSERT_TRUE(NULL != clientEvent);
+    ASSERT_TRUE(NULL != serverEvent);
+    EXPECT_EQ(OC_STACK_OK, OCRegisterProcessEvent(serverEvent));
+    EXPECT_EQ(OC_STACK_OK, OCRegisterProcessEvent(clientEvent));
+    EXPECT_EQ(OC_WAIT_SUCCESS, oc_event_wait_for(serverEvent, 1000));
+    EXPECT_EQ(OC_WAIT_SUCCESS, oc_event_wait_for(clientEvent, 1000));
+
+    OCSignalProcessEvent();
+    EXPECT_EQ(OC_WAIT_SUCCESS, oc_event_wait_for(serverEvent, 1000));
+    EXPECT_EQ(OC_WAIT_SUCCESS, oc_event_wait_for(clientEvent, 1000));
+
+    // Stopping the client must not stop signalling the server.
+    OCUnregisterProcessEvent(clientEvent);
+    oc_event_wait_for(clientEvent, 0);
+    OCSignalProcessEvent();
+    EXPECT_EQ(OC_WAIT_SUCCESS, oc_event_wait_for(serverEvent, 1000));
+    EXPECT_EQ(OC_WAIT_TIMEDOUT, oc_event_wait_for(clientEvent, 10));
+
+    OCUnregisterProcessEvent(serverEvent);
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+    oc_event_free(clientEvent);
+    oc_event_free(serverEvent);
+}
+
 TEST(StackStart, SetPlatformInfoValid)
 {
     itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
@@ -2330,6 +2415,512 @@ TEST(StackResourceAccess, DeleteMiddleResource)
     EXPECT_EQ(OC_STACK_OK, OCStop());
 }
 
+TEST(StackResourceAccess, FindResourceByUriAfterDelete)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting FindResourceByUriAfterDelete test");
+    InitStack(OC_SERVER);
+
+    OCResourceHandle handle0;
+    EXPECT_EQ(OC_STACK_OK, OCCreateResource(&handle0,
+                                            "core.led",
+                                            "core.rw",
+                                            "/a/led0",
+                                            0,
+                                            NULL,
+                                            OC_DISCOVERABLE|OC_OBSERVABLE));
+    OCResourceHandle handle1;
+    EXPECT_EQ(OC_STACK_OK, OCCreateResource(&handle1,
+                                            "core.led",
+                                            "core.rw",
+                                            "/a/led1",
+                                            0,
+                                            NULL,
+                                            OC_DISCOVERABLE|OC_OBSERVABLE));
+
+    EXPECT_EQ(handle0, FindResourceByUri("/a/led0"));
+    EXPECT_EQ(handle1, FindResourceByUri("/a/led1"));
+
+    EXPECT_EQ(OC_STACK_OK, OCDeleteResource(handle0));
+    EXPECT_EQ(NULL, FindResourceByUri("/a/led0"));
+    EXPECT_EQ(handle1, FindResourceByUri("/a/led1"));
+    EXPECT_EQ(OC_STACK_ERROR, OCDeleteResource(handle0));
+
+    // The URI can be reused once the previous resource is gone.
+    EXPECT_EQ(OC_STACK_OK, OCCreateResource(&handle0,
+                                            "core.led",
+                                            "core.rw",
+                                            "/a/led0",
+                                            0,
+                                            NULL,
+                                            OC_DISCOVERABLE|OC_OBSERVABLE));
+    EXPECT_EQ(handle0, FindResourceByUri("/a/led0"));
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
+TEST(StackResourceAccess, GroupedNotificationWithoutObservers)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting GroupedNotificationWithoutObservers test");
+    InitStack(OC_SERVER);
+
+    OCResourceHandle handle;
+    EXPECT_EQ(OC_STACK_OK, OCCreateResource(&handle,
+                                            "core.led",
+                                            "core.rw",
+                                            "/a/led",
+                                            entityHandler,
+                                            NULL,
+                                            OC_DISCOVERABLE|OC_OBSERVABLE));
+
+    EXPECT_EQ(OC_STACK_OK, OCSetGroupedObserverNotification(true));
+    EXPECT_EQ(OC_STACK_NO_OBSERVERS, OCNotifyAllObservers(handle, OC_NA_QOS));
+    EXPECT_EQ(OC_STACK_OK, OCSetGroupedObserverNotification(false));
+    EXPECT_EQ(OC_STACK_NO_OBSERVERS, OCNotifyAllObservers(handle, OC_NA_QOS));
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
+static size_t g_groupedNotificationCalls = 0;
+static size_t g_groupedNotificationMembers = 0;
+
+static OCEntityHandlerResult GroupedNotificationHandler(OCEntityHandlerFlag /*flag*/,
+                                                        OCEntityHandlerRequest *ehRequest,
+                                                        void* /*callbackParam*/)
+{
+    OCServerRequest *request = (OCServerRequest *) ehRequest->requestHandle;
+    g_groupedNotificationCalls++;
+    g_groupedNotificationMembers = request->numGroupObservers;
+
+    OCRepPayload *payload = OCRepPayloadCreate();
+    OCRepPayloadSetPropInt(payload, "power", 1);
+
+    OCEntityHandlerResponse response = {};
+    response.requestHandle = ehRequest->requestHandle;
+    response.resourceHandle = ehRequest->resource;
+    response.ehResult = OC_EH_OK;
+    response.payload = (OCPayload *) payload;
+    EXPECT_EQ(OC_STACK_OK, OCDoResponse(&response));
+
+    OCRepPayloadDestroy(payload);
+    return OC_EH_OK;
+}
+
+#ifdef HAVE_SYS_SOCKET_H
+/**
+ * Count the notifications received on sock, one per observer index carried in the token.
+ */
+static size_t ReceiveGroupedNotifications(int sock, size_t numObservers)
+{
+    std::vector<bool> notified(numObservers, false);
+    size_t count = 0;
+    uint8_t buffer[COAP_MAX_PDU_SIZE];
+
+    while (count < numObservers)
+    {
+        ssize_t len = recv(sock, buffer, sizeof(buffer), 0);
+        if (len <= 0)
+        {
+            break;
+        }
+
+        // CoAP header: version, type and token length, code, message id, token.
+        size_t tokenLength = buffer[0] & 0x0f;
+        size_t index = 0;
+        if (tokenLength != sizeof(index) || (size_t)len < 4 + tokenLength)
+        {
+            continue;
+        }
+        memcpy(&index, &buffer[4], sizeof(index));
+        EXPECT_GT(numObservers, index);
+        if (index < numObservers && !notified[index])
+        {
+            notified[index] = true;
+            count++;
+        }
+    }
+    return count;
+}
+
+TEST(StackResourceAccess, GroupedNotificationMoreThan255Observers)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting GroupedNotificationMoreThan255Observers test");
+    InitStack(OC_SERVER);
+
+    OCResourceHandle handle;
+    EXPECT_EQ(OC_STACK_OK, OCCreateResource(&handle,
+                                            "core.led",
+                                            "core.rw",
+                                            "/a/led",
+                                            GroupedNotificationHandler,
+                                            NULL,
+                                            OC_DISCOVERABLE|OC_OBSERVABLE));
+
+    // Every observer listens on the same socket and is told apart by its token.
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_LE(0, sock);
+    struct sockaddr_in sin = {};
+    sin.sin_family = AF_INET;
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(0, bind(sock, (struct sockaddr *)&sin, sizeof(sin)));
+    socklen_t sinLen = sizeof(sin);
+    ASSERT_EQ(0, getsockname(sock, (struct sockaddr *)&sin, &sinLen));
+    int rcvbuf = 1024 * 1024;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    struct timeval timeout = { 2, 0 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    const size_t numObservers = 300;
+    OCDevAddr devAddr = {};
+    devAddr.adapter = OC_ADAPTER_IP;
+    devAddr.flags = OC_IP_USE_V4;
+    devAddr.port = ntohs(sin.sin_port);
+    OICStrcpy(devAddr.addr, sizeof(devAddr.addr), "127.0.0.1");
+    for (size_t i = 0; i < numObservers; i++)
+    {
+        char token[CA_MAX_TOKEN_LEN] = { 0 };
+        memcpy(token, &i, sizeof(i));
+        ASSERT_EQ(OC_STACK_OK, AddObserver("/a/led", NULL, (OCObservationId)(i + 1),
+                                           token, sizeof(i), (OCResource *) handle,
+                                           OC_LOW_QOS, OC_FORMAT_CBOR, 0, &devAddr));
+    }
+
+    size_t received = 0;
+    std::thread receiver([&]() { received = ReceiveGroupedNotifications(sock, numObservers); });
+
+    g_groupedNotificationCalls = 0;
+    g_groupedNotificationMembers = 0;
+    EXPECT_EQ(OC_STACK_OK, OCSetGroupedObserverNotification(true));
+    EXPECT_EQ(OC_STACK_OK, OCNotifyAllObservers(handle, OC_NA_QOS));
+    receiver.join();
+    close(sock);
+
+    // One entity handler call for the leader; every other observer rides along.
+    EXPECT_EQ(1u, g_groupedNotificationCalls);
+    EXPECT_EQ(numObservers - 1, g_groupedNotificationMembers);
+    // The encoded response reaches every observer once.
+    EXPECT_EQ(numObservers, received);
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+#endif // HAVE_SYS_SOCKET_H
+
+TEST(StackResourceAccess, GroupedNotificationIsResetByStop)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    InitStack(OC_SERVER);
+
+    OCResourceHandle handle;
+    EXPECT_EQ(OC_STACK_OK, OCCreateResource(&handle,
+                                            "core.led",
+                                            "core.rw",
+                                            "/a/led",
+                                            GroupedNotificationHandler,
+                                            NULL,
+                                            OC_DISCOVERABLE|OC_OBSERVABLE));
+    EXPECT_EQ(OC_STACK_OK, OCSetGroupedObserverNotification(true));
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+
+    InitStack(OC_SERVER);
+    EXPECT_EQ(OC_STACK_OK, OCCreateResource(&handle,
+                                            "core.led",
+                                            "core.rw",
+                                            "/a/led",
+                                            GroupedNotificationHandler,
+                                            NULL,
+                                            OC_DISCOVERABLE|OC_OBSERVABLE));
+
+    OCDevAddr devAddr = {};
+    devAddr.adapter = OC_ADAPTER_IP;
+    devAddr.flags = OC_IP_USE_V4;
+    devAddr.port = 9;
+    OICStrcpy(devAddr.addr, sizeof(devAddr.addr), "127.0.0.1");
+    for (size_t i = 0; i < 2; i++)
+    {
+        char token[CA_MAX_TOKEN_LEN] = { 0 };
+        memcpy(token, &i, sizeof(i));
+        ASSERT_EQ(OC_STACK_OK, AddObserver("/a/led", NULL, (OCObservationId)(i + 1),
+                                           token, sizeof(i), (OCResource *) handle,
+                                           OC_LOW_QOS, OC_FORMAT_CBOR, 0, &devAddr));
+    }
+
+    // Without grouping each observer gets its own entity handler call.
+    g_groupedNotificationCalls = 0;
+    g_groupedNotificationMembers = 0;
+    EXPECT_EQ(OC_STACK_OK, OCNotifyAllObservers(handle, OC_NA_QOS));
+    EXPECT_EQ(2u, g_groupedNotificationCalls);
+    EXPECT_EQ(0u, g_groupedNotificationMembers);
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
+struct ConcurrentDeleteState
+{
+    std::atomic<size_t> handled;
+};
+
+static OCEntityHandlerResult ConcurrentDeleteHandler(OCEntityHandlerFlag /*flag*/,
+                                                     OCEntityHandlerRequest *ehRequest,
+                                                     void *callbackParam)
+{
+    ConcurrentDeleteState *state = (ConcurrentDeleteState *) callbackParam;
+    // Widen the window in which OCDeleteResource could race with this handler.
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    // The handler runs without the stack lock, so the resource may be deleted meanwhile,
+    // but it stays allocated until the handler returns.
+    EXPECT_STREQ("/a/led", ((OCResource *) ehRequest->resource)->uri);
+    state->handled++;
+    return OC_EH_OK;
+}
+
+static void SendConcurrentGets(uint16_t port, size_t count)
+{
+    CAEndpoint_t endpoint = {};
+    endpoint.adapter = CA_ADAPTER_IP;
+    endpoint.flags = CA_IPV4;
+    endpoint.port = port;
+    OICStrcpy(endpoint.addr, sizeof(endpoint.addr), "127.0.0.1");
+
+    char uri[] = "/a/led";
+    for (size_t i = 0; i < count; i++)
+    {
+        char token[CA_MAX_TOKEN_LEN] = { 0 };
+        memcpy(token, &i, sizeof(i));
+
+        CARequestInfo_t requestInfo = {};
+        requestInfo.method = CA_GET;
+        requestInfo.info.type = CA_MSG_NONCONFIRM;
+        requestInfo.info.messageId = (uint16_t)(i + 1);
+        requestInfo.info.token = token;
+        requestInfo.info.tokenLength = sizeof(i);
+        requestInfo.info.resourceUri = uri;
+        HandleCARequests(&endpoint, &requestInfo);
+    }
+}
+
+TEST(StackResourceAccess, ConcurrentRequestsWhileDeletingResource)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting ConcurrentRequestsWhileDeletingResource test");
+    InitStack(OC_SERVER);
+
+    ConcurrentDeleteState state;
+    state.handled = 0;
+
+    OCResourceHandle handle;
+    ASSERT_EQ(OC_STACK_OK, OCCreateResource(&handle,
+                                            "core.led",
+                                            "core.rw",
+                                            "/a/led",
+                                            ConcurrentDeleteHandler,
+                                            &state,
+                                            OC_DISCOVERABLE|OC_OBSERVABLE));
+
+    // Each thread plays the part of a receive worker.
+    const size_t numThreads = 4;
+    const size_t requestsPerThread = 200;
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < numThreads; i++)
+    {
+        workers.push_back(std::thread(SendConcurrentGets, (uint16_t)(20000 + i),
+                                      requestsPerThread));
+    }
+
+    while (state.handled < numThreads)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(OC_STACK_OK, OCDeleteResource(handle));
+    EXPECT_TRUE(NULL == OCGetResourceUri(handle));
+
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    // Handlers that were running during the delete have returned; no new ones start.
+    size_t handled = state.handled;
+    SendConcurrentGets(20000, 10);
+    EXPECT_EQ(handled, state.handled.load());
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
+struct BlockingHandlerState
+{
+    std::mutex appLock;
+    std::atomic<bool> entered;
+    std::atomic<bool> done;
+};
+
+static OCEntityHandlerResult BlockingHandler(OCEntityHandlerFlag /*flag*/,
+                                             OCEntityHandlerRequest * /*ehRequest*/,
+                                             void *callbackParam)
+{
+    BlockingHandlerState *state = (BlockingHandlerState *) callbackParam;
+    state->entered = true;
+    std::lock_guard<std::mutex> lock(state->appLock);
+    state->done = true;
+    return OC_EH_OK;
+}
+
+TEST(StackResourceAccess, EntityHandlerMayWaitForThreadCallingStack)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting EntityHandlerMayWaitForThreadCallingStack test");
+    InitStack(OC_SERVER);
+
+    BlockingHandlerState state;
+    state.entered = false;
+    state.done = false;
+
+    OCResourceHandle handle;
+    ASSERT_EQ(OC_STACK_OK, OCCreateResource(&handle,
+                                            "core.led",
+                                            "core.rw",
+                                            "/a/led",
+                                            BlockingHandler,
+                                            &state,
+                                            OC_DISCOVERABLE|OC_OBSERVABLE));
+
+    // Like the C++ server wrapper: the application thread holds its own lock while
+    // calling into the stack, and the entity handler waits for that lock.
+    state.appLock.lock();
+    std::thread worker(SendConcurrentGets, (uint16_t)20000, (size_t)1);
+    while (!state.entered)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(OC_STACK_OK, OCBindResourceTypeToResource(handle, "core.brightled"));
+    EXPECT_EQ(OC_STACK_OK, OCSetResourceProperties(handle, OC_SLOW));
+    EXPECT_TRUE(NULL != OCGetResourceHandle(0));
+    state.appLock.unlock();
+
+    worker.join();
+    EXPECT_TRUE(state.done);
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
+struct CancellingCallbackState
+{
+    OCDoHandle handle;
+    size_t called;
+    size_t contextDeleted;
+};
+
+static OCStackApplicationResult CancellingCallback(void *context, OCDoHandle handle,
+                                                   OCClientResponse * /*clientResponse*/)
+{
+    CancellingCallbackState *state = (CancellingCallbackState *) context;
+    EXPECT_EQ(state->handle, handle);
+    state->called++;
+    EXPECT_EQ(OC_STACK_OK, OCCancel(handle, OC_LOW_QOS, NULL, 0));
+    // The node and its context are freed once the callback returns, not before.
+    EXPECT_EQ(0u, state->contextDeleted);
+    return OC_STACK_KEEP_TRANSACTION;
+}
+
+static void CancellingCallbackDeleter(void *context)
+{
+    ((CancellingCallbackState *) context)->contextDeleted++;
+}
+
+TEST(StackResourceAccess, ClientCallbackMayCancelItself)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting ClientCallbackMayCancelItself test");
+    InitStack(OC_CLIENT);
+
+    CancellingCallbackState state = { NULL, 0, 0 };
+    OCCallbackData cbData;
+    cbData.cb = CancellingCallback;
+    cbData.context = &state;
+    cbData.cd = CancellingCallbackDeleter;
+
+    EXPECT_EQ(OC_STACK_OK, OCDoResource(&state.handle, OC_REST_DISCOVER, "/oic/res", NULL, 0,
+                                        CT_ADAPTER_IP, OC_LOW_QOS, &cbData, NULL, 0));
+    ClientCB *cbNode = GetClientCBUsingHandle(state.handle);
+    ASSERT_TRUE(NULL != cbNode);
+
+    CAEndpoint_t endpoint = {};
+    endpoint.adapter = CA_ADAPTER_IP;
+    endpoint.flags = CA_IPV4;
+    endpoint.port = 20000;
+    OICStrcpy(endpoint.addr, sizeof(endpoint.addr), "127.0.0.1");
+
+    // The callback frees cbNode, so pass a copy of its token.
+    char token[CA_MAX_TOKEN_LEN] = { 0 };
+    memcpy(token, cbNode->token, cbNode->tokenLength);
+
+    CAErrorInfo_t errorInfo = {};
+    errorInfo.result = CA_SEND_FAILED;
+    errorInfo.info.token = token;
+    errorInfo.info.tokenLength = cbNode->tokenLength;
+    HandleCAErrorResponse(&endpoint, &errorInfo);
+
+    EXPECT_EQ(1u, state.called);
+    EXPECT_EQ(1u, state.contextDeleted);
+    EXPECT_TRUE(NULL == GetClientCBUsingHandle(state.handle));
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
+TEST(StackResourceAccess, RequestDispatchLatency)
+{
+    itst::DeadmanTimer killSwitch(LONG_TEST_TIMEOUT);
+    OIC_LOG(INFO, TAG, "Starting RequestDispatchLatency test");
+
+    const size_t resourceCounts[] = { 10, 1000, 10000 };
+    const size_t lookups = 100000;
+
+    for (size_t count : resourceCounts)
+    {
+        InitStack(OC_SERVER);
+
+        char uri[MAX_URI_LENGTH];
+        for (size_t i = 0; i < count; ++i)
+        {
+            OCResourceHandle handle;
+            snprintf(uri, sizeof(uri), "/a/light/%u", (unsigned)i);
+            ASSERT_EQ(OC_STACK_OK, OCCreateResource(&handle,
+                                                    "core.light",
+                                                    "core.rw",
+                                                    uri,
+                                                    entityHandler,
+                                                    NULL,
+                                                    OC_DISCOVERABLE));
+        }
+
+        OCServerRequest request;
+        memset(&request, 0, sizeof(request));
+        request.devAddr.adapter = OC_ADAPTER_IP;
+        request.devAddr.flags = OC_IP_USE_V4;
+        // Worst case for the previous list walk: the most recently created resource.
+        snprintf(request.resourceUrl, sizeof(request.resourceUrl),
+                 "/a/light/%u", (unsigned)(count - 1));
+
+        ResourceHandling handling;
+        OCResource *resource = NULL;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < lookups; ++i)
+        {
+            ASSERT_EQ(OC_STACK_OK, DetermineResourceHandling(&request, &handling, &resource));
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start);
+
+        EXPECT_EQ(OC_RESOURCE_NOT_COLLECTION_WITH_ENTITYHANDLER, handling);
+        EXPECT_STREQ(request.resourceUrl, resource->uri);
+        OIC_LOG_V(INFO, TAG, "%u resources: %lld ns per dispatch lookup",
+                  (unsigned)count, (long long)(elapsed.count() / lookups));
+
+        EXPECT_EQ(OC_STACK_OK, OCStop());
+    }
+}
+
 // Visual Studio versions earlier than 2015 have bugs in is_pod and report the wrong answer.
 #if !defined(_MSC_VER) || (_MSC_VER >= 1900)
 TEST(PODTests, OCHeaderOption)
@@ -3337,3 +3928,346 @@ TEST(OCIpv6ScopeLevel, invalidAddressTest)
     EXPECT_EQ(OC_STACK_ERROR, OCGetIpv6AddrScope(invalidAddr3, &scopeLevel));
     EXPECT_EQ(OC_STACK_ERROR, OCGetIpv6AddrScope(invalidAddr4, &scopeLevel));
 }
+
+class OCDiscoveryCacheTests : public testing::Test
+{
+    protected:
+        virtual void SetUp()
+        {
+            memset(&m_devAddr, 0, sizeof(m_devAddr));
+            m_devAddr.adapter = OC_ADAPTER_IP;
+            m_devAddr.flags = OC_IP_USE_V4;
+            m_devAddr.ifindex = 2;
+
+            memset(m_networkInfo, 0, sizeof(m_networkInfo));
+            m_networkInfo[0].adapter = CA_ADAPTER_IP;
+            m_networkInfo[0].flags = CA_IPV4;
+            m_networkInfo[0].ifindex = 2;
+            m_networkInfo[0].port = 5683;
+            OICStrcpy(m_networkInfo[0].addr, sizeof(m_networkInfo[0].addr), "192.168.1.2");
+
+            m_key.uri = OC_WELL_KNOWN_URI;
+            m_key.interfaceQuery = OC_RSRVD_INTERFACE_LL;
+            m_key.resourceTypeQuery = NULL;
+            m_key.acceptFormat = OC_FORMAT_CBOR;
+            m_key.acceptVersion = 0;
+            m_key.devAddr = &m_devAddr;
+            m_key.deviceId = "2a1ca7e1-2c8b-4f1e-a26b-4e1a5a1b8c3d";
+            m_key.networkInfo = m_networkInfo;
+            m_key.infoSize = 1;
+
+            ASSERT_EQ(OC_STACK_OK, OCDiscoveryCacheInit());
+        }
+
+        virtual void TearDown()
+        {
+            OCDiscoveryCacheTerminate();
+        }
+
+        bool IsCached()
+        {
+            OCPayload *payload = OCDiscoveryCacheLookup(&m_key);
+            OCPayloadDestroy(payload);
+            return NULL != payload;
+        }
+
+        OCDevAddr m_devAddr;
+        CAEndpoint_t m_networkInfo[1];
+        OCDiscoveryCacheKey m_key;
+};
+
+static const uint8_t g_encodedDiscovery[] = { 0x9f, 0xbf, 0x63, 'r', 't', 's', 0xff, 0xff };
+
+TEST_F(OCDiscoveryCacheTests, LookupReturnsStoredResponse)
+{
+    EXPECT_TRUE(NULL == OCDiscoveryCacheLookup(&m_key));
+    EXPECT_EQ(OC_STACK_OK, OCDiscoveryCacheStore(&m_key, g_encodedDiscovery,
+                                                 sizeof(g_encodedDiscovery)));
+
+    OCPayload *payload = OCDiscoveryCacheLookup(&m_key);
+    ASSERT_TRUE(NULL != payload);
+    EXPECT_EQ(PAYLOAD_TYPE_SECURITY, payload->type);
+    OCSecurityPayload *encoded = (OCSecurityPayload *)payload;
+    ASSERT_EQ(sizeof(g_encodedDiscovery), encoded->payloadSize);
+    EXPECT_EQ(0, memcmp(g_encodedDiscovery, encoded->securityData, encoded->payloadSize));
+    OCPayloadDestroy(payload);
+
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    OCDiscoveryCacheGetStats(&hits, &misses);
+    EXPECT_EQ(1u, hits);
+    EXPECT_EQ(1u, misses);
+}
+
+TEST_F(OCDiscoveryCacheTests, RequestParametersAreMatched)
+{
+    EXPECT_EQ(OC_STACK_OK, OCDiscoveryCacheStore(&m_key, g_encodedDiscovery,
+                                                 sizeof(g_encodedDiscovery)));
+
+    // multicast and unicast requests share the response.
+    m_devAddr.flags = (OCTransportFlags)(OC_IP_USE_V4 | OC_MULTICAST);
+    EXPECT_TRUE(IsCached());
+
+    m_key.resourceTypeQuery = "oic.r.light";
+    EXPECT_FALSE(IsCached());
+    m_key.resourceTypeQuery = NULL;
+
+    m_key.acceptFormat = OC_FORMAT_VND_OCF_CBOR;
+    EXPECT_FALSE(IsCached());
+    m_key.acceptFormat = OC_FORMAT_CBOR;
+
+    m_devAddr.ifindex = 3;
+    EXPECT_FALSE(IsCached());
+    m_devAddr.ifindex = 2;
+
+    m_devAddr.flags = OC_IP_USE_V6;
+    EXPECT_FALSE(IsCached());
+    m_devAddr.flags = OC_IP_USE_V4;
+
+    EXPECT_TRUE(IsCached());
+}
+
+TEST_F(OCDiscoveryCacheTests, NetworkChangeMissesCache)
+{
+    EXPECT_EQ(OC_STACK_OK, OCDiscoveryCacheStore(&m_key, g_encodedDiscovery,
+                                                 sizeof(g_encodedDiscovery)));
+
+    OICStrcpy(m_networkInfo[0].addr, sizeof(m_networkInfo[0].addr), "192.168.1.3");
+    EXPECT_FALSE(IsCached());
+
+    m_key.infoSize = 0;
+    EXPECT_FALSE(IsCached());
+}
+
+TEST_F(OCDiscoveryCacheTests, InvalidateDropsResponses)
+{
+    EXPECT_EQ(OC_STACK_OK, OCDiscoveryCacheStore(&m_key, g_encodedDiscovery,
+                                                 sizeof(g_encodedDiscovery)));
+    EXPECT_TRUE(IsCached());
+
+    OCDiscoveryCacheInvalidate();
+    EXPECT_FALSE(IsCached());
+}
+
+TEST_F(OCDiscoveryCacheTests, LeastRecentlyUsedResponseIsReplaced)
+{
+    char query[16];
+    for (int i = 0; i < OC_DISCOVERY_CACHE_SIZE; i++)
+    {
+        snprintf(query, sizeof(query), "oic.r.%d", i);
+        m_key.resourceTypeQuery = query;
+        EXPECT_EQ(OC_STACK_OK, OCDiscoveryCacheStore(&m_key, g_encodedDiscovery,
+                                                     sizeof(g_encodedDiscovery)));
+    }
+
+    // keep the first response in use, the second one is the oldest now.
+    m_key.resourceTypeQuery = "oic.r.0";
+    EXPECT_TRUE(IsCached());
+
+    m_key.resourceTypeQuery = NULL;
+    EXPECT_EQ(OC_STACK_OK, OCDiscoveryCacheStore(&m_key, g_encodedDiscovery,
+                                                 sizeof(g_encodedDiscovery)));
+    EXPECT_TRUE(IsCached());
+
+    m_key.resourceTypeQuery = "oic.r.0";
+    EXPECT_TRUE(IsCached());
+    m_key.resourceTypeQuery = "oic.r.1";
+    EXPECT_FALSE(IsCached());
+    m_key.resourceTypeQuery = "oic.r.2";
+    EXPECT_TRUE(IsCached());
+}
+
+TEST_F(OCDiscoveryCacheTests, OversizedResponseIsNotCached)
+{
+    size_t size = OC_DISCOVERY_CACHE_MAX_PAYLOAD_SIZE + 1;
+    uint8_t *large = (uint8_t *)OICCalloc(1, size);
+    ASSERT_TRUE(NULL != large);
+    EXPECT_NE(OC_STACK_OK, OCDiscoveryCacheStore(&m_key, large, size));
+    OICFree(large);
+
+    EXPECT_FALSE(IsCached());
+}
+
+TEST(OCDiscoveryCacheStackTests, ResourceChangesInvalidateCache)
+{
+    itst::DeadmanTimer killSwitch(SHORT_TEST_TIMEOUT);
+    EXPECT_EQ(OC_STACK_OK, OCInit("127.0.0.1", 5683, OC_SERVER));
+
+    OCDevAddr devAddr;
+    memset(&devAddr, 0, sizeof(devAddr));
+    devAddr.adapter = OC_ADAPTER_IP;
+    OCDiscoveryCacheKey key;
+    memset(&key, 0, sizeof(key));
+    key.uri = OC_WELL_KNOWN_URI;
+    key.devAddr = &devAddr;
+
+    OCResourceHandle handle;
+    EXPECT_EQ(OC_STACK_OK, OCDiscoveryCacheStore(&key, g_encodedDiscovery,
+                                                 sizeof(g_encodedDiscovery)));
+    EXPECT_EQ(OC_STACK_OK, OCCreateResource(&handle, "core.light", "oic.if.baseline",
+                                            "/a/light", NULL, NULL, OC_DISCOVERABLE));
+    OCPayload *payload = OCDiscoveryCacheLookup(&key);
+    EXPECT_TRUE(NULL == payload);
+    OCPayloadDestroy(payload);
+
+    EXPECT_EQ(OC_STACK_OK, OCDiscoveryCacheStore(&key, g_encodedDiscovery,
+                                                 sizeof(g_encodedDiscovery)));
+    EXPECT_EQ(OC_STACK_OK, OCBindResourceTypeToResource(handle, "core.brightlight"));
+    payload = OCDiscoveryCacheLookup(&key);
+    EXPECT_TRUE(NULL == payload);
+    OCPayloadDestroy(payload);
+
+    EXPECT_EQ(OC_STACK_OK, OCDiscoveryCacheStore(&key, g_encodedDiscovery,
+                                                 sizeof(g_encodedDiscovery)));
+    EXPECT_EQ(OC_STACK_OK, OCDeleteResource(handle));
+    payload = OCDiscoveryCacheLookup(&key);
+    EXPECT_TRUE(NULL == payload);
+    OCPayloadDestroy(payload);
+
+    EXPECT_EQ(OC_STACK_OK, OCStop());
+}
+
+class OCClientCBTests : public testing::Test
+{
+    protected:
+        virtual void SetUp()
+        {
+            m_deleted = 0;
+        }
+
+        virtual void TearDown()
+        {
+            DeleteClientCBList();
+        }
+
+        static OCStackApplicationResult Callback(void * /*ctx*/, OCDoHandle /*handle*/,
+                                                 OCClientResponse * /*clientResponse*/)
+        {
+            return OC_STACK_DELETE_TRANSACTION;
+        }
+
+        static void Deleter(void *ctx)
+        {
+            (*(int *)ctx)++;
+        }
+
+        ClientCB *Add(uint8_t id, uint32_t ttl, OCDoHandle *handle = NULL)
+        {
+            CAToken_t token = (CAToken_t)OICMalloc(CA_MAX_TOKEN_LEN);
+            memset(token, id, CA_MAX_TOKEN_LEN);
+            OCDoHandle cbHandle = (OCDoHandle)OICMalloc(1);
+            OCCallbackData cbData = { &m_deleted, Callback, Deleter };
+
+            ClientCB *cbNode = NULL;
+            EXPECT_EQ(OC_STACK_OK, AddClientCB(&cbNode, &cbData, CA_MSG_CONFIRM,
+                                               token, CA_MAX_TOKEN_LEN, NULL, 0, NULL, 0,
+                                               CA_FORMAT_UNDEFINED, &cbHandle, OC_REST_GET,
+                                               NULL, OICStrdup("/a/light"), NULL, ttl));
+            if (handle)
+            {
+                *handle = cbHandle;
+            }
+            return cbNode;
+        }
+
+        static ClientCB *Find(uint8_t id)
+        {
+            uint8_t token[CA_MAX_TOKEN_LEN];
+            memset(token, id, sizeof(token));
+            return GetClientCBUsingToken((CAToken_t)token, sizeof(token));
+        }
+
+        int m_deleted;
+};
+
+TEST_F(OCClientCBTests, LookupByTokenAndHandle)
+{
+    OCDoHandle handles[3];
+    ClientCB *nodes[3];
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        nodes[i] = Add(i + 1, 0, &handles[i]);
+        ASSERT_TRUE(NULL != nodes[i]);
+    }
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        EXPECT_EQ(nodes[i], Find(i + 1));
+        EXPECT_EQ(nodes[i], GetClientCBUsingHandle(handles[i]));
+        EXPECT_EQ(handles[i], nodes[i]->handle);
+    }
+
+    uint8_t shortToken[CA_MAX_TOKEN_LEN - 1];
+    memset(shortToken, 1, sizeof(shortToken));
+    EXPECT_TRUE(NULL == GetClientCBUsingToken((CAToken_t)shortToken, sizeof(shortToken)));
+    EXPECT_TRUE(NULL == Find(4));
+    EXPECT_TRUE(NULL == GetClientCBUsingHandle(&shortToken));
+}
+
+TEST_F(OCClientCBTests, DeleteRemovesFromIndexes)
+{
+    OCDoHandle firstHandle;
+    OCDoHandle secondHandle;
+    ClientCB *first = Add(1, 0, &firstHandle);
+    ClientCB *second = Add(2, GetTicks(60 * MILLISECONDS_PER_SECOND), &secondHandle);
+    ASSERT_TRUE(NULL != first);
+    ASSERT_TRUE(NULL != second);
+
+    DeleteClientCB(first);
+    EXPECT_EQ(1, m_deleted);
+    EXPECT_TRUE(NULL == Find(1));
+    EXPECT_TRUE(NULL == GetClientCBUsingHandle(firstHandle));
+    EXPECT_EQ(second, Find(2));
+    EXPECT_EQ(second, g_cbList);
+
+    // a node deleted from within an application callback is not deleted twice.
+    DeleteClientCB(first);
+    EXPECT_EQ(1, m_deleted);
+
+    DeleteClientCB(second);
+    EXPECT_EQ(2, m_deleted);
+    EXPECT_TRUE(NULL == GetClientCBUsingHandle(secondHandle));
+    EXPECT_TRUE(NULL == g_cbList);
+    EXPECT_EQ(UINT32_MAX, GetClientCBTimeoutDelay());
+}
+
+TEST_F(OCClientCBTests, TimedOutCallbacksAreDeletedInTTLOrder)
+{
+    ClientCB *late = Add(1, GetTicks(60 * MILLISECONDS_PER_SECOND));
+    ClientCB *early = Add(2, GetTicks(100));
+    ClientCB *middle = Add(3, GetTicks(30 * MILLISECONDS_PER_SECOND));
+    ClientCB *observe = Add(4, 0);
+    ASSERT_TRUE(late && early && middle && observe);
+
+    EXPECT_GE(200u, GetClientCBTimeoutDelay());
+
+    usleep(300 * 1000);
+    DeleteTimedOutClientCBs();
+    EXPECT_EQ(1, m_deleted);
+    EXPECT_TRUE(NULL == Find(2));
+    EXPECT_EQ(late, Find(1));
+    EXPECT_EQ(middle, Find(3));
+    EXPECT_EQ(observe, Find(4));
+
+    uint32_t delay = GetClientCBTimeoutDelay();
+    EXPECT_LT(25 * MILLISECONDS_PER_SECOND, delay);
+    EXPECT_GE(31 * MILLISECONDS_PER_SECOND, delay);
+
+    // moving the last node to the front of the heap reorders it.
+    UpdateClientCBTTL(late, GetTicks(100));
+    EXPECT_GE(200u, GetClientCBTimeoutDelay());
+
+    usleep(300 * 1000);
+    DeleteTimedOutClientCBs();
+    EXPECT_EQ(2, m_deleted);
+    EXPECT_TRUE(NULL == Find(1));
+    EXPECT_EQ(middle, Find(3));
+
+    // a TTL of 0 takes the node out of the heap.
+    UpdateClientCBTTL(middle, 0);
+    EXPECT_EQ(UINT32_MAX, GetClientCBTimeoutDelay());
+    DeleteTimedOutClientCBs();
+    EXPECT_EQ(2, m_deleted);
+    EXPECT_EQ(middle, Find(3));
+    EXPECT_EQ(observe, Find(4));
+}
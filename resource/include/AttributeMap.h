@@ -0,0 +1,239 @@
+//******************************************************************
+//
+// Copyright 2017 Samsung Electronics All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+/**
+ * @file
+ *
+ * This file contains the declaration of the internally used container
+ * that stores the attributes of an OCRepresentation.
+ */
+
+#ifndef OC_ATTRIBUTEMAP_H_
+#define OC_ATTRIBUTEMAP_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace OC
+{
+    /**
+     * Map from attribute name to value, stored flat.
+     *
+     * The attributes are kept in one vector in the order they were added, with a
+     * second vector of their indexes sorted by name. All attributes share two
+     * allocations instead of one node each, adding an attribute only shifts indexes
+     * and the iteration order is the same as the std::map it replaces.
+     */
+    template<typename T>
+    class FlatAttributeMap
+    {
+        public:
+            typedef std::string key_type;
+            typedef T mapped_type;
+            typedef std::pair<std::string, T> value_type;
+
+            template<typename Value, typename Items>
+            class basic_iterator
+            {
+                public:
+                    typedef std::forward_iterator_tag iterator_category;
+                    typedef typename FlatAttributeMap::value_type value_type;
+                    typedef std::ptrdiff_t difference_type;
+                    typedef Value* pointer;
+                    typedef Value& reference;
+
+                    basic_iterator() : m_items(nullptr), m_pos(nullptr) {}
+
+                    // allows converting an iterator to a const_iterator.
+                    template<typename V, typename I>
+                    basic_iterator(const basic_iterator<V, I>& rhs)
+                        : m_items(rhs.m_items), m_pos(rhs.m_pos) {}
+
+                    reference operator*() const { return (*m_items)[*m_pos]; }
+                    pointer operator->() const { return &(*m_items)[*m_pos]; }
+
+                    basic_iterator& operator++()
+                    {
+                        ++m_pos;
+                        return *this;
+                    }
+
+                    basic_iterator operator++(int)
+                    {
+                        basic_iterator itr(*this);
+                        ++m_pos;
+                        return itr;
+                    }
+
+                    bool operator==(const basic_iterator& rhs) const { return m_pos == rhs.m_pos; }
+                    bool operator!=(const basic_iterator& rhs) const { return m_pos != rhs.m_pos; }
+
+                private:
+                    friend class FlatAttributeMap;
+                    template<typename V, typename I> friend class basic_iterator;
+
+                    basic_iterator(Items* items, const uint32_t* pos)
+                        : m_items(items), m_pos(pos) {}
+
+                    Items* m_items;
+                    const uint32_t* m_pos;
+            };
+
+            typedef basic_iterator<value_type, std::vector<value_type>> iterator;
+            typedef basic_iterator<const value_type, const std::vector<value_type>> const_iterator;
+
+            iterator begin() { return iterator(&m_items, m_order.data()); }
+            const_iterator begin() const { return const_iterator(&m_items, m_order.data()); }
+            const_iterator cbegin() const { return begin(); }
+            iterator end() { return iterator(&m_items, m_order.data() + m_order.size()); }
+            const_iterator end() const
+            {
+                return const_iterator(&m_items, m_order.data() + m_order.size());
+            }
+            const_iterator cend() const { return end(); }
+
+            /**
+             * Changes whenever an attribute may have been added, changed or removed
+             * through this map. Values changed through an iterator are not counted.
+             */
+            uint64_t generation() const { return m_generation; }
+
+            size_t size() const { return m_items.size(); }
+            bool empty() const { return m_items.empty(); }
+
+            void clear()
+            {
+                ++m_generation;
+                m_items.clear();
+                m_order.clear();
+            }
+
+            void reserve(size_t count)
+            {
+                m_items.reserve(count);
+                m_order.reserve(count);
+            }
+
+            iterator find(const std::string& key)
+            {
+                auto pos = lowerBound(key);
+                if (pos == m_order.end() || m_items[*pos].first != key)
+                {
+                    return end();
+                }
+                return iterator(&m_items, &*pos);
+            }
+
+            const_iterator find(const std::string& key) const
+            {
+                return const_cast<FlatAttributeMap*>(this)->find(key);
+            }
+
+            size_t count(const std::string& key) const
+            {
+                return find(key) != end() ? 1 : 0;
+            }
+
+            T& operator[](const std::string& key)
+            {
+                // the caller may change the value through the reference.
+                ++m_generation;
+                auto pos = lowerBound(key);
+                if (pos != m_order.end() && m_items[*pos].first == key)
+                {
+                    return m_items[*pos].second;
+                }
+                m_items.push_back(value_type(key, T()));
+                m_order.insert(pos, static_cast<uint32_t>(m_items.size() - 1));
+                return m_items.back().second;
+            }
+
+            T& operator[](std::string&& key)
+            {
+                ++m_generation;
+                auto pos = lowerBound(key);
+                if (pos != m_order.end() && m_items[*pos].first == key)
+                {
+                    return m_items[*pos].second;
+                }
+                m_items.push_back(value_type(std::move(key), T()));
+                m_order.insert(pos, static_cast<uint32_t>(m_items.size() - 1));
+                return m_items.back().second;
+            }
+
+            size_t erase(const std::string& key)
+            {
+                auto pos = lowerBound(key);
+                if (pos == m_order.end() || m_items[*pos].first != key)
+                {
+                    return 0;
+                }
+
+                ++m_generation;
+                uint32_t index = *pos;
+                m_order.erase(pos);
+                m_items.erase(m_items.begin() + index);
+                for (auto& i : m_order)
+                {
+                    if (i > index)
+                    {
+                        --i;
+                    }
+                }
+                return 1;
+            }
+
+            bool operator==(const FlatAttributeMap& rhs) const
+            {
+                return size() == rhs.size() && std::equal(begin(), end(), rhs.begin());
+            }
+
+            bool operator!=(const FlatAttributeMap& rhs) const
+            {
+                return !(*this == rhs);
+            }
+
+        private:
+            std::vector<uint32_t>::iterator lowerBound(const std::string& key)
+            {
+                // most maps are filled in name order, check the end first.
+                if (m_order.empty() || m_items[m_order.back()].first < key)
+                {
+                    return m_order.end();
+                }
+                return std::lower_bound(m_order.begin(), m_order.end(), key,
+                        [this](uint32_t index, const std::string& k)
+                        {
+                            return m_items[index].first < k;
+                        });
+            }
+
+            std::vector<value_type> m_items;
+            // indexes into m_items, sorted by name.
+            std::vector<uint32_t> m_order;
+            uint64_t m_generation = 0;
+    };
+} // namespace OC
+
+#endif // OC_ATTRIBUTEMAP_H_
@@ -0,0 +1,99 @@
+//******************************************************************
+//
+// Copyright 2017 Samsung Electronics All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+/**
+ * @file
+ *
+ * This file contains the declaration of the executor that delivers the
+ * callbacks of the C++ client API.
+ */
+
+#ifndef OC_CALLBACK_EXECUTOR_H_
+#define OC_CALLBACK_EXECUTOR_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace OC
+{
+    /**
+     * Runs callbacks on a bounded set of worker threads.
+     *
+     * Callbacks posted with a key are run one at a time in the order they were
+     * posted, callbacks with different keys or without a key run concurrently.
+     * An executor created with no threads starts a detached thread for every
+     * callback, which was the behavior before the executor was added.
+     */
+    class CallbackExecutor
+    {
+    public:
+        typedef std::function<void()> Task;
+
+        explicit CallbackExecutor(size_t threadCount);
+
+        /**
+         * Runs the callbacks that are already posted and joins the workers.
+         */
+        ~CallbackExecutor();
+
+        CallbackExecutor(const CallbackExecutor&) = delete;
+        CallbackExecutor& operator=(const CallbackExecutor&) = delete;
+
+        void post(Task task);
+
+        /**
+         * Posts a callback that runs after all callbacks posted with the same key.
+         */
+        void post(const void* key, Task task);
+
+        size_t threadCount() const
+        {
+            return m_threads.size();
+        }
+
+    private:
+        // shared with the workers, so a worker outlives the executor when the
+        // executor is destroyed from one of its own callbacks.
+        struct Queue
+        {
+            std::mutex mutex;
+            std::condition_variable cond;
+            std::deque<Task> tasks;
+            // callbacks waiting for the running callback of the same key.
+            std::unordered_map<const void*, std::deque<Task>> serialTasks;
+            bool stop = false;
+        };
+
+        static void workerFunc(std::shared_ptr<Queue> queue);
+        static Task serialTask(Queue* queue, const void* key, Task task);
+        static void serialTaskDone(Queue* queue, const void* key);
+
+        std::shared_ptr<Queue> m_queue;
+        std::vector<std::thread> m_threads;
+    };
+}
+
+#endif
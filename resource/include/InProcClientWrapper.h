@@ -31,8 +31,12 @@
 #include <InitializeException.h>
 #include <ResourceInitException.h>
 
+struct oc_event_t;
+
 namespace OC
 {
+    class CallbackExecutor;
+
     namespace ClientCallbackContext
     {
         struct GetContext
@@ -257,9 +261,12 @@ namespace OC
         std::thread m_listeningThread;
         bool m_threadRun;
         std::weak_ptr<std::recursive_mutex> m_csdkLock;
+        // signalled by the stack when OCProcessEvent has work.
+        struct oc_event_t* m_processEvent;
 
     private:
         PlatformConfig  m_cfg;
+        std::shared_ptr<CallbackExecutor> m_executor;
     };
 }
 
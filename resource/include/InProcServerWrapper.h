@@ -26,6 +26,8 @@
 
 #include <IServerWrapper.h>
 
+struct oc_event_t;
+
 namespace OC
 {
     class InProcServerWrapper : public IServerWrapper
@@ -95,6 +97,8 @@ namespace OC
         std::thread m_processThread;
         bool m_threadRun;
         std::weak_ptr<std::recursive_mutex> m_csdkLock;
+        // signalled by the stack when OCProcessEvent has work.
+        struct oc_event_t* m_processEvent;
         PlatformConfig  m_cfg;
     };
 }
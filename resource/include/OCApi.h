@@ -174,6 +174,18 @@ namespace OC
          */
         bool                       useLegacyCleanup;
 
+        /**
+         * Number of threads that deliver the callbacks of the client API.
+         * With 0 (the default) a new thread is started for every callback.
+         */
+        size_t                     callbackThreadCount;
+
+        /**
+         * Deliver the notifications of one observation one at a time and in the order
+         * they were received. Only takes effect with callback threads.
+         */
+        bool                       serialObserveCallbacks;
+
         public:
             PlatformConfig(const ServiceType serviceType_,
             const ModeType mode_,
@@ -187,7 +199,9 @@ namespace OC
                 port(0),
                 QoS(QualityOfService::NaQos),
                 ps(ps_),
-                useLegacyCleanup(false)
+                useLegacyCleanup(false),
+                callbackThreadCount(0),
+                serialObserveCallbacks(true)
         {}
             /* @deprecated: Use a non deprecated constructor. */
             PlatformConfig()
@@ -200,7 +214,9 @@ namespace OC
                 port(0),
                 QoS(QualityOfService::NaQos),
                 ps(nullptr),
-                useLegacyCleanup(true)
+                useLegacyCleanup(true),
+                callbackThreadCount(0),
+                serialObserveCallbacks(true)
         {}
             /* @deprecated: Use a non deprecated constructor. */
             PlatformConfig(const ServiceType serviceType_,
@@ -218,7 +234,9 @@ namespace OC
                 port(0),
                 QoS(QoS_),
                 ps(ps_),
-                useLegacyCleanup(true)
+                useLegacyCleanup(true),
+                callbackThreadCount(0),
+                serialObserveCallbacks(true)
         {}
             /* @deprecated: Use a non deprecated constructor. */
             PlatformConfig(const ServiceType serviceType_,
@@ -236,7 +254,9 @@ namespace OC
                 port(port_),
                 QoS(QoS_),
                 ps(ps_),
-                useLegacyCleanup(true)
+                useLegacyCleanup(true),
+                callbackThreadCount(0),
+                serialObserveCallbacks(true)
         {}
             /* @deprecated: Use a non deprecated constructor. */
             PlatformConfig(const ServiceType serviceType_,
@@ -254,7 +274,9 @@ namespace OC
                 ipAddress(ipAddress_),
                 port(port_),
                 QoS(QoS_),
-                ps(ps_)
+                ps(ps_),
+                callbackThreadCount(0),
+                serialObserveCallbacks(true)
         {}
             PlatformConfig(const ServiceType serviceType_,
             const ModeType mode_,
@@ -270,7 +292,9 @@ namespace OC
                 port(0),
                 QoS(QoS_),
                 ps(ps_),
-                useLegacyCleanup(true)
+                useLegacyCleanup(true),
+                callbackThreadCount(0),
+                serialObserveCallbacks(true)
         {}
             /* @deprecated: Use a non deprecated constructor. */
             PlatformConfig(const ServiceType serviceType_,
@@ -289,7 +313,9 @@ namespace OC
                 port(0),
                 QoS(QoS_),
                 ps(ps_),
-                useLegacyCleanup(true)
+                useLegacyCleanup(true),
+                callbackThreadCount(0),
+                serialObserveCallbacks(true)
         {}
 
     };
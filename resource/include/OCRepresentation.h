@@ -32,8 +32,10 @@
 #include <sstream>
 #include <vector>
 #include <map>
+#include <memory>
 
 #include <AttributeValue.h>
+#include <AttributeMap.h>
 #include <StringConstants.h>
 
 #ifdef __ANDROID__
@@ -56,6 +58,8 @@ namespace OC
         DefaultChild
     };
 
+    class CborRepresentationDecoder;
+
     class MessageContainer
     {
         public:
@@ -63,6 +67,18 @@ namespace OC
 
             void setPayload(const OCRepPayload* rep);
 
+            /**
+             * Decode a CBOR encoded representation payload, as received in
+             * OCClientResponse::rawPayload. The result is the same as parsing it with
+             * OCParsePayload and calling setPayload, without the OCRepPayload in between.
+             *
+             * Byte strings in arrays are OCByteString values that point into the payload,
+             * they are only valid as long as the payload is.
+             *
+             * @throws OCException with OC_STACK_MALFORMED_RESPONSE if the payload is invalid.
+             */
+            void setCborPayload(const uint8_t* payload, size_t size);
+
             OCRepPayload* getPayload() const;
 
             const std::vector<OCRepresentation>& representations() const;
@@ -85,6 +101,9 @@ namespace OC
     {
         public:
             friend bool operator==(const OC::OCRepresentation&, const OC::OCRepresentation&);
+
+            typedef FlatAttributeMap<AttributeValue> AttributeMap;
+
             // Note: Implementation of all constructors and destructors
             // are all placed in the same location due to a crash that
             // was observed in Android, where merely constructing/destructing
@@ -94,6 +113,16 @@ namespace OC
             // this fix will work in the meantime.
             OCRepresentation(): m_interfaceType(InterfaceType::None){}
 
+            OCRepresentation(const OCRepresentation&) = default;
+
+            // the virtual destructor suppresses the implicit move operations, declare
+            // them so attributes holding representations are moved rather than copied.
+            OCRepresentation(OCRepresentation&&) = default;
+
+            OCRepresentation& operator=(const OCRepresentation&) = default;
+
+            OCRepresentation& operator=(OCRepresentation&&) = default;
+
             virtual ~OCRepresentation(){}
 
             void setDevAddr(const OCDevAddr&);
@@ -151,9 +180,13 @@ namespace OC
                 m_values[str] = std::forward<T>(val);
             }
 
-            const std::map<std::string, AttributeValue>& getValues() const {
-                return m_values;
-            }
+            /**
+             *  Return all attributes. The map is built on the first call after the
+             *  attributes changed, so prefer iterating the representation. The
+             *  reference stays valid until the attributes change and getValues is
+             *  called again.
+             */
+            const std::map<std::string, AttributeValue>& getValues() const;
 
             /**
              *  Retrieve the attribute value associated with the supplied name
@@ -349,11 +382,10 @@ namespace OC
                     }
 
                 private:
-                    AttributeItem(const std::string& name,
-                            std::map<std::string, AttributeValue>& vals);
+                    AttributeItem(const std::string& name, AttributeMap& vals);
                     AttributeItem(const AttributeItem&) = default;
                     std::string m_attrName;
-                    std::map<std::string, AttributeValue>& m_values;
+                    AttributeMap& m_values;
             };
 
             // Iterator to allow iteration via STL containers/methods
@@ -380,11 +412,10 @@ namespace OC
                     reference operator*();
                     pointer operator->();
                 private:
-                    iterator(std::map<std::string, AttributeValue>::iterator&& itr,
-                            std::map<std::string, AttributeValue>& vals)
+                    iterator(AttributeMap::iterator&& itr, AttributeMap& vals)
                         : m_iterator(std::move(itr)),
                         m_item(m_iterator != vals.end() ? m_iterator->first:"", vals){}
-                    std::map<std::string, AttributeValue>::iterator m_iterator;
+                    AttributeMap::iterator m_iterator;
                     AttributeItem m_item;
             };
 
@@ -413,11 +444,10 @@ namespace OC
                     const_reference operator*() const;
                     const_pointer operator->() const;
                 private:
-                    const_iterator(std::map<std::string, AttributeValue>::const_iterator&& itr,
-                            std::map<std::string, AttributeValue>& vals)
+                    const_iterator(AttributeMap::const_iterator&& itr, AttributeMap& vals)
                         : m_iterator(std::move(itr)),
                         m_item(m_iterator != vals.end() ? m_iterator->first: "", vals){}
-                    std::map<std::string, AttributeValue>::const_iterator m_iterator;
+                    AttributeMap::const_iterator m_iterator;
                     AttributeItem m_item;
             };
 
@@ -435,6 +465,7 @@ namespace OC
         private:
             friend class OCResourceResponse;
             friend class MessageContainer;
+            friend class CborRepresentationDecoder;
 
             template<typename T>
             void payload_array_helper(const OCRepPayloadValue* pl, size_t depth);
@@ -442,8 +473,8 @@ namespace OC
             T payload_array_helper_copy(size_t index, const OCRepPayloadValue* pl);
             void setPayload(const OCRepPayload* payload);
             void setPayloadArray(const OCRepPayloadValue* pl);
-            void getPayloadArray(OCRepPayload* payload,
-                    const OCRepresentation::AttributeItem& item) const;
+            void getPayloadArray(OCRepPayload* payload, const std::string& name,
+                    AttributeValue& value, AttributeType baseType) const;
             // the root node has a slightly different JSON version
             // based on the interface type configured in ResourceResponse.
             // This allows ResourceResponse to set it, so that the save function
@@ -472,9 +503,17 @@ namespace OC
                     std::vector<std::string>& m_interfaces;
             };
         private:
+            struct ValuesSnapshot
+            {
+                uint64_t generation;
+                std::map<std::string, AttributeValue> values;
+            };
+
             std::string m_uri;
             std::vector<OCRepresentation> m_children;
-            mutable std::map<std::string, AttributeValue> m_values;
+            mutable AttributeMap m_values;
+            // map returned by getValues, shared by copies until either changes.
+            mutable std::shared_ptr<const ValuesSnapshot> m_valuesSnapshot;
             std::vector<std::string> m_resourceTypes;
             std::vector<std::string> m_interfaces;
             std::vector<std::string> m_dataModelVersions;
@@ -0,0 +1,162 @@
+//******************************************************************
+//
+// Copyright 2017 Samsung Electronics All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include "CallbackExecutor.h"
+
+#include "logger.h"
+
+#define TAG "OIC_CALLBACK_EXECUTOR"
+
+namespace OC
+{
+    CallbackExecutor::CallbackExecutor(size_t threadCount)
+        : m_queue(std::make_shared<Queue>())
+    {
+        for (size_t i = 0; i < threadCount; ++i)
+        {
+            m_threads.push_back(std::thread(&CallbackExecutor::workerFunc, m_queue));
+        }
+    }
+
+    CallbackExecutor::~CallbackExecutor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_queue->mutex);
+            m_queue->stop = true;
+        }
+        m_queue->cond.notify_all();
+
+        for (auto& thread : m_threads)
+        {
+            if (thread.get_id() == std::this_thread::get_id())
+            {
+                thread.detach();
+            }
+            else if (thread.joinable())
+            {
+                thread.join();
+            }
+        }
+    }
+
+    void CallbackExecutor::post(Task task)
+    {
+        if (m_threads.empty())
+        {
+            std::thread exec(task);
+            exec.detach();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_queue->mutex);
+            m_queue->tasks.push_back(std::move(task));
+        }
+        m_queue->cond.notify_one();
+    }
+
+    void CallbackExecutor::post(const void* key, Task task)
+    {
+        if (m_threads.empty())
+        {
+            post(std::move(task));
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_queue->mutex);
+            auto it = m_queue->serialTasks.find(key);
+            if (it != m_queue->serialTasks.end())
+            {
+                it->second.push_back(std::move(task));
+                return;
+            }
+
+            m_queue->serialTasks[key];
+            m_queue->tasks.push_back(serialTask(m_queue.get(), key, std::move(task)));
+        }
+        m_queue->cond.notify_one();
+    }
+
+    CallbackExecutor::Task CallbackExecutor::serialTask(Queue* queue, const void* key,
+                                                        Task task)
+    {
+        return [queue, key, task]()
+        {
+            try
+            {
+                task();
+            }
+            catch (...)
+            {
+                serialTaskDone(queue, key);
+                throw;
+            }
+            serialTaskDone(queue, key);
+        };
+    }
+
+    void CallbackExecutor::serialTaskDone(Queue* queue, const void* key)
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        auto it = queue->serialTasks.find(key);
+        if (it == queue->serialTasks.end())
+        {
+            return;
+        }
+
+        if (it->second.empty())
+        {
+            queue->serialTasks.erase(it);
+            return;
+        }
+
+        // the calling worker picks the next task up itself, no need to notify.
+        queue->tasks.push_back(serialTask(queue, key, std::move(it->second.front())));
+        it->second.pop_front();
+    }
+
+    void CallbackExecutor::workerFunc(std::shared_ptr<Queue> queue)
+    {
+        for (;;)
+        {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(queue->mutex);
+                queue->cond.wait(lock, [&queue] { return queue->stop || !queue->tasks.empty(); });
+                if (queue->tasks.empty())
+                {
+                    return;
+                }
+                task = std::move(queue->tasks.front());
+                queue->tasks.pop_front();
+            }
+
+            try
+            {
+                task();
+            }
+            catch (std::exception& e)
+            {
+                OIC_LOG_V(ERROR, TAG, "Exception in callback: %s", e.what());
+            }
+        }
+    }
+}
@@ -21,7 +21,9 @@
 #include "iotivity_config.h"
 
 #include "InProcClientWrapper.h"
+#include "CallbackExecutor.h"
 #include "ocstack.h"
+#include "ocevent.h"
 
 #include "OCPlatform.h"
 #include "OCResource.h"
@@ -35,11 +37,82 @@ using namespace std;
 
 namespace OC
 {
+    // executor of the client wrapper, callbacks are invoked from the C stack
+    // which knows nothing about the wrapper.
+    static std::mutex s_executorMutex;
+    static std::weak_ptr<CallbackExecutor> s_executor;
+    static bool s_serialObserveCallbacks = false;
+
+    static void dispatchCallback(const void* serialKey, CallbackExecutor::Task task)
+    {
+        std::shared_ptr<CallbackExecutor> executor;
+        {
+            std::lock_guard<std::mutex> lock(s_executorMutex);
+            executor = s_executor.lock();
+            if (!s_serialObserveCallbacks)
+            {
+                serialKey = nullptr;
+            }
+        }
+
+        if (!executor)
+        {
+            std::thread exec(task);
+            exec.detach();
+        }
+        else if (serialKey)
+        {
+            executor->post(serialKey, std::move(task));
+        }
+        else
+        {
+            executor->post(std::move(task));
+        }
+    }
+
+    static void dispatchCallback(CallbackExecutor::Task task)
+    {
+        dispatchCallback(nullptr, std::move(task));
+    }
+
+    // notifications of one observation are delivered in order if configured.
+    static void dispatchObserveCallback(const void* context, CallbackExecutor::Task task)
+    {
+        dispatchCallback(context, std::move(task));
+    }
+
+    OCStackApplicationResult listenDeviceCallback(void* ctx, OCDoHandle handle,
+                                                  OCClientResponse* clientResponse);
+    OCStackApplicationResult getResourceCallback(void* ctx, OCDoHandle handle,
+                                                 OCClientResponse* clientResponse);
+    OCStackApplicationResult setResourceCallback(void* ctx, OCDoHandle handle,
+                                                 OCClientResponse* clientResponse);
+    OCStackApplicationResult observeResourceCallback(void* ctx, OCDoHandle handle,
+                                                     OCClientResponse* clientResponse);
+
+    // these callbacks only convert the payload into an OCRepresentation, which
+    // parseGetSetCallback decodes straight from the CBOR.
+    static void registerRawPayloadHandlers()
+    {
+        OCRegisterRawPayloadHandler(listenDeviceCallback);
+        OCRegisterRawPayloadHandler(getResourceCallback);
+        OCRegisterRawPayloadHandler(setResourceCallback);
+        OCRegisterRawPayloadHandler(observeResourceCallback);
+    }
+
     InProcClientWrapper::InProcClientWrapper(
         std::weak_ptr<std::recursive_mutex> csdkLock, PlatformConfig cfg)
-            : m_threadRun(false), m_csdkLock(csdkLock),
-              m_cfg { cfg }
+            : m_threadRun(false), m_csdkLock(csdkLock), m_processEvent(nullptr),
+              m_cfg { cfg },
+              m_executor(std::make_shared<CallbackExecutor>(cfg.callbackThreadCount))
     {
+        {
+            std::lock_guard<std::mutex> lock(s_executorMutex);
+            s_executor = m_executor;
+            s_serialObserveCallbacks = cfg.serialObserveCallbacks;
+        }
+        registerRawPayloadHandlers();
+
         // if the config type is server, we ought to never get called.  If the config type
         // is both, we count on the server to run the thread and do the initialize
         start();
@@ -55,6 +128,17 @@ namespace OC
         {
             oclog() << "Exception in stop"<< e.what() << std::flush;
         }
+
+        if (m_processEvent)
+        {
+            oc_event_free(m_processEvent);
+        }
+
+        std::lock_guard<std::mutex> lock(s_executorMutex);
+        if (s_executor.lock() == m_executor)
+        {
+            s_executor.reset();
+        }
     }
 
     OCStackResult InProcClientWrapper::start()
@@ -65,6 +149,16 @@ namespace OC
         {
             if (false == m_threadRun)
             {
+                if (!m_processEvent)
+                {
+                    m_processEvent = oc_event_new();
+                }
+                if (m_processEvent && OC_STACK_OK != OCRegisterProcessEvent(m_processEvent))
+                {
+                    // fall back to polling.
+                    oc_event_free(m_processEvent);
+                    m_processEvent = nullptr;
+                }
                 m_threadRun = true;
                 m_listeningThread = std::thread(&InProcClientWrapper::listeningFunc, this);
             }
@@ -79,6 +173,11 @@ namespace OC
         if (m_threadRun && m_listeningThread.joinable())
         {
             m_threadRun = false;
+            if (m_processEvent)
+            {
+                OCUnregisterProcessEvent(m_processEvent);
+                oc_event_signal(m_processEvent);
+            }
             m_listeningThread.join();
         }
         return OC_STACK_OK;
@@ -89,30 +188,39 @@ namespace OC
         while(m_threadRun)
         {
             OCStackResult result;
+            uint32_t nextEventTime = 0;
             auto cLock = m_csdkLock.lock();
             if (cLock)
             {
                 std::lock_guard<std::recursive_mutex> lock(*cLock);
-                result = OCProcess();
+                result = OCProcessEvent(&nextEventTime);
             }
             else
             {
                 result = OC_STACK_ERROR;
             }
 
-            if (result != OC_STACK_OK)
+            if (result != OC_STACK_OK || !m_processEvent)
             {
-                // TODO: do something with result if failed?
+                // the stack is not up yet, poll as before.
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            else if (nextEventTime)
+            {
+                oc_event_wait_for(m_processEvent, nextEventTime);
             }
-
-            // To minimize CPU utilization we may wish to do this with sleep
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
         }
     }
 
     OCRepresentation parseGetSetCallback(OCClientResponse* clientResponse)
     {
-        if (clientResponse->payload == nullptr ||
+        MessageContainer oc;
+        if (clientResponse->rawPayload)
+        {
+            // registered with OCRegisterRawPayloadHandler, decode the CBOR directly.
+            oc.setCborPayload(clientResponse->rawPayload, clientResponse->rawPayloadSize);
+        }
+        else if (clientResponse->payload == nullptr ||
                 (
                     clientResponse->payload->type != PAYLOAD_TYPE_REPRESENTATION
                 )
@@ -120,9 +228,10 @@ namespace OC
         {
             return OCRepresentation();
         }
-
-        MessageContainer oc;
-        oc.setPayload(clientResponse->payload);
+        else
+        {
+            oc.setPayload(clientResponse->payload);
+        }
 
         std::vector<OCRepresentation>::const_iterator it = oc.representations().begin();
         if (it == oc.representations().end())
@@ -186,8 +295,7 @@ namespace OC
 
             for(auto resource : container.Resources())
             {
-                std::thread exec(context->callback, resource);
-                exec.detach();
+                dispatchCallback(std::bind(context->callback, resource));
             }
         }
         catch (std::exception &e)
@@ -235,16 +343,14 @@ namespace OC
             // loop to ensure valid construction of all resources
             for (auto resource : container.Resources())
             {
-                std::thread exec(context->callback, resource);
-                exec.detach();
+                dispatchCallback(std::bind(context->callback, resource));
             }
             return OC_STACK_KEEP_TRANSACTION;
         }
 
         OIC_LOG_V(DEBUG, TAG, "%s: call response callback", __func__);
         std::string resourceURI = clientResponse->resourceUri;
-        std::thread exec(context->errorCallback, resourceURI, result);
-        exec.detach();
+        dispatchCallback(std::bind(context->errorCallback, resourceURI, result));
         return OC_STACK_KEEP_TRANSACTION;
     }
 
@@ -380,8 +486,7 @@ namespace OC
                                     reinterpret_cast<OCDiscoveryPayload*>(clientResponse->payload));
 
             OIC_LOG_V(DEBUG, TAG, "%s: call response callback", __func__);
-            std::thread exec(context->callback, container.Resources());
-            exec.detach();
+            dispatchCallback(std::bind(context->callback, container.Resources()));
         }
         catch (std::exception &e)
         {
@@ -452,8 +557,7 @@ namespace OC
 
             //send the error callback
             std::string uri = clientResponse->resourceUri;
-            std::thread exec(context->errorCallback, uri, result);
-            exec.detach();
+            dispatchCallback(std::bind(context->errorCallback, uri, result));
             return OC_STACK_KEEP_TRANSACTION;
         }
 
@@ -479,8 +583,7 @@ namespace OC
                             reinterpret_cast<OCDiscoveryPayload*>(clientResponse->payload));
 
             OIC_LOG_V(DEBUG, TAG, "%s: call response callback", __func__);
-            std::thread exec(context->callback, container.Resources());
-            exec.detach();
+            dispatchCallback(std::bind(context->callback, container.Resources()));
         }
         catch (std::exception &e)
         {
@@ -558,9 +661,8 @@ namespace OC
                     << clientResponse->result
                     << std::flush;
 
-            std::thread exec(context->callback, clientResponse->result,
-                             resourceURI, nullptr);
-            exec.detach();
+            dispatchCallback(std::bind(context->callback, clientResponse->result,
+                                       resourceURI, nullptr));
 
             return OC_STACK_DELETE_TRANSACTION;
         }
@@ -581,9 +683,8 @@ namespace OC
             // loop to ensure valid construction of all resources
             for (auto resource : container.Resources())
             {
-                std::thread exec(context->callback, clientResponse->result,
-                                 resourceURI, resource);
-                exec.detach();
+                dispatchCallback(std::bind(context->callback, clientResponse->result,
+                                           resourceURI, resource));
             }
         }
         catch (std::exception &e)
@@ -654,8 +755,7 @@ namespace OC
         {
             OIC_LOG_V(DEBUG, TAG, "%s: call response callback", __func__);
             OCRepresentation rep = parseGetSetCallback(clientResponse);
-            std::thread exec(context->callback, rep);
-            exec.detach();
+            dispatchCallback(std::bind(context->callback, rep));
         }
         catch(OC::OCException& e)
         {
@@ -792,19 +892,17 @@ namespace OC
                                             createdUri);
                 for (auto resource : container.Resources())
                 {
-                    std::thread exec(context->callback, result,
-                                     createdUri,
-                                     resource);
-                    exec.detach();
+                    dispatchCallback(std::bind(context->callback, result,
+                                               createdUri,
+                                               resource));
                 }
             }
             else
             {
                 OIC_LOG_V(DEBUG, TAG, "%s: call response callback", __func__);
-                std::thread exec(context->callback, result,
-                                 createdUri,
-                                 nullptr);
-                exec.detach();
+                dispatchCallback(std::bind(context->callback, result,
+                                           createdUri,
+                                           nullptr));
             }
         }
         catch (std::exception &e)
@@ -882,8 +980,7 @@ namespace OC
         }
 
         OIC_LOG_V(DEBUG, TAG, "%s: call response callback", __func__);
-        std::thread exec(context->callback, serverHeaderOptions, rep, result);
-        exec.detach();
+        dispatchCallback(std::bind(context->callback, serverHeaderOptions, rep, result));
         return OC_STACK_DELETE_TRANSACTION;
     }
 
@@ -958,8 +1055,7 @@ namespace OC
         }
 
         OIC_LOG_V(DEBUG, TAG, "%s: call response callback", __func__);
-        std::thread exec(context->callback, serverHeaderOptions, attrs, result);
-        exec.detach();
+        dispatchCallback(std::bind(context->callback, serverHeaderOptions, attrs, result));
         return OC_STACK_DELETE_TRANSACTION;
     }
 
@@ -1161,8 +1257,8 @@ namespace OC
         parseServerHeaderOptions(clientResponse, serverHeaderOptions);
 
         OIC_LOG_V(DEBUG, TAG, "%s: call response callback", __func__);
-        std::thread exec(context->callback, serverHeaderOptions, clientResponse->result);
-        exec.detach();
+        dispatchCallback(std::bind(context->callback, serverHeaderOptions,
+                                   clientResponse->result));
         return OC_STACK_DELETE_TRANSACTION;
     }
 
@@ -1236,9 +1332,8 @@ namespace OC
         }
 
         OIC_LOG_V(DEBUG, TAG, "%s: call response callback", __func__);
-        std::thread exec(context->callback, serverHeaderOptions, attrs,
-                    result, sequenceNumber);
-        exec.detach();
+        dispatchObserveCallback(context, std::bind(context->callback, serverHeaderOptions, attrs,
+                                                   result, sequenceNumber));
         if (sequenceNumber == MAX_SEQUENCE_NUMBER + 1)
         {
             return OC_STACK_DELETE_TRANSACTION;
@@ -1358,10 +1453,8 @@ namespace OC
         std::string url = clientResponse->devAddr.addr;
 
         OIC_LOG_V(DEBUG, TAG, "%s: call response callback", __func__);
-        std::thread exec(context->callback, clientResponse->result,
-                    clientResponse->sequenceNumber, url);
-
-        exec.detach();
+        dispatchObserveCallback(context, std::bind(context->callback, clientResponse->result,
+                                                   clientResponse->sequenceNumber, url));
 
         return OC_STACK_KEEP_TRANSACTION;
     }
@@ -1560,8 +1653,7 @@ namespace OC
             else {
                 OIC_LOG_V(DEBUG, TAG, "%s: call response callback", __func__);
                 convert(list, dpDeviceList);
-                std::thread exec(callback, dpDeviceList);
-                exec.detach();
+                dispatchCallback(std::bind(callback, dpDeviceList));
                 result = OC_STACK_OK;
             }
         }
@@ -1599,8 +1691,7 @@ namespace OC
             else {
                 OIC_LOG_V(DEBUG, TAG, "%s: call response callback", __func__);
                 convert(list, dpDeviceList);
-                std::thread exec(callback, dpDeviceList);
-                exec.detach();
+                dispatchCallback(std::bind(callback, dpDeviceList));
                 result = OC_STACK_OK;
             }
         }
@@ -1620,8 +1711,7 @@ namespace OC
             static_cast<ClientCallbackContext::DirectPairingContext*>(ctx);
 
         OIC_LOG_V(DEBUG, TAG, "%s: call response callback", __func__);
-        std::thread exec(context->callback, cloneDevice(peer), result);
-        exec.detach();
+        dispatchCallback(std::bind(context->callback, cloneDevice(peer), result));
     }
 
     OCStackResult InProcClientWrapper::DoDirectPairing(std::shared_ptr<OCDirectPairing> peer,
@@ -34,6 +34,7 @@
 #include <OCResourceRequest.h>
 #include <OCResourceResponse.h>
 #include <ocstack.h>
+#include <ocevent.h>
 #include <ocpayload.h>
 
 #include <OCApi.h>
@@ -260,7 +261,7 @@ namespace OC
 {
     InProcServerWrapper::InProcServerWrapper(
         std::weak_ptr<std::recursive_mutex> csdkLock, PlatformConfig cfg)
-     : m_threadRun(false), m_csdkLock(csdkLock),
+     : m_threadRun(false), m_csdkLock(csdkLock), m_processEvent(nullptr),
        m_cfg { cfg }
     {
     }
@@ -271,6 +272,16 @@ namespace OC
 
         if (false == m_threadRun)
         {
+            if (!m_processEvent)
+            {
+                m_processEvent = oc_event_new();
+            }
+            if (m_processEvent && OC_STACK_OK != OCRegisterProcessEvent(m_processEvent))
+            {
+                // fall back to polling.
+                oc_event_free(m_processEvent);
+                m_processEvent = nullptr;
+            }
             m_threadRun = true;
             m_processThread = std::thread(&InProcServerWrapper::processFunc, this);
         }
@@ -284,6 +295,11 @@ namespace OC
         if(m_processThread.joinable())
         {
             m_threadRun = false;
+            if (m_processEvent)
+            {
+                OCUnregisterProcessEvent(m_processEvent);
+                oc_event_signal(m_processEvent);
+            }
             m_processThread.join();
         }
 
@@ -296,10 +312,11 @@ namespace OC
         while(cLock && m_threadRun)
         {
             OCStackResult result;
+            uint32_t nextEventTime = 0;
 
             {
                 std::lock_guard<std::recursive_mutex> lock(*cLock);
-                result = OCProcess();
+                result = OCProcessEvent(&nextEventTime);
             }
 
             if(OC_STACK_ERROR == result)
@@ -308,7 +325,14 @@ namespace OC
                 // ...the value of variable result is simply ignored for now.
             }
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            if (OC_STACK_OK != result || !m_processEvent)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            else if (nextEventTime)
+            {
+                oc_event_wait_for(m_processEvent, nextEventTime);
+            }
         }
     }
 
@@ -721,5 +745,10 @@ namespace OC
         {
             oclog() << "Exception in stop"<< e.what() << std::flush;
         }
+
+        if (m_processEvent)
+        {
+            oc_event_free(m_processEvent);
+        }
     }
 }
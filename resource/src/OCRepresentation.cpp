@@ -32,6 +32,7 @@
 #include <algorithm>
 #include <iomanip>
 #include "iotivity_config.h"
+#include "cbor.h"
 #include "ocpayload.h"
 #include "ocrandom.h"
 #include "oic_malloc.h"
@@ -71,7 +72,7 @@ namespace OC
             cur.setPayload(pl);
 
             pl = pl->next;
-            this->addRepresentation(cur);
+            m_reps.push_back(std::move(cur));
         }
     }
 
@@ -280,46 +281,47 @@ namespace OC
         ((OCRepPayload**)array)[pos] = item.getPayload();
     }
 
-    void OCRepresentation::getPayloadArray(OCRepPayload* payload,
-                    const OCRepresentation::AttributeItem& item) const
+    static AttributeType getAttributeType(const AttributeValue& value, AttributeType& baseType);
+
+    void OCRepresentation::getPayloadArray(OCRepPayload* payload, const std::string& name,
+                    AttributeValue& value, AttributeType baseType) const
     {
         get_payload_array vis{};
-        boost::apply_visitor(vis, m_values[item.attrname()]);
-
+        boost::apply_visitor(vis, value);
 
-        switch(item.base_type())
+        switch(baseType)
         {
             case AttributeType::Integer:
-                OCRepPayloadSetIntArrayAsOwner(payload, item.attrname().c_str(),
+                OCRepPayloadSetIntArrayAsOwner(payload, name.c_str(),
                         (int64_t*)vis.m_array,
                         vis.dimensions);
                 break;
             case AttributeType::Double:
-                OCRepPayloadSetDoubleArrayAsOwner(payload, item.attrname().c_str(),
+                OCRepPayloadSetDoubleArrayAsOwner(payload, name.c_str(),
                         (double*)vis.m_array,
                         vis.dimensions);
                 break;
             case AttributeType::Boolean:
-                OCRepPayloadSetBoolArrayAsOwner(payload, item.attrname().c_str(),
+                OCRepPayloadSetBoolArrayAsOwner(payload, name.c_str(),
                         (bool*)vis.m_array,
                         vis.dimensions);
                 break;
             case AttributeType::String:
-                OCRepPayloadSetStringArrayAsOwner(payload, item.attrname().c_str(),
+                OCRepPayloadSetStringArrayAsOwner(payload, name.c_str(),
                         (char**)vis.m_array,
                         vis.dimensions);
                 break;
             case AttributeType::OCByteString:
-                OCRepPayloadSetByteStringArrayAsOwner(payload, item.attrname().c_str(),
+                OCRepPayloadSetByteStringArrayAsOwner(payload, name.c_str(),
                                                       (OCByteString *)vis.m_array, vis.dimensions);
                 break;
             case AttributeType::OCRepresentation:
-                OCRepPayloadSetPropObjectArrayAsOwner(payload, item.attrname().c_str(),
+                OCRepPayloadSetPropObjectArrayAsOwner(payload, name.c_str(),
                         (OCRepPayload**)vis.m_array, vis.dimensions);
                 break;
             default:
                 throw std::logic_error(std::string("GetPayloadArray: Not Implemented") +
-                        std::to_string((int)item.base_type()));
+                        std::to_string((int)baseType));
         }
     }
 
@@ -343,45 +345,49 @@ namespace OC
             OCRepPayloadAddInterface(root, iface.c_str());
         }
 
-        for(auto& val : *this)
+        for(auto& val : m_values)
         {
-            switch(val.type())
+            const char* name = val.first.c_str();
+            AttributeType baseType;
+            AttributeType type = getAttributeType(val.second, baseType);
+            switch(type)
             {
                 case AttributeType::Null:
-                    OCRepPayloadSetNull(root, val.attrname().c_str());
+                    OCRepPayloadSetNull(root, name);
                     break;
                 case AttributeType::Integer:
-                    OCRepPayloadSetPropInt(root, val.attrname().c_str(), static_cast<int>(val));
+                    OCRepPayloadSetPropInt(root, name, boost::get<int>(val.second));
                     break;
                 case AttributeType::Double:
-                    OCRepPayloadSetPropDouble(root, val.attrname().c_str(),
-                            val.getValue<double>());
+                    OCRepPayloadSetPropDouble(root, name, boost::get<double>(val.second));
                     break;
                 case AttributeType::Boolean:
-                    OCRepPayloadSetPropBool(root, val.attrname().c_str(), val.getValue<bool>());
+                    OCRepPayloadSetPropBool(root, name, boost::get<bool>(val.second));
                     break;
                 case AttributeType::String:
-                    OCRepPayloadSetPropString(root, val.attrname().c_str(),
-                            static_cast<std::string>(val).c_str());
+                    OCRepPayloadSetPropString(root, name,
+                            boost::get<std::string>(val.second).c_str());
                     break;
                 case AttributeType::OCByteString:
-                    OCRepPayloadSetPropByteString(root, val.attrname().c_str(), val.getValue<OCByteString>());
+                    OCRepPayloadSetPropByteString(root, name, boost::get<OCByteString>(val.second));
                     break;
                 case AttributeType::OCRepresentation:
-                    OCRepPayloadSetPropObjectAsOwner(root, val.attrname().c_str(),
-                            static_cast<OCRepresentation>(val).getPayload());
+                    OCRepPayloadSetPropObjectAsOwner(root, name,
+                            boost::get<OCRepresentation>(val.second).getPayload());
                     break;
                 case AttributeType::Vector:
-                    getPayloadArray(root, val);
+                    getPayloadArray(root, val.first, val.second, baseType);
                     break;
                 case AttributeType::Binary:
-                    OCRepPayloadSetPropByteString(root, val.attrname().c_str(),
-                            OCByteString{const_cast<uint8_t*>(val.getValue<std::vector<uint8_t>>().data()),
-                            val.getValue<std::vector<uint8_t>>().size()});
+                    {
+                        std::vector<uint8_t>& binary = boost::get<std::vector<uint8_t>>(val.second);
+                        OCRepPayloadSetPropByteString(root, name,
+                                OCByteString{binary.data(), binary.size()});
+                    }
                     break;
                 default:
                     throw std::logic_error(std::string("Getpayload: Not Implemented") +
-                            std::to_string((int)val.type()));
+                            std::to_string((int)type));
                     break;
             }
         }
@@ -484,7 +490,7 @@ namespace OC
             {
                 val[i] = payload_array_helper_copy<T>(i, pl);
             }
-            this->setValue(std::string(pl->name), val);
+            m_values[pl->name] = std::move(val);
         }
         else if (depth == 2)
         {
@@ -498,7 +504,7 @@ namespace OC
                             i * pl->arr.dimensions[1] + j, pl);
                 }
             }
-            this->setValue(std::string(pl->name), val);
+            m_values[pl->name] = std::move(val);
         }
         else if (depth == 3)
         {
@@ -519,7 +525,7 @@ namespace OC
                     }
                 }
             }
-            this->setValue(std::string(pl->name), val);
+            m_values[pl->name] = std::move(val);
         }
         else
         {
@@ -576,46 +582,47 @@ namespace OC
 
         OCRepPayloadValue* val = pl->values;
 
+        size_t count = 0;
+        for (OCRepPayloadValue* v = val; v; v = v->next)
+        {
+            ++count;
+        }
+        m_values.reserve(m_values.size() + count);
+
+        // the values are constructed in place, the name is the only copy.
         while(val)
         {
             switch(val->type)
             {
                 case OCREP_PROP_NULL:
-                    setNULL(val->name);
+                    m_values[val->name] = OC::NullType();
                     break;
                 case OCREP_PROP_INT:
                     // Needs to be removed as part of IOT-1726 fix.
-#ifdef _MSC_VER
-#pragma warning(suppress : 4244)
-                    setValue<int>(val->name, val->i);
-#else
-                    setValue<int>(val->name, val->i);
-#endif
+                    m_values[val->name] = static_cast<int>(val->i);
                     break;
                 case OCREP_PROP_DOUBLE:
-                    setValue<double>(val->name, val->d);
+                    m_values[val->name] = val->d;
                     break;
                 case OCREP_PROP_BOOL:
-                    setValue<bool>(val->name, val->b);
+                    m_values[val->name] = val->b;
                     break;
                 case OCREP_PROP_STRING:
-                    setValue<std::string>(val->name, val->str);
+                    m_values[val->name] = std::string(val->str);
                     break;
                 case OCREP_PROP_OBJECT:
                     {
                         OCRepresentation cur;
                         cur.setPayload(val->obj);
-                        setValue<OCRepresentation>(val->name, cur);
+                        m_values[val->name] = std::move(cur);
                     }
                     break;
                 case OCREP_PROP_ARRAY:
                     setPayloadArray(val);
                     break;
                 case OCREP_PROP_BYTE_STRING:
-                    setValue(val->name,
-                            std::vector<uint8_t>
-                            (val->ocByteStr.bytes, val->ocByteStr.bytes + val->ocByteStr.len)
-                            );
+                    m_values[val->name] = std::vector<uint8_t>
+                            (val->ocByteStr.bytes, val->ocByteStr.bytes + val->ocByteStr.len);
                     break;
                 default:
                     throw std::logic_error(std::string("Not Implemented!") +
@@ -626,6 +633,480 @@ namespace OC
         }
     }
 
+    /**
+     * Decodes representation payloads straight from CBOR into OCRepresentation,
+     * following the rules of OCParseRepPayload. Strings are copied from the buffer
+     * into their std::string once, instead of into an OCRepPayload first.
+     */
+    class CborRepresentationDecoder
+    {
+        public:
+            static void decode(std::vector<OCRepresentation>& reps,
+                               const uint8_t* payload, size_t size)
+            {
+                CborParser parser;
+                CborValue root;
+                verify(cbor_parser_init(payload, size, 0, &parser, &root),
+                       "Failed initializing parser");
+
+                bool isArray = cbor_value_is_array(&root);
+                CborValue item = root;
+                if (isArray)
+                {
+                    verify(cbor_value_enter_container(&root, &item), "Failed entering root");
+                }
+
+                while (cbor_value_is_valid(&item))
+                {
+                    OCRepresentation rep;
+                    if (cbor_value_is_map(&item))
+                    {
+                        decodeObject(rep, &item, true);
+                    }
+                    else if (cbor_value_is_array(&item))
+                    {
+                        verify(cbor_value_advance(&item), "Failed advancing root");
+                    }
+                    else
+                    {
+                        throw OCException("Malformed representation payload",
+                                          OC_STACK_MALFORMED_RESPONSE);
+                    }
+                    reps.push_back(std::move(rep));
+
+                    if (!isArray)
+                    {
+                        break;
+                    }
+                }
+            }
+
+        private:
+            static void verify(CborError err, const char* msg)
+            {
+                if (CborNoError != err)
+                {
+                    throw OCException(msg, OC_STACK_MALFORMED_RESPONSE);
+                }
+            }
+
+            static OCRepPayloadPropType getPropType(CborType type)
+            {
+                switch (type)
+                {
+                    case CborIntegerType:
+                        return OCREP_PROP_INT;
+                    case CborDoubleType:
+                    case CborFloatType:
+                        return OCREP_PROP_DOUBLE;
+                    case CborBooleanType:
+                        return OCREP_PROP_BOOL;
+                    case CborTextStringType:
+                        return OCREP_PROP_STRING;
+                    case CborByteStringType:
+                        return OCREP_PROP_BYTE_STRING;
+                    case CborMapType:
+                        return OCREP_PROP_OBJECT;
+                    case CborArrayType:
+                        return OCREP_PROP_ARRAY;
+                    default:
+                        return OCREP_PROP_NULL;
+                }
+            }
+
+            // The decode functions below consume the value, leaving it at the next one.
+            static std::string decodeTextString(CborValue* value)
+            {
+                size_t len = 0;
+                verify(cbor_value_calculate_string_length(value, &len),
+                       "Failed getting string length");
+
+                std::string str(len, '\0');
+                CborValue next;
+                verify(cbor_value_copy_text_string(value, &str[0], &len, &next),
+                       "Failed getting string value");
+                *value = next;
+                return str;
+            }
+
+            static std::vector<uint8_t> decodeByteString(CborValue* value)
+            {
+                size_t len = 0;
+                verify(cbor_value_calculate_string_length(value, &len),
+                       "Failed getting byte string length");
+
+                std::vector<uint8_t> bytes(len);
+                CborValue next;
+                verify(cbor_value_copy_byte_string(value, bytes.data(), &len, &next),
+                       "Failed getting byte string value");
+                *value = next;
+                return bytes;
+            }
+
+            static void decodeStringList(CborValue* value, std::vector<std::string>& list)
+            {
+                if (cbor_value_is_array(value))
+                {
+                    CborValue item;
+                    verify(cbor_value_enter_container(value, &item), "Failed entering list");
+                    while (cbor_value_is_text_string(&item))
+                    {
+                        std::string str = decodeTextString(&item);
+                        size_t pos = 0;
+                        while (pos < str.size())
+                        {
+                            size_t end = str.find(' ', pos);
+                            if (end == std::string::npos)
+                            {
+                                end = str.size();
+                            }
+                            if (end > pos)
+                            {
+                                list.push_back(str.substr(pos, end - pos));
+                            }
+                            pos = end + 1;
+                        }
+                    }
+                }
+                verify(cbor_value_advance(value), "Failed advancing list");
+            }
+
+            static void decodeObject(OCRepresentation& rep, CborValue* container, bool isRoot)
+            {
+                bool isMap = cbor_value_is_map(container);
+                size_t arrayIndex = 0;
+                CborValue item;
+                verify(cbor_value_enter_container(container, &item), "Failed entering object");
+
+                while (cbor_value_is_valid(&item))
+                {
+                    std::string name;
+                    if (isMap)
+                    {
+                        if (!cbor_value_is_text_string(&item))
+                        {
+                            throw OCException("Invalid attribute name",
+                                              OC_STACK_MALFORMED_RESPONSE);
+                        }
+                        name = decodeTextString(&item);
+
+                        if (isRoot && name == OC_RSRVD_HREF)
+                        {
+                            if (cbor_value_is_text_string(&item))
+                            {
+                                rep.setUri(decodeTextString(&item));
+                            }
+                            else
+                            {
+                                verify(cbor_value_advance(&item), "Failed advancing href");
+                            }
+                            continue;
+                        }
+                        else if (isRoot && name == OC_RSRVD_RESOURCE_TYPE)
+                        {
+                            decodeStringList(&item, rep.m_resourceTypes);
+                            continue;
+                        }
+                        else if (isRoot && name == OC_RSRVD_INTERFACE)
+                        {
+                            decodeStringList(&item, rep.m_interfaces);
+                            continue;
+                        }
+                    }
+                    else
+                    {
+                        name = std::to_string(arrayIndex++);
+                    }
+                    decodeValue(rep, std::move(name), &item);
+                }
+
+                verify(cbor_value_leave_container(container, &item), "Failed leaving object");
+            }
+
+            static void decodeValue(OCRepresentation& rep, std::string&& name, CborValue* value)
+            {
+                switch (cbor_value_get_type(value))
+                {
+                    case CborNullType:
+                        rep.m_values[std::move(name)] = OC::NullType();
+                        verify(cbor_value_advance_fixed(value), "Failed advancing value");
+                        break;
+                    case CborIntegerType:
+                        {
+                            int i;
+                            decodeItem(value, i);
+                            rep.m_values[std::move(name)] = i;
+                        }
+                        break;
+                    case CborDoubleType:
+                    case CborFloatType:
+                        {
+                            double d;
+                            decodeItem(value, d);
+                            rep.m_values[std::move(name)] = d;
+                        }
+                        break;
+                    case CborBooleanType:
+                        {
+                            bool b;
+                            decodeItem(value, b);
+                            rep.m_values[std::move(name)] = b;
+                        }
+                        break;
+                    case CborTextStringType:
+                        rep.m_values[std::move(name)] = decodeTextString(value);
+                        break;
+                    case CborByteStringType:
+                        rep.m_values[std::move(name)] = decodeByteString(value);
+                        break;
+                    case CborMapType:
+                        {
+                            OCRepresentation cur;
+                            decodeObject(cur, value, false);
+                            rep.m_values[std::move(name)] = std::move(cur);
+                        }
+                        break;
+                    case CborArrayType:
+                        decodeArray(rep, std::move(name), value);
+                        break;
+                    default:
+                        throw OCException("Unknown attribute type", OC_STACK_MALFORMED_RESPONSE);
+                }
+            }
+
+            // Returns false for arrays with mixed types, which are decoded as objects.
+            static bool findArrayDimensions(const CborValue* array,
+                                            size_t dimensions[MAX_REP_ARRAY_DEPTH],
+                                            OCRepPayloadPropType& type)
+            {
+                type = OCREP_PROP_NULL;
+                dimensions[0] = dimensions[1] = dimensions[2] = 0;
+
+                CborValue item;
+                verify(cbor_value_enter_container(array, &item), "Failed entering array");
+                while (cbor_value_is_valid(&item))
+                {
+                    OCRepPayloadPropType itemType = getPropType(cbor_value_get_type(&item));
+                    if (itemType == OCREP_PROP_ARRAY)
+                    {
+                        size_t subdim[MAX_REP_ARRAY_DEPTH];
+                        if (!findArrayDimensions(&item, subdim, itemType))
+                        {
+                            return false;
+                        }
+                        dimensions[1] = std::max(dimensions[1], subdim[0]);
+                        dimensions[2] = std::max(dimensions[2], subdim[1]);
+                    }
+
+                    if (type == OCREP_PROP_NULL)
+                    {
+                        type = itemType;
+                    }
+                    else if (itemType != OCREP_PROP_NULL && itemType != type)
+                    {
+                        return false;
+                    }
+
+                    ++dimensions[0];
+                    verify(cbor_value_advance(&item), "Failed advancing array");
+                }
+                return true;
+            }
+
+            static void decodeItem(CborValue* value, int& item)
+            {
+                int64_t i = 0;
+                verify(cbor_value_get_int64(value, &i), "Failed getting int value");
+                // Needs to be removed as part of IOT-1726 fix.
+                item = static_cast<int>(i);
+                verify(cbor_value_advance_fixed(value), "Failed advancing value");
+            }
+
+            static void decodeItem(CborValue* value, double& item)
+            {
+                if (cbor_value_is_float(value))
+                {
+                    float f = 0;
+                    verify(cbor_value_get_float(value, &f), "Failed getting float value");
+                    item = f;
+                }
+                else
+                {
+                    verify(cbor_value_get_double(value, &item), "Failed getting double value");
+                }
+                verify(cbor_value_advance_fixed(value), "Failed advancing value");
+            }
+
+            static void decodeItem(CborValue* value, bool& item)
+            {
+                verify(cbor_value_get_boolean(value, &item), "Failed getting boolean value");
+                verify(cbor_value_advance_fixed(value), "Failed advancing value");
+            }
+
+            static void decodeItem(CborValue* value, std::string& item)
+            {
+                item = decodeTextString(value);
+            }
+
+            // Like the OCRepPayload path, the OCByteString refers to the bytes of the
+            // payload instead of owning a copy.
+            static void decodeItem(CborValue* value, OCByteString& item)
+            {
+                size_t len = 0;
+                verify(cbor_value_get_string_length(value, &len),
+                       "Chunked byte strings are not supported in arrays");
+                verify(cbor_value_advance(value), "Failed advancing value");
+                item.bytes = len ? const_cast<uint8_t*>(value->ptr - len) : nullptr;
+                item.len = len;
+            }
+
+            static void decodeItem(CborValue* value, OCRepresentation& item)
+            {
+                decodeObject(item, value, false);
+            }
+
+            // Fills one level of a typed array. With a null value the array is only
+            // sized, missing and null items keep the default value.
+            template<typename T>
+            static void fillArray(std::vector<T>& arr, CborValue* value,
+                                  const size_t* dimensions, OCRepPayloadPropType type)
+            {
+                arr.resize(dimensions[0]);
+                if (!value)
+                {
+                    return;
+                }
+
+                CborValue item;
+                verify(cbor_value_enter_container(value, &item), "Failed entering array");
+                for (size_t i = 0; cbor_value_is_valid(&item); ++i)
+                {
+                    if (i < dimensions[0] && getPropType(cbor_value_get_type(&item)) == type)
+                    {
+                        T val;
+                        decodeItem(&item, val);
+                        arr[i] = std::move(val);
+                    }
+                    else
+                    {
+                        verify(cbor_value_advance(&item), "Failed advancing array");
+                    }
+                }
+                verify(cbor_value_leave_container(value, &item), "Failed leaving array");
+            }
+
+            template<typename T>
+            static void fillArray(std::vector<std::vector<T>>& arr, CborValue* value,
+                                  const size_t* dimensions, OCRepPayloadPropType type)
+            {
+                arr.resize(dimensions[0]);
+                for (auto& sub : arr)
+                {
+                    fillArray(sub, nullptr, dimensions + 1, type);
+                }
+                if (!value)
+                {
+                    return;
+                }
+
+                CborValue item;
+                verify(cbor_value_enter_container(value, &item), "Failed entering array");
+                for (size_t i = 0; cbor_value_is_valid(&item); ++i)
+                {
+                    if (i < dimensions[0] && cbor_value_is_array(&item))
+                    {
+                        fillArray(arr[i], &item, dimensions + 1, type);
+                    }
+                    else
+                    {
+                        verify(cbor_value_advance(&item), "Failed advancing array");
+                    }
+                }
+                verify(cbor_value_leave_container(value, &item), "Failed leaving array");
+            }
+
+            template<typename T>
+            static void decodeTypedArray(OCRepresentation& rep, std::string&& name,
+                                         CborValue* value, const size_t* dimensions,
+                                         OCRepPayloadPropType type)
+            {
+                switch (calcArrayDepth(dimensions))
+                {
+                    case 1:
+                        {
+                            std::vector<T> arr;
+                            fillArray(arr, value, dimensions, type);
+                            rep.m_values[std::move(name)] = std::move(arr);
+                        }
+                        break;
+                    case 2:
+                        {
+                            std::vector<std::vector<T>> arr;
+                            fillArray(arr, value, dimensions, type);
+                            rep.m_values[std::move(name)] = std::move(arr);
+                        }
+                        break;
+                    default:
+                        {
+                            std::vector<std::vector<std::vector<T>>> arr;
+                            fillArray(arr, value, dimensions, type);
+                            rep.m_values[std::move(name)] = std::move(arr);
+                        }
+                        break;
+                }
+            }
+
+            static void decodeArray(OCRepresentation& rep, std::string&& name, CborValue* value)
+            {
+                size_t dimensions[MAX_REP_ARRAY_DEPTH];
+                OCRepPayloadPropType type;
+                if (!findArrayDimensions(value, dimensions, type))
+                {
+                    // mixed arrays are objects with the item indexes as names.
+                    OCRepresentation cur;
+                    decodeObject(cur, value, false);
+                    rep.m_values[std::move(name)] = std::move(cur);
+                    return;
+                }
+
+                switch (type)
+                {
+                    case OCREP_PROP_NULL:
+                        rep.m_values[std::move(name)] = OC::NullType();
+                        verify(cbor_value_advance(value), "Failed advancing array");
+                        break;
+                    case OCREP_PROP_INT:
+                        decodeTypedArray<int>(rep, std::move(name), value, dimensions, type);
+                        break;
+                    case OCREP_PROP_DOUBLE:
+                        decodeTypedArray<double>(rep, std::move(name), value, dimensions, type);
+                        break;
+                    case OCREP_PROP_BOOL:
+                        decodeTypedArray<bool>(rep, std::move(name), value, dimensions, type);
+                        break;
+                    case OCREP_PROP_STRING:
+                        decodeTypedArray<std::string>(rep, std::move(name), value, dimensions,
+                                                      type);
+                        break;
+                    case OCREP_PROP_BYTE_STRING:
+                        decodeTypedArray<OCByteString>(rep, std::move(name), value, dimensions,
+                                                       type);
+                        break;
+                    case OCREP_PROP_OBJECT:
+                        decodeTypedArray<OCRepresentation>(rep, std::move(name), value,
+                                                           dimensions, type);
+                        break;
+                    default:
+                        throw OCException("Invalid array type", OC_STACK_MALFORMED_RESPONSE);
+                }
+            }
+    };
+
+    void MessageContainer::setCborPayload(const uint8_t* payload, size_t size)
+    {
+        CborRepresentationDecoder::decode(m_reps, payload, size);
+    }
+
     void OCRepresentation::addChild(const OCRepresentation& rep)
     {
         m_children.push_back(rep);
@@ -745,6 +1226,24 @@ namespace OC
         m_dataModelVersions.push_back(str);
     }
 
+    const std::map<std::string, AttributeValue>& OCRepresentation::getValues() const
+    {
+        // const access may come from several threads, publish one snapshot per change.
+        std::shared_ptr<const ValuesSnapshot> snapshot = std::atomic_load(&m_valuesSnapshot);
+        if (!snapshot || snapshot->generation != m_values.generation())
+        {
+            std::shared_ptr<const ValuesSnapshot> built = std::make_shared<const ValuesSnapshot>(
+                    ValuesSnapshot{m_values.generation(),
+                        std::map<std::string, AttributeValue>(m_values.begin(), m_values.end())});
+            // on failure another reader has published the same attributes first.
+            if (std::atomic_compare_exchange_strong(&m_valuesSnapshot, &snapshot, built))
+            {
+                snapshot = built;
+            }
+        }
+        return snapshot->values;
+    }
+
     bool OCRepresentation::hasAttribute(const std::string& str) const
     {
         return m_values.find(str) != m_values.end();
@@ -857,7 +1356,7 @@ namespace OC
 namespace OC
 {
     OCRepresentation::AttributeItem::AttributeItem(const std::string& name,
-            std::map<std::string, AttributeValue>& vals):
+            AttributeMap& vals):
             m_attrName(name), m_values(vals){}
 
     OCRepresentation::AttributeItem OCRepresentation::operator[](const std::string& key)
@@ -942,6 +1441,14 @@ namespace OC
         }
     };
 
+    static AttributeType getAttributeType(const AttributeValue& value, AttributeType& baseType)
+    {
+        type_introspection_visitor vis;
+        boost::apply_visitor(vis, value);
+        baseType = vis.base_type;
+        return vis.type;
+    }
+
     AttributeType OCRepresentation::AttributeItem::type() const
     {
         type_introspection_visitor vis;
@@ -0,0 +1,183 @@
+//******************************************************************
+//
+// Copyright 2017 Samsung Electronics All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <gtest/gtest.h>
+#include <CallbackExecutor.h>
+
+namespace OC
+{
+    namespace test
+    {
+        namespace CallbackExecutorTests
+        {
+            using namespace OC;
+            typedef std::chrono::steady_clock Clock;
+
+            static bool waitFor(const std::atomic<size_t>& counter, size_t count)
+            {
+                auto deadline = Clock::now() + std::chrono::seconds(30);
+                while (counter < count)
+                {
+                    if (Clock::now() > deadline)
+                    {
+                        return false;
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                return true;
+            }
+
+            TEST(CallbackExecutorTest, RunsAllCallbacks)
+            {
+                std::atomic<size_t> done(0);
+                CallbackExecutor executor(4);
+                EXPECT_EQ(4u, executor.threadCount());
+
+                for (size_t i = 0; i < 1000; ++i)
+                {
+                    executor.post([&done]() { done++; });
+                }
+                EXPECT_TRUE(waitFor(done, 1000));
+            }
+
+            TEST(CallbackExecutorTest, NoThreadsStartsThreadPerCallback)
+            {
+                std::atomic<size_t> done(0);
+                CallbackExecutor executor(0);
+                EXPECT_EQ(0u, executor.threadCount());
+
+                for (size_t i = 0; i < 100; ++i)
+                {
+                    executor.post([&done]() { done++; });
+                }
+                EXPECT_TRUE(waitFor(done, 100));
+            }
+
+            TEST(CallbackExecutorTest, SameKeyKeepsOrder)
+            {
+                const size_t count = 1000;
+                int keys[2];
+                std::vector<size_t> order[2];
+                std::atomic<size_t> running[2];
+                std::atomic<size_t> done(0);
+                std::atomic<bool> overlapped(false);
+                running[0] = 0;
+                running[1] = 0;
+
+                {
+                    CallbackExecutor executor(4);
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        for (size_t k = 0; k < 2; ++k)
+                        {
+                            executor.post(&keys[k], [&, i, k]()
+                            {
+                                if (running[k]++ != 0)
+                                {
+                                    overlapped = true;
+                                }
+                                order[k].push_back(i);
+                                running[k]--;
+                                done++;
+                            });
+                        }
+                    }
+                    EXPECT_TRUE(waitFor(done, 2 * count));
+                }
+
+                EXPECT_FALSE(overlapped);
+                for (size_t k = 0; k < 2; ++k)
+                {
+                    ASSERT_EQ(count, order[k].size());
+                    EXPECT_TRUE(std::is_sorted(order[k].begin(), order[k].end()));
+                }
+            }
+
+            TEST(CallbackExecutorTest, DestructorRunsPostedCallbacks)
+            {
+                std::atomic<size_t> done(0);
+                {
+                    CallbackExecutor executor(1);
+                    for (size_t i = 0; i < 100; ++i)
+                    {
+                        executor.post([&done]() { done++; });
+                    }
+                }
+                EXPECT_EQ(100u, done);
+            }
+
+            TEST(CallbackExecutorTest, ExceptionDoesNotBlockKey)
+            {
+                std::atomic<size_t> done(0);
+                int key;
+                CallbackExecutor executor(2);
+
+                executor.post(&key, []() { throw std::runtime_error("callback failed"); });
+                executor.post(&key, [&done]() { done++; });
+                EXPECT_TRUE(waitFor(done, 1));
+            }
+
+            // Dispatch short callbacks the way the client wrapper does and log
+            // callbacks/sec and the p99 of the time from dispatch to invocation.
+            static void measureDispatch(const char* name, size_t threadCount)
+            {
+                const size_t count = 20000;
+                std::vector<long long> latencies(count);
+                std::atomic<size_t> done(0);
+
+                auto start = Clock::now();
+                {
+                    CallbackExecutor executor(threadCount);
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        auto posted = Clock::now();
+                        executor.post([&latencies, &done, i, posted]()
+                        {
+                            latencies[i] = std::chrono::duration_cast<std::chrono::microseconds>(
+                                Clock::now() - posted).count();
+                            done++;
+                        });
+                    }
+                    EXPECT_TRUE(waitFor(done, count));
+                }
+                auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                    Clock::now() - start).count();
+
+                std::sort(latencies.begin(), latencies.end());
+                std::cout << name << ": "
+                          << (elapsed ? (count * 1000000.0) / elapsed : 0) << " callbacks/sec, "
+                          << "p99 dispatch latency " << latencies[count * 99 / 100] << " us"
+                          << std::endl;
+            }
+
+            TEST(CallbackExecutorTest, DispatchBenchmark)
+            {
+                measureDispatch("thread per callback", 0);
+                measureDispatch("4 callback threads", 4);
+            }
+        }
+    }
+}
@@ -460,6 +460,93 @@ namespace OCRepresentationEncodingTest
                 newSubRep.getValue<std::vector<uint8_t>>("BinaryAttr"));
         OCPayloadDestroy(cparsed);
     }
+    TEST(RepresentationEncoding, CborPayloadMatchesParsedPayload)
+    {
+        OC::OCRepresentation subRep;
+        subRep.setNULL("NullAttr");
+        subRep.setValue("IntAttr", -77);
+        subRep.setValue("StringAttr", std::string("String attr"));
+
+        uint8_t binval1[] = {0x1, 0x2, 0x3, 0x4};
+        OCByteString byteStringRef1 {binval1, sizeof(binval1)};
+        OCByteString byteString1 {NULL,0};
+        EXPECT_TRUE(OCByteStringCopy(&byteString1, &byteStringRef1));
+        uint8_t binval2[] = {0x5};
+        OCByteString byteStringRef2 {binval2, sizeof(binval2)};
+        OCByteString byteString2 {NULL,0};
+        EXPECT_TRUE(OCByteStringCopy(&byteString2, &byteStringRef2));
+        std::vector<OCByteString> bytestrarrRef {byteStringRef1, byteStringRef2};
+        std::vector<OCByteString> bytestrarr {byteString1, byteString2};
+        std::vector<std::vector<int>> iarr {{1, 2, 3}, {4, 5}};
+        std::vector<std::vector<std::vector<std::string>>> strarr
+            {{{"item1", "item2"}, {"item3"}}, {{"item4", ""}}};
+        std::vector<OC::OCRepresentation> objarr {subRep, subRep};
+
+        OC::OCRepresentation startRep;
+        startRep.setUri("/a/light");
+        startRep.addResourceType("core.light");
+        startRep.addResourceType("core.brightlight");
+        startRep.addResourceInterface(OC_RSRVD_INTERFACE_DEFAULT);
+        startRep.setValue("IntAttr", 77);
+        startRep.setValue("DoubleAttr", 3.333);
+        startRep.setValue("BoolAttr", true);
+        startRep.setValue("StringAttr", std::string("String attr"));
+        startRep.setValue("BinaryAttr", std::vector<uint8_t> {5, 3, 4, 5, 6, 0, 34});
+        startRep.setValue("Sub", subRep);
+        startRep["iarr"] = iarr;
+        startRep["darr"] = std::vector<double> {1.1, 2.2};
+        startRep["barr"] = std::vector<bool> {false, true};
+        startRep["strarr"] = strarr;
+        startRep["objarr"] = objarr;
+        startRep["bytestrarr"] = bytestrarr;
+
+        OC::OCRepresentation secondRep;
+        secondRep.setUri("/a/light/2");
+        secondRep.setValue("IntAttr", 1);
+
+        OC::MessageContainer mc1;
+        mc1.addRepresentation(startRep);
+        mc1.addRepresentation(secondRep);
+        OCRepPayload* cstart = mc1.getPayload();
+
+        uint8_t* cborData;
+        size_t cborSize;
+        OCPayload* cparsed;
+        EXPECT_EQ(OC_STACK_OK, OCConvertPayload((OCPayload*)cstart, OC_FORMAT_CBOR, &cborData, &cborSize));
+        EXPECT_EQ(OC_STACK_OK, OCParsePayload(&cparsed, OC_FORMAT_CBOR, PAYLOAD_TYPE_REPRESENTATION,
+                    cborData, cborSize));
+        OCPayloadDestroy((OCPayload*)cstart);
+
+        OC::MessageContainer parsed;
+        parsed.setPayload(cparsed);
+        OC::MessageContainer decoded;
+        decoded.setCborPayload(cborData, cborSize);
+
+        ASSERT_EQ(2u, decoded.representations().size());
+        EXPECT_TRUE(parsed.representations() == decoded.representations());
+        EXPECT_EQ("/a/light", decoded[0].getUri());
+        EXPECT_EQ(2u, decoded[0].getResourceTypes().size());
+        // jagged arrays come back padded to their largest dimensions, as from OCParsePayload.
+        std::vector<std::vector<int>> iarrPadded {{1, 2, 3}, {4, 5, 0}};
+        std::vector<std::vector<std::vector<std::string>>> strarrPadded
+            {{{"item1", "item2"}, {"item3", ""}}, {{"item4", ""}, {"", ""}}};
+        EXPECT_EQ(iarrPadded, decoded[0].getValue<std::vector<std::vector<int>>>("iarr"));
+        EXPECT_EQ(strarrPadded,
+                (decoded[0].getValue<std::vector<std::vector<std::vector<std::string>>>>("strarr")));
+        EXPECT_EQ(bytestrarrRef, decoded[0].getValue<std::vector<OCByteString>>("bytestrarr"));
+
+        OICFree(cborData);
+        OCPayloadDestroy(cparsed);
+    }
+
+    TEST(RepresentationEncoding, CborPayloadMalformed)
+    {
+        // a single integer is not a representation.
+        uint8_t cborData[] = {0x01};
+        OC::MessageContainer mc;
+        EXPECT_THROW(mc.setCborPayload(cborData, sizeof(cborData)), OC::OCException);
+    }
+
 #if defined (_MSC_VER)
     TEST(RepresentationEncoding, DISABLED_OneDVectors)
 #else
@@ -22,7 +22,11 @@
 #include <OCApi.h>
 #include <string>
 #include <limits>
+#include <chrono>
+#include <iostream>
 #include <boost/lexical_cast.hpp>
+#include "ocpayload.h"
+
 namespace OCRepresentationTest
 {
     using namespace OC;
@@ -1466,4 +1470,177 @@ namespace OCRepresentationTest
         EXPECT_ANY_THROW(rep.setDevAddr(addr));
     }
 
+    TEST(OCRepresentationAttributeOrder, IteratesInNameOrder)
+    {
+        OCRepresentation rep;
+        rep.setValue("c", 3);
+        rep.setValue("a", 1);
+        rep.setValue("d", 4);
+        rep.setValue("b", 2);
+        rep.setValue("a", 5);
+
+        EXPECT_EQ(4u, rep.numberOfAttributes());
+        std::string names;
+        for (const auto& item : rep)
+        {
+            names += item.attrname();
+        }
+        EXPECT_EQ("abcd", names);
+        EXPECT_EQ(5, rep.getValue<int>("a"));
+
+        EXPECT_TRUE(rep.erase("b"));
+        EXPECT_FALSE(rep.erase("b"));
+        EXPECT_FALSE(rep.hasAttribute("b"));
+        EXPECT_EQ(3, rep.getValue<int>("c"));
+        EXPECT_EQ(3u, rep.getValues().size());
+    }
+
+    TEST(OCRepresentationAttributeOrder, GetValuesKeepsMapUntilChanged)
+    {
+        OCRepresentation rep;
+        rep.setValue("b", 2);
+        rep.setValue("a", 1);
+
+        const std::map<std::string, AttributeValue>& values = rep.getValues();
+        EXPECT_EQ(&values, &rep.getValues());
+        EXPECT_EQ(2, std::distance(rep.getValues().begin(), rep.getValues().end()));
+        EXPECT_EQ(1, rep.getValue<int>("a"));
+        EXPECT_TRUE(rep.hasAttribute("b"));
+        EXPECT_EQ(&values, &rep.getValues());
+
+        // a copy shares the map until one of them changes.
+        OCRepresentation copy = rep;
+        EXPECT_EQ(&values, &copy.getValues());
+        copy["a"] = 3;
+        EXPECT_EQ(3, boost::get<int>(copy.getValues().at("a")));
+        EXPECT_EQ(1, boost::get<int>(values.at("a")));
+
+        rep.setValue("c", 4);
+        rep.erase("b");
+        const std::map<std::string, AttributeValue>& changed = rep.getValues();
+        ASSERT_EQ(2u, changed.size());
+        EXPECT_EQ("a", changed.begin()->first);
+        EXPECT_EQ(4, boost::get<int>(changed.at("c")));
+    }
+
+    TEST(OCRepresentationAttributeOrder, PayloadInAnyOrder)
+    {
+        OCRepPayload* payload = OCRepPayloadCreate();
+        ASSERT_TRUE(NULL != payload);
+        EXPECT_TRUE(OCRepPayloadSetPropInt(payload, "zeta", 1));
+        EXPECT_TRUE(OCRepPayloadSetPropString(payload, "alpha", "value"));
+        EXPECT_TRUE(OCRepPayloadSetPropBool(payload, "mu", true));
+
+        OCRepresentation rep;
+        MessageContainer mc;
+        mc.setPayload(payload);
+        OCPayloadDestroy((OCPayload*)payload);
+        ASSERT_EQ(1u, mc.representations().size());
+        rep = mc.representations()[0];
+
+        EXPECT_EQ(1, rep.getValue<int>("zeta"));
+        EXPECT_EQ("value", rep.getValue<std::string>("alpha"));
+        EXPECT_TRUE(rep.getValue<bool>("mu"));
+
+        payload = rep.getPayload();
+        ASSERT_TRUE(NULL != payload);
+        ASSERT_TRUE(NULL != payload->values);
+        EXPECT_STREQ("alpha", payload->values->name);
+        OCPayloadDestroy((OCPayload*)payload);
+    }
+
+    // Sets, reads and converts a representation of 50 attributes the way a
+    // sensor response is built and log the operations/sec of each step.
+    class OCRepresentationBenchmark : public testing::Test
+    {
+        protected:
+            static const size_t Attributes = 50;
+            static const size_t Rounds = 2000;
+
+            static std::string name(size_t i)
+            {
+                return "attribute" + std::to_string(i);
+            }
+
+            static void fill(OCRepresentation& rep)
+            {
+                for (size_t i = 0; i < Attributes; ++i)
+                {
+                    switch (i % 4)
+                    {
+                        case 0:
+                            rep.setValue(name(i), static_cast<int>(i));
+                            break;
+                        case 1:
+                            rep.setValue(name(i), i * 0.5);
+                            break;
+                        case 2:
+                            rep.setValue(name(i), (i % 3) == 0);
+                            break;
+                        default:
+                            rep.setValue(name(i), std::string("a string value"));
+                            break;
+                    }
+                }
+            }
+
+            template<typename F>
+            static void measure(const char* step, F func)
+            {
+                auto start = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < Rounds; ++i)
+                {
+                    func();
+                }
+                auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                double perSec = elapsed ? (Rounds * 1000000.0) / elapsed : 0;
+
+                std::cout << step << ": " << perSec << " representations/sec" << std::endl;
+            }
+    };
+
+    TEST_F(OCRepresentationBenchmark, SetGetSerialize)
+    {
+        std::vector<std::string> names;
+        for (size_t i = 0; i < Attributes; ++i)
+        {
+            names.push_back(name(i));
+        }
+
+        measure("set", []()
+        {
+            OCRepresentation rep;
+            fill(rep);
+        });
+
+        OCRepresentation rep;
+        fill(rep);
+        size_t found = 0;
+        measure("get", [&]()
+        {
+            for (const auto& n : names)
+            {
+                AttributeValue value;
+                found += rep.getAttributeValue(n, value) ? 1 : 0;
+            }
+        });
+        EXPECT_EQ(Attributes * Rounds, found);
+
+        measure("getPayload", [&rep]()
+        {
+            OCRepPayload* payload = rep.getPayload();
+            OCPayloadDestroy((OCPayload*)payload);
+        });
+
+        OCRepPayload* payload = rep.getPayload();
+        ASSERT_TRUE(NULL != payload);
+        measure("setPayload", [payload]()
+        {
+            MessageContainer mc;
+            mc.setPayload(payload);
+        });
+        OCPayloadDestroy((OCPayload*)payload);
+    }
+
 }
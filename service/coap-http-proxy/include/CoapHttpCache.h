@@ -0,0 +1,127 @@
+/* ****************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+/**
+ * @file
+ * This file contains the HTTP response cache of the proxy.
+ *
+ * Responses to GET requests are cached as a shared cache in the sense of RFC 7234,
+ * keyed by resource uri and Accept header. Stale entries are only kept if they have
+ * an ETag, in which case they can be revalidated with a conditional request.
+ */
+
+#ifndef COAP_HTTP_CACHE_H_
+#define COAP_HTTP_CACHE_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include "CoapHttpParser.h"
+
+#define CHP_CACHE_MAX_ENTRIES (64)
+#define CHP_CACHE_MAX_SIZE (1048576U) // 1 MB for all cached payloads
+#define CHP_CACHE_MAX_ENTRY_SIZE (65536U)
+
+/**
+ * @enum CHPCacheResult_t
+ * Result of a cache lookup.
+ */
+typedef enum
+{
+    CHP_CACHE_MISS = 0,     /**< No usable entry, forward the request */
+    CHP_CACHE_FRESH,        /**< Fresh entry, respond from the cache */
+    CHP_CACHE_STALE         /**< Stale entry with an ETag, revalidate it */
+} CHPCacheResult_t;
+
+/**
+ * Function to remove all entries from the cache.
+ */
+void CHPCacheTerminate();
+
+/**
+ * Function to look up the response cached for a request.
+ *
+ * @param[in]   uri         Uri of the HTTP resource.
+ * @param[in]   accept      Accept header sent with the request.
+ * @param[out]  response    Copy of the cached response for CHP_CACHE_FRESH and
+ *                          CHP_CACHE_STALE. Caller shall free it with
+ *                          CHPCacheFreeResponse().
+ * @param[out]  maxAge      Seconds the entry stays fresh.
+ * @return CHP_CACHE_FRESH, CHP_CACHE_STALE or CHP_CACHE_MISS.
+ */
+CHPCacheResult_t CHPCacheLookup(const char *uri, const char *accept,
+                                HttpResponse_t **response, uint32_t *maxAge);
+
+/**
+ * Function to store the response of a GET request if it is cacheable.
+ *
+ * @param[in]   uri         Uri of the HTTP resource.
+ * @param[in]   accept      Accept header sent with the request.
+ * @param[in]   response    Response received from the HTTP server.
+ * @param[out]  maxAge      Seconds the response may be reused by CoAP clients,
+ *                          0 if it is not cacheable.
+ * @return OC_STACK_OK if the response is cached.
+ */
+OCStackResult CHPCacheStore(const char *uri, const char *accept,
+                            const HttpResponse_t *response, uint32_t *maxAge);
+
+/**
+ * Function to refresh a stale entry with a 304 (Not Modified) response.
+ * The header fields of notModified replace those of the stored response.
+ *
+ * @param[in]   uri         Uri of the HTTP resource.
+ * @param[in]   accept      Accept header sent with the request.
+ * @param[in,out] stored    Response returned by CHPCacheLookup().
+ * @param[in]   notModified 304 response received from the HTTP server.
+ * @param[out]  maxAge      Seconds the refreshed response stays fresh.
+ * @return OC_STACK_OK if the refreshed response is cached.
+ */
+OCStackResult CHPCacheRefresh(const char *uri, const char *accept, HttpResponse_t *stored,
+                              const HttpResponse_t *notModified, uint32_t *maxAge);
+
+/**
+ * Function to remove all entries of a resource, for any Accept header.
+ * Used after unsafe requests as described in RFC 7234 section 4.4.
+ *
+ * @param[in]   uri         Uri of the HTTP resource.
+ */
+void CHPCacheInvalidate(const char *uri);
+
+/**
+ * Function to free a response returned by CHPCacheLookup().
+ */
+void CHPCacheFreeResponse(HttpResponse_t *response);
+
+/**
+ * Function to get a header field of a response.
+ *
+ * @param[in]   response    HTTP response.
+ * @param[in]   name        Lower case header field name.
+ * @return Value of the first header field with that name or NULL.
+ */
+const char *CHPCacheGetHeader(const HttpResponse_t *response, const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
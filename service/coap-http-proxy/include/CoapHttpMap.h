@@ -34,6 +34,9 @@ extern "C"
 #include "CoapHttpParser.h"
 #include "cJSON.h"
 
+/** Maximum length of a CoAP ETag option, RFC 7252 section 5.10.6. */
+#define CHP_MAX_ETAG_LENGTH 8
+
 /**
  * Function to get CoAP option ID for an HTTP option name.
  * @param[in]   httpOptionNameStr   HTTP option name.
@@ -59,6 +62,23 @@ OCStackResult CHPGetOCCode(const HttpResponseResult_t httpCode, const OCMethod m
  */
 OCStackResult CHPGetOCOption(const HttpHeaderOption_t *httpOption, OCHeaderOption *ret);
 
+/**
+ * Function to get CoAP Max-Age option.
+ * @param[in]   maxAge            Seconds the response stays fresh.
+ * @param[out]  ret               CoAP Max-Age option.
+ * @return ::OC_STACK_OK or appropriate error code.
+ */
+OCStackResult CHPGetOCMaxAgeOption(uint32_t maxAge, OCHeaderOption *ret);
+
+/**
+ * Function to get CoAP ETag option for an HTTP entity tag. Entity tags longer
+ * than a CoAP ETag are replaced by a hash of the entity tag.
+ * @param[in]   httpETag          HTTP entity tag.
+ * @param[out]  ret               CoAP ETag option.
+ * @return ::OC_STACK_OK or appropriate error code.
+ */
+OCStackResult CHPGetOCETagOption(const char *httpETag, OCHeaderOption *ret);
+
 /**
  * Function to get CoAP payload format for HTTP payload format.
  * @param[in]   httpContentType   HTTP payload format.
@@ -50,6 +50,10 @@ extern "C"
 #define HTTP_OPTION_CONTENT_TYPE    "content-type"
 #define HTTP_OPTION_CONTENT_LENGTH  "content-length"
 #define HTTP_OPTION_EXPIRES         "expires"
+#define HTTP_OPTION_DATE            "date"
+#define HTTP_OPTION_AGE             "age"
+#define HTTP_OPTION_PRAGMA          "pragma"
+#define HTTP_OPTION_VARY            "vary"
 
 /**
  * @enum HttpResponseResult_t
@@ -0,0 +1,678 @@
+/* ****************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+#include "iotivity_config.h"
+#include "CoapHttpCache.h"
+#include "oic_malloc.h"
+#include "oic_string.h"
+#include "oic_time.h"
+#include "uarraylist.h"
+#include "logger.h"
+
+#include <ctype.h>
+#include <string.h>
+#include <time.h>
+#include <curl/curl.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#define TAG "CHP_CACHE"
+
+/* RFC 7234 section 1.2.1: delta-seconds greater than this are treated as this value */
+#define CHP_CACHE_MAX_DELTA_SECONDS (2147483648LL)
+
+/*
+ * Header fields kept with a cached response, the others are neither needed to
+ * compute freshness nor mapped to CoAP options.
+ */
+static const char *g_cacheHeaders[] =
+{
+    HTTP_OPTION_CACHE_CONTROL,
+    HTTP_OPTION_EXPIRES,
+    HTTP_OPTION_ETAG,
+    HTTP_OPTION_DATE,
+    HTTP_OPTION_AGE,
+    HTTP_OPTION_PRAGMA,
+    HTTP_OPTION_VARY,
+};
+
+typedef struct
+{
+    bool noStore;
+    bool noCache;
+    bool isPrivate;
+    int64_t maxAge;     /* -1 if not present */
+    int64_t sMaxAge;    /* -1 if not present */
+} CHPCacheControl_t;
+
+typedef struct CHPCacheEntry_t
+{
+    uint32_t hash;
+    char *uri;
+    char *accept;
+    HttpResponse_t *response;
+    /* Monotonic seconds until which the response is fresh */
+    uint64_t expiresAt;
+    size_t size;
+    struct CHPCacheEntry_t *prev;
+    struct CHPCacheEntry_t *next;
+} CHPCacheEntry_t;
+
+/* Entries are kept in least recently used order, most recent first. */
+static pthread_mutex_t g_cacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static CHPCacheEntry_t *g_cacheHead;
+static CHPCacheEntry_t *g_cacheTail;
+static size_t g_cacheCount;
+static size_t g_cacheSize;
+
+static uint64_t CHPCacheNow()
+{
+    return OICGetCurrentTime(TIME_IN_MS) / 1000;
+}
+
+static uint32_t CHPCacheHash(const char *uri, const char *accept)
+{
+    uint32_t hash = 5381;
+    for (const char *c = uri; *c; c++)
+    {
+        hash = (hash * 33) ^ (unsigned char)*c;
+    }
+    hash = hash * 33;
+    for (const char *c = accept; *c; c++)
+    {
+        hash = (hash * 33) ^ (unsigned char)*c;
+    }
+    return hash;
+}
+
+static bool CHPCacheNameEquals(const char *name, size_t length, const char *expected)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        if ('\0' == expected[i] || tolower((unsigned char)name[i]) != expected[i])
+        {
+            return false;
+        }
+    }
+    return '\0' == expected[length];
+}
+
+static bool CHPCacheIsKeptHeader(const char *name)
+{
+    for (size_t i = 0; i < sizeof(g_cacheHeaders) / sizeof(g_cacheHeaders[0]); i++)
+    {
+        if (CHPCacheNameEquals(name, strlen(name), g_cacheHeaders[i]))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *CHPCacheGetHeader(const HttpResponse_t *response, const char *name)
+{
+    if (!response || !name || !response->headerOptions)
+    {
+        return NULL;
+    }
+
+    size_t count = u_arraylist_length(response->headerOptions);
+    for (size_t i = 0; i < count; i++)
+    {
+        HttpHeaderOption_t *option = u_arraylist_get(response->headerOptions, i);
+        if (option && CHPCacheNameEquals(option->optionName, strlen(option->optionName), name))
+        {
+            return option->optionData;
+        }
+    }
+    return NULL;
+}
+
+static int64_t CHPCacheParseSeconds(const char *value, size_t length)
+{
+    if (!value || !length)
+    {
+        return 0;
+    }
+
+    int64_t seconds = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        if (!isdigit((unsigned char)value[i]))
+        {
+            // An invalid delta-seconds makes the response stale.
+            return 0;
+        }
+        if (seconds < CHP_CACHE_MAX_DELTA_SECONDS)
+        {
+            seconds = seconds * 10 + (value[i] - '0');
+        }
+    }
+    return seconds < CHP_CACHE_MAX_DELTA_SECONDS ? seconds : CHP_CACHE_MAX_DELTA_SECONDS;
+}
+
+static void CHPCacheParseControlValue(const char *data, CHPCacheControl_t *cc)
+{
+    const char *ptr = data;
+    while (*ptr)
+    {
+        while (*ptr == ' ' || *ptr == '\t' || *ptr == ',')
+        {
+            ptr++;
+        }
+
+        const char *name = ptr;
+        while (*ptr && *ptr != ',' && *ptr != '=' && *ptr != ' ' && *ptr != '\t')
+        {
+            ptr++;
+        }
+        size_t nameLength = ptr - name;
+
+        while (*ptr == ' ' || *ptr == '\t')
+        {
+            ptr++;
+        }
+
+        const char *value = NULL;
+        size_t valueLength = 0;
+        if (*ptr == '=')
+        {
+            ptr++;
+            if (*ptr == '"')
+            {
+                value = ++ptr;
+                while (*ptr && *ptr != '"')
+                {
+                    ptr++;
+                }
+                valueLength = ptr - value;
+                if (*ptr)
+                {
+                    ptr++;
+                }
+            }
+            else
+            {
+                value = ptr;
+                while (*ptr && *ptr != ',' && *ptr != ' ' && *ptr != '\t')
+                {
+                    ptr++;
+                }
+                valueLength = ptr - value;
+            }
+        }
+
+        // Skip anything left up to the next directive
+        while (*ptr && *ptr != ',')
+        {
+            ptr++;
+        }
+
+        if (CHPCacheNameEquals(name, nameLength, "no-store"))
+        {
+            cc->noStore = true;
+        }
+        else if (CHPCacheNameEquals(name, nameLength, "no-cache"))
+        {
+            // no-cache with field names is treated as a plain no-cache.
+            cc->noCache = true;
+        }
+        else if (CHPCacheNameEquals(name, nameLength, "private"))
+        {
+            cc->isPrivate = true;
+        }
+        else if (CHPCacheNameEquals(name, nameLength, "max-age"))
+        {
+            cc->maxAge = CHPCacheParseSeconds(value, valueLength);
+        }
+        else if (CHPCacheNameEquals(name, nameLength, "s-maxage"))
+        {
+            cc->sMaxAge = CHPCacheParseSeconds(value, valueLength);
+        }
+    }
+}
+
+static void CHPCacheParseControl(const HttpResponse_t *response, CHPCacheControl_t *cc)
+{
+    memset(cc, 0, sizeof(*cc));
+    cc->maxAge = -1;
+    cc->sMaxAge = -1;
+
+    bool present = false;
+    size_t count = u_arraylist_length(response->headerOptions);
+    for (size_t i = 0; i < count; i++)
+    {
+        HttpHeaderOption_t *option = u_arraylist_get(response->headerOptions, i);
+        if (option && CHPCacheNameEquals(option->optionName, strlen(option->optionName),
+                                         HTTP_OPTION_CACHE_CONTROL))
+        {
+            CHPCacheParseControlValue(option->optionData, cc);
+            present = true;
+        }
+    }
+
+    // RFC 7234 section 5.4: Pragma is only considered without Cache-Control.
+    const char *pragma = CHPCacheGetHeader(response, HTTP_OPTION_PRAGMA);
+    if (!present && pragma && strstr(pragma, "no-cache"))
+    {
+        cc->noCache = true;
+    }
+}
+
+/*
+ * Returns the seconds the response stays fresh after it has been received
+ * (RFC 7234 section 4.2), 0 if it must be revalidated before it is reused.
+ */
+static int64_t CHPCacheGetFreshness(const HttpResponse_t *response, bool *storable)
+{
+    CHPCacheControl_t cc;
+    CHPCacheParseControl(response, &cc);
+
+    bool explicitLifetime = true;
+    int64_t lifetime = 0;
+    const char *expires = CHPCacheGetHeader(response, HTTP_OPTION_EXPIRES);
+    if (cc.sMaxAge >= 0)
+    {
+        lifetime = cc.sMaxAge;
+    }
+    else if (cc.maxAge >= 0)
+    {
+        lifetime = cc.maxAge;
+    }
+    else if (expires)
+    {
+        // An invalid date, like "0", means the response is already expired.
+        time_t expiresTime = curl_getdate(expires, NULL);
+        const char *date = CHPCacheGetHeader(response, HTTP_OPTION_DATE);
+        time_t dateTime = date ? curl_getdate(date, NULL) : -1;
+        if (-1 == dateTime)
+        {
+            dateTime = time(NULL);
+        }
+        lifetime = (-1 != expiresTime && expiresTime > dateTime) ? expiresTime - dateTime : 0;
+    }
+    else
+    {
+        // Heuristic freshness is not used, such responses are only revalidated.
+        explicitLifetime = false;
+    }
+
+    const char *age = CHPCacheGetHeader(response, HTTP_OPTION_AGE);
+    int64_t ageSeconds = age ? CHPCacheParseSeconds(age, strlen(age)) : 0;
+    int64_t freshness = (explicitLifetime && !cc.noCache && !cc.noStore && lifetime > ageSeconds) ?
+                        lifetime - ageSeconds : 0;
+
+    // A proxy is a shared cache, it must not store private responses. As the
+    // only request header field that changes between requests is Accept, which
+    // is part of the key, any Vary except "*" is satisfied by the stored entry.
+    const char *vary = CHPCacheGetHeader(response, HTTP_OPTION_VARY);
+    *storable = CHP_SUCCESS == response->status && !cc.noStore && !cc.isPrivate &&
+                !(vary && strchr(vary, '*')) &&
+                (freshness > 0 || CHPCacheGetHeader(response, HTTP_OPTION_ETAG));
+
+    return freshness;
+}
+
+static HttpResponse_t *CHPCacheCloneResponse(const HttpResponse_t *response, size_t *size)
+{
+    HttpResponse_t *clone = OICCalloc(1, sizeof(HttpResponse_t));
+    if (!clone)
+    {
+        OIC_LOG(ERROR, TAG, "Memory failed!");
+        return NULL;
+    }
+
+    clone->httpMajor = response->httpMajor;
+    clone->httpMinor = response->httpMinor;
+    clone->status = response->status;
+    OICStrcpy(clone->dataFormat, sizeof(clone->dataFormat), response->dataFormat);
+
+    // Keep the payload NUL terminated, a JSON payload is parsed as a string.
+    clone->payload = OICCalloc(1, response->payloadLength + 1);
+    if (!clone->payload)
+    {
+        OIC_LOG(ERROR, TAG, "Memory failed!");
+        OICFree(clone);
+        return NULL;
+    }
+    if (response->payloadLength)
+    {
+        memcpy(clone->payload, response->payload, response->payloadLength);
+    }
+    clone->payloadLength = response->payloadLength;
+
+    clone->headerOptions = u_arraylist_create();
+    if (!clone->headerOptions)
+    {
+        OIC_LOG(ERROR, TAG, "Memory failed!");
+        CHPCacheFreeResponse(clone);
+        return NULL;
+    }
+
+    size_t total = sizeof(HttpResponse_t) + clone->payloadLength + 1;
+    size_t count = u_arraylist_length(response->headerOptions);
+    for (size_t i = 0; i < count; i++)
+    {
+        HttpHeaderOption_t *option = u_arraylist_get(response->headerOptions, i);
+        if (!option || !CHPCacheIsKeptHeader(option->optionName))
+        {
+            continue;
+        }
+
+        HttpHeaderOption_t *copy = OICMalloc(sizeof(HttpHeaderOption_t));
+        if (!copy || !u_arraylist_add(clone->headerOptions, copy))
+        {
+            OIC_LOG(ERROR, TAG, "Memory failed!");
+            OICFree(copy);
+            CHPCacheFreeResponse(clone);
+            return NULL;
+        }
+        memcpy(copy, option, sizeof(HttpHeaderOption_t));
+        total += sizeof(HttpHeaderOption_t);
+    }
+
+    if (size)
+    {
+        *size = total;
+    }
+    return clone;
+}
+
+void CHPCacheFreeResponse(HttpResponse_t *response)
+{
+    if (!response)
+    {
+        return;
+    }
+
+    u_arraylist_destroy(response->headerOptions);
+    OICFree(response->payload);
+    OICFree(response);
+}
+
+static void CHPCacheUnlink(CHPCacheEntry_t *entry)
+{
+    if (entry->prev)
+    {
+        entry->prev->next = entry->next;
+    }
+    else
+    {
+        g_cacheHead = entry->next;
+    }
+
+    if (entry->next)
+    {
+        entry->next->prev = entry->prev;
+    }
+    else
+    {
+        g_cacheTail = entry->prev;
+    }
+
+    entry->prev = NULL;
+    entry->next = NULL;
+}
+
+static void CHPCachePushFront(CHPCacheEntry_t *entry)
+{
+    entry->prev = NULL;
+    entry->next = g_cacheHead;
+    if (g_cacheHead)
+    {
+        g_cacheHead->prev = entry;
+    }
+    else
+    {
+        g_cacheTail = entry;
+    }
+    g_cacheHead = entry;
+}
+
+static void CHPCacheFreeEntry(CHPCacheEntry_t *entry)
+{
+    CHPCacheFreeResponse(entry->response);
+    OICFree(entry->uri);
+    OICFree(entry->accept);
+    OICFree(entry);
+}
+
+static void CHPCacheRemove(CHPCacheEntry_t *entry)
+{
+    CHPCacheUnlink(entry);
+    g_cacheCount--;
+    g_cacheSize -= entry->size;
+    CHPCacheFreeEntry(entry);
+}
+
+static CHPCacheEntry_t *CHPCacheFind(uint32_t hash, const char *uri, const char *accept)
+{
+    for (CHPCacheEntry_t *entry = g_cacheHead; entry; entry = entry->next)
+    {
+        if (entry->hash == hash && 0 == strcmp(entry->uri, uri) &&
+            0 == strcmp(entry->accept, accept))
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+void CHPCacheTerminate()
+{
+    pthread_mutex_lock(&g_cacheMutex);
+    while (g_cacheHead)
+    {
+        CHPCacheRemove(g_cacheHead);
+    }
+    pthread_mutex_unlock(&g_cacheMutex);
+}
+
+CHPCacheResult_t CHPCacheLookup(const char *uri, const char *accept,
+                                HttpResponse_t **response, uint32_t *maxAge)
+{
+    VERIFY_NON_NULL_RET(uri, TAG, "uri", CHP_CACHE_MISS);
+    VERIFY_NON_NULL_RET(accept, TAG, "accept", CHP_CACHE_MISS);
+    VERIFY_NON_NULL_RET(response, TAG, "response", CHP_CACHE_MISS);
+    VERIFY_NON_NULL_RET(maxAge, TAG, "maxAge", CHP_CACHE_MISS);
+
+    *response = NULL;
+    *maxAge = 0;
+
+    uint32_t hash = CHPCacheHash(uri, accept);
+    uint64_t now = CHPCacheNow();
+    CHPCacheResult_t result = CHP_CACHE_MISS;
+
+    pthread_mutex_lock(&g_cacheMutex);
+    CHPCacheEntry_t *entry = CHPCacheFind(hash, uri, accept);
+    if (entry)
+    {
+        if (entry->expiresAt > now)
+        {
+            result = CHP_CACHE_FRESH;
+            *maxAge = (uint32_t)(entry->expiresAt - now);
+        }
+        else if (CHPCacheGetHeader(entry->response, HTTP_OPTION_ETAG))
+        {
+            result = CHP_CACHE_STALE;
+        }
+        else
+        {
+            OIC_LOG_V(DEBUG, TAG, "Dropping stale entry for %s", uri);
+            CHPCacheRemove(entry);
+            entry = NULL;
+        }
+    }
+
+    if (entry)
+    {
+        *response = CHPCacheCloneResponse(entry->response, NULL);
+        if (*response)
+        {
+            CHPCacheUnlink(entry);
+            CHPCachePushFront(entry);
+        }
+        else
+        {
+            result = CHP_CACHE_MISS;
+            *maxAge = 0;
+        }
+    }
+    pthread_mutex_unlock(&g_cacheMutex);
+
+    OIC_LOG_V(DEBUG, TAG, "Lookup %s: %d", uri, result);
+    return result;
+}
+
+OCStackResult CHPCacheStore(const char *uri, const char *accept,
+                            const HttpResponse_t *response, uint32_t *maxAge)
+{
+    VERIFY_NON_NULL_RET(uri, TAG, "uri", OC_STACK_INVALID_PARAM);
+    VERIFY_NON_NULL_RET(accept, TAG, "accept", OC_STACK_INVALID_PARAM);
+    VERIFY_NON_NULL_RET(response, TAG, "response", OC_STACK_INVALID_PARAM);
+    VERIFY_NON_NULL_RET(maxAge, TAG, "maxAge", OC_STACK_INVALID_PARAM);
+
+    uint32_t hash = CHPCacheHash(uri, accept);
+    bool storable = false;
+    int64_t freshness = CHPCacheGetFreshness(response, &storable);
+    *maxAge = (uint32_t)freshness;
+
+    CHPCacheEntry_t *entry = NULL;
+    size_t size = 0;
+    if (storable)
+    {
+        entry = OICCalloc(1, sizeof(CHPCacheEntry_t));
+        if (entry)
+        {
+            entry->hash = hash;
+            entry->uri = OICStrdup(uri);
+            entry->accept = OICStrdup(accept);
+            entry->response = CHPCacheCloneResponse(response, &size);
+            entry->expiresAt = CHPCacheNow() + freshness;
+            entry->size = size + sizeof(CHPCacheEntry_t) + strlen(uri) + strlen(accept) + 2;
+        }
+
+        if (!entry || !entry->uri || !entry->accept || !entry->response)
+        {
+            OIC_LOG(ERROR, TAG, "Memory failed!");
+            if (entry)
+            {
+                CHPCacheFreeEntry(entry);
+                entry = NULL;
+            }
+        }
+        else if (entry->size > CHP_CACHE_MAX_ENTRY_SIZE)
+        {
+            OIC_LOG_V(DEBUG, TAG, "Response of %s too large to cache", uri);
+            CHPCacheFreeEntry(entry);
+            entry = NULL;
+        }
+    }
+
+    pthread_mutex_lock(&g_cacheMutex);
+    // A newer response replaces the stored one, even if it cannot be cached itself.
+    CHPCacheEntry_t *old = CHPCacheFind(hash, uri, accept);
+    if (old)
+    {
+        CHPCacheRemove(old);
+    }
+
+    if (entry)
+    {
+        while (g_cacheTail && (g_cacheCount >= CHP_CACHE_MAX_ENTRIES ||
+                               g_cacheSize + entry->size > CHP_CACHE_MAX_SIZE))
+        {
+            OIC_LOG_V(DEBUG, TAG, "Evicting %s", g_cacheTail->uri);
+            CHPCacheRemove(g_cacheTail);
+        }
+
+        CHPCachePushFront(entry);
+        g_cacheCount++;
+        g_cacheSize += entry->size;
+    }
+    pthread_mutex_unlock(&g_cacheMutex);
+
+    OIC_LOG_V(DEBUG, TAG, "Store %s: %s, max-age %u", uri, entry ? "cached" : "not cached",
+              *maxAge);
+    return entry ? OC_STACK_OK : OC_STACK_ERROR;
+}
+
+OCStackResult CHPCacheRefresh(const char *uri, const char *accept, HttpResponse_t *stored,
+                              const HttpResponse_t *notModified, uint32_t *maxAge)
+{
+    VERIFY_NON_NULL_RET(stored, TAG, "stored", OC_STACK_INVALID_PARAM);
+    VERIFY_NON_NULL_RET(notModified, TAG, "notModified", OC_STACK_INVALID_PARAM);
+
+    // RFC 7234 section 4.3.4: header fields of the 304 replace the stored ones.
+    size_t count = u_arraylist_length(notModified->headerOptions);
+    for (size_t i = 0; i < count; i++)
+    {
+        HttpHeaderOption_t *option = u_arraylist_get(notModified->headerOptions, i);
+        if (!option || !CHPCacheIsKeptHeader(option->optionName))
+        {
+            continue;
+        }
+
+        char name[CHP_MAX_HF_NAME_LENGTH];
+        OICStrcpy(name, sizeof(name), option->optionName);
+        OICStringToLower(name);
+
+        for (size_t j = u_arraylist_length(stored->headerOptions); j > 0; j--)
+        {
+            HttpHeaderOption_t *storedOption = u_arraylist_get(stored->headerOptions, j - 1);
+            if (storedOption && CHPCacheNameEquals(storedOption->optionName,
+                                                   strlen(storedOption->optionName), name))
+            {
+                OICFree(u_arraylist_remove(stored->headerOptions, j - 1));
+            }
+        }
+
+        HttpHeaderOption_t *copy = OICMalloc(sizeof(HttpHeaderOption_t));
+        if (!copy || !u_arraylist_add(stored->headerOptions, copy))
+        {
+            OIC_LOG(ERROR, TAG, "Memory failed!");
+            OICFree(copy);
+            return OC_STACK_NO_MEMORY;
+        }
+        memcpy(copy, option, sizeof(HttpHeaderOption_t));
+    }
+
+    return CHPCacheStore(uri, accept, stored, maxAge);
+}
+
+void CHPCacheInvalidate(const char *uri)
+{
+    VERIFY_NON_NULL_VOID(uri, TAG, "uri");
+
+    pthread_mutex_lock(&g_cacheMutex);
+    CHPCacheEntry_t *entry = g_cacheHead;
+    while (entry)
+    {
+        CHPCacheEntry_t *next = entry->next;
+        if (0 == strcmp(entry->uri, uri))
+        {
+            OIC_LOG_V(DEBUG, TAG, "Invalidating %s", uri);
+            CHPCacheRemove(entry);
+        }
+        entry = next;
+    }
+    pthread_mutex_unlock(&g_cacheMutex);
+}
@@ -29,6 +29,7 @@
 #include "uarraylist.h"
 #include "CoapHttpParser.h"
 #include "CoapHttpMap.h"
+#include "CoapHttpCache.h"
 #include "cJSON.h"
 
 #define TAG "CHPHandler"
@@ -44,6 +45,12 @@ typedef struct
 {
     OCMethod method;
     OCRequestHandle requestHandle;
+    /* GET request whose response can be served from and stored in the cache */
+    bool cacheable;
+    char uri[CHP_MAX_HF_DATA_LENGTH];
+    char accept[CHP_MAX_HF_DATA_LENGTH];
+    /* Stale cache entry being revalidated, NULL otherwise */
+    HttpResponse_t *cached;
 } CHPRequest_t;
 
 /**
@@ -54,9 +61,10 @@ static int g_isCHProxyInitialized = false;
 
 /**
  * Function to hand over CoAP request handling to Proxy.
+ * responded is set if the request was answered from the cache.
  */
 OCStackResult CHPHandleOCFRequest(const OCEntityHandlerRequest* requestInfo,
-                                   const char* proxyUri);
+                                   const char* proxyUri, bool *responded);
 
 /**
  * Entity handler to receive requests from csdk.
@@ -133,6 +141,7 @@ OCStackResult CHPTerminate()
     {
         OIC_LOG_V(ERROR, TAG, "Parser termination failed[%d]", result);
     }
+    CHPCacheTerminate();
 
     result = OCDeleteResource(g_proxyHandle);
     if (OC_STACK_OK != result)
@@ -237,10 +246,12 @@ OCEntityHandlerResult CHPEntityHandler(OCEntityHandlerFlag flag,
         if (proxyUri[0] != '\0')
         {
             // A request for HTTP resource. Response will be sent asynchronously
+            // unless it was answered from the cache.
+            bool responded = false;
             if (OC_STACK_OK == CHPHandleOCFRequest(entityHandlerRequest,
-                                                   proxyUri) )
+                                                   proxyUri, &responded) )
             {
-                return OC_EH_SLOW;
+                return responded ? OC_EH_OK : OC_EH_SLOW;
             }
         }
         else
@@ -285,20 +296,18 @@ OCEntityHandlerResult CHPEntityHandler(OCEntityHandlerFlag flag,
     return OC_EH_ERROR;
 }
 
-void CHPHandleHttpResponse(const HttpResponse_t *httpResponse, void *context)
+/*
+ * Sends an HTTP response to the CoAP client. maxAge is mapped to the Max-Age option
+ * for GET requests, as CoAP clients use a default of 60 seconds without it.
+ */
+static void CHPSendHttpResponse(const HttpResponse_t *httpResponse, OCMethod method,
+                                OCRequestHandle requestHandle, uint32_t maxAge)
 {
     OIC_LOG_V(DEBUG, TAG, "%s IN", __func__);
-    if (!httpResponse || !context)
-    {
-        OIC_LOG(ERROR, TAG, "Invalid arguements");
-        return;
-    }
-
-    CHPRequest_t *ctxt = (CHPRequest_t *)context;
-    OCEntityHandlerResponse response = { .requestHandle = ctxt->requestHandle };
+    OCEntityHandlerResponse response = { .requestHandle = requestHandle };
     response.persistentBufferFlag = 0;
 
-    OCStackResult result = CHPGetOCCode(httpResponse->status, ctxt->method,
+    OCStackResult result = CHPGetOCCode(httpResponse->status, method,
                                         &response.ehResult);
     if (OC_STACK_OK != result)
     {
@@ -308,13 +317,9 @@ void CHPHandleHttpResponse(const HttpResponse_t *httpResponse, void *context)
         {
             OIC_LOG(ERROR, TAG, "Error sending response");
         }
-        OICFree(ctxt);
         return;
     }
 
-    // ctxt not required now.
-    OICFree(ctxt);
-
     if (httpResponse->dataFormat[0] != '\0')
     {
         OCPayloadFormat format = CHPGetOCContentType(httpResponse->dataFormat);
@@ -392,6 +397,29 @@ void CHPHandleHttpResponse(const HttpResponse_t *httpResponse, void *context)
             continue;
         }
 
+        // Max-Age and ETag are not copied verbatim, they are added below.
+        if (COAP_OPTION_MAXAGE == optionsPointer->optionID ||
+            COAP_OPTION_ETAG == optionsPointer->optionID)
+        {
+            continue;
+        }
+
+        response.numSendVendorSpecificHeaderOptions++;
+        optionsPointer += 1;
+    }
+
+    const char *etag = CHPCacheGetHeader(httpResponse, HTTP_OPTION_ETAG);
+    if (etag && response.numSendVendorSpecificHeaderOptions < MAX_HEADER_OPTIONS &&
+        OC_STACK_OK == CHPGetOCETagOption(etag, optionsPointer))
+    {
+        response.numSendVendorSpecificHeaderOptions++;
+        optionsPointer += 1;
+    }
+
+    if (OC_REST_GET == method &&
+        response.numSendVendorSpecificHeaderOptions < MAX_HEADER_OPTIONS &&
+        OC_STACK_OK == CHPGetOCMaxAgeOption(maxAge, optionsPointer))
+    {
         response.numSendVendorSpecificHeaderOptions++;
         optionsPointer += 1;
     }
@@ -405,10 +433,80 @@ void CHPHandleHttpResponse(const HttpResponse_t *httpResponse, void *context)
     OIC_LOG_V(DEBUG, TAG, "%s OUT", __func__);
 }
 
+void CHPHandleHttpResponse(const HttpResponse_t *httpResponse, void *context)
+{
+    OIC_LOG_V(DEBUG, TAG, "%s IN", __func__);
+    if (!httpResponse || !context)
+    {
+        OIC_LOG(ERROR, TAG, "Invalid arguements");
+        return;
+    }
+
+    CHPRequest_t *ctxt = (CHPRequest_t *)context;
+    uint32_t maxAge = 0;
+    if (ctxt->cacheable)
+    {
+        if (ctxt->cached && CHP_NOT_MODIFIED == httpResponse->status)
+        {
+            // Stale entry is still valid, answer with the refreshed entry.
+            OIC_LOG(DEBUG, TAG, "Cached response revalidated");
+            CHPCacheRefresh(ctxt->uri, ctxt->accept, ctxt->cached, httpResponse, &maxAge);
+            httpResponse = ctxt->cached;
+        }
+        else
+        {
+            CHPCacheStore(ctxt->uri, ctxt->accept, httpResponse, &maxAge);
+        }
+    }
+    else if (OC_REST_GET != ctxt->method && httpResponse->status < CHP_BAD_REQ)
+    {
+        // Unsafe method succeeded, stored responses of the resource are outdated.
+        CHPCacheInvalidate(ctxt->uri);
+    }
+
+    CHPSendHttpResponse(httpResponse, ctxt->method, ctxt->requestHandle, maxAge);
+
+    CHPCacheFreeResponse(ctxt->cached);
+    OICFree(ctxt);
+    OIC_LOG_V(DEBUG, TAG, "%s OUT", __func__);
+}
+
+/*
+ * Returns the Accept header sent upstream, an accept option of the CoAP client
+ * overrides the default one. Returns NULL for conditional requests, they are
+ * forwarded as they are.
+ */
+static const char *CHPGetCacheAccept(const HttpRequest_t *httpRequest)
+{
+    const char *accept = httpRequest->acceptFormat;
+    size_t count = u_arraylist_length(httpRequest->headerOptions);
+    for (size_t i = 0; i < count; i++)
+    {
+        HttpHeaderOption_t *option = u_arraylist_get(httpRequest->headerOptions, i);
+        if (!option)
+        {
+            continue;
+        }
+
+        if (0 == strcmp(option->optionName, HTTP_OPTION_ACCEPT))
+        {
+            accept = option->optionData;
+        }
+        else if (0 == strcmp(option->optionName, HTTP_OPTION_IF_MATCH) ||
+                 0 == strcmp(option->optionName, HTTP_OPTION_IF_NONE_MATCH) ||
+                 0 == strcmp(option->optionName, HTTP_OPTION_ETAG))
+        {
+            return NULL;
+        }
+    }
+    return accept;
+}
+
 OCStackResult CHPHandleOCFRequest(const OCEntityHandlerRequest* requestInfo,
-                                   const char* proxyUri)
+                                   const char* proxyUri, bool *responded)
 {
     OIC_LOG_V(DEBUG, TAG, "%s IN", __func__);
+    *responded = false;
 
     HttpRequest_t httpRequest = { .httpMajor = 1,
                                   .httpMinor = 1};
@@ -488,6 +586,55 @@ OCStackResult CHPHandleOCFRequest(const OCEntityHandlerRequest* requestInfo,
 
     chpRequest->requestHandle = requestInfo->requestHandle;
     chpRequest->method = requestInfo->method;
+    OICStrcpy(chpRequest->uri, sizeof(chpRequest->uri), httpRequest.resourceUri);
+
+    const char *accept = CHPGetCacheAccept(&httpRequest);
+    if (OC_REST_GET == requestInfo->method && accept)
+    {
+        chpRequest->cacheable = true;
+        OICStrcpy(chpRequest->accept, sizeof(chpRequest->accept), accept);
+
+        uint32_t maxAge = 0;
+        HttpResponse_t *cached = NULL;
+        switch (CHPCacheLookup(chpRequest->uri, chpRequest->accept, &cached, &maxAge))
+        {
+            case CHP_CACHE_FRESH:
+                OIC_LOG_V(DEBUG, TAG, "Responding from cache, max-age %u", maxAge);
+                CHPSendHttpResponse(cached, requestInfo->method, requestInfo->requestHandle,
+                                    maxAge);
+                CHPCacheFreeResponse(cached);
+                OICFree(chpRequest);
+                u_arraylist_destroy(httpRequest.headerOptions);
+                *responded = true;
+                return OC_STACK_OK;
+            case CHP_CACHE_STALE:
+            {
+                // Revalidate with the stored ETag, a 304 lets us reuse the entry.
+                HttpHeaderOption_t *ifNoneMatch = OICCalloc(1, sizeof(HttpHeaderOption_t));
+                if (!httpRequest.headerOptions)
+                {
+                    httpRequest.headerOptions = u_arraylist_create();
+                }
+                if (!ifNoneMatch || !httpRequest.headerOptions ||
+                    !u_arraylist_add(httpRequest.headerOptions, ifNoneMatch))
+                {
+                    OIC_LOG(ERROR, TAG, "Not revalidating, memory failed");
+                    OICFree(ifNoneMatch);
+                    CHPCacheFreeResponse(cached);
+                    break;
+                }
+                OICStrcpy(ifNoneMatch->optionName, sizeof(ifNoneMatch->optionName),
+                          HTTP_OPTION_IF_NONE_MATCH);
+                OICStrcpy(ifNoneMatch->optionData, sizeof(ifNoneMatch->optionData),
+                          CHPCacheGetHeader(cached, HTTP_OPTION_ETAG));
+                ifNoneMatch->optionLength = strlen(ifNoneMatch->optionData);
+                chpRequest->cached = cached;
+                break;
+            }
+            default:
+                break;
+        }
+    }
 
     result = CHPPostHttpRequest(&httpRequest, CHPHandleHttpResponse,
                                 (void *)chpRequest);
@@ -509,6 +656,7 @@ OCStackResult CHPHandleOCFRequest(const OCEntityHandlerRequest* requestInfo,
         }
 
         OICFree(httpRequest.payload);
+        CHPCacheFreeResponse(chpRequest->cached);
         OICFree(chpRequest);
         u_arraylist_destroy(httpRequest.headerOptions);
         return OC_STACK_ERROR;
@@ -165,6 +165,69 @@ OCStackResult CHPGetOCOption(const HttpHeaderOption_t *httpOption, OCHeaderOptio
     return OC_STACK_OK;
 }
 
+OCStackResult CHPGetOCMaxAgeOption(uint32_t maxAge, OCHeaderOption *ocfOption)
+{
+    if (!ocfOption)
+    {
+        OIC_LOG(ERROR, TAG, "CoAP option is Null");
+        return OC_STACK_INVALID_PARAM;
+    }
+
+    ocfOption->protocolID = OC_COAP_ID;
+    ocfOption->optionID = COAP_OPTION_MAXAGE;
+
+    // uint option value in network byte order without leading zero bytes
+    uint8_t length = 0;
+    for (uint32_t value = maxAge; value; value >>= 8)
+    {
+        length++;
+    }
+
+    ocfOption->optionLength = length;
+    for (uint8_t i = 0; i < length; i++)
+    {
+        ocfOption->optionData[i] = (uint8_t)(maxAge >> (8 * (length - i - 1)));
+    }
+
+    return OC_STACK_OK;
+}
+
+OCStackResult CHPGetOCETagOption(const char *httpETag, OCHeaderOption *ocfOption)
+{
+    if (!httpETag || '\0' == httpETag[0] || !ocfOption)
+    {
+        OIC_LOG(ERROR, TAG, "Invalid ETag");
+        return OC_STACK_INVALID_PARAM;
+    }
+
+    ocfOption->protocolID = OC_COAP_ID;
+    ocfOption->optionID = COAP_OPTION_ETAG;
+
+    size_t length = strlen(httpETag);
+    if (length <= CHP_MAX_ETAG_LENGTH)
+    {
+        ocfOption->optionLength = (uint16_t)length;
+        memcpy(ocfOption->optionData, httpETag, length);
+        return OC_STACK_OK;
+    }
+
+    // 64 bit FNV-1a, the CoAP ETag only has to change when the entity tag does.
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (uint8_t)httpETag[i];
+        hash *= 1099511628211ULL;
+    }
+
+    ocfOption->optionLength = CHP_MAX_ETAG_LENGTH;
+    for (uint8_t i = 0; i < CHP_MAX_ETAG_LENGTH; i++)
+    {
+        ocfOption->optionData[i] = (uint8_t)(hash >> (8 * (CHP_MAX_ETAG_LENGTH - i - 1)));
+    }
+
+    return OC_STACK_OK;
+}
+
 OCPayloadFormat CHPGetOCContentType(const char *httpContentTypeStr)
 {
     OIC_LOG_V(DEBUG, TAG, "%s IN", __func__);
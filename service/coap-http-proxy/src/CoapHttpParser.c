@@ -48,6 +48,8 @@
 
 #define DEFAULT_USER_AGENT "IoTivity"
 #define MAX_PAYLOAD_SIZE (1048576U) // 1 MB
+/* Idle connections kept open by the multi handle for reuse by later requests */
+#define MAX_CACHED_CONNECTIONS (16L)
 
 typedef struct
 {
@@ -408,6 +410,10 @@ static OCStackResult CHPParserInitializeMultiHandle()
         return OC_STACK_ERROR;
     }
 
+    /* Connections are owned by the multi handle, so easy handles of later
+     * requests to the same server reuse them. */
+    curl_multi_setopt(g_multiHandle, CURLMOPT_MAXCONNECTS, MAX_CACHED_CONNECTIONS);
+
     CHPParserUnlockMutex();
     return OC_STACK_OK;
 }
@@ -748,8 +754,6 @@ static OCStackResult CHPInitializeEasyHandle(CURL** easyHandle, HttpRequest_t *r
     curl_easy_setopt(e, CURLOPT_LOW_SPEED_LIMIT, 1024L);
     curl_easy_setopt(e, CURLOPT_LOW_SPEED_TIME, 60L);
     curl_easy_setopt(e, CURLOPT_USERAGENT, DEFAULT_USER_AGENT);
-    /* Close connection once done with transaction */
-    curl_easy_setopt(e, CURLOPT_FORBID_REUSE, 1L);
     /* Allow redirect */
     curl_easy_setopt(e, CURLOPT_FOLLOWLOCATION, 1L);
     /* Only redirect to http servers */
@@ -817,6 +821,8 @@ static OCStackResult CHPInitializeEasyHandle(CURL** easyHandle, HttpRequest_t *r
     list = curl_slist_append(list, buffer);
     snprintf(buffer, sizeof(buffer), "Content-Type: %s", req->payloadFormat);
     curl_easy_setopt(e, CURLOPT_HTTPHEADER, list);
+    /* Freed with the context once the transfer is done */
+    handleContext->list = list;
 
     *easyHandle = e;
     OIC_LOG_V(DEBUG, TAG, "%s OUT", __func__);
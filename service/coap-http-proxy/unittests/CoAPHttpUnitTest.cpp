@@ -23,6 +23,7 @@
 #include <condition_variable>
 #include <mutex>
 #include <chrono>
+#include <string>
 #include <signal.h>
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
@@ -37,6 +38,7 @@
 #include "uarraylist.h"
 #include "CoapHttpParser.h"
 #include "CoapHttpMap.h"
+#include "CoapHttpCache.h"
 #include "ocpayload.h"
 
 static std::chrono::milliseconds g_waitForResponse(10000);
@@ -307,6 +309,269 @@ TEST_F(CoApHttpTest, CHPGetHttpOption)
     EXPECT_EQ(OC_STACK_INVALID_OPTION, (CHPGetHttpOption(&ocOp, &httpOp)));
 }
 
+TEST_F(CoApHttpTest, CHPGetOCMaxAgeOption)
+{
+    OCHeaderOption ocOp;
+    EXPECT_NE(OC_STACK_OK, (CHPGetOCMaxAgeOption(60, NULL)));
+
+    EXPECT_EQ(OC_STACK_OK, (CHPGetOCMaxAgeOption(0, &ocOp)));
+    EXPECT_EQ(COAP_OPTION_MAXAGE, ocOp.optionID);
+    EXPECT_EQ(0, ocOp.optionLength);
+
+    EXPECT_EQ(OC_STACK_OK, (CHPGetOCMaxAgeOption(60, &ocOp)));
+    ASSERT_EQ(1, ocOp.optionLength);
+    EXPECT_EQ(60, ocOp.optionData[0]);
+
+    EXPECT_EQ(OC_STACK_OK, (CHPGetOCMaxAgeOption(0x12345, &ocOp)));
+    ASSERT_EQ(3, ocOp.optionLength);
+    EXPECT_EQ(0x01, ocOp.optionData[0]);
+    EXPECT_EQ(0x23, ocOp.optionData[1]);
+    EXPECT_EQ(0x45, ocOp.optionData[2]);
+}
+
+TEST_F(CoApHttpTest, CHPGetOCETagOption)
+{
+    OCHeaderOption ocOp;
+    EXPECT_NE(OC_STACK_OK, (CHPGetOCETagOption(NULL, &ocOp)));
+    EXPECT_NE(OC_STACK_OK, (CHPGetOCETagOption("", &ocOp)));
+
+    EXPECT_EQ(OC_STACK_OK, (CHPGetOCETagOption("\"v1\"", &ocOp)));
+    EXPECT_EQ(COAP_OPTION_ETAG, ocOp.optionID);
+    ASSERT_EQ(4, ocOp.optionLength);
+    EXPECT_EQ(0, memcmp("\"v1\"", ocOp.optionData, 4));
+
+    // Longer entity tags are hashed to the maximum CoAP ETag length.
+    OCHeaderOption other;
+    EXPECT_EQ(OC_STACK_OK, (CHPGetOCETagOption("\"5d8c72a5edda8d6a:0\"", &ocOp)));
+    EXPECT_EQ(CHP_MAX_ETAG_LENGTH, ocOp.optionLength);
+    EXPECT_EQ(OC_STACK_OK, (CHPGetOCETagOption("\"5d8c72a5edda8d6a:1\"", &other)));
+    EXPECT_NE(0, memcmp(ocOp.optionData, other.optionData, CHP_MAX_ETAG_LENGTH));
+}
+
+class CoApHttpCacheTest: public testing::Test
+{
+protected:
+    void TearDown()
+    {
+        CHPCacheTerminate();
+    }
+
+    static HttpResponse_t *createResponse(HttpResponseResult_t status, const char *payload,
+                                          std::initializer_list<std::pair<const char *,
+                                                                          const char *>> headers)
+    {
+        HttpResponse_t *response = (HttpResponse_t *)OICCalloc(1, sizeof(HttpResponse_t));
+        response->status = status;
+        OICStrcpy(response->dataFormat, sizeof(response->dataFormat), JSON_CONTENT_TYPE);
+        response->payload = OICStrdup(payload);
+        response->payloadLength = strlen(payload);
+        response->headerOptions = u_arraylist_create();
+        for (const auto &header : headers)
+        {
+            HttpHeaderOption_t *option =
+                (HttpHeaderOption_t *)OICCalloc(1, sizeof(HttpHeaderOption_t));
+            OICStrcpy(option->optionName, sizeof(option->optionName), header.first);
+            OICStrcpy(option->optionData, sizeof(option->optionData), header.second);
+            u_arraylist_add(response->headerOptions, option);
+        }
+        return response;
+    }
+
+    static CHPCacheResult_t lookup(const char *uri, uint32_t *maxAge,
+                                   std::string *payload = NULL)
+    {
+        HttpResponse_t *cached = NULL;
+        CHPCacheResult_t result = CHPCacheLookup(uri, ACCEPT_MEDIA_TYPE, &cached, maxAge);
+        if (cached && payload)
+        {
+            payload->assign((const char *)cached->payload, cached->payloadLength);
+        }
+        CHPCacheFreeResponse(cached);
+        return result;
+    }
+
+    static OCStackResult store(HttpResponse_t *response, uint32_t *maxAge,
+                               const char *uri = "http://example.com/a")
+    {
+        OCStackResult result = CHPCacheStore(uri, ACCEPT_MEDIA_TYPE, response, maxAge);
+        CHPCacheFreeResponse(response);
+        return result;
+    }
+};
+
+TEST_F(CoApHttpCacheTest, FreshResponseIsServedFromCache)
+{
+    const char *uri = "http://example.com/a";
+    uint32_t maxAge = 0;
+    EXPECT_EQ(CHP_CACHE_MISS, lookup(uri, &maxAge));
+
+    EXPECT_EQ(OC_STACK_OK, store(createResponse(CHP_SUCCESS, "{\"value\":1}",
+                                                {{"Cache-Control", "public, max-age=60"}}),
+                                 &maxAge));
+    EXPECT_EQ(60u, maxAge);
+
+    std::string payload;
+    EXPECT_EQ(CHP_CACHE_FRESH, lookup(uri, &maxAge, &payload));
+    EXPECT_LE(59u, maxAge);
+    EXPECT_GE(60u, maxAge);
+    EXPECT_EQ("{\"value\":1}", payload);
+
+    // Entries are keyed by uri and Accept.
+    HttpResponse_t *cached = NULL;
+    EXPECT_EQ(CHP_CACHE_MISS, CHPCacheLookup(uri, JSON_CONTENT_TYPE, &cached, &maxAge));
+    EXPECT_EQ(NULL, cached);
+    EXPECT_EQ(CHP_CACHE_MISS, lookup("http://example.com/b", &maxAge));
+}
+
+TEST_F(CoApHttpCacheTest, FreshnessFromHeaders)
+{
+    uint32_t maxAge = 0;
+    EXPECT_EQ(OC_STACK_OK, store(createResponse(CHP_SUCCESS, "{}",
+                                                {{"Date", "Thu, 01 Jan 2015 00:00:00 GMT"},
+                                                 {"Expires", "Thu, 01 Jan 2015 00:02:00 GMT"}}),
+                                 &maxAge));
+    EXPECT_EQ(120u, maxAge);
+
+    EXPECT_EQ(OC_STACK_OK, store(createResponse(CHP_SUCCESS, "{}",
+                                                {{"cache-control", "max-age=60"},
+                                                 {"Age", "20"}}),
+                                 &maxAge));
+    EXPECT_EQ(40u, maxAge);
+
+    // s-maxage applies to shared caches and takes precedence over max-age and Expires.
+    EXPECT_EQ(OC_STACK_OK, store(createResponse(CHP_SUCCESS, "{}",
+                                                {{"Cache-Control", "max-age=60, s-maxage=\"10\""},
+                                                 {"Expires", "Thu, 01 Jan 2015 00:02:00 GMT"}}),
+                                 &maxAge));
+    EXPECT_EQ(10u, maxAge);
+
+    // An invalid Expires means already expired.
+    EXPECT_NE(OC_STACK_OK, store(createResponse(CHP_SUCCESS, "{}", {{"Expires", "0"}}),
+                                 &maxAge));
+    EXPECT_EQ(0u, maxAge);
+}
+
+TEST_F(CoApHttpCacheTest, UncacheableResponsesAreNotStored)
+{
+    const char *uri = "http://example.com/a";
+    uint32_t maxAge = 0;
+    EXPECT_NE(OC_STACK_OK, store(createResponse(CHP_SUCCESS, "{}",
+                                                {{"Cache-Control", "no-store, max-age=60"}}),
+                                 &maxAge));
+    EXPECT_EQ(0u, maxAge);
+    EXPECT_EQ(CHP_CACHE_MISS, lookup(uri, &maxAge));
+
+    // Private responses may still be cached by the CoAP client.
+    EXPECT_NE(OC_STACK_OK, store(createResponse(CHP_SUCCESS, "{}",
+                                                {{"Cache-Control", "private, max-age=60"}}),
+                                 &maxAge));
+    EXPECT_EQ(60u, maxAge);
+    EXPECT_EQ(CHP_CACHE_MISS, lookup(uri, &maxAge));
+
+    EXPECT_NE(OC_STACK_OK, store(createResponse(CHP_SUCCESS, "{}",
+                                                {{"Cache-Control", "max-age=60"}, {"Vary", "*"}}),
+                                 &maxAge));
+    EXPECT_EQ(CHP_CACHE_MISS, lookup(uri, &maxAge));
+
+    EXPECT_NE(OC_STACK_OK, store(createResponse(CHP_NOT_FOUND, "{}",
+                                                {{"Cache-Control", "max-age=60"}}),
+                                 &maxAge));
+    EXPECT_EQ(CHP_CACHE_MISS, lookup(uri, &maxAge));
+
+    // Without freshness information or validator there is nothing to reuse.
+    EXPECT_NE(OC_STACK_OK, store(createResponse(CHP_SUCCESS, "{}", {}), &maxAge));
+    EXPECT_EQ(CHP_CACHE_MISS, lookup(uri, &maxAge));
+
+    // A newer uncacheable response replaces a stored one.
+    EXPECT_EQ(OC_STACK_OK, store(createResponse(CHP_SUCCESS, "{}",
+                                                {{"Cache-Control", "max-age=60"}}),
+                                 &maxAge));
+    EXPECT_EQ(CHP_CACHE_FRESH, lookup(uri, &maxAge));
+    EXPECT_NE(OC_STACK_OK, store(createResponse(CHP_SUCCESS, "{}",
+                                                {{"Cache-Control", "no-store"}}),
+                                 &maxAge));
+    EXPECT_EQ(CHP_CACHE_MISS, lookup(uri, &maxAge));
+}
+
+TEST_F(CoApHttpCacheTest, StaleResponseIsRevalidated)
+{
+    const char *uri = "http://example.com/a";
+    uint32_t maxAge = 0;
+    EXPECT_EQ(OC_STACK_OK, store(createResponse(CHP_SUCCESS, "{\"value\":1}",
+                                                {{"Cache-Control", "no-cache"},
+                                                 {"ETag", "\"v1\""}}),
+                                 &maxAge));
+    EXPECT_EQ(0u, maxAge);
+
+    HttpResponse_t *stale = NULL;
+    EXPECT_EQ(CHP_CACHE_STALE, CHPCacheLookup(uri, ACCEPT_MEDIA_TYPE, &stale, &maxAge));
+    ASSERT_TRUE(stale != NULL);
+    EXPECT_STREQ("\"v1\"", CHPCacheGetHeader(stale, HTTP_OPTION_ETAG));
+
+    HttpResponse_t *notModified = createResponse(CHP_NOT_MODIFIED, "",
+                                                 {{"Cache-Control", "max-age=30"},
+                                                  {"ETag", "\"v1\""}});
+    EXPECT_EQ(OC_STACK_OK, CHPCacheRefresh(uri, ACCEPT_MEDIA_TYPE, stale, notModified,
+                                           &maxAge));
+    EXPECT_EQ(30u, maxAge);
+    EXPECT_STREQ("max-age=30", CHPCacheGetHeader(stale, HTTP_OPTION_CACHE_CONTROL));
+    CHPCacheFreeResponse(notModified);
+    CHPCacheFreeResponse(stale);
+
+    std::string payload;
+    EXPECT_EQ(CHP_CACHE_FRESH, lookup(uri, &maxAge, &payload));
+    EXPECT_EQ("{\"value\":1}", payload);
+}
+
+TEST_F(CoApHttpCacheTest, InvalidateRemovesAllVariants)
+{
+    const char *uri = "http://example.com/a";
+    uint32_t maxAge = 0;
+    HttpResponse_t *response = createResponse(CHP_SUCCESS, "{}", {{"Cache-Control", "max-age=60"}});
+    EXPECT_EQ(OC_STACK_OK, CHPCacheStore(uri, JSON_CONTENT_TYPE, response, &maxAge));
+    EXPECT_EQ(OC_STACK_OK, CHPCacheStore(uri, ACCEPT_MEDIA_TYPE, response, &maxAge));
+    EXPECT_EQ(OC_STACK_OK, CHPCacheStore("http://example.com/b", ACCEPT_MEDIA_TYPE, response,
+                                         &maxAge));
+    CHPCacheFreeResponse(response);
+
+    CHPCacheInvalidate(uri);
+
+    HttpResponse_t *cached = NULL;
+    EXPECT_EQ(CHP_CACHE_MISS, CHPCacheLookup(uri, JSON_CONTENT_TYPE, &cached, &maxAge));
+    EXPECT_EQ(CHP_CACHE_MISS, lookup(uri, &maxAge));
+    EXPECT_EQ(CHP_CACHE_FRESH, lookup("http://example.com/b", &maxAge));
+}
+
+TEST_F(CoApHttpCacheTest, LeastRecentlyUsedEntryIsEvicted)
+{
+    uint32_t maxAge = 0;
+    char uri[64];
+    for (int i = 0; i < CHP_CACHE_MAX_ENTRIES; i++)
+    {
+        snprintf(uri, sizeof(uri), "http://example.com/%d", i);
+        EXPECT_EQ(OC_STACK_OK, store(createResponse(CHP_SUCCESS, "{}",
+                                                    {{"Cache-Control", "max-age=60"}}),
+                                     &maxAge, uri));
+    }
+
+    // Using the oldest entry makes the second one the least recently used.
+    EXPECT_EQ(CHP_CACHE_FRESH, lookup("http://example.com/0", &maxAge));
+    EXPECT_EQ(OC_STACK_OK, store(createResponse(CHP_SUCCESS, "{}",
+                                                {{"Cache-Control", "max-age=60"}}),
+                                 &maxAge, "http://example.com/new"));
+
+    EXPECT_EQ(CHP_CACHE_FRESH, lookup("http://example.com/0", &maxAge));
+    EXPECT_EQ(CHP_CACHE_MISS, lookup("http://example.com/1", &maxAge));
+    EXPECT_EQ(CHP_CACHE_FRESH, lookup("http://example.com/new", &maxAge));
+
+    // Responses larger than an entry are not cached at all.
+    std::string large(CHP_CACHE_MAX_ENTRY_SIZE, 'x');
+    EXPECT_NE(OC_STACK_OK, store(createResponse(CHP_SUCCESS, large.c_str(),
+                                                {{"Cache-Control", "max-age=60"}}),
+                                 &maxAge, "http://example.com/large"));
+    EXPECT_EQ(CHP_CACHE_MISS, lookup("http://example.com/large", &maxAge));
+}
+
 OCRepPayload* payload;
 cJSON* cj;
 TEST_F(CoApHttpTest, CHPRepPayloadToJson)
@@ -0,0 +1,237 @@
+//******************************************************************
+//
+// Copyright 2016 Samsung Electronics All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include "NSCacheIndex.h"
+#include "oic_malloc.h"
+
+// Must be a power of two and a multiple of NS_CACHE_INDEX_LOCK_STRIPES, so the
+// stripe of a hash does not change when the bucket array grows.
+#define NS_CACHE_INDEX_MIN_BUCKETS (64)
+
+#define NS_CACHE_INDEX_STRIPE(index, hash) \
+    (&(index)->locks[(hash) % NS_CACHE_INDEX_LOCK_STRIPES])
+
+NSCacheIndex * NSCacheIndexCreate(NSCacheType keyType)
+{
+    NSCacheIndex * index = (NSCacheIndex *) OICCalloc(1, sizeof(NSCacheIndex));
+    NS_VERIFY_NOT_NULL(index, NULL);
+
+    index->keyType = keyType;
+
+    for (size_t i = 0; i < NS_CACHE_INDEX_LOCK_STRIPES; ++i)
+    {
+        pthread_mutex_init(&index->locks[i], NULL);
+    }
+
+    return index;
+}
+
+void NSCacheIndexDestroy(NSCacheIndex * index)
+{
+    if (!index)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < index->bucketCount; ++i)
+    {
+        NSCacheIndexEntry * iter = index->buckets[i];
+
+        while (iter)
+        {
+            NSCacheIndexEntry * next = iter->next;
+            NSOICFree(iter);
+            iter = next;
+        }
+    }
+
+    for (size_t i = 0; i < NS_CACHE_INDEX_LOCK_STRIPES; ++i)
+    {
+        pthread_mutex_destroy(&index->locks[i]);
+    }
+
+    NSOICFree(index->buckets);
+    NSOICFree(index);
+}
+
+static bool NSCacheIndexResize(NSCacheIndex * index, size_t bucketCount)
+{
+    NSCacheIndexEntry ** buckets =
+            (NSCacheIndexEntry **) OICCalloc(bucketCount, sizeof(NSCacheIndexEntry *));
+
+    if (!buckets)
+    {
+        NS_LOG(ERROR, "Failed to grow cache index");
+        return false;
+    }
+
+    for (size_t i = 0; i < NS_CACHE_INDEX_LOCK_STRIPES; ++i)
+    {
+        pthread_mutex_lock(&index->locks[i]);
+    }
+
+    for (size_t i = 0; i < index->bucketCount; ++i)
+    {
+        NSCacheIndexEntry * iter = index->buckets[i];
+
+        while (iter)
+        {
+            NSCacheIndexEntry * next = iter->next;
+            size_t bucket = iter->hash % bucketCount;
+            iter->next = buckets[bucket];
+            buckets[bucket] = iter;
+            iter = next;
+        }
+    }
+
+    NSOICFree(index->buckets);
+    index->buckets = buckets;
+    index->bucketCount = bucketCount;
+
+    for (size_t i = NS_CACHE_INDEX_LOCK_STRIPES; i > 0; --i)
+    {
+        pthread_mutex_unlock(&index->locks[i - 1]);
+    }
+
+    return true;
+}
+
+NSResult NSCacheIndexAdd(NSCacheIndex * index, size_t hash, void * item)
+{
+    NS_VERIFY_NOT_NULL(index, NS_ERROR);
+    NS_VERIFY_NOT_NULL(item, NS_ERROR);
+
+    if (index->count >= index->bucketCount)
+    {
+        size_t bucketCount = index->bucketCount ?
+                index->bucketCount * 2 : NS_CACHE_INDEX_MIN_BUCKETS;
+
+        // a full index still works, only with longer chains.
+        if (!NSCacheIndexResize(index, bucketCount) && !index->buckets)
+        {
+            return NS_ERROR;
+        }
+    }
+
+    NSCacheIndexEntry * entry = (NSCacheIndexEntry *) OICMalloc(sizeof(NSCacheIndexEntry));
+    NS_VERIFY_NOT_NULL(entry, NS_ERROR);
+
+    entry->hash = hash;
+    entry->item = item;
+
+    pthread_mutex_t * mutex = NS_CACHE_INDEX_STRIPE(index, hash);
+    pthread_mutex_lock(mutex);
+
+    size_t bucket = hash % index->bucketCount;
+    entry->next = index->buckets[bucket];
+    index->buckets[bucket] = entry;
+    index->count++;
+
+    pthread_mutex_unlock(mutex);
+
+    return NS_OK;
+}
+
+void NSCacheIndexRemove(NSCacheIndex * index, size_t hash, const void * item)
+{
+    if (!index || !index->buckets)
+    {
+        return;
+    }
+
+    pthread_mutex_t * mutex = NS_CACHE_INDEX_STRIPE(index, hash);
+    pthread_mutex_lock(mutex);
+
+    NSCacheIndexEntry ** link = &index->buckets[hash % index->bucketCount];
+
+    while (*link)
+    {
+        if ((*link)->item == item)
+        {
+            NSCacheIndexEntry * del = *link;
+            *link = del->next;
+            NSOICFree(del);
+            index->count--;
+            break;
+        }
+
+        link = &(*link)->next;
+    }
+
+    pthread_mutex_unlock(mutex);
+}
+
+void * NSCacheIndexFind(NSCacheIndex * index, size_t hash,
+        NSCacheIndexMatch match, const void * key)
+{
+    NS_VERIFY_NOT_NULL(index, NULL);
+    NS_VERIFY_NOT_NULL(match, NULL);
+
+    void * item = NULL;
+
+    pthread_mutex_t * mutex = NS_CACHE_INDEX_STRIPE(index, hash);
+    pthread_mutex_lock(mutex);
+
+    if (index->buckets)
+    {
+        NSCacheIndexEntry * iter = index->buckets[hash % index->bucketCount];
+
+        while (iter)
+        {
+            if (iter->hash == hash && match(iter->item, key))
+            {
+                item = iter->item;
+                break;
+            }
+
+            iter = iter->next;
+        }
+    }
+
+    pthread_mutex_unlock(mutex);
+
+    return item;
+}
+
+size_t NSCacheIndexHashString(size_t hash, const char * str)
+{
+    if (!str)
+    {
+        return hash;
+    }
+
+    for (; *str; ++str)
+    {
+        hash = (hash * 33) ^ (unsigned char) *str;
+    }
+
+    // separates the strings of a composite key.
+    return hash * 33;
+}
+
+size_t NSCacheIndexHashInt(size_t hash, uint64_t value)
+{
+    for (size_t i = 0; i < sizeof(value); ++i)
+    {
+        hash = (hash * 33) ^ (unsigned char) (value >> (i * 8));
+    }
+
+    return hash;
+}
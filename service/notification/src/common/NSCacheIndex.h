@@ -0,0 +1,82 @@
+//******************************************************************
+//
+// Copyright 2016 Samsung Electronics All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef _NS_CACHE_INDEX_H_
+#define _NS_CACHE_INDEX_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "NSCommon.h"
+#include "NSConstants.h"
+
+/*
+ * Hash index over the items of a cache list.
+ *
+ * The index only stores pointers, the list keeps owning the items. Buckets are
+ * guarded by NS_CACHE_INDEX_LOCK_STRIPES mutexes, the stripe of an item is
+ * picked from its hash, so lookups of different keys do not contend.
+ * NSCacheIndexAdd() and NSCacheIndexRemove() must be serialized by the lock of
+ * the owning list; NSCacheIndexFind() may run concurrently with them.
+ */
+#define NS_CACHE_INDEX_LOCK_STRIPES (16)
+#define NS_CACHE_INDEX_HASH_SEED (5381)
+
+typedef struct _NSCacheIndexEntry
+{
+    size_t hash;
+    void * item;
+    struct _NSCacheIndexEntry * next;
+
+} NSCacheIndexEntry;
+
+typedef struct _NSCacheIndex
+{
+    NSCacheType keyType;
+    NSCacheIndexEntry ** buckets;
+    size_t bucketCount;
+    size_t count;
+    pthread_mutex_t locks[NS_CACHE_INDEX_LOCK_STRIPES];
+
+} NSCacheIndex;
+
+typedef bool (* NSCacheIndexMatch)(void * item, const void * key);
+
+NSCacheIndex * NSCacheIndexCreate(NSCacheType keyType);
+void NSCacheIndexDestroy(NSCacheIndex * index);
+
+NSResult NSCacheIndexAdd(NSCacheIndex * index, size_t hash, void * item);
+void NSCacheIndexRemove(NSCacheIndex * index, size_t hash, const void * item);
+void * NSCacheIndexFind(NSCacheIndex * index, size_t hash,
+        NSCacheIndexMatch match, const void * key);
+
+size_t NSCacheIndexHashString(size_t hash, const char * str);
+size_t NSCacheIndexHashInt(size_t hash, uint64_t value);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _NS_CACHE_INDEX_H_
@@ -22,6 +22,7 @@
 #include "NSConsumerCommon.h"
 #include "NSConsumerInternalTaskController.h"
 #include "NSStructs.h"
+#include "NSCacheIndex.h"
 
 #include "oic_malloc.h"
 #include "oic_string.h"
@@ -41,6 +42,7 @@ typedef struct
 {
     NSMessageStateLL * head;
     NSMessageStateLL * tail;
+    NSCacheIndex * index; // by message ID
 
 } NSMessageStateList;
 
@@ -91,10 +93,9 @@ NSProvider_internal * NSProviderCacheFind(const char * providerId)
     if (!ProviderCache)
     {
         NS_LOG(DEBUG, "Provider Cache Init");
-        ProviderCache = NSConsumerStorageCreate();
+        ProviderCache = NSConsumerStorageCreate(NS_CONSUMER_CACHE_PROVIDER);
         NS_VERIFY_NOT_NULL(ProviderCache, NULL);
 
-        ProviderCache->cacheType = NS_CONSUMER_CACHE_PROVIDER;
         NSSetProviderCacheList(ProviderCache);
     }
 
@@ -129,10 +130,9 @@ NSResult NSProviderCacheUpdate(NSProvider_internal * provider)
     if (!ProviderCache)
     {
         NS_LOG(DEBUG, "Provider Cache Init");
-        ProviderCache = NSConsumerStorageCreate();
+        ProviderCache = NSConsumerStorageCreate(NS_CONSUMER_CACHE_PROVIDER);
         NS_VERIFY_NOT_NULL(ProviderCache, NS_ERROR);
 
-        ProviderCache->cacheType = NS_CONSUMER_CACHE_PROVIDER;
         NSSetProviderCacheList(ProviderCache);
     }
 
@@ -160,10 +160,9 @@ void NSCancelAllSubscription()
     if (!ProviderCache)
     {
         NS_LOG(DEBUG, "Provider Cache Init");
-        ProviderCache = NSConsumerStorageCreate();
+        ProviderCache = NSConsumerStorageCreate(NS_CONSUMER_CACHE_PROVIDER);
         NS_VERIFY_NOT_NULL_V(ProviderCache);
 
-        ProviderCache->cacheType = NS_CONSUMER_CACHE_PROVIDER;
         NSSetProviderCacheList(ProviderCache);
     }
 
@@ -553,11 +552,15 @@ NSMessageStateList ** NSGetMessageStateListAddr()
     static NSMessageStateList * g_messageStateList = NULL;
     if (g_messageStateList == NULL)
     {
-        g_messageStateList = (NSMessageStateList *)OICMalloc(sizeof(NSMessageStateList));
-        NS_VERIFY_NOT_NULL(g_messageStateList, NULL);
+        NSMessageStateList * newList = (NSMessageStateList *)OICMalloc(sizeof(NSMessageStateList));
+        NS_VERIFY_NOT_NULL(newList, NULL);
 
-        g_messageStateList->head = NULL;
-        g_messageStateList->tail = NULL;
+        newList->head = NULL;
+        newList->tail = NULL;
+        newList->index = NSCacheIndexCreate(NS_CONSUMER_CACHE_MESSAGE);
+
+        // published only once the index is set, lookups do not recheck it.
+        g_messageStateList = newList;
     }
 
     return & g_messageStateList;
@@ -568,35 +571,54 @@ NSMessageStateList * NSGetMessageStateList()
     return * NSGetMessageStateListAddr();
 }
 
-NSMessageStateLL * NSFindMessageState(uint64_t msgId)
+static size_t NSHashMessageState(uint64_t msgId)
 {
-    NS_LOG_V(DEBUG, "%s", __func__);
-    if (msgId <= NS_RESERVED_MESSAGEID)
-    {
-        return NULL;
-    }
-    NSMessageStateLL * iter = NULL;
+    return NSCacheIndexHashInt(NS_CACHE_INDEX_HASH_SEED, msgId);
+}
 
-    NSLockMessageListMutex();
-    if (NSGetMessageStateList()->head == NULL)
+static bool NSMatchMessageState(void * item, const void * key)
+{
+    return ((NSMessageStateLL *) item)->messageId == *(const uint64_t *) key;
+}
+
+// must be called with the message list mutex held.
+static NSMessageStateLL * NSFindMessageStateLocked(uint64_t msgId)
+{
+    NSMessageStateList * list = NSGetMessageStateList();
+
+    if (list->index)
     {
-        NSUnlockMessageListMutex();
-        return NULL;
+        return (NSMessageStateLL *) NSCacheIndexFind(list->index, NSHashMessageState(msgId),
+                NSMatchMessageState, &msgId);
     }
 
-    for (iter = NSGetMessageStateList()->head; iter; iter = iter->next)
+    NSMessageStateLL * iter = NULL;
+    for (iter = list->head; iter; iter = iter->next)
     {
         if (iter->messageId == msgId)
         {
-            NSUnlockMessageListMutex();
             return iter;
         }
     }
 
-    NSUnlockMessageListMutex();
     return NULL;
 }
 
+NSMessageStateLL * NSFindMessageState(uint64_t msgId)
+{
+    NS_LOG_V(DEBUG, "%s", __func__);
+    if (msgId <= NS_RESERVED_MESSAGEID)
+    {
+        return NULL;
+    }
+
+    NSLockMessageListMutex();
+    NSMessageStateLL * iter = NSFindMessageStateLocked(msgId);
+    NSUnlockMessageListMutex();
+
+    return iter;
+}
+
 bool NSUpdateMessageState(uint64_t msgId, NSSyncType state)
 {
     NS_LOG_V(DEBUG, "%s", __func__);
@@ -604,17 +626,14 @@ bool NSUpdateMessageState(uint64_t msgId, NSSyncType state)
     {
         return false;
     }
-    NSMessageStateLL * iter = NULL;
 
     NSLockMessageListMutex();
-    for (iter = NSGetMessageStateList()->head; iter; iter = iter->next)
+    NSMessageStateLL * iter = NSFindMessageStateLocked(msgId);
+    if (iter && state != iter->state)
     {
-        if (iter->messageId == msgId && state != iter->state)
-        {
-            iter->state = state;
-            NSUnlockMessageListMutex();
-            return true;
-        }
+        iter->state = state;
+        NSUnlockMessageListMutex();
+        return true;
     }
 
     NSUnlockMessageListMutex();
@@ -633,24 +652,28 @@ bool NSDeleteMessageState(uint64_t msgId)
     NSMessageStateLL * prev = NULL;
 
     NSLockMessageListMutex();
-    for (iter = NSGetMessageStateList()->head; iter; iter = iter->next)
+    NSMessageStateList * list = NSGetMessageStateList();
+    NSMessageStateLL * del = NSFindMessageStateLocked(msgId);
+
+    for (iter = list->head; del && iter; iter = iter->next)
     {
-        if (iter->messageId == msgId)
+        if (iter == del)
         {
-            if (iter == NSGetMessageStateList()->head)
+            if (prev)
             {
-                NSGetMessageStateList()->head = NULL;
-                NSGetMessageStateList()->tail = NULL;
+                prev->next = iter->next;
             }
-            else if (iter == NSGetMessageStateList()->tail)
+            else
             {
-                prev->next = NULL;
-                NSGetMessageStateList()->tail = prev;
+                list->head = iter->next;
             }
-            else
+
+            if (iter == list->tail)
             {
-                prev->next = iter->next;
+                list->tail = prev;
             }
+
+            NSCacheIndexRemove(list->index, NSHashMessageState(msgId), iter);
             NSUnlockMessageListMutex();
 
             NSOICFree(iter);
@@ -679,6 +702,14 @@ bool NSInsertMessageState(uint64_t msgId, NSSyncType state)
     insertMsg->next = NULL;
 
     NSLockMessageListMutex();
+    if (NSGetMessageStateList()->index && NSCacheIndexAdd(NSGetMessageStateList()->index,
+            NSHashMessageState(msgId), insertMsg) != NS_OK)
+    {
+        NSUnlockMessageListMutex();
+        NSOICFree(insertMsg);
+        return false;
+    }
+
     if (NSGetMessageStateList()->head == NULL)
     {
         NSGetMessageStateList()->head = insertMsg;
@@ -708,6 +739,8 @@ void NSDestroyMessageStateList()
 
     NSGetMessageStateList()->head = NULL;
     NSGetMessageStateList()->tail = NULL;
+    NSCacheIndexDestroy(NSGetMessageStateList()->index);
+    NSGetMessageStateList()->index = NULL;
 
     NSUnlockMessageListMutex();
 
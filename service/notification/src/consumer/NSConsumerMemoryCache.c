@@ -21,6 +21,105 @@
 #include "NSConsumerMemoryCache.h"
 #include "oic_malloc.h"
 #include "oic_string.h"
+#include "NSCacheIndex.h"
+
+/*
+ * The provider cache is indexed by provider ID and by the address:port of each
+ * connection of a provider, so both lookups only take an index lock stripe.
+ */
+typedef struct
+{
+    const char * addr;
+    uint16_t port;
+
+} NSConsumerAddrKey;
+
+static size_t NSConsumerHashAddr(const char * addr, uint16_t port)
+{
+    return NSCacheIndexHashInt(NSCacheIndexHashString(NS_CACHE_INDEX_HASH_SEED, addr), port);
+}
+
+static bool NSConsumerMatchProviderId(void * item, const void * key)
+{
+    NSCacheElement * element = (NSCacheElement *) item;
+    return NSConsumerCompareIdCacheData(NS_CONSUMER_CACHE_PROVIDER, element->data,
+            (const char *) key);
+}
+
+static bool NSConsumerMatchProviderAddr(void * item, const void * key)
+{
+    NSCacheElement * element = (NSCacheElement *) item;
+    const NSConsumerAddrKey * addrKey = (const NSConsumerAddrKey *) key;
+
+    NSProviderConnectionInfo * connection = ((NSProvider_internal *) element->data)->connection;
+    while (connection)
+    {
+        if (!strcmp(connection->addr->addr, addrKey->addr) && connection->addr->port == addrKey->port)
+        {
+            return true;
+        }
+        connection = connection->next;
+    }
+
+    return false;
+}
+
+static NSResult NSConsumerIndexAddConnections(NSCacheList * list, NSCacheElement * element,
+        NSProviderConnectionInfo * connection)
+{
+    while (connection)
+    {
+        size_t hash = NSConsumerHashAddr(connection->addr->addr, connection->addr->port);
+        if (NSCacheIndexAdd(list->addrIndex, hash, element) != NS_OK)
+        {
+            return NS_ERROR;
+        }
+        connection = connection->next;
+    }
+
+    return NS_OK;
+}
+
+static void NSConsumerIndexRemove(NSCacheList * list, NSCacheElement * element)
+{
+    NSProvider_internal * prov = (NSProvider_internal *) element->data;
+
+    NSCacheIndexRemove(list->index,
+            NSCacheIndexHashString(NS_CACHE_INDEX_HASH_SEED, prov->providerId), element);
+
+    NSProviderConnectionInfo * connection = prov->connection;
+    while (connection)
+    {
+        NSCacheIndexRemove(list->addrIndex,
+                NSConsumerHashAddr(connection->addr->addr, connection->addr->port), element);
+        connection = connection->next;
+    }
+}
+
+static NSResult NSConsumerIndexAdd(NSCacheList * list, NSCacheElement * element)
+{
+    if (!list->index || !list->addrIndex)
+    {
+        return NS_OK;
+    }
+
+    NSProvider_internal * prov = (NSProvider_internal *) element->data;
+
+    NSResult ret = NSCacheIndexAdd(list->index,
+            NSCacheIndexHashString(NS_CACHE_INDEX_HASH_SEED, prov->providerId), element);
+
+    if (ret == NS_OK)
+    {
+        ret = NSConsumerIndexAddConnections(list, element, prov->connection);
+    }
+
+    if (ret != NS_OK)
+    {
+        NSConsumerIndexRemove(list, element);
+    }
+
+    return ret;
+}
 
 pthread_mutex_t * NSGetCacheMutex()
 {
@@ -35,7 +134,7 @@ pthread_mutex_t * NSGetCacheMutex()
     return g_NSCacheMutex;
 }
 
-NSCacheList * NSConsumerStorageCreate()
+NSCacheList * NSConsumerStorageCreate(NSCacheType type)
 {
     pthread_mutex_t * mutex = NSGetCacheMutex();
     pthread_mutex_lock(mutex);
@@ -43,8 +142,28 @@ NSCacheList * NSConsumerStorageCreate()
     NSCacheList * newList = (NSCacheList *) OICMalloc(sizeof(NSCacheList));
     NS_VERIFY_NOT_NULL_WITH_POST_CLEANING(newList, NULL, pthread_mutex_unlock(mutex));
 
+    newList->cacheType = type;
     newList->head = NULL;
     newList->tail = NULL;
+    newList->index = NULL;
+    newList->addrIndex = NULL;
+
+    // the indexes are read without the cache mutex, so they are only assigned
+    // here, before the list is handed out.
+    if (type == NS_CONSUMER_CACHE_PROVIDER)
+    {
+        newList->index = NSCacheIndexCreate(NS_CONSUMER_CACHE_PROVIDER);
+        newList->addrIndex = NSCacheIndexCreate(NS_CONSUMER_CACHE_PROVIDER);
+
+        if (!newList->index || !newList->addrIndex)
+        {
+            NSCacheIndexDestroy(newList->index);
+            NSCacheIndexDestroy(newList->addrIndex);
+            NSOICFree(newList);
+            pthread_mutex_unlock(mutex);
+            return NULL;
+        }
+    }
 
     pthread_mutex_unlock(mutex);
 
@@ -56,11 +175,20 @@ NSCacheElement * NSConsumerStorageRead(NSCacheList * list, const char * findId)
     NS_VERIFY_NOT_NULL(list, NULL);
     NS_VERIFY_NOT_NULL(findId, NULL);
 
+    NSCacheType type = list->cacheType;
+
+    // indexed lookups only take the lock stripe of the key.
+    if (type == NS_CONSUMER_CACHE_PROVIDER && list->index)
+    {
+        return (NSCacheElement *) NSCacheIndexFind(list->index,
+                NSCacheIndexHashString(NS_CACHE_INDEX_HASH_SEED, findId),
+                NSConsumerMatchProviderId, findId);
+    }
+
     pthread_mutex_t * mutex = NSGetCacheMutex();
     pthread_mutex_lock(mutex);
 
     NSCacheElement * iter = list->head;
-    NSCacheType type = list->cacheType;
 
     while (iter)
     {
@@ -85,6 +213,13 @@ NSCacheElement * NSGetProviderFromAddr(NSCacheList * list, const char * addr, ui
     NS_VERIFY_NOT_NULL(
             (list->cacheType != NS_CONSUMER_CACHE_PROVIDER) ? NULL : (void *) 1, NULL);
 
+    if (list->addrIndex)
+    {
+        NSConsumerAddrKey key = { addr, port };
+        return (NSCacheElement *) NSCacheIndexFind(list->addrIndex,
+                NSConsumerHashAddr(addr, port), NSConsumerMatchProviderAddr, &key);
+    }
+
     pthread_mutex_t * mutex = NSGetCacheMutex();
     pthread_mutex_lock(mutex);
 
@@ -143,58 +278,51 @@ NSResult NSConsumerStorageDelete(NSCacheList * list, const char * delId)
     pthread_mutex_t * mutex = NSGetCacheMutex();
     pthread_mutex_lock(mutex);
 
-    NSCacheElement * prev = list->head;
     NSCacheElement * del = list->head;
     NS_VERIFY_NOT_NULL_WITH_POST_CLEANING(del, NS_ERROR, pthread_mutex_unlock(mutex));
 
-    if (NSConsumerCompareIdCacheData(type, del->data, delId))
+    if (type == NS_CONSUMER_CACHE_PROVIDER && list->index)
+    {
+        del = NSConsumerStorageRead(list, delId);
+    }
+    else
     {
-        if (del == list->head)
+        while (del && !NSConsumerCompareIdCacheData(type, del->data, delId))
         {
-            if (del == list->tail)
-            {
-                list->tail = del->next;
-            }
-
-            list->head = del->next;
-
-            if (type == NS_CONSUMER_CACHE_PROVIDER)
-            {
-                NSRemoveProvider_internal((void *) del->data);
-            }
-            NSOICFree(del);
-            pthread_mutex_unlock(mutex);
-
-            return NS_OK;
+            del = del->next;
         }
     }
+    NS_VERIFY_NOT_NULL_WITH_POST_CLEANING(del, NS_OK, pthread_mutex_unlock(mutex));
 
-    del = del->next;
-    while (del)
+    if (del->next)
     {
-        if (NSConsumerCompareIdCacheData(type, del->data, delId))
-        {
-            if (del == list->tail)
-            {
-                list->tail = prev;
-            }
-
-            prev->next = del->next;
+        del->next->prev = del->prev;
+    }
+    else
+    {
+        list->tail = del->prev;
+    }
 
-            if (type == NS_CONSUMER_CACHE_PROVIDER)
-            {
-                NSRemoveProvider_internal((NSProvider_internal *) del->data);
-            }
-            NSOICFree(del);
-            pthread_mutex_unlock(mutex);
+    if (del->prev)
+    {
+        del->prev->next = del->next;
+    }
+    else
+    {
+        list->head = del->next;
+    }
 
-            return NS_OK;
+    if (type == NS_CONSUMER_CACHE_PROVIDER)
+    {
+        if (list->index)
+        {
+            NSConsumerIndexRemove(list, del);
         }
-
-        prev = del;
-        del = del->next;
+        NSRemoveProvider_internal((NSProvider_internal *) del->data);
     }
+    NSOICFree(del);
     pthread_mutex_unlock(mutex);
+
     return NS_OK;
 }
 
@@ -207,10 +335,10 @@ NSResult NSConsumerCacheWriteProvider(NSCacheList * list, NSCacheElement * newOb
 
     NSProvider_internal * newProvObj = (NSProvider_internal *) newObj->data;
 
-    NSCacheElement * it = NSConsumerStorageRead(list, newProvObj->providerId);
-
     pthread_mutex_lock(mutex);
 
+    NSCacheElement * it = NSConsumerStorageRead(list, newProvObj->providerId);
+
     if (it)
     {
         if (newProvObj->connection)
@@ -225,6 +353,11 @@ NSResult NSConsumerCacheWriteProvider(NSCacheList * list, NSCacheElement * newOb
                 lastConn = lastConn->next;
             }
             infos->next = NSCopyProviderConnections(newProvObj->connection);
+
+            if (NSConsumerIndexAddConnections(list, it, infos->next) != NS_OK)
+            {
+                NS_LOG (ERROR, "Failed to index provider connections");
+            }
         }
 
         if (newProvObj->topicLL)
@@ -254,6 +387,17 @@ NSResult NSConsumerCacheWriteProvider(NSCacheList * list, NSCacheElement * newOb
         return NS_ERROR;
     }
     obj->next = NULL;
+    obj->prev = list->tail;
+
+    if (NSConsumerIndexAdd(list, obj) != NS_OK)
+    {
+        NS_LOG (ERROR, "Failed to index provider");
+        NSRemoveProvider_internal((NSProvider_internal *) obj->data);
+        NSOICFree(obj);
+        pthread_mutex_unlock(mutex);
+
+        return NS_ERROR;
+    }
 
     if (!list->head)
     {
@@ -289,7 +433,16 @@ NSCacheElement * NSPopProviderCacheList(NSCacheList * list)
         }
 
         list->head = head->next;
+        if (list->head)
+        {
+            list->head->prev = NULL;
+        }
         head->next = NULL;
+
+        if (list->index)
+        {
+            NSConsumerIndexRemove(list, head);
+        }
     }
 
     pthread_mutex_unlock(mutex);
@@ -311,6 +464,11 @@ NSResult NSConsumerStorageDestroy(NSCacheList * list)
 
     if (type == NS_CONSUMER_CACHE_PROVIDER)
     {
+        NSCacheIndexDestroy(list->index);
+        NSCacheIndexDestroy(list->addrIndex);
+        list->index = NULL;
+        list->addrIndex = NULL;
+
         while (iter)
         {
             next = (NSCacheElement *) iter->next;
@@ -30,7 +30,7 @@ extern "C" {
 #include <pthread.h>
 #include "NSConsumerCommon.h"
 
-NSCacheList * NSConsumerStorageCreate();
+NSCacheList * NSConsumerStorageCreate(NSCacheType type);
 NSCacheElement * NSConsumerStorageRead(NSCacheList * list, const char * findId);
 NSResult NSConsumerStorageWrite(NSCacheList * list, NSCacheElement * newObj);
 NSResult NSConsumerStorageDelete(NSCacheList * list, const char * delId);
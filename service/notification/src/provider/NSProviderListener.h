@@ -63,8 +63,8 @@ OCStackApplicationResult NSProviderPublishMQResponseCB(void *ctx, OCDoHandle han
         OCClientResponse *clientResponse);
 #endif
 
-#endif /* _NS_PROVIDER_LISTENER__H_ */
-
 #ifdef __cplusplus
 }
 #endif // __cplusplus
+
+#endif /* _NS_PROVIDER_LISTENER__H_ */
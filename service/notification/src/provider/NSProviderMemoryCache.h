@@ -30,8 +30,9 @@
 #include "oic_malloc.h"
 #include "oic_string.h"
 #include "NSUtil.h"
+#include "NSCacheIndex.h"
 
-NSCacheList * NSProviderStorageCreate();
+NSCacheList * NSProviderStorageCreate(NSCacheType type);
 NSCacheElement * NSProviderStorageRead(NSCacheList * list, const char * findId);
 NSResult NSProviderStorageWrite(NSCacheList * list, NSCacheElement * newObj);
 NSResult NSProviderStorageDelete(NSCacheList * list, const char * delId);
@@ -52,7 +53,8 @@ NSTopicLL * NSProviderGetTopicsCacheData(NSCacheList * regTopicList);
 NSTopicLL * NSProviderGetConsumerTopicsCacheData(NSCacheList * regTopicList,
         NSCacheList * conTopicList, const char * consumerId);
 
-bool NSProviderIsTopicSubScribed(NSCacheElement * conTopicList, char * cId, char * topicName);
+bool NSProviderIsTopicSubScribed(NSCacheList * conTopicList, const char * cId,
+        const char * topicName);
 
 NSResult NSProviderDeleteConsumerTopic(NSCacheList * conTopicList,
         NSCacheTopicSubData * topicSubData);
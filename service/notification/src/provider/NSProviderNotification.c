@@ -22,6 +22,71 @@
 #include "NSProviderListener.h"
 #include "NSProviderSystem.h"
 
+#define NS_OBSERVER_LIST_INITIAL_SIZE (16)
+
+/* OCNotifyListOfObservers() takes at most UINT8_MAX observation IDs per call. */
+#define NS_OBSERVER_BATCH_SIZE (UINT8_MAX)
+
+typedef struct
+{
+    OCObservationId * ids;
+    size_t count;
+    size_t size;
+
+} NSObserverList;
+
+static bool NSAddObserver(NSObserverList * list, OCObservationId id)
+{
+    if (list->count == list->size)
+    {
+        size_t size = list->size ? list->size * 2 : NS_OBSERVER_LIST_INITIAL_SIZE;
+        OCObservationId * ids =
+                (OCObservationId *) OICRealloc(list->ids, size * sizeof(OCObservationId));
+
+        if (!ids)
+        {
+            NS_LOG(ERROR, "Failed to grow observer list");
+            return false;
+        }
+
+        list->ids = ids;
+        list->size = size;
+    }
+
+    list->ids[list->count++] = id;
+    return true;
+}
+
+static OCStackResult NSNotifyObservers(OCResourceHandle rHandle, NSObserverList * list,
+        const OCRepPayload * payload)
+{
+    OCStackResult result = OC_STACK_OK;
+
+    NS_LOG_V(DEBUG, "Notify %" PRIuPTR " observers", list->count);
+
+    for (size_t i = 0; i < list->count; i += NS_OBSERVER_BATCH_SIZE)
+    {
+        size_t count = list->count - i;
+
+        if (count > NS_OBSERVER_BATCH_SIZE)
+        {
+            count = NS_OBSERVER_BATCH_SIZE;
+        }
+
+        OCStackResult batchResult = OCNotifyListOfObservers(rHandle, list->ids + i,
+                (uint8_t) count, payload, OC_LOW_QOS);
+
+        if (batchResult != OC_STACK_OK)
+        {
+            NS_LOG_V(ERROR, "fail to notify observers[%" PRIuPTR "..%" PRIuPTR "] : %d",
+                    i, i + count - 1, batchResult);
+            result = batchResult;
+        }
+    }
+
+    return result;
+}
+
 NSResult NSSetMessagePayload(NSMessage *msg, OCRepPayload** msgPayload)
 {
     NS_LOG(DEBUG, "NSSetMessagePayload - IN");
@@ -108,8 +173,7 @@ NSResult NSSendNotification(NSMessage *msg)
     NS_LOG(DEBUG, "NSSendMessage - IN");
 
     OCResourceHandle rHandle = NULL;
-    OCObservationId obArray[255] = { 0, };
-    size_t obCount = 0;
+    NSObserverList obList = { NULL, 0, 0 };
 
     if (NSPutMessageResource(msg, &rHandle) != NS_OK)
     {
@@ -140,6 +204,14 @@ NSResult NSSendNotification(NSMessage *msg)
         return NS_ERROR;
     }
 
+    bool isTopicMessage = (msg->topic && (msg->topic)[0] != '\0');
+
+    if (isTopicMessage)
+    {
+        NS_LOG_V(DEBUG, "this is topic message: %s", msg->topic);
+    }
+
+    pthread_mutex_lock(&NSCacheMutex);
     NSCacheElement * it = consumerSubList->head;
 
     while (it)
@@ -150,45 +222,32 @@ NSResult NSSendNotification(NSMessage *msg)
         NS_LOG_V(DEBUG, "subData->syncId = %d", subData->syncObId);
         NS_LOG_V(DEBUG, "subData->isWhite = %d", subData->isWhite);
 
-        if (subData->isWhite)
+        if (subData->isWhite && subData->messageObId != 0)
         {
-            if(subData->messageObId != 0)
+            if (!isTopicMessage ||
+                    NSProviderIsTopicSubScribed(consumerTopicList, subData->id, msg->topic))
             {
-                if (msg->topic && (msg->topic)[0] != '\0')
-                {
-                    NS_LOG_V(DEBUG, "this is topic message: %s", msg->topic);
-
-                    if (NSProviderIsTopicSubScribed(consumerTopicList->head, subData->id, msg->topic))
-                    {
-                        obArray[obCount++] = subData->messageObId;
-                    }
-                }
-                else
+                if (!NSAddObserver(&obList, subData->messageObId))
                 {
-                    obArray[obCount++] = subData->messageObId;
+                    break;
                 }
             }
         }
         it = it->next;
     }
+    pthread_mutex_unlock(&NSCacheMutex);
 
-    for (size_t i = 0; i < obCount; ++i)
-    {
-        NS_LOG(DEBUG, "-------------------------------------------------------message\n");
-        NS_LOG_V(DEBUG, "SubScription WhiteList[%" PRIuPTR "] = %d", i, obArray[i]);
-        NS_LOG(DEBUG, "-------------------------------------------------------message\n");
-    }
-
-    if (!obCount)
+    if (!obList.count)
     {
         NS_LOG(ERROR, "observer count is zero");
+        NSOICFree(obList.ids);
         OCRepPayloadDestroy(payload);
         msg->extraInfo = NULL;
         return NS_ERROR;
     }
 
-    OCStackResult ocstackResult = OCNotifyListOfObservers(rHandle, obArray, obCount, payload,
-            OC_LOW_QOS);
+    OCStackResult ocstackResult = NSNotifyObservers(rHandle, &obList, payload);
+    NSOICFree(obList.ids);
 
     NS_LOG_V(DEBUG, "Message ocstackResult = %d", ocstackResult);
 
@@ -211,8 +270,7 @@ NSResult NSSendSync(NSSyncInfo *sync)
 {
     NS_LOG(DEBUG, "NSSendSync - IN");
 
-    OCObservationId obArray[255] = { 0, };
-    size_t obCount = 0;
+    NSObserverList obList = { NULL, 0, 0 };
 
     OCResourceHandle rHandle = NULL;
     if (NSPutSyncResource(sync, &rHandle) != NS_OK)
@@ -221,6 +279,7 @@ NSResult NSSendSync(NSSyncInfo *sync)
         return NS_ERROR;
     }
 
+    pthread_mutex_lock(&NSCacheMutex);
     NSCacheElement * it = consumerSubList->head;
 
     while (it)
@@ -231,20 +290,22 @@ NSResult NSSendSync(NSSyncInfo *sync)
         NS_LOG_V(DEBUG, "subData->syncId = %d", subData->syncObId);
         NS_LOG_V(DEBUG, "subData->isWhite = %d", subData->isWhite);
 
-        if (subData->isWhite)
+        if (subData->isWhite && subData->syncObId != 0)
         {
-            if (subData->syncObId != 0)
+            if (!NSAddObserver(&obList, subData->syncObId))
             {
-                obArray[obCount++] = subData->syncObId;
+                break;
             }
         }
         it = it->next;
     }
+    pthread_mutex_unlock(&NSCacheMutex);
 
     OCRepPayload* payload = NULL;
     if (NSSetSyncPayload(sync, &payload) != NS_OK)
     {
         NS_LOG(ERROR, "Failed to allocate payload");
+        NSOICFree(obList.ids);
         return NS_ERROR;
     }
 
@@ -268,15 +329,8 @@ NSResult NSSendSync(NSSyncInfo *sync)
     }
 #endif
 
-    for (size_t i = 0; i < obCount; ++i)
-    {
-        NS_LOG(DEBUG, "-------------------------------------------------------message\n");
-        NS_LOG_V(DEBUG, "Sync WhiteList[%" PRIuPTR "] = %d", i, obArray[i]);
-        NS_LOG(DEBUG, "-------------------------------------------------------message\n");
-    }
-
-    OCStackResult ocstackResult = OCNotifyListOfObservers(rHandle, obArray,
-            obCount, payload, OC_LOW_QOS);
+    OCStackResult ocstackResult = NSNotifyObservers(rHandle, &obList, payload);
+    NSOICFree(obList.ids);
 
     NS_LOG_V(DEBUG, "Sync ocstackResult = %d", ocstackResult);
     if (ocstackResult != OC_STACK_OK)
@@ -25,9 +25,8 @@ NSResult NSInitSubscriptionList()
 {
     NS_LOG(DEBUG, "NSInitSubscriptionList - IN");
 
-    consumerSubList = NSProviderStorageCreate();
+    consumerSubList = NSProviderStorageCreate(NS_PROVIDER_CACHE_SUBSCRIBER);
     NS_VERIFY_NOT_NULL(consumerSubList, NS_FAIL);
-    consumerSubList->cacheType = NS_PROVIDER_CACHE_SUBSCRIBER;
 
     NS_LOG(DEBUG, "NSInitSubscriptionList - OUT");
     return NS_OK;
@@ -29,13 +29,11 @@ NSResult NSInitTopicList()
 {
     NS_LOG(DEBUG, "NSInitTopicList - IN");
 
-    consumerTopicList = NSProviderStorageCreate();
+    consumerTopicList = NSProviderStorageCreate(NS_PROVIDER_CACHE_CONSUMER_TOPIC_NAME);
     NS_VERIFY_NOT_NULL(consumerTopicList, NS_FAIL);
-    consumerTopicList->cacheType = NS_PROVIDER_CACHE_CONSUMER_TOPIC_NAME;
 
-    registeredTopicList = NSProviderStorageCreate();
+    registeredTopicList = NSProviderStorageCreate(NS_PROVIDER_CACHE_REGISTER_TOPIC);
     NS_VERIFY_NOT_NULL(registeredTopicList, NS_FAIL);
-    registeredTopicList->cacheType = NS_PROVIDER_CACHE_REGISTER_TOPIC;
 
     NS_LOG(DEBUG, "NSInitTopicList - OUT");
     return NS_OK;
@@ -0,0 +1,417 @@
+//******************************************************************
+//
+// Copyright 2017 Samsung Electronics All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ocstack.h"
+#include "oic_malloc.h"
+#include "oic_string.h"
+
+extern "C"
+{
+#include "NSCacheIndex.h"
+#include "NSConsumerCommon.h"
+#include "NSConsumerMemoryCache.h"
+
+// message state storage of NSConsumerInternalTaskController.c
+typedef struct _NSMessageStateLL NSMessageStateLL;
+NSMessageStateLL * NSFindMessageState(uint64_t msgId);
+bool NSUpdateMessageState(uint64_t msgId, NSSyncType state);
+bool NSDeleteMessageState(uint64_t msgId);
+bool NSInsertMessageState(uint64_t msgId, NSSyncType state);
+void NSDestroyMessageStateList();
+}
+
+namespace
+{
+    const char * const TEST_ADDR = "10.0.0.1";
+    const uint64_t FIRST_MESSAGE_ID = 100;
+
+    struct TestItem
+    {
+        int key;
+    };
+
+    bool MatchTestItem(void * item, const void * key)
+    {
+        return ((TestItem *) item)->key == *(const int *) key;
+    }
+
+    size_t HashTestItem(int key)
+    {
+        return NSCacheIndexHashInt(NS_CACHE_INDEX_HASH_SEED, (uint64_t) key);
+    }
+
+    TestItem * FindTestItem(NSCacheIndex * index, int key)
+    {
+        return (TestItem *) NSCacheIndexFind(index, HashTestItem(key), MatchTestItem, &key);
+    }
+
+    std::string ProviderId(size_t n)
+    {
+        return "provider-" + std::to_string(n);
+    }
+
+    NSProvider_internal * NewProvider(size_t n, uint16_t port)
+    {
+        OCDevAddr addr = {};
+        OICStrcpy(addr.addr, sizeof(addr.addr), TEST_ADDR);
+        addr.port = port;
+
+        NSProvider_internal * provider =
+                (NSProvider_internal *) OICCalloc(1, sizeof(NSProvider_internal));
+        OICStrcpy(provider->providerId, sizeof(provider->providerId), ProviderId(n).c_str());
+        provider->connection = NSCreateProviderConnections(&addr);
+        return provider;
+    }
+
+    NSResult WriteProvider(NSCacheList * list, size_t n, uint16_t port)
+    {
+        NSProvider_internal * provider = NewProvider(n, port);
+
+        NSCacheElement element = {};
+        element.data = (NSCacheData *) provider;
+        NSResult ret = NSConsumerStorageWrite(list, &element);
+
+        NSRemoveProvider_internal(provider);
+        return ret;
+    }
+
+    const char * FoundProviderId(NSCacheElement * element)
+    {
+        return element ? ((NSProvider_internal *) element->data)->providerId : NULL;
+    }
+}
+
+TEST(NotificationCacheIndexTest, AddFindRemove)
+{
+    NSCacheIndex * index = NSCacheIndexCreate(NS_CONSUMER_CACHE_MESSAGE);
+    ASSERT_TRUE(index != NULL);
+    EXPECT_EQ(NULL, FindTestItem(index, 1));
+
+    TestItem items[3] = { { 1 }, { 2 }, { 3 } };
+    for (TestItem & item : items)
+    {
+        EXPECT_EQ(NS_OK, NSCacheIndexAdd(index, HashTestItem(item.key), &item));
+    }
+    EXPECT_EQ(3u, index->count);
+
+    for (TestItem & item : items)
+    {
+        EXPECT_EQ(&item, FindTestItem(index, item.key));
+    }
+    EXPECT_EQ(NULL, FindTestItem(index, 4));
+
+    NSCacheIndexRemove(index, HashTestItem(2), &items[1]);
+    EXPECT_EQ(NULL, FindTestItem(index, 2));
+    EXPECT_EQ(&items[0], FindTestItem(index, 1));
+    EXPECT_EQ(&items[2], FindTestItem(index, 3));
+    EXPECT_EQ(2u, index->count);
+
+    // removing an item that is not indexed leaves the index alone.
+    NSCacheIndexRemove(index, HashTestItem(2), &items[1]);
+    EXPECT_EQ(2u, index->count);
+
+    NSCacheIndexDestroy(index);
+}
+
+TEST(NotificationCacheIndexTest, InvalidArguments)
+{
+    TestItem item = { 1 };
+    int key = 1;
+
+    EXPECT_EQ(NS_ERROR, NSCacheIndexAdd(NULL, 0, &item));
+    EXPECT_EQ(NULL, NSCacheIndexFind(NULL, 0, MatchTestItem, &key));
+    NSCacheIndexRemove(NULL, 0, &item);
+    NSCacheIndexDestroy(NULL);
+
+    NSCacheIndex * index = NSCacheIndexCreate(NS_CONSUMER_CACHE_MESSAGE);
+    ASSERT_TRUE(index != NULL);
+    EXPECT_EQ(NS_ERROR, NSCacheIndexAdd(index, 0, NULL));
+    EXPECT_EQ(NULL, NSCacheIndexFind(index, 0, NULL, &key));
+
+    // nothing added yet, so there are no buckets to remove from.
+    NSCacheIndexRemove(index, 0, &item);
+    EXPECT_EQ(0u, index->count);
+
+    NSCacheIndexDestroy(index);
+}
+
+TEST(NotificationCacheIndexTest, EqualHashesAreToldApartByMatch)
+{
+    NSCacheIndex * index = NSCacheIndexCreate(NS_CONSUMER_CACHE_MESSAGE);
+    ASSERT_TRUE(index != NULL);
+
+    const size_t hash = 7;
+    TestItem items[3] = { { 1 }, { 2 }, { 3 } };
+    for (TestItem & item : items)
+    {
+        EXPECT_EQ(NS_OK, NSCacheIndexAdd(index, hash, &item));
+    }
+
+    for (TestItem & item : items)
+    {
+        EXPECT_EQ(&item, NSCacheIndexFind(index, hash, MatchTestItem, &item.key));
+    }
+
+    NSCacheIndexRemove(index, hash, &items[0]);
+    EXPECT_EQ(NULL, NSCacheIndexFind(index, hash, MatchTestItem, &items[0].key));
+    EXPECT_EQ(&items[1], NSCacheIndexFind(index, hash, MatchTestItem, &items[1].key));
+    EXPECT_EQ(&items[2], NSCacheIndexFind(index, hash, MatchTestItem, &items[2].key));
+
+    NSCacheIndexDestroy(index);
+}
+
+TEST(NotificationCacheIndexTest, GrowsWithTheItems)
+{
+    NSCacheIndex * index = NSCacheIndexCreate(NS_CONSUMER_CACHE_MESSAGE);
+    ASSERT_TRUE(index != NULL);
+
+    std::vector<TestItem> items(1000);
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        items[i].key = (int) i;
+        ASSERT_EQ(NS_OK, NSCacheIndexAdd(index, HashTestItem(items[i].key), &items[i]));
+    }
+
+    EXPECT_EQ(items.size(), index->count);
+    EXPECT_LE(items.size(), index->bucketCount);
+    EXPECT_EQ(0u, index->bucketCount % NS_CACHE_INDEX_LOCK_STRIPES);
+
+    for (TestItem & item : items)
+    {
+        EXPECT_EQ(&item, FindTestItem(index, item.key));
+    }
+
+    NSCacheIndexDestroy(index);
+}
+
+TEST(NotificationCacheIndexTest, FindRunsConcurrentlyWithAddAndRemove)
+{
+    NSCacheIndex * index = NSCacheIndexCreate(NS_CONSUMER_CACHE_MESSAGE);
+    ASSERT_TRUE(index != NULL);
+
+    // the stable items are always found, while the writer keeps adding and
+    // removing others, which also grows the bucket array.
+    const size_t stable = 64;
+    const size_t changing = 2000;
+    std::vector<TestItem> items(stable + changing);
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        items[i].key = (int) i;
+    }
+
+    for (size_t i = 0; i < stable; i++)
+    {
+        ASSERT_EQ(NS_OK, NSCacheIndexAdd(index, HashTestItem(items[i].key), &items[i]));
+    }
+
+    std::atomic<bool> done(false);
+    std::atomic<size_t> misses(0);
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < 4; t++)
+    {
+        readers.push_back(std::thread([&, t]()
+        {
+            size_t i = t;
+            while (!done)
+            {
+                TestItem * item = &items[i % stable];
+                if (FindTestItem(index, item->key) != item)
+                {
+                    misses++;
+                }
+                i++;
+            }
+        }));
+    }
+
+    for (size_t i = stable; i < items.size(); i++)
+    {
+        EXPECT_EQ(NS_OK, NSCacheIndexAdd(index, HashTestItem(items[i].key), &items[i]));
+        if (i % 2)
+        {
+            NSCacheIndexRemove(index, HashTestItem(items[i - 1].key), &items[i - 1]);
+        }
+    }
+
+    done = true;
+    for (std::thread & reader : readers)
+    {
+        reader.join();
+    }
+
+    EXPECT_EQ(0u, misses);
+    EXPECT_EQ(stable + changing / 2, index->count);
+
+    NSCacheIndexDestroy(index);
+}
+
+class NotificationConsumerCacheTest : public testing::Test
+{
+protected:
+    NSCacheList * m_list;
+
+    virtual void SetUp()
+    {
+        m_list = NSConsumerStorageCreate(NS_CONSUMER_CACHE_PROVIDER);
+        ASSERT_TRUE(m_list != NULL);
+    }
+
+    virtual void TearDown()
+    {
+        NSConsumerStorageDestroy(m_list);
+        NSDestroyMessageStateList();
+    }
+};
+
+TEST_F(NotificationConsumerCacheTest, IndexesAreCreatedWithTheList)
+{
+    EXPECT_EQ(NS_CONSUMER_CACHE_PROVIDER, m_list->cacheType);
+    EXPECT_TRUE(m_list->index != NULL);
+    EXPECT_TRUE(m_list->addrIndex != NULL);
+}
+
+TEST_F(NotificationConsumerCacheTest, ProviderIsFoundByIdAndAddress)
+{
+    const size_t providers = 100;
+    for (size_t i = 0; i < providers; i++)
+    {
+        ASSERT_EQ(NS_OK, WriteProvider(m_list, i, (uint16_t) (5000 + i)));
+    }
+
+    for (size_t i = 0; i < providers; i++)
+    {
+        EXPECT_STREQ(ProviderId(i).c_str(),
+                FoundProviderId(NSConsumerStorageRead(m_list, ProviderId(i).c_str())));
+        EXPECT_STREQ(ProviderId(i).c_str(),
+                FoundProviderId(NSGetProviderFromAddr(m_list, TEST_ADDR, (uint16_t) (5000 + i))));
+    }
+
+    EXPECT_EQ(NULL, NSConsumerStorageRead(m_list, ProviderId(providers).c_str()));
+    EXPECT_EQ(NULL, NSGetProviderFromAddr(m_list, TEST_ADDR, (uint16_t) (5000 + providers)));
+    EXPECT_EQ(NULL, NSGetProviderFromAddr(m_list, "10.0.0.2", 5000));
+}
+
+TEST_F(NotificationConsumerCacheTest, NewConnectionOfKnownProviderIsIndexed)
+{
+    ASSERT_EQ(NS_OK, WriteProvider(m_list, 1, 5000));
+    ASSERT_EQ(NS_OK, WriteProvider(m_list, 1, 5001));
+
+    EXPECT_EQ(m_list->head, m_list->tail);
+    EXPECT_EQ(1u, m_list->index->count);
+    EXPECT_EQ(m_list->head, NSGetProviderFromAddr(m_list, TEST_ADDR, 5000));
+    EXPECT_EQ(m_list->head, NSGetProviderFromAddr(m_list, TEST_ADDR, 5001));
+}
+
+TEST_F(NotificationConsumerCacheTest, DeleteUpdatesIndexes)
+{
+    const size_t providers = 4;
+    for (size_t i = 0; i < providers; i++)
+    {
+        ASSERT_EQ(NS_OK, WriteProvider(m_list, i, (uint16_t) (5000 + i)));
+    }
+
+    // head, tail, then one in the middle.
+    const size_t deleted[] = { 0, providers - 1, 1 };
+    for (size_t n : deleted)
+    {
+        EXPECT_EQ(NS_OK, NSConsumerStorageDelete(m_list, ProviderId(n).c_str()));
+        EXPECT_EQ(NULL, NSConsumerStorageRead(m_list, ProviderId(n).c_str()));
+        EXPECT_EQ(NULL, NSGetProviderFromAddr(m_list, TEST_ADDR, (uint16_t) (5000 + n)));
+    }
+
+    EXPECT_EQ(m_list->head, m_list->tail);
+    EXPECT_STREQ(ProviderId(2).c_str(), FoundProviderId(m_list->head));
+    EXPECT_EQ(1u, m_list->index->count);
+    EXPECT_EQ(1u, m_list->addrIndex->count);
+}
+
+TEST_F(NotificationConsumerCacheTest, PopUpdatesIndexes)
+{
+    ASSERT_EQ(NS_OK, WriteProvider(m_list, 1, 5001));
+    ASSERT_EQ(NS_OK, WriteProvider(m_list, 2, 5002));
+
+    NSCacheElement * popped = NSPopProviderCacheList(m_list);
+    ASSERT_TRUE(popped != NULL);
+    EXPECT_STREQ(ProviderId(1).c_str(), FoundProviderId(popped));
+    EXPECT_EQ(NULL, NSConsumerStorageRead(m_list, ProviderId(1).c_str()));
+    EXPECT_EQ(NULL, NSGetProviderFromAddr(m_list, TEST_ADDR, 5001));
+    EXPECT_STREQ(ProviderId(2).c_str(), FoundProviderId(m_list->head));
+
+    NSRemoveProvider_internal(popped->data);
+    NSOICFree(popped);
+}
+
+TEST_F(NotificationConsumerCacheTest, MessageStateIsFoundById)
+{
+    for (uint64_t id = FIRST_MESSAGE_ID; id < FIRST_MESSAGE_ID + 100; id++)
+    {
+        EXPECT_TRUE(NSInsertMessageState(id, NS_SYNC_UNREAD));
+    }
+    EXPECT_FALSE(NSInsertMessageState(FIRST_MESSAGE_ID, NS_SYNC_UNREAD));
+
+    for (uint64_t id = FIRST_MESSAGE_ID; id < FIRST_MESSAGE_ID + 100; id++)
+    {
+        EXPECT_TRUE(NSFindMessageState(id) != NULL);
+    }
+    EXPECT_EQ(NULL, NSFindMessageState(FIRST_MESSAGE_ID + 100));
+
+    EXPECT_TRUE(NSUpdateMessageState(FIRST_MESSAGE_ID + 1, NS_SYNC_READ));
+    EXPECT_FALSE(NSUpdateMessageState(FIRST_MESSAGE_ID + 1, NS_SYNC_READ));
+    EXPECT_FALSE(NSUpdateMessageState(FIRST_MESSAGE_ID + 100, NS_SYNC_READ));
+}
+
+TEST_F(NotificationConsumerCacheTest, DeleteMessageStateHeadKeepsTheRest)
+{
+    for (uint64_t id = FIRST_MESSAGE_ID; id < FIRST_MESSAGE_ID + 3; id++)
+    {
+        EXPECT_TRUE(NSInsertMessageState(id, NS_SYNC_UNREAD));
+    }
+
+    EXPECT_TRUE(NSDeleteMessageState(FIRST_MESSAGE_ID));
+    EXPECT_EQ(NULL, NSFindMessageState(FIRST_MESSAGE_ID));
+    EXPECT_TRUE(NSFindMessageState(FIRST_MESSAGE_ID + 1) != NULL);
+    EXPECT_TRUE(NSFindMessageState(FIRST_MESSAGE_ID + 2) != NULL);
+    EXPECT_FALSE(NSDeleteMessageState(FIRST_MESSAGE_ID));
+
+    // the tail is still linked, so inserting after it keeps every state reachable.
+    EXPECT_TRUE(NSDeleteMessageState(FIRST_MESSAGE_ID + 2));
+    EXPECT_TRUE(NSInsertMessageState(FIRST_MESSAGE_ID + 3, NS_SYNC_UNREAD));
+    EXPECT_TRUE(NSDeleteMessageState(FIRST_MESSAGE_ID + 1));
+    EXPECT_TRUE(NSFindMessageState(FIRST_MESSAGE_ID + 3) != NULL);
+    EXPECT_TRUE(NSDeleteMessageState(FIRST_MESSAGE_ID + 3));
+    EXPECT_EQ(NULL, NSFindMessageState(FIRST_MESSAGE_ID + 3));
+
+    EXPECT_TRUE(NSInsertMessageState(FIRST_MESSAGE_ID, NS_SYNC_UNREAD));
+    EXPECT_TRUE(NSFindMessageState(FIRST_MESSAGE_ID) != NULL);
+}
+
+TEST_F(NotificationConsumerCacheTest, ReservedMessageIdsAreNotStored)
+{
+    EXPECT_EQ(NULL, NSFindMessageState(1));
+    EXPECT_FALSE(NSDeleteMessageState(1));
+    EXPECT_FALSE(NSUpdateMessageState(1, NS_SYNC_READ));
+}
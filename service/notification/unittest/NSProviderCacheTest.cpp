@@ -0,0 +1,382 @@
+//******************************************************************
+//
+// Copyright 2017 Samsung Electronics All Rights Reserved.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "ocstack.h"
+#include "ocpayload.h"
+
+extern "C"
+{
+#include "NSProviderMemoryCache.h"
+#include "NSProviderNotification.h"
+#include "NSProviderSubscription.h"
+#include "NSProviderTopic.h"
+}
+
+namespace
+{
+    std::vector<std::vector<OCObservationId>> g_batches;
+    size_t g_failBatch = SIZE_MAX;
+}
+
+// Build the notification sender against a stub of OCNotifyListOfObservers, so
+// the batches it sends can be checked without observers in the stack.
+// Functions exported by the library are renamed to avoid clashing with it.
+#define OCNotifyListOfObservers NSTestNotifyListOfObservers
+#define NSSetMessagePayload NSSetMessagePayloadTest
+#define NSSetSyncPayload NSSetSyncPayloadTest
+#define NSProviderPublishTopic NSProviderPublishTopicTest
+#define NSSendNotification NSSendNotificationTest
+#define NSSendSync NSSendSyncTest
+#define NSNotificationSchedule NSNotificationScheduleTest
+
+extern "C"
+{
+OCStackResult NSTestNotifyListOfObservers(OCResourceHandle handle, OCObservationId * obsIdList,
+        uint8_t numberOfIds, const OCRepPayload * payload, OCQualityOfService qos)
+{
+    (void) handle;
+    (void) payload;
+    (void) qos;
+
+    g_batches.push_back(std::vector<OCObservationId>(obsIdList, obsIdList + numberOfIds));
+    return (g_batches.size() - 1 == g_failBatch) ? OC_STACK_ERROR : OC_STACK_OK;
+}
+
+#include "NSProviderNotification.c"
+}
+
+namespace
+{
+    const char * const TEST_TOPIC = "test/topic";
+
+    std::string ConsumerId(size_t n)
+    {
+        return "consumer-" + std::to_string(n);
+    }
+
+    NSCacheElement * NewSubscriber(size_t n, bool isWhite)
+    {
+        NSCacheSubData * subData = (NSCacheSubData *) OICCalloc(1, sizeof(NSCacheSubData));
+        OICStrcpy(subData->id, sizeof(subData->id), ConsumerId(n).c_str());
+        subData->messageObId = (int) n + 1;
+        subData->syncObId = (int) n + 1;
+        subData->isWhite = isWhite;
+
+        NSCacheElement * element = (NSCacheElement *) OICCalloc(1, sizeof(NSCacheElement));
+        element->data = (NSCacheData *) subData;
+        return element;
+    }
+
+    NSCacheElement * NewConsumerTopic(const std::string & id, const char * topicName)
+    {
+        NSCacheTopicSubData * topicData =
+                (NSCacheTopicSubData *) OICCalloc(1, sizeof(NSCacheTopicSubData));
+        OICStrcpy(topicData->id, sizeof(topicData->id), id.c_str());
+        topicData->topicName = OICStrdup(topicName);
+
+        NSCacheElement * element = (NSCacheElement *) OICCalloc(1, sizeof(NSCacheElement));
+        element->data = (NSCacheData *) topicData;
+        return element;
+    }
+
+    NSResult DeleteConsumerTopic(const std::string & id, const char * topicName)
+    {
+        NSCacheTopicSubData topicData;
+        OICStrcpy(topicData.id, sizeof(topicData.id), id.c_str());
+        topicData.topicName = (char *) topicName;
+        return NSProviderDeleteConsumerTopic(consumerTopicList, &topicData);
+    }
+
+    std::vector<OCObservationId> SentIds()
+    {
+        std::vector<OCObservationId> ids;
+        for (const auto & batch : g_batches)
+        {
+            ids.insert(ids.end(), batch.begin(), batch.end());
+        }
+        return ids;
+    }
+}
+
+class NotificationProviderCacheTest : public testing::Test
+{
+protected:
+    static void SetUpTestCase()
+    {
+        pthread_mutexattr_init(&NSCacheMutexAttr);
+        pthread_mutexattr_settype(&NSCacheMutexAttr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&NSCacheMutex, &NSCacheMutexAttr);
+    }
+
+    static void TearDownTestCase()
+    {
+        pthread_mutex_destroy(&NSCacheMutex);
+        pthread_mutexattr_destroy(&NSCacheMutexAttr);
+    }
+
+    virtual void SetUp()
+    {
+        consumerSubList = NSProviderStorageCreate(NS_PROVIDER_CACHE_SUBSCRIBER);
+        ASSERT_TRUE(consumerSubList != NULL);
+
+        consumerTopicList = NSProviderStorageCreate(NS_PROVIDER_CACHE_CONSUMER_TOPIC_NAME);
+        ASSERT_TRUE(consumerTopicList != NULL);
+
+        g_batches.clear();
+        g_failBatch = SIZE_MAX;
+    }
+
+    virtual void TearDown()
+    {
+        NSProviderStorageDestroy(consumerSubList);
+        consumerSubList = NULL;
+        NSProviderStorageDestroy(consumerTopicList);
+        consumerTopicList = NULL;
+    }
+
+    void AddSubscribers(size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            ASSERT_EQ(NS_OK, NSProviderStorageWrite(consumerSubList, NewSubscriber(i, true)));
+        }
+    }
+};
+
+TEST_F(NotificationProviderCacheTest, IndexIsCreatedWithTheList)
+{
+    ASSERT_TRUE(consumerSubList->index != NULL);
+    EXPECT_EQ(NS_PROVIDER_CACHE_SUBSCRIBER, consumerSubList->index->keyType);
+    EXPECT_EQ(0u, consumerSubList->index->count);
+
+    ASSERT_TRUE(consumerTopicList->index != NULL);
+    EXPECT_EQ(NS_PROVIDER_CACHE_CONSUMER_TOPIC_NAME, consumerTopicList->index->keyType);
+
+    NSCacheList * topicList = NSProviderStorageCreate(NS_PROVIDER_CACHE_REGISTER_TOPIC);
+    ASSERT_TRUE(topicList != NULL);
+    EXPECT_EQ(NS_PROVIDER_CACHE_REGISTER_TOPIC, topicList->cacheType);
+    ASSERT_TRUE(topicList->index != NULL);
+    EXPECT_EQ(NS_PROVIDER_CACHE_REGISTER_TOPIC, topicList->index->keyType);
+    NSProviderStorageDestroy(topicList);
+}
+
+TEST_F(NotificationProviderCacheTest, SubscriberIndexFindsEverySubscriber)
+{
+    const size_t subscribers = 200;
+    AddSubscribers(subscribers);
+    EXPECT_EQ(subscribers, consumerSubList->index->count);
+
+    for (size_t i = 0; i < subscribers; i++)
+    {
+        NSCacheElement * it = NSProviderStorageRead(consumerSubList, ConsumerId(i).c_str());
+        ASSERT_TRUE(it != NULL);
+        EXPECT_STREQ(ConsumerId(i).c_str(), ((NSCacheSubData *) it->data)->id);
+    }
+
+    EXPECT_EQ(NULL, NSProviderStorageRead(consumerSubList, ConsumerId(subscribers).c_str()));
+}
+
+TEST_F(NotificationProviderCacheTest, SubscriberWriteUpdatesIndexedEntry)
+{
+    AddSubscribers(3);
+
+    NSCacheElement * update = NewSubscriber(1, true);
+    ((NSCacheSubData *) update->data)->messageObId = 0;
+    ((NSCacheSubData *) update->data)->syncObId = 42;
+    EXPECT_EQ(NS_OK, NSProviderStorageWrite(consumerSubList, update));
+    EXPECT_EQ(3u, consumerSubList->index->count);
+
+    NSCacheElement * it = NSProviderStorageRead(consumerSubList, ConsumerId(1).c_str());
+    ASSERT_TRUE(it != NULL);
+    EXPECT_EQ(2, ((NSCacheSubData *) it->data)->messageObId);
+    EXPECT_EQ(42, ((NSCacheSubData *) it->data)->syncObId);
+}
+
+TEST_F(NotificationProviderCacheTest, SubscriberDeleteUpdatesIndex)
+{
+    const size_t subscribers = 5;
+    AddSubscribers(subscribers);
+
+    // head, tail, then one in the middle.
+    const size_t deleted[] = { 0, subscribers - 1, 2 };
+    for (size_t n : deleted)
+    {
+        EXPECT_EQ(NS_OK, NSProviderStorageDelete(consumerSubList, ConsumerId(n).c_str()));
+        EXPECT_EQ(NULL, NSProviderStorageRead(consumerSubList, ConsumerId(n).c_str()));
+    }
+
+    EXPECT_EQ(subscribers - 3, consumerSubList->index->count);
+    EXPECT_TRUE(NSProviderStorageRead(consumerSubList, ConsumerId(1).c_str()) != NULL);
+    EXPECT_TRUE(NSProviderStorageRead(consumerSubList, ConsumerId(3).c_str()) != NULL);
+    EXPECT_STREQ(ConsumerId(1).c_str(), ((NSCacheSubData *) consumerSubList->head->data)->id);
+    EXPECT_STREQ(ConsumerId(3).c_str(), ((NSCacheSubData *) consumerSubList->tail->data)->id);
+    EXPECT_EQ(consumerSubList->head, consumerSubList->tail->prev);
+    EXPECT_EQ(NULL, consumerSubList->head->prev);
+    EXPECT_EQ(NULL, consumerSubList->tail->next);
+
+    // the list still appends after its tail was unlinked.
+    EXPECT_EQ(NS_OK, NSProviderStorageWrite(consumerSubList, NewSubscriber(subscribers, true)));
+    EXPECT_EQ(consumerSubList->head->next, consumerSubList->tail->prev);
+    EXPECT_EQ(NS_OK, NSProviderStorageDelete(consumerSubList, ConsumerId(3).c_str()));
+    EXPECT_EQ(consumerSubList->head, consumerSubList->tail->prev);
+    EXPECT_EQ(consumerSubList->tail, consumerSubList->head->next);
+}
+
+TEST_F(NotificationProviderCacheTest, ConsumerTopicIndexFindsSubscribedTopics)
+{
+    EXPECT_EQ(NS_OK, NSProviderStorageWrite(consumerTopicList,
+            NewConsumerTopic(ConsumerId(1), "topic/a")));
+    EXPECT_EQ(NS_OK, NSProviderStorageWrite(consumerTopicList,
+            NewConsumerTopic(ConsumerId(1), "topic/b")));
+    EXPECT_EQ(NS_OK, NSProviderStorageWrite(consumerTopicList,
+            NewConsumerTopic(ConsumerId(2), "topic/b")));
+
+    EXPECT_TRUE(NSProviderIsTopicSubScribed(consumerTopicList, ConsumerId(1).c_str(), "topic/a"));
+    EXPECT_TRUE(NSProviderIsTopicSubScribed(consumerTopicList, ConsumerId(1).c_str(), "topic/b"));
+    EXPECT_TRUE(NSProviderIsTopicSubScribed(consumerTopicList, ConsumerId(2).c_str(), "topic/b"));
+    EXPECT_FALSE(NSProviderIsTopicSubScribed(consumerTopicList, ConsumerId(2).c_str(), "topic/a"));
+    EXPECT_FALSE(NSProviderIsTopicSubScribed(consumerTopicList, ConsumerId(3).c_str(), "topic/a"));
+    EXPECT_FALSE(NSProviderIsTopicSubScribed(consumerTopicList, NULL, "topic/a"));
+    EXPECT_FALSE(NSProviderIsTopicSubScribed(NULL, ConsumerId(1).c_str(), "topic/a"));
+}
+
+TEST_F(NotificationProviderCacheTest, TopicCanBeSubscribedByMoreThanOneConsumer)
+{
+    const size_t consumers = 10;
+
+    for (size_t i = 0; i < consumers; i++)
+    {
+        EXPECT_EQ(NS_OK, NSProviderStorageWrite(consumerTopicList,
+                NewConsumerTopic(ConsumerId(i), TEST_TOPIC)));
+    }
+
+    for (size_t i = 0; i < consumers; i++)
+    {
+        EXPECT_TRUE(NSProviderIsTopicSubScribed(consumerTopicList, ConsumerId(i).c_str(),
+                TEST_TOPIC));
+    }
+}
+
+TEST_F(NotificationProviderCacheTest, DuplicateConsumerTopicIsRejected)
+{
+    EXPECT_EQ(NS_OK, NSProviderStorageWrite(consumerTopicList,
+            NewConsumerTopic(ConsumerId(1), TEST_TOPIC)));
+    EXPECT_EQ(NS_FAIL, NSProviderStorageWrite(consumerTopicList,
+            NewConsumerTopic(ConsumerId(1), TEST_TOPIC)));
+
+    EXPECT_EQ(NS_OK, DeleteConsumerTopic(ConsumerId(1), TEST_TOPIC));
+    EXPECT_EQ(NULL, consumerTopicList->head);
+}
+
+TEST_F(NotificationProviderCacheTest, DeleteConsumerTopicUpdatesIndex)
+{
+    for (size_t i = 0; i < 3; i++)
+    {
+        EXPECT_EQ(NS_OK, NSProviderStorageWrite(consumerTopicList,
+                NewConsumerTopic(ConsumerId(i), TEST_TOPIC)));
+    }
+
+    // head, tail, then the remaining element.
+    EXPECT_EQ(NS_OK, DeleteConsumerTopic(ConsumerId(0), TEST_TOPIC));
+    EXPECT_FALSE(NSProviderIsTopicSubScribed(consumerTopicList, ConsumerId(0).c_str(),
+            TEST_TOPIC));
+    EXPECT_TRUE(NSProviderIsTopicSubScribed(consumerTopicList, ConsumerId(1).c_str(),
+            TEST_TOPIC));
+
+    EXPECT_EQ(NS_OK, DeleteConsumerTopic(ConsumerId(2), TEST_TOPIC));
+    EXPECT_FALSE(NSProviderIsTopicSubScribed(consumerTopicList, ConsumerId(2).c_str(),
+            TEST_TOPIC));
+    EXPECT_EQ(consumerTopicList->head, consumerTopicList->tail);
+
+    EXPECT_EQ(NS_FAIL, DeleteConsumerTopic(ConsumerId(2), TEST_TOPIC));
+    EXPECT_EQ(NS_OK, DeleteConsumerTopic(ConsumerId(1), TEST_TOPIC));
+    EXPECT_FALSE(NSProviderIsTopicSubScribed(consumerTopicList, ConsumerId(1).c_str(),
+            TEST_TOPIC));
+    EXPECT_EQ(NULL, consumerTopicList->head);
+    EXPECT_EQ(NULL, consumerTopicList->tail);
+}
+
+TEST_F(NotificationProviderCacheTest, SyncIsSentToAllSubscribersInBatches)
+{
+    const size_t subscribers = 2 * NS_OBSERVER_BATCH_SIZE + 90;
+    AddSubscribers(subscribers);
+
+    NSSyncInfo sync = {};
+    sync.messageId = 1;
+    sync.state = NS_SYNC_READ;
+    EXPECT_EQ(NS_OK, NSSendSyncTest(&sync));
+
+    ASSERT_EQ(3u, g_batches.size());
+    EXPECT_EQ((size_t) NS_OBSERVER_BATCH_SIZE, g_batches[0].size());
+    EXPECT_EQ((size_t) NS_OBSERVER_BATCH_SIZE, g_batches[1].size());
+    EXPECT_EQ(90u, g_batches[2].size());
+
+    std::vector<OCObservationId> ids = SentIds();
+    ASSERT_EQ(subscribers, ids.size());
+    for (size_t i = 0; i < subscribers; i++)
+    {
+        EXPECT_EQ((OCObservationId) (i + 1), ids[i]);
+    }
+}
+
+TEST_F(NotificationProviderCacheTest, FailedBatchDoesNotStopTheOthers)
+{
+    AddSubscribers(3 * NS_OBSERVER_BATCH_SIZE);
+    g_failBatch = 1;
+
+    NSSyncInfo sync = {};
+    sync.messageId = 1;
+    sync.state = NS_SYNC_DELETED;
+    EXPECT_EQ(NS_ERROR, NSSendSyncTest(&sync));
+
+    EXPECT_EQ(3u, g_batches.size());
+    EXPECT_EQ((size_t) (3 * NS_OBSERVER_BATCH_SIZE), SentIds().size());
+}
+
+TEST_F(NotificationProviderCacheTest, TopicMessageOnlyReachesTopicSubscribers)
+{
+    const size_t subscribers = 300;
+    AddSubscribers(subscribers);
+    ASSERT_EQ(NS_OK, NSProviderStorageWrite(consumerSubList, NewSubscriber(subscribers, false)));
+
+    std::vector<OCObservationId> expected;
+    for (size_t i = 0; i <= subscribers; i += 2)
+    {
+        ASSERT_EQ(NS_OK, NSProviderStorageWrite(consumerTopicList,
+                NewConsumerTopic(ConsumerId(i), TEST_TOPIC)));
+        if (i < subscribers)
+        {
+            expected.push_back((OCObservationId) (i + 1));
+        }
+    }
+
+    NSMessage msg = {};
+    msg.messageId = 1;
+    msg.topic = (char *) TEST_TOPIC;
+    EXPECT_EQ(NS_OK, NSSendNotificationTest(&msg));
+
+    // the blocked subscriber is left out even though it has the topic.
+    EXPECT_EQ(expected, SentIds());
+}